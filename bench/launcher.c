@@ -0,0 +1,177 @@
+#define _GNU_SOURCE
+
+#include "comfy_io.h"
+#include "task/launcher.h"
+#include "task/zygote.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/wait.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The number of processes each run launches, spread over as many pipelines as
+ * it takes, so that runs of any length cost about the same.
+ */
+#define PROCESSES_PER_RUN 4096ul
+
+/**
+ * The longest command line launched: 16 stages of @p "true".
+ */
+#define MAX_CMD_SIZE 128ul
+
+static char const* const program_name = "bench_launcher";
+
+/**
+ * Launches a pipeline's stages, and stores their process ids.
+ */
+typedef bool (*LaunchFn)(
+    Zygote* zygote,
+    char const* cmd,
+    size_t len,
+    int out_fd,
+    pid_t* pids,
+    size_t* stage_count
+);
+
+static bool spawn_pipeline(
+    Zygote* const zygote,
+    char const* const cmd,
+    size_t const len,
+    int const out_fd,
+    pid_t* const pids,
+    size_t* const stage_count
+) {
+    (void) zygote;
+
+    Pipeline pipeline;
+    if (pipeline_parse(&pipeline, cmd, len) != LAUNCHER_OK) {
+        return false;
+    }
+    bool const is_launched =
+        pipeline_launch(&pipeline, false, out_fd, -1) == LAUNCHER_OK;
+    if (is_launched) {
+        memcpy(pids, pipeline.pids, pipeline.stage_count * sizeof *pids);
+        *stage_count = pipeline.stage_count;
+    }
+    pipeline_drop(&pipeline);
+    return is_launched;
+}
+
+static bool zygote_pipeline(
+    Zygote* const zygote,
+    char const* const cmd,
+    size_t const len,
+    int const out_fd,
+    pid_t* const pids,
+    size_t* const stage_count
+) {
+    static ZygoteLaunch launch;
+    if (
+        zygote_launch(zygote, cmd, len, false, out_fd, -1, &launch) !=
+            ZYGOTE_OK ||
+        launch.outcome != LAUNCHER_OK
+    ) {
+        return false;
+    }
+    memcpy(pids, launch.pids, launch.stage_count * sizeof *pids);
+    *stage_count = launch.stage_count;
+    return true;
+}
+
+static double elapsed_secs(
+    struct timespec const* const begin,
+    struct timespec const* const end
+) {
+    return (double) (end->tv_sec - begin->tv_sec) +
+        (double) (end->tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+/**
+ * Launches pipelines of @p stages stages of @p "true", one at a time, each
+ * reaped before the next is launched, and prints how many are launched and
+ * reaped per second.
+ */
+static bool run(
+    char const* const name,
+    LaunchFn const launch,
+    Zygote* const zygote,
+    size_t const stages,
+    int const null_fd
+) {
+    char cmd[MAX_CMD_SIZE];
+    size_t len = 0ul;
+    for (size_t i = 0ul; i < stages; ++i) {
+        len += (size_t) snprintf(
+            cmd + len,
+            sizeof cmd - len,
+            i == 0ul ? "true" : " | true"
+        );
+    }
+    size_t const runs = PROCESSES_PER_RUN / stages;
+
+    struct timespec begin;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0ul; i < runs; ++i) {
+        pid_t pids[16];
+        size_t stage_count;
+        if (!launch(zygote, cmd, len, null_fd, pids, &stage_count)) {
+            program_eprintln(
+                "Failed launching '%s': %s.",
+                cmd,
+                strerror(errno)
+            );
+            return false;
+        }
+        for (size_t j = 0ul; j < stage_count; ++j) {
+            while (waitpid(pids[j], NULL, 0) == -1 && errno == EINTR) {}
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double const secs = elapsed_secs(&begin, &end);
+    printf(
+        "%-8s %2zu stages: %8.0f tasks/s, %6.1f us/task\n",
+        name,
+        stages,
+        (double) runs / secs,
+        secs * 1e6 / (double) runs
+    );
+    return true;
+}
+
+int main(void) {
+    // the zygote's stages are made the bench's children, as with the server
+    Zygote zygote;
+    ZygoteOutcome const zygote_outcome = zygote_new(&zygote);
+    if (zygote_outcome != ZYGOTE_OK) {
+        program_eprintln(
+            "Failed forking the zygote: %s.",
+            zygote_outcome_msg(zygote_outcome, &errno)
+        );
+        return EXIT_FAILURE;
+    }
+    int const null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (null_fd == -1) {
+        program_eprintln("Failed opening /dev/null: %s.", strerror(errno));
+        zygote_drop(&zygote);
+        return EXIT_FAILURE;
+    }
+
+    static size_t const stage_counts[] = { 1ul, 4ul, 16ul };
+    bool is_ok = true;
+    for (size_t i = 0ul; is_ok && i < 3ul; ++i) {
+        is_ok = run("spawn", spawn_pipeline, NULL, stage_counts[i], null_fd) &&
+            run("zygote", zygote_pipeline, &zygote, stage_counts[i], null_fd);
+    }
+
+    close(null_fd);
+    zygote_drop(&zygote);
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
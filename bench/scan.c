@@ -0,0 +1,221 @@
+#define _GNU_SOURCE
+
+#include "comfy_io.h"
+#include "scan.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The size of the large buffer scanned, as a task's output or a batch file.
+ */
+#define LARGE_SIZE (1ul << 20ul)
+
+/**
+ * The size of the small buffer scanned, as a command line.
+ */
+#define SMALL_SIZE 64ul
+
+/**
+ * The number of bytes scanned per measurement.
+ */
+#define BYTES_PER_RUN (1ul << 30ul)
+
+/**
+ * The longest buffer checked against the portable kernel, at every length and
+ * alignment up to it.
+ */
+#define MAX_CHECKED_LEN 160ul
+
+static char const* const program_name = "bench_scan";
+
+static char const* const isa_names[] = { "portable", "sse2", "avx2" };
+
+/**
+ * Keeps the compiler from discarding scans whose results aren't used.
+ */
+static volatile size_t sink;
+
+static uint64_t next_random(uint64_t* const state) {
+    *state ^= *state << 13u;
+    *state ^= *state >> 7u;
+    *state ^= *state << 17u;
+    return *state;
+}
+
+/**
+ * Fills @p buf with words of lowercase letters, separated by spaces, tabs and
+ * the odd newline, and pipes if @p has_pipes is set, as in a batch file.
+ */
+static void fill_text(
+    char* const buf,
+    size_t const len,
+    bool const has_pipes,
+    uint64_t* const state
+) {
+    for (size_t i = 0ul; i < len; ++i) {
+        uint64_t const r = next_random(state) % 64u;
+        buf[i] = r < 7u ? ' ' :
+            r == 7u ? '\n' :
+            r == 8u ? '\t' :
+            r == 9u && has_pipes ? '|' :
+            r == 10u ? (char) 0xc3 :
+            (char) ('a' + r % 26u);
+    }
+}
+
+/**
+ * The scanning functions, all returning a size, for timing and checking.
+ */
+typedef size_t (*ScanFn)(char const* begin, char const* end, unsigned classes);
+
+static size_t find_offset(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes
+) {
+    return (size_t) (scan_find(begin, end, classes) - begin);
+}
+
+static size_t skip_offset(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes
+) {
+    return (size_t) (scan_skip(begin, end, classes) - begin);
+}
+
+typedef struct ScanCase {
+    char const* name;   //!< What's scanned.
+    ScanFn fn;  //!< The scanning function.
+    unsigned classes;   //!< The ScanClasses looked for.
+    bool is_blank;  //!< Whether it's timed over blanks rather than text.
+} ScanCase;
+
+/**
+ * Finding a pipe in text without any scans it whole, and so does skipping
+ * over blanks.
+ */
+static ScanCase const cases[] = {
+    { "find pipe", find_offset, SCAN_PIPE, false },
+    { "skip spaces", skip_offset, SCAN_SPACE, true },
+    { "count newlines", scan_count, SCAN_NEWLINE, false },
+    { "count words", scan_count_runs, SCAN_SPACE, false },
+    { "count stages", scan_count_runs, SCAN_PIPE, false },
+};
+
+#define CASE_COUNT (sizeof cases / sizeof *cases)
+
+static double elapsed_secs(
+    struct timespec const* const begin,
+    struct timespec const* const end
+) {
+    return (double) (end->tv_sec - begin->tv_sec) +
+        (double) (end->tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+/**
+ * Checks that every kernel agrees with the portable one, on every length and
+ * alignment up to @p MAX_CHECKED_LEN, so that both the vectors and the tails
+ * are covered.
+ */
+static bool check(char const* const text, ScanIsa const widest) {
+    for (size_t c = 0ul; c < CASE_COUNT; ++c) {
+        for (size_t off = 0ul; off < 32ul; ++off) {
+            for (size_t len = 0ul; len <= MAX_CHECKED_LEN; ++len) {
+                char const* const begin = text + off;
+                scan_limit_isa(SCAN_ISA_PORTABLE);
+                size_t const expected =
+                    cases[c].fn(begin, begin + len, cases[c].classes);
+                for (int isa = SCAN_ISA_SSE2; isa <= (int) widest; ++isa) {
+                    scan_limit_isa((ScanIsa) isa);
+                    size_t const got =
+                        cases[c].fn(begin, begin + len, cases[c].classes);
+                    if (got != expected) {
+                        program_eprintln(
+                            "%s: %s gave %zu instead of %zu, at offset %zu "
+                                "and length %zu.",
+                            cases[c].name,
+                            isa_names[isa],
+                            got,
+                            expected,
+                            off,
+                            len
+                        );
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Prints the bytes per second of each kernel, scanning @p len bytes of
+ * @p text, or of @p blank, at a time.
+ */
+static void run(
+    char const* const text,
+    char const* const blank,
+    size_t const len,
+    ScanIsa const widest
+) {
+    size_t const reps = BYTES_PER_RUN / len;
+    for (size_t c = 0ul; c < CASE_COUNT; ++c) {
+        char const* const buf = cases[c].is_blank ? blank : text;
+        printf("%7zu B %-15s", len, cases[c].name);
+        for (int isa = SCAN_ISA_PORTABLE; isa <= (int) widest; ++isa) {
+            scan_limit_isa((ScanIsa) isa);
+            struct timespec begin;
+            struct timespec end;
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+            for (size_t i = 0ul; i < reps; ++i) {
+                sink = cases[c].fn(buf, buf + len, cases[c].classes);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double const gib_per_sec = (double) reps * (double) len /
+                elapsed_secs(&begin, &end) / (double) (1ul << 30ul);
+            printf(" %s %6.2f GiB/s", isa_names[isa], gib_per_sec);
+        }
+        putchar('\n');
+    }
+}
+
+int main(void) {
+    char* const text = malloc(LARGE_SIZE);
+    char* const blank = malloc(LARGE_SIZE);
+    if (!text || !blank) {
+        program_eprintln("Failed allocating text: %s.", strerror(errno));
+        free(text);
+        free(blank);
+        return EXIT_FAILURE;
+    }
+    uint64_t state = 0x9e3779b97f4a7c15u;
+    ScanIsa const widest = scan_limit_isa(SCAN_ISA_AVX2);
+
+    fill_text(text, MAX_CHECKED_LEN + 32ul, true, &state);
+    if (!check(text, widest)) {
+        free(text);
+        free(blank);
+        return EXIT_FAILURE;
+    }
+    printf(
+        "Every kernel up to %s agrees with the portable one.\n",
+        isa_names[widest]
+    );
+
+    fill_text(text, LARGE_SIZE, false, &state);
+    for (size_t i = 0ul; i < LARGE_SIZE; ++i) {
+        blank[i] = i % 8ul == 7ul ? '\t' : ' ';
+    }
+    run(text, blank, SMALL_SIZE, widest);
+    run(text, blank, LARGE_SIZE, widest);
+    free(text);
+    free(blank);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#define _GNU_SOURCE
+
+#include "comfy_io.h"
+#include "task/task_idx.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The least number of operations timed per measurement, so that the small
+ * indexes are measured over as many repetitions as it takes.
+ */
+#define MIN_OPS 4000000ul
+
+static char const* const program_name = "bench_task_idx";
+
+/**
+ * Keeps the compiler from discarding lookups whose results aren't used.
+ */
+static volatile size_t sink;
+
+static uint64_t next_random(uint64_t* const state) {
+    *state ^= *state << 13u;
+    *state ^= *state >> 7u;
+    *state ^= *state << 17u;
+    return *state;
+}
+
+static double elapsed_ns(
+    struct timespec const* const begin,
+    struct timespec const* const end
+) {
+    return (double) (end->tv_sec - begin->tv_sec) * 1e9 +
+        (double) (end->tv_nsec - begin->tv_nsec);
+}
+
+/**
+ * Indexes @p len task ids, given out in increasing order as the server does,
+ * looks each up, in a random order, both present and absent, and removes them,
+ * in a random order, and prints the nanoseconds each operation takes.
+ */
+static bool run(size_t const len) {
+    size_t* const order = malloc(len * sizeof *order);
+    if (!order) {
+        program_eprintln("Failed allocating ids: %s.", strerror(errno));
+        return false;
+    }
+    uint64_t state = 0x9e3779b97f4a7c15u;
+    for (size_t i = 0ul; i < len; ++i) {
+        order[i] = i;
+    }
+    for (size_t i = len - 1ul; i > 0ul; --i) {
+        size_t const j = (size_t) (next_random(&state) % (i + 1ul));
+        size_t const tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    size_t const reps = len < MIN_OPS ? MIN_OPS / len : 1ul;
+
+    double put_ns = 0.0;
+    double hit_ns = 0.0;
+    double miss_ns = 0.0;
+    double rm_ns = 0.0;
+    for (size_t rep = 0ul; rep < reps; ++rep) {
+        TaskIdx idx;
+        tidx_new(&idx);
+        struct timespec begin;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t i = 0ul; i < len; ++i) {
+            if (!tidx_put(&idx, i, i)) {
+                program_eprintln("Failed indexing: %s.", strerror(errno));
+                tidx_drop(&idx);
+                free(order);
+                return false;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        put_ns += elapsed_ns(&begin, &end);
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t i = 0ul; i < len; ++i) {
+            size_t found;
+            if (tidx_get(&idx, order[i], &found)) {
+                sink = found;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        hit_ns += elapsed_ns(&begin, &end);
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t i = 0ul; i < len; ++i) {
+            size_t found;
+            if (tidx_get(&idx, len + order[i], &found)) {
+                sink = found;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        miss_ns += elapsed_ns(&begin, &end);
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t i = 0ul; i < len; ++i) {
+            tidx_rm(&idx, order[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        rm_ns += elapsed_ns(&begin, &end);
+
+        if (tidx_len(&idx) != 0ul) {
+            program_eprintln(
+                "%zu ids left after removing all.",
+                tidx_len(&idx)
+            );
+            tidx_drop(&idx);
+            free(order);
+            return false;
+        }
+        tidx_drop(&idx);
+    }
+    free(order);
+
+    double const ops = (double) len * (double) reps;
+    printf(
+        "%8zu tasks: insert %6.1f ns, lookup hit %6.1f ns, "
+            "lookup miss %6.1f ns, remove %6.1f ns\n",
+        len,
+        put_ns / ops,
+        hit_ns / ops,
+        miss_ns / ops,
+        rm_ns / ops
+    );
+    return true;
+}
+
+int main(void) {
+    static size_t const lens[] = { 1000ul, 100000ul, 1000000ul };
+    for (size_t i = 0ul; i < sizeof lens / sizeof *lens; ++i) {
+        if (!run(lens[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
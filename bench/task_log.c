@@ -0,0 +1,525 @@
+#define _GNU_SOURCE
+
+#include "codec/lz.h"
+#include "comfy_io.h"
+#include "task/task_log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/sendfile.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The size of the buffer each kind of output is cut from.
+ */
+#define SOURCE_SIZE (1ul << 20ul)
+
+/**
+ * The number of output bytes each measurement logs.
+ */
+#define BYTES_PER_RUN (32ul << 20ul)
+
+/**
+ * The number of bytes each frame size is measured over.
+ */
+#define BYTES_PER_FRAME_RUN (256ul << 20ul)
+
+/**
+ * The names of the uncompressed log and its index, as the log was before it
+ * was compressed, for a baseline.
+ */
+#define RAW_FILENAME "raw.log"
+#define RAW_IDX_FILENAME "raw.log.idx"
+
+static char const* const program_name = "bench_task_log";
+
+/**
+ * Keeps the compiler from discarding decompressions whose results aren't used.
+ */
+static volatile bool sink;
+
+static uint64_t next_random(uint64_t* const state) {
+    *state ^= *state << 13u;
+    *state ^= *state >> 7u;
+    *state ^= *state << 17u;
+    return *state;
+}
+
+/**
+ * Fills @p buf with log lines, as most tasks print: a timestamp, a level, and
+ * a message from a handful, with varying numbers.
+ */
+static void fill_lines(
+    char* const buf,
+    size_t const len,
+    uint64_t* const state
+) {
+    static char const* const levels[] = { "INFO", "INFO", "DEBUG", "WARN" };
+    static char const* const msgs[] = {
+        "processed %u items in %u ms",
+        "connected to 10.0.%u.%u",
+        "cache miss for key user:%u:%u",
+        "retrying request %u after %u ms",
+    };
+    size_t pos = 0ul;
+    unsigned secs = 0u;
+    while (pos < len) {
+        uint64_t const r = next_random(state);
+        secs += (unsigned) (r % 3u);
+        char line[128];
+        int const prefix_len = snprintf(
+            line,
+            sizeof line,
+            "2026-10-16 12:%02u:%02u %-5s worker %2u: ",
+            secs / 60u % 60u,
+            secs % 60u,
+            levels[r % 4u],
+            (unsigned) (r >> 8u) % 16u
+        );
+        int const msg_len = snprintf(
+            line + prefix_len,
+            sizeof line - (size_t) prefix_len,
+            msgs[(r >> 16u) % 4u],
+            (unsigned) (r >> 24u) % 10000u,
+            (unsigned) (r >> 40u) % 1000u
+        );
+        size_t line_len = (size_t) (prefix_len + msg_len);
+        line[line_len++] = '\n';
+        size_t const copied = len - pos < line_len ? len - pos : line_len;
+        memcpy(buf + pos, line, copied);
+        pos += copied;
+    }
+}
+
+/**
+ * Fills @p buf with random bytes, as in already compressed output.
+ */
+static void fill_random(
+    char* const buf,
+    size_t const len,
+    uint64_t* const state
+) {
+    for (size_t i = 0ul; i < len; ++i) {
+        buf[i] = (char) (next_random(state) >> 32u);
+    }
+}
+
+/**
+ * Fills @p buf with the same line over and over, as a progress indicator.
+ */
+static void fill_repetitive(
+    char* const buf,
+    size_t const len,
+    uint64_t* const state
+) {
+    (void) state;
+
+    static char const line[] = "waiting for the lock on /var/lib/argus...\n";
+    for (size_t i = 0ul; i < len; ++i) {
+        buf[i] = line[i % (sizeof line - 1ul)];
+    }
+}
+
+typedef void (*FillFn)(char* buf, size_t len, uint64_t* state);
+
+typedef struct OutputKind {
+    char const* name;   //!< What the output is like.
+    FillFn fill;    //!< Fills a buffer with such output.
+} OutputKind;
+
+static OutputKind const kinds[] = {
+    { "lines", fill_lines },
+    { "random", fill_random },
+    { "repetitive", fill_repetitive },
+};
+
+#define KIND_COUNT (sizeof kinds / sizeof *kinds)
+
+static double elapsed_secs(
+    struct timespec const* const begin,
+    struct timespec const* const end
+) {
+    return (double) (end->tv_sec - begin->tv_sec) +
+        (double) (end->tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+static bool write_all(int const fd, char const* const buf, size_t const len) {
+    size_t pos = 0ul;
+    while (pos < len) {
+        ssize_t const written = write(fd, buf + pos, len - pos);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        pos += (size_t) written;
+    }
+    return true;
+}
+
+/**
+ * Copies @p len bytes from the start of @p in_fd to @p out_fd at @p out_off,
+ * as the log did before it was compressed, falling back to
+ * <tt>sendfile()</tt> if the file system can't <tt>copy_file_range()</tt>.
+ */
+static bool copy_range(
+    int const in_fd,
+    int const out_fd,
+    uint64_t const out_off,
+    uint64_t const len
+) {
+    off_t in_pos = 0;
+    off_t out_pos = (off_t) out_off;
+    bool can_copy_range = true;
+    while ((uint64_t) in_pos < len) {
+        size_t const left = (size_t) (len - (uint64_t) in_pos);
+        ssize_t copied;
+        if (can_copy_range) {
+            copied = copy_file_range(in_fd, &in_pos, out_fd, &out_pos, left, 0);
+            if (copied == -1l &&
+                (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP ||
+                    errno == EINVAL)
+            ) {
+                can_copy_range = false;
+                continue;
+            }
+        } else {
+            if (lseek(out_fd, out_pos, SEEK_SET) == -1) {
+                return false;
+            }
+            copied = sendfile(out_fd, in_fd, &in_pos, left);
+            if (copied > 0l) {
+                out_pos += copied;
+            }
+        }
+        if (copied == -1l && errno == EINTR) {
+            continue;
+        }
+        if (copied <= 0l) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Logs @p outputs outputs of @p output_len bytes cut from @p source, each
+ * spooled, then appended, as the server does once a task finishes, and
+ * stores the seconds taken and the log's length.
+ */
+static bool log_framed(
+    char const* const dirname,
+    char const* const source,
+    size_t const output_len,
+    size_t const outputs,
+    double* const secs,
+    uint64_t* const log_len
+) {
+    TaskLog log;
+    TaskLogOutcome outcome = tlog_open(&log, dirname);
+    if (outcome != TLOG_OK) {
+        program_eprintln(
+            "Failed opening the log: %s.",
+            tlog_outcome_msg(outcome, &errno)
+        );
+        return false;
+    }
+
+    struct timespec begin;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0ul; outcome == TLOG_OK && i < outputs; ++i) {
+        size_t const off = i * output_len % (SOURCE_SIZE - output_len + 1ul);
+        int spool_fd;
+        outcome = tlog_spool(&log, &spool_fd);
+        if (outcome != TLOG_OK) {
+            break;
+        }
+        if (!write_all(spool_fd, source + off, output_len)) {
+            outcome = TLOG_ERR_WRITE_FAIL;
+        } else {
+            outcome = tlog_append(&log, i, spool_fd);
+        }
+        close(spool_fd);
+    }
+    if (outcome == TLOG_OK) {
+        outcome = tlog_flush(&log);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *secs = elapsed_secs(&begin, &end);
+    *log_len = log.log_len;
+    TaskLogOutcome const close_outcome = tlog_close(&log);
+    if (outcome == TLOG_OK) {
+        outcome = close_outcome;
+    }
+    if (outcome != TLOG_OK) {
+        program_eprintln(
+            "Failed logging: %s.",
+            tlog_outcome_msg(outcome, &errno)
+        );
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Logs the same outputs as <tt>log_framed()</tt>, uncompressed, as the log
+ * did before: each spool file is copied within the kernel to the end of a
+ * plain log, then its index entry, of its offset plus one and its length, is
+ * written, and stores the seconds taken.
+ */
+static bool log_raw(
+    char const* const dirname,
+    char const* const source,
+    size_t const output_len,
+    size_t const outputs,
+    double* const secs
+) {
+    int const dir_fd = open(dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        program_eprintln("Failed opening %s: %s.", dirname, strerror(errno));
+        return false;
+    }
+    int const log_fd =
+        openat(dir_fd, RAW_FILENAME, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    int const idx_fd =
+        openat(dir_fd, RAW_IDX_FILENAME, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    bool is_ok = log_fd != -1 && idx_fd != -1;
+
+    uint64_t log_len = 0u;
+    struct timespec begin;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0ul; is_ok && i < outputs; ++i) {
+        size_t const off = i * output_len % (SOURCE_SIZE - output_len + 1ul);
+        int const spool_fd =
+            openat(dir_fd, ".", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        if (spool_fd == -1) {
+            is_ok = false;
+            break;
+        }
+        uint64_t entry[2] = { log_len + 1u, output_len };
+        is_ok = write_all(spool_fd, source + off, output_len) &&
+            copy_range(spool_fd, log_fd, log_len, output_len) &&
+            pwrite(idx_fd, entry, sizeof entry, (off_t) (i * sizeof entry)) ==
+                (ssize_t) sizeof entry;
+        log_len += output_len;
+        close(spool_fd);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *secs = elapsed_secs(&begin, &end);
+    if (!is_ok) {
+        program_eprintln("Failed logging raw: %s.", strerror(errno));
+    }
+    if (log_fd != -1) {
+        close(log_fd);
+    }
+    if (idx_fd != -1) {
+        close(idx_fd);
+    }
+    close(dir_fd);
+    return is_ok;
+}
+
+static void remove_logs(char const* const dirname) {
+    int const dir_fd = open(dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd != -1) {
+        unlinkat(dir_fd, TLOG_FILENAME, 0);
+        unlinkat(dir_fd, TLOG_IDX_FILENAME, 0);
+        unlinkat(dir_fd, TLOG_IDS_FILENAME, 0);
+        unlinkat(dir_fd, RAW_FILENAME, 0);
+        unlinkat(dir_fd, RAW_IDX_FILENAME, 0);
+        close(dir_fd);
+    }
+    rmdir(dirname);
+}
+
+/**
+ * Logs outputs of @p output_len bytes cut from @p source both uncompressed
+ * and in compressed frames, and prints the output bytes logged per second of
+ * each, and how much smaller the compressed log is than the outputs.
+ */
+static bool run_log(
+    char const* const name,
+    char const* const source,
+    size_t const output_len
+) {
+    char dirname[] = "/tmp/bench_task_log.XXXXXX";
+    if (!mkdtemp(dirname)) {
+        program_eprintln("Failed creating a directory: %s.", strerror(errno));
+        return false;
+    }
+    size_t const outputs = BYTES_PER_RUN / output_len;
+    double raw_secs;
+    double framed_secs;
+    uint64_t log_len;
+    bool const is_ok =
+        log_raw(dirname, source, output_len, outputs, &raw_secs) &&
+        log_framed(
+            dirname,
+            source,
+            output_len,
+            outputs,
+            &framed_secs,
+            &log_len
+        );
+    remove_logs(dirname);
+    if (!is_ok) {
+        return false;
+    }
+
+    double const mib = (double) outputs * (double) output_len /
+        (double) (1ul << 20ul);
+    printf(
+        "%-10s %7zu B outputs: raw %7.1f MiB/s, framed %7.1f MiB/s, "
+            "ratio %6.2f\n",
+        name,
+        output_len,
+        mib / raw_secs,
+        mib / framed_secs,
+        (double) outputs * (double) output_len / (double) log_len
+    );
+    return true;
+}
+
+/**
+ * Compresses @p source cut into frames of @p frame_size bytes, each with its
+ * header, as <tt>tlog_flush()</tt> does, then decompresses them, and prints
+ * the ratio and the bytes per second each way.
+ */
+static bool run_frames(
+    char const* const name,
+    char const* const source,
+    size_t const frame_size,
+    char* const packed,
+    char* const unpacked
+) {
+    size_t const frames = SOURCE_SIZE / frame_size;
+    size_t const reps = BYTES_PER_FRAME_RUN / SOURCE_SIZE;
+    size_t* const packed_lens = malloc(frames * sizeof *packed_lens);
+    if (!packed_lens) {
+        program_eprintln("Failed allocating lengths: %s.", strerror(errno));
+        return false;
+    }
+    size_t const packed_cap = lz_bound(frame_size);
+
+    size_t total_len = 0ul;
+    struct timespec begin;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t rep = 0ul; rep < reps; ++rep) {
+        total_len = 0ul;
+        for (size_t i = 0ul; i < frames; ++i) {
+            size_t const len = lz_compress(
+                source + i * frame_size,
+                frame_size,
+                packed + i * packed_cap
+            );
+            packed_lens[i] = len;
+            // frames that don't compress are stored as they are
+            if (len >= frame_size) {
+                packed_lens[i] = frame_size;
+                memcpy(
+                    packed + i * packed_cap,
+                    source + i * frame_size,
+                    frame_size
+                );
+            }
+            total_len += TLOG_FRAME_HEADER_SIZE + packed_lens[i];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const compress_secs = elapsed_secs(&begin, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t rep = 0ul; rep < reps; ++rep) {
+        for (size_t i = 0ul; i < frames; ++i) {
+            if (packed_lens[i] < frame_size) {
+                sink = lz_decompress(
+                    packed + i * packed_cap,
+                    packed_lens[i],
+                    unpacked + i * frame_size,
+                    frame_size
+                );
+            } else {
+                memcpy(
+                    unpacked + i * frame_size,
+                    packed + i * packed_cap,
+                    frame_size
+                );
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const decompress_secs = elapsed_secs(&begin, &end);
+    free(packed_lens);
+
+    if (memcmp(source, unpacked, frames * frame_size) != 0) {
+        program_eprintln("The %s frames didn't round trip.", name);
+        return false;
+    }
+
+    double const bytes = (double) reps * (double) SOURCE_SIZE;
+    double const mib = (double) (1ul << 20ul);
+    printf(
+        "%-10s %5zu KiB frames: ratio %6.2f, compress %7.1f MiB/s, "
+            "decompress %7.1f MiB/s\n",
+        name,
+        frame_size >> 10ul,
+        (double) SOURCE_SIZE / (double) total_len,
+        bytes / compress_secs / mib,
+        bytes / decompress_secs / mib
+    );
+    return true;
+}
+
+int main(void) {
+    static size_t const output_lens[] = { 256ul, 16384ul, 1048576ul };
+    static size_t const frame_sizes[] = { 4096ul, 16384ul, LZ_MAX_BLOCK_SIZE };
+
+    char* const source = malloc(SOURCE_SIZE);
+    // the smallest frames have the most room to spare in total
+    char* const packed =
+        malloc(SOURCE_SIZE / frame_sizes[0] * lz_bound(frame_sizes[0]));
+    char* const unpacked = malloc(SOURCE_SIZE);
+    if (!source || !packed || !unpacked) {
+        program_eprintln("Failed allocating buffers: %s.", strerror(errno));
+        free(source);
+        free(packed);
+        free(unpacked);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t state = 0x9e3779b97f4a7c15u;
+    bool is_ok = true;
+    for (size_t k = 0ul; is_ok && k < KIND_COUNT; ++k) {
+        kinds[k].fill(source, SOURCE_SIZE, &state);
+        for (size_t i = 0ul; is_ok && i < 3ul; ++i) {
+            is_ok = run_log(kinds[k].name, source, output_lens[i]);
+        }
+        for (size_t i = 0ul; is_ok && i < 3ul; ++i) {
+            is_ok = run_frames(
+                kinds[k].name,
+                source,
+                frame_sizes[i],
+                packed,
+                unpacked
+            );
+        }
+    }
+
+    free(source);
+    free(packed);
+    free(unpacked);
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
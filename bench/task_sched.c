@@ -0,0 +1,161 @@
+#define _GNU_SOURCE
+
+#include "comfy_io.h"
+#include "task/task_queue.h"
+#include "task/task_sched.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The number of tasks pending at once, as after a large batch.
+ */
+#define BACKLOG 100000ul
+
+/**
+ * The number of times each backlog is pushed and popped.
+ */
+#define REPS 10ul
+
+static char const* const program_name = "bench_task_sched";
+
+static char const cmd[] = "grep -c argus /usr/share/dict/words";
+
+static TaskLimits const limits = {
+    .memory_mib = 0u,
+    .cpu_percent = 0u,
+    .pids = 0u
+};
+
+static double elapsed_ns(
+    struct timespec const* const begin,
+    struct timespec const* const end
+) {
+    return (double) (end->tv_sec - begin->tv_sec) * 1e9 +
+        (double) (end->tv_nsec - begin->tv_nsec);
+}
+
+static void print_result(
+    char const* const name,
+    double const push_ns,
+    double const pop_ns
+) {
+    double const ops = (double) BACKLOG * (double) REPS;
+    printf(
+        "%-28s push %6.1f ns/task, pop %6.1f ns/task\n",
+        name,
+        push_ns / ops,
+        pop_ns / ops
+    );
+}
+
+/**
+ * Times the plain first in, first out queue the scheduler replaced, as a
+ * baseline.
+ */
+static bool run_queue(void) {
+    double push_ns = 0.0;
+    double pop_ns = 0.0;
+    for (size_t rep = 0ul; rep < REPS; ++rep) {
+        TaskQueue queue;
+        tqueue_new(&queue);
+        struct timespec begin;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t i = 0ul; i < BACKLOG; ++i) {
+            if (!tqueue_push(&queue, i, cmd, sizeof cmd - 1ul, &limits)) {
+                program_eprintln("Failed queueing: %s.", strerror(errno));
+                tqueue_drop(&queue);
+                return false;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        push_ns += elapsed_ns(&begin, &end);
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        PendingTask task;
+        while (tqueue_pop(&queue, &task)) {
+            free(task.cmd);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        pop_ns += elapsed_ns(&begin, &end);
+        tqueue_drop(&queue);
+    }
+    print_result("queue", push_ns, pop_ns);
+    return true;
+}
+
+/**
+ * Times the scheduler, with the backlog's tasks submitted by @p owners owners,
+ * in turn, at @p levels priorities, in turn.
+ */
+static bool run_sched(size_t const owners, size_t const levels) {
+    double push_ns = 0.0;
+    double pop_ns = 0.0;
+    for (size_t rep = 0ul; rep < REPS; ++rep) {
+        TaskSched sched;
+        tsched_new(&sched);
+        struct timespec begin;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t i = 0ul; i < BACKLOG; ++i) {
+            if (!tsched_push(
+                &sched,
+                i % levels,
+                i % owners,
+                i,
+                cmd,
+                sizeof cmd - 1ul,
+                &limits
+            )) {
+                program_eprintln("Failed scheduling: %s.", strerror(errno));
+                tsched_drop(&sched);
+                return false;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        push_ns += elapsed_ns(&begin, &end);
+
+        size_t popped = 0ul;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        PendingTask task = { .cmd = NULL };
+        while (tsched_pop(&sched, &task)) {
+            free(task.cmd);
+            ++popped;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        pop_ns += elapsed_ns(&begin, &end);
+        tsched_drop(&sched);
+        if (popped != BACKLOG) {
+            program_eprintln(
+                "Popped %zu tasks out of %zu.",
+                popped,
+                BACKLOG
+            );
+            return false;
+        }
+    }
+    char name[64];
+    snprintf(
+        name,
+        sizeof name,
+        "sched, %zu owners, %zu levels",
+        owners,
+        levels
+    );
+    print_result(name, push_ns, pop_ns);
+    return true;
+}
+
+int main(void) {
+    bool const is_ok = run_queue() &&
+        run_sched(1ul, 1ul) &&
+        run_sched(16ul, TSCHED_LEVELS) &&
+        run_sched(1024ul, TSCHED_LEVELS);
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
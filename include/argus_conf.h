@@ -5,21 +5,34 @@
 #define END_TASK_FLAG 't'
 #define SET_ACTIVE_TIMEOUT_FLAG 'm'
 #define SET_INACTIVE_TIMEOUT_FLAG 'i'
+#define SET_MAX_RUNNING_FLAG 'c'
 #define LIST_RUNNING_TASKS_FLAG 'l'
 #define LIST_FINISHED_TASKS_FLAG 'r'
 #define HELP_FLAG 'h'
+#define BATCH_FILE_FLAG 'f'
+#define PRIORITY_FLAG 'p'
+#define OUTPUT_FLAG 'o'
+
+#define REPLY_FIFONAME_SIZE 64ul
 
 char const* const server_dirname = "/tmp/argus";
 char const* const commands_fifoname = "/tmp/argus/commands";
-char const* const running_tasks_fifoname = "/tmp/argus/running_tasks";
-char const* const finished_tasks_fifoname = "/tmp/argus/finished_tasks";
+char const* const commands_socketname = "/tmp/argus/commands.sock";
+char const* const reply_fifoname_fmt = "/tmp/argus/reply.%u";
+char const* const running_tasks_shmname = "/argus_running_tasks";
+char const* const tasks_cgroup_name = "argus";
 
 char const* const exec_task_cmd = "executar";
 char const* const end_task_cmd = "terminar";
 char const* const set_active_timeout_cmd = "tempo-execucao";
 char const* const set_inactive_timeout_cmd = "tempo-inactividade";
+char const* const set_max_running_cmd = "max-concorrentes";
 char const* const list_running_tasks_cmd = "listar";
 char const* const list_finished_tasks_cmd = "historico";
+char const* const output_cmd = "output";
 char const* const help_cmd = "ajuda";
+char const* const memory_limit_word = "memoria=";
+char const* const cpu_limit_word = "cpu=";
+char const* const pids_limit_word = "processos=";
 
 #endif  // ARGUS_CONF_H
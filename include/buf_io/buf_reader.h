@@ -12,12 +12,17 @@
 /**
  * A wrapper around a file descriptor opened with read mode that provides
  * buffered reading.
+ * The buffered bytes may wrap around the end of the circular buffer, so that
+ * consuming them never moves the rest, and the free space, which may wrap too,
+ * is refilled with a single <tt>readv(2)</tt>.
  */
 typedef struct BufReader {
     int file_des;   //!< The underlying file descriptor.
     char* buf;  //!< The underlying intermediary circular buffer.
-    size_t begin;   //!< The index of the first character of the buffer.
-    size_t end; //!< The index of the past the end character of the buffer.
+    size_t begin;   //!< The index of the first character of the buffer, less
+                    //!< than @p cap.
+    size_t end; //!< The index of the past the end character of the buffer, at
+                //!< most <tt>begin + cap</tt>, taken modulo @p cap.
     size_t cap; //!< The buffer's maximum capacity.
 } BufReader;
 
@@ -26,7 +31,7 @@ typedef struct BufReader {
  */
 typedef enum BrOutcome {
     BR_OK,  //!< No error
-    // BR_EOF, //!< End of file reached while reading from the file.
+    BR_EOF, //!< End of file reached while reading from the file.
     BR_ERR_ALLOC_FAIL,  //!< Error occurred while allocating dynamic memory.
     BR_ERR_READ_FAIL,   //!< Error occurred while reading from a file.
     BR_ERR_CLOSE_FAIL,  //!< Error occurred while closing a file.
@@ -39,7 +44,7 @@ typedef enum BrOutcome {
  * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
  * made:
  * 1. <tt>assert(init != NULL)</tt>;
- * 2. <tt>assert(file_des > 0)</tt>.
+ * 2. <tt>assert(file_des >= 0)</tt>.
  * <tt>O(malloc(default capacity))</tt> complexity.
  * @param init (output parameter) address of the BufReader to initialize.
  * <b>Must not be @p NULL.</b>
@@ -55,7 +60,7 @@ BrOutcome br_with_default_cap(BufReader* init, int file_des);
  * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
  * made:
  * 1. <tt>assert(init != NULL)</tt>;
- * 2. <tt>assert(file_des > 0)</tt>;
+ * 2. <tt>assert(file_des >= 0)</tt>;
  * 3. <tt>assert(capacity > 0ul)</tt>.
  * <tt>O(malloc(capacity))</tt> complexity.
  * @param init (output parameter) address of the BufReader to initialize.
@@ -74,7 +79,7 @@ BrOutcome br_with_cap(BufReader* init, int file_des, size_t capacity);
  * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
  * made:
  * 1. <tt>assert(init != NULL)</tt>;
- * 2. <tt>assert(file_des > 0)</tt>;
+ * 2. <tt>assert(file_des >= 0)</tt>;
  * 3. <tt>assert(buf != NULL)</tt>;
  * 4. <tt>assert(buf_size > 0ul).
  * <tt>O(1)</tt> complexity.
@@ -170,7 +175,7 @@ char* br_replace_buf(
  * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
  * are made:
  * 1. <tt>assert(self != NULL)</tt>;
- * 2. <tt>assert(new_file_des > 0)</tt>.
+ * 2. <tt>assert(new_file_des >= 0)</tt>.
  * <tt>O(1)</tt> complexity.
  * @param self address of the BufReader whose underlying file descriptor shall
  * be replaced. <b>Must not be @p NULL.</b>
@@ -325,10 +330,54 @@ BrOutcome br_read_line(
  * shall be read.
  * <b>Must not be @p NULL.</b>
  * @return @p BR_ERR_READ_FAIL if a file read occurs and fails, otherwise
- * @p BW_OK.
+ * @p BR_EOF if the file has no more characters, otherwise @p BR_OK.
  */
 BrOutcome br_read_char(BufReader* restrict self, char* restrict c);
 
+/**
+ * Returns the next line, including its newline, as a slice of the BufReader's
+ * buffer, without copying it, reading from the file until it's complete.
+ * The line isn't consumed: that's left to <tt>br_consume()</tt>, so that it's
+ * only consumed once handled. The slice stays valid until the BufReader is
+ * next read from, even once consumed.
+ * The last line may have no newline, and a line longer than the BufReader's
+ * capacity is returned in parts, each as long as the capacity, without a
+ * newline.
+ * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(line != NULL)</tt>;
+ * 3. <tt>assert(line_len != NULL)</tt>.
+ * Amortized <tt>O(line length)</tt> complexity.
+ * @param self address of the BufReader from which the line is peeked.
+ * <b>Must not be @p NULL.</b>
+ * @param line (output parameter) address to which the line's address is
+ * stored. <b>Must not be @p NULL.</b>
+ * @param line_len (output parameter) address to which the line's length is
+ * stored. <b>Must not be @p NULL.</b>
+ * @return @p BR_ERR_READ_FAIL if a file read occurs and fails, otherwise
+ * @p BR_EOF if there are no more lines, otherwise @p BR_OK.
+ */
+BrOutcome br_peek_line(
+    BufReader* restrict self,
+    char const** restrict line,
+    size_t* restrict line_len
+);
+
+/**
+ * Consumes @p n buffered bytes, e.g. those of a line returned by
+ * <tt>br_peek_line()</tt>.
+ * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(n <= br_available_bytes(self))</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the BufReader. <b>Must not be @p NULL.</b>
+ * @param n the amount of bytes to consume. <b>Must be at most
+ * <tt>br_available_bytes(self)</tt>.</b>
+ */
+void br_consume(BufReader* self, size_t n);
+
 /**
  * Returns the message associated with the BrOutcome.
  * If @p BUF_READER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
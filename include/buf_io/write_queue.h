@@ -0,0 +1,154 @@
+#ifndef BUF_IO_WRITE_QUEUE_H
+#define BUF_IO_WRITE_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define WRITE_QUEUE_RUNTIME_ASSERTS 0
+
+/**
+ * A growable queue of bytes pending to be written to a non blocking file
+ * descriptor. Unlike a BufWriter, pushing never writes, and flushing stops as
+ * soon as the file descriptor would block, so that the caller may retry when
+ * it becomes writable.
+ * The queue may end with a range of a file, which is written after the bytes
+ * without entering user space.
+ */
+typedef struct WriteQueue {
+    char* buf;  //!< The underlying dynamically allocated buffer.
+    size_t begin;   //!< The index of the first pending byte.
+    size_t end; //!< The index of the past the last pending byte.
+    size_t cap; //!< The buffer's capacity.
+    int file_des;   //!< The file of the pending range, or @p -1 if none.
+    uint64_t file_off;  //!< The offset of the range's first pending byte.
+    uint64_t file_left; //!< The number of the range's pending bytes.
+} WriteQueue;
+
+/**
+ * An outcome returned by WriteQueue functions.
+ */
+typedef enum WqOutcome {
+    WQ_OK,  //!< No error.
+    WQ_PENDING, //!< The file descriptor would block before the queue emptied.
+    WQ_ERR_ALLOC_FAIL,  //!< Error occurred while allocating dynamic memory.
+    WQ_ERR_WRITE_FAIL,  //!< Error occurred while writing to a file.
+    WQ_ERR_BAD_RANGE,  //!< The file range can't be queued.
+} WqOutcome;
+
+/**
+ * Creates an empty WriteQueue. No memory is allocated until bytes are pushed.
+ * The WriteQueue must later be passed to <tt>wq_drop()</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param init (output parameter) address of the WriteQueue to initialize.
+ * <b>Must not be @p NULL.</b>
+ */
+void wq_new(WriteQueue* init);
+
+/**
+ * Deallocates the WriteQueue's buffer, discarding any pending bytes.
+ * <tt>O(free(self->buf))</tt> complexity.
+ * @param self address of the WriteQueue to drop. <b>Must not be @p NULL.</b>
+ */
+void wq_drop(WriteQueue* self);
+
+/**
+ * Returns the amount of bytes pending to be written, including those of the
+ * file range.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the WriteQueue. <b>Must not be @p NULL.</b>
+ * @return the amount of pending bytes.
+ */
+size_t wq_pending_bytes(WriteQueue const* self);
+
+/**
+ * Checks if the WriteQueue has no pending bytes.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the WriteQueue. <b>Must not be @p NULL.</b>
+ * @return @p true if there are no pending bytes, @p false otherwise.
+ */
+bool wq_is_empty(WriteQueue const* self);
+
+/**
+ * Appends @p n bytes of @p buf to the WriteQueue, without writing them.
+ * If @p WRITE_QUEUE_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(buf != NULL || n == 0ul)</tt>.
+ * Amortized <tt>O(n)</tt> complexity.
+ * @param self address of the WriteQueue. <b>Must not be @p NULL.</b>
+ * @param buf the bytes to append. <b>Must not be @p NULL.</b>
+ * @param n the amount of bytes to append.
+ * @return @p WQ_ERR_ALLOC_FAIL if memory allocation fails, otherwise @p WQ_OK.
+ */
+WqOutcome wq_push(WriteQueue* restrict self, char const* restrict buf, size_t n);
+
+/**
+ * Appends @p n bytes of @p buf and a newline character to the WriteQueue,
+ * without writing them.
+ * Amortized <tt>O(n)</tt> complexity.
+ * @param self address of the WriteQueue. <b>Must not be @p NULL.</b>
+ * @param buf the bytes to append. <b>Must not be @p NULL.</b>
+ * @param n the amount of bytes to append, excluding the newline.
+ * @return @p WQ_ERR_ALLOC_FAIL if memory allocation fails, otherwise @p WQ_OK.
+ */
+WqOutcome wq_push_line(
+    WriteQueue* restrict self,
+    char const* restrict buf,
+    size_t n
+);
+
+/**
+ * Appends @p len bytes of @p file_des, starting at @p offset, to the
+ * WriteQueue, without reading them. The file must stay open until they're
+ * written, and nothing else may be pushed until then.
+ * If @p WRITE_QUEUE_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(self->file_des == -1)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the WriteQueue. <b>Must not be @p NULL.</b>
+ * @param file_des the file to read from, which must support
+ * <tt>splice()</tt>.
+ * @param offset the offset of the range's first byte.
+ * @param len the range's length.
+ * @return @p WQ_ERR_BAD_RANGE if a file range is still pending or the range
+ * ends past the largest file offset, otherwise @p WQ_OK.
+ */
+WqOutcome wq_push_file(
+    WriteQueue* self,
+    int file_des,
+    uint64_t offset,
+    uint64_t len
+);
+
+/**
+ * Writes as many pending bytes as possible to @p file_des, which should be
+ * non blocking. The file range is moved with <tt>splice()</tt> if
+ * @p file_des is a pipe, or with <tt>sendfile()</tt> otherwise.
+ * <tt>O(wq_pending_bytes(self))</tt> complexity.
+ * @param self address of the WriteQueue. <b>Must not be @p NULL.</b>
+ * @param file_des the file descriptor to write to.
+ * @return @p WQ_ERR_WRITE_FAIL if a write fails, otherwise @p WQ_PENDING if
+ * the file descriptor would block before all bytes were written, otherwise
+ * @p WQ_OK.
+ */
+WqOutcome wq_flush(WriteQueue* self, int file_des);
+
+/**
+ * Returns the message associated with the WqOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the WqOutcome whose associated message is returned. If not a
+ * valid WqOutcome, a message describing that the outcome is unknown is
+ * returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the WqOutcome.
+ */
+char const* wq_outcome_msg(WqOutcome outcome, int const* opt_errno);
+
+#endif  // BUF_IO_WRITE_QUEUE_H
@@ -0,0 +1,72 @@
+#ifndef CODEC_LZ_H
+#define CODEC_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define LZ_RUNTIME_ASSERTS 0
+
+/**
+ * The maximum length of a block, so that every match offset fits in 16 bits.
+ */
+#define LZ_MAX_BLOCK_SIZE 65536ul
+
+/**
+ * Returns the maximum compressed length of a block of @p len bytes, i.e. of a
+ * block that doesn't compress at all.
+ * <tt>O(1)</tt> complexity.
+ * @param len the block's length.
+ * @return the maximum compressed length of the block.
+ */
+#define lz_bound(len) ((len) + (len) / 255ul + 16ul)
+
+/**
+ * Compresses a block with a greedy LZ77 parse, in the spirit of LZ4: a
+ * sequence of tokens, each a run of literals followed by a match of at least
+ * 4 bytes, found through a hash table of the block's 4 byte prefixes. It
+ * favors speed over ratio, and skips ahead faster the longer no match is
+ * found, so that incompressible data costs little.
+ * If @p LZ_RUNTIME_ASSERTS is set to @p 1, the following assertions are made:
+ * 1. <tt>assert(src != NULL || len == 0)</tt>;
+ * 2. <tt>assert(dst != NULL)</tt>;
+ * 3. <tt>assert(len <= LZ_MAX_BLOCK_SIZE)</tt>.
+ * <tt>O(len)</tt> complexity.
+ * @param src the block to compress.
+ * @param len the block's length. <b>Must not exceed @p LZ_MAX_BLOCK_SIZE.</b>
+ * @param dst (output parameter) address to which the compressed block is
+ * stored. <b>Must have room for <tt>lz_bound(len)</tt> bytes.</b>
+ * @return the compressed block's length.
+ */
+size_t lz_compress(
+    char const* restrict src,
+    size_t len,
+    char* restrict dst
+);
+
+/**
+ * Decompresses a block compressed by <tt>lz_compress()</tt>, checking every
+ * token against both buffers' bounds, so that a corrupt block is rejected
+ * rather than overflowing them.
+ * If @p LZ_RUNTIME_ASSERTS is set to @p 1, the following assertions are made:
+ * 1. <tt>assert(src != NULL || len == 0)</tt>;
+ * 2. <tt>assert(dst != NULL || dst_len == 0)</tt>.
+ * <tt>O(dst_len)</tt> complexity.
+ * @param src the compressed block.
+ * @param len the compressed block's length.
+ * @param dst (output parameter) address to which the block is stored.
+ * @param dst_len the block's length.
+ * @return @p true if the block decompressed to exactly @p dst_len bytes,
+ * otherwise @p false.
+ */
+bool lz_decompress(
+    char const* restrict src,
+    size_t len,
+    char* restrict dst,
+    size_t dst_len
+);
+
+#endif  // CODEC_LZ_H
@@ -0,0 +1,261 @@
+#ifndef PROTO_FRAME_H
+#define PROTO_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define FRAME_RUNTIME_ASSERTS 0
+
+/**
+ * The first byte of every frame, used to detect corrupt streams and resync.
+ */
+#define FRAME_MAGIC 0xA5u
+
+/**
+ * The version of the frame format. Frames with a different version are
+ * rejected.
+ */
+#define FRAME_VERSION 1u
+
+/**
+ * The size of an encoded FrameHeader.
+ */
+#define FRAME_HEADER_SIZE 16ul
+
+/**
+ * The maximum size of an encoded frame, header included. It's equal to the
+ * minimum @p PIPE_BUF mandated by POSIX, so that frames written to a fifo
+ * with a single <tt>write(2)</tt> are never interleaved with other writers'.
+ */
+#define FRAME_MAX_SIZE 4096ul
+
+/**
+ * The maximum size of a frame's payload.
+ */
+#define FRAME_MAX_PAYLOAD (FRAME_MAX_SIZE - FRAME_HEADER_SIZE)
+
+struct BufWriter;
+
+/**
+ * The operation requested by a frame.
+ */
+typedef enum FrameOpcode {
+    FRAME_OP_EXEC_TASK = 'e',   //!< Payload: the task's command line.
+    FRAME_OP_END_TASK = 't',    //!< Payload: the task id, as a u64.
+    FRAME_OP_SET_ACTIVE_TIMEOUT = 'm',  //!< Payload: the seconds, as a u64.
+    FRAME_OP_SET_INACTIVE_TIMEOUT = 'i',    //!< Payload: the seconds, as a u64.
+    FRAME_OP_SET_MAX_RUNNING = 'c', //!< Payload: the maximum number of
+                                    //!< running tasks, or 0 for no maximum,
+                                    //!< as a u64.
+    FRAME_OP_LIST_RUNNING_TASKS = 'l',  //!< No payload. Replied to the
+                                        //!< client's own fifo.
+    FRAME_OP_LIST_FINISHED_TASKS = 'r', //!< Payload: a HistoryQuery, or
+                                        //!< none. Replied to the client's own
+                                        //!< fifo.
+    FRAME_OP_GET_OUTPUT = 'o',  //!< Payload: the task id, as a u64. Replied to
+                                //!< the client's own fifo.
+} FrameOpcode;
+
+/**
+ * Flags of @p FRAME_OP_EXEC_TASK frames.
+ */
+typedef enum FrameExecFlags {
+    FRAME_EXEC_BATCH = 1u << 0u,    //!< The task is part of a batch, whose ids
+                                    //!< are replied to the client's own fifo.
+    FRAME_EXEC_BATCH_END = 1u << 1u,    //!< The batch is over. The frame's
+                                        //!< payload may be empty.
+    FRAME_EXEC_PRIORITY = 3u << 2u, //!< The task's priority, shifted by
+                                    //!< @p FRAME_EXEC_PRIORITY_SHIFT.
+    FRAME_EXEC_LIMITS = 1u << 4u,   //!< The payload starts with the task's
+                                    //!< resource limits, of
+                                    //!< @p FRAME_EXEC_LIMITS_SIZE bytes.
+} FrameExecFlags;
+
+/**
+ * The shift of the priority in the flags of @p FRAME_OP_EXEC_TASK frames.
+ * Priorities range from @p 0 to @p 3, and greater ones are launched first,
+ * when tasks are queued.
+ */
+#define FRAME_EXEC_PRIORITY_SHIFT 2u
+
+/**
+ * The priority of tasks submitted without one.
+ */
+#define FRAME_EXEC_DEFAULT_PRIORITY 1u
+
+/**
+ * The size of the resource limits of @p FRAME_OP_EXEC_TASK frames with the
+ * @p FRAME_EXEC_LIMITS flag: the memory in MiB, the CPU time in percent of a
+ * CPU, and the number of processes, each as a u64, and zero for no limit.
+ */
+#define FRAME_EXEC_LIMITS_SIZE 24ul
+
+/**
+ * The fixed size header preceding every frame's payload.
+ * It's encoded as little endian, in the order its fields are declared, after
+ * the magic and version bytes.
+ */
+typedef struct FrameHeader {
+    uint8_t opcode; //!< A FrameOpcode.
+    uint16_t flags; //!< Opcode specific flags.
+    uint16_t len;   //!< The payload's length, at most @p FRAME_MAX_PAYLOAD.
+    uint32_t request_id;    //!< An id chosen by the client, unique among its
+                            //!< requests.
+    uint32_t client_pid;    //!< The process id of the client.
+} FrameHeader;
+
+/**
+ * A streaming decoder of frames, which accepts bytes as they're read, whether
+ * they end mid frame or span several frames.
+ */
+typedef struct FrameDecoder {
+    char* buf;  //!< The underlying dynamically allocated buffer.
+    size_t begin;   //!< The index of the first undecoded byte.
+    size_t end; //!< The index of the past the last undecoded byte.
+    size_t cap; //!< The buffer's capacity.
+} FrameDecoder;
+
+/**
+ * An outcome returned by frame functions.
+ */
+typedef enum FrameOutcome {
+    FRAME_OK,   //!< No error.
+    FRAME_PENDING,  //!< More bytes are needed, but none are available yet.
+    FRAME_EOF,  //!< End of file reached while reading.
+    FRAME_ERR_TOO_LARGE,    //!< Payload larger than @p FRAME_MAX_PAYLOAD.
+    FRAME_ERR_CORRUPT,  //!< Bytes were skipped to resync with the stream.
+    FRAME_ERR_ALLOC_FAIL,   //!< Error occurred while allocating memory.
+    FRAME_ERR_READ_FAIL,    //!< Error occurred while reading from a file.
+    FRAME_ERR_WRITE_FAIL,   //!< Error occurred while writing to a file.
+} FrameOutcome;
+
+/**
+ * Stores @p value at @p dst as a little endian u64.
+ * <tt>O(1)</tt> complexity.
+ * @param dst the address of at least 8 bytes. <b>Must not be @p NULL.</b>
+ * @param value the value to store.
+ */
+void frame_put_u64(unsigned char* dst, uint64_t value);
+
+/**
+ * Loads a little endian u64 from @p src.
+ * <tt>O(1)</tt> complexity.
+ * @param src the address of at least 8 bytes. <b>Must not be @p NULL.</b>
+ * @return the loaded value.
+ */
+uint64_t frame_get_u64(unsigned char const* src);
+
+/**
+ * Encodes a FrameHeader into @p FRAME_HEADER_SIZE bytes.
+ * If @p FRAME_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(header != NULL)</tt>;
+ * 2. <tt>assert(dst != NULL)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param header address of the FrameHeader to encode.
+ * <b>Must not be @p NULL.</b>
+ * @param dst (output parameter) the address of at least @p FRAME_HEADER_SIZE
+ * bytes. <b>Must not be @p NULL.</b>
+ */
+void frame_encode_header(
+    FrameHeader const* restrict header,
+    unsigned char* restrict dst
+);
+
+/**
+ * Writes a frame to a BufWriter. If the frame doesn't fit in the BufWriter's
+ * remaining capacity, the BufWriter is flushed first, so that as long as its
+ * capacity is at most @p FRAME_MAX_SIZE, every <tt>write(2)</tt> it makes
+ * contains only whole frames.
+ * @p header->len is ignored, and set to @p len.
+ * If @p FRAME_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(writer != NULL)</tt>;
+ * 2. <tt>assert(header != NULL)</tt>;
+ * 3. <tt>assert(payload != NULL || len == 0ul)</tt>.
+ * <tt>O(len)</tt> complexity.
+ * @param writer address of the BufWriter to write to.
+ * <b>Must not be @p NULL.</b>
+ * @param header address of the frame's header. <b>Must not be @p NULL.</b>
+ * @param payload the frame's payload. <b>Must not be @p NULL, unless @p len is
+ * @p 0.</b>
+ * @param len the payload's length.
+ * @return @p FRAME_ERR_TOO_LARGE if @p len exceeds @p FRAME_MAX_PAYLOAD,
+ * otherwise @p FRAME_ERR_WRITE_FAIL if writing fails, otherwise @p FRAME_OK.
+ */
+FrameOutcome frame_write(
+    struct BufWriter* restrict writer,
+    FrameHeader const* restrict header,
+    void const* restrict payload,
+    size_t len
+);
+
+/**
+ * Creates a FrameDecoder with room for several frames.
+ * The FrameDecoder must later be passed to <tt>fdec_drop()</tt>.
+ * <tt>O(malloc())</tt> complexity.
+ * @param init (output parameter) address of the FrameDecoder to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return @p FRAME_ERR_ALLOC_FAIL if memory allocation fails, otherwise
+ * @p FRAME_OK.
+ */
+FrameOutcome fdec_new(FrameDecoder* init);
+
+/**
+ * Deallocates the FrameDecoder's buffer.
+ * <tt>O(free())</tt> complexity.
+ * @param self address of the FrameDecoder to drop. <b>Must not be @p NULL.</b>
+ */
+void fdec_drop(FrameDecoder* self);
+
+/**
+ * Reads as many bytes as fit in the FrameDecoder from @p file_des, with a
+ * single <tt>read(2)</tt>.
+ * <tt>O(read())</tt> complexity.
+ * @param self address of the FrameDecoder. <b>Must not be @p NULL.</b>
+ * @param file_des the file descriptor to read from, which should be non
+ * blocking.
+ * @return @p FRAME_PENDING if the file descriptor would block, otherwise
+ * @p FRAME_EOF if it reached end of file, otherwise @p FRAME_ERR_READ_FAIL if
+ * reading fails, otherwise @p FRAME_OK.
+ */
+FrameOutcome fdec_fill(FrameDecoder* self, int file_des);
+
+/**
+ * Decodes the next complete frame, if there's one. The payload is not copied:
+ * @p payload points into the FrameDecoder's buffer, and is valid until the
+ * next call to <tt>fdec_fill()</tt>.
+ * If the stream is corrupt, bytes are skipped until the next frame magic, and
+ * @p FRAME_ERR_CORRUPT is returned; decoding may continue afterwards.
+ * <tt>O(1)</tt> complexity, or <tt>O(skipped bytes)</tt> when resyncing.
+ * @param self address of the FrameDecoder. <b>Must not be @p NULL.</b>
+ * @param header (output parameter) address of the decoded frame's header.
+ * <b>Must not be @p NULL.</b>
+ * @param payload (output parameter) address of a pointer to which the
+ * payload's address is stored. <b>Must not be @p NULL.</b>
+ * @return @p FRAME_PENDING if there isn't a complete frame, otherwise
+ * @p FRAME_ERR_CORRUPT if bytes had to be skipped, otherwise @p FRAME_OK.
+ */
+FrameOutcome fdec_next(
+    FrameDecoder* restrict self,
+    FrameHeader* restrict header,
+    char const** restrict payload
+);
+
+/**
+ * Returns the message associated with the FrameOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the FrameOutcome whose associated message is returned. If
+ * not a valid FrameOutcome, a message describing that the outcome is unknown
+ * is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the FrameOutcome.
+ */
+char const* frame_outcome_msg(FrameOutcome outcome, int const* opt_errno);
+
+#endif  // PROTO_FRAME_H
@@ -0,0 +1,209 @@
+#ifndef PROTO_HISTORY_QUERY_H
+#define PROTO_HISTORY_QUERY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define HISTORY_QUERY_RUNTIME_ASSERTS 0
+
+/**
+ * The size of an encoded HistoryQuery, not counting the command prefix.
+ */
+#define HQUERY_HEADER_SIZE 72ul
+
+/**
+ * The number of HistoryClasses.
+ */
+#define HQUERY_CLASSES 5ul
+
+/**
+ * The number of HistoryColumns.
+ */
+#define HQUERY_COLUMNS 9ul
+
+/**
+ * The filters set in a HistoryQuery.
+ */
+typedef enum HistoryQueryField {
+    HQUERY_LAST = 1u << 0u,    //!< Only the last @p last matching tasks.
+    HQUERY_SINCE = 1u << 1u,   //!< Only tasks whose id is at least
+                               //!< @p since_id.
+    HQUERY_FROM = 1u << 2u,    //!< Only tasks which ended at or after
+                               //!< @p from_sec.
+    HQUERY_TO = 1u << 3u,  //!< Only tasks which ended before @p to_sec.
+    HQUERY_STATUS = 1u << 4u,  //!< Only tasks which exited with
+                               //!< @p exit_status.
+    HQUERY_CLASS = 1u << 5u,   //!< Only tasks which ended as @p end_class.
+    HQUERY_PREFIX = 1u << 6u,  //!< Only tasks whose command starts with
+                               //!< @p prefix.
+    HQUERY_SHOW = 1u << 7u,    //!< Show the @p columns of each task.
+    HQUERY_SORT = 1u << 8u,    //!< List tasks by @p sort_column, greatest
+                               //!< first.
+} HistoryQueryField;
+
+/**
+ * How a finished task ended, coarsely, as filtered by historico.
+ */
+typedef enum HistoryClass {
+    HCLASS_OK,  //!< It exited with status zero.
+    HCLASS_FAILED,  //!< It exited with another status, or was killed.
+    HCLASS_TERMINATED,  //!< It was terminated by a client.
+    HCLASS_EXEC_TIMEOUT,    //!< It hit the maximum execution time.
+    HCLASS_INACTIVE_TIMEOUT,    //!< It hit the maximum inactivity time.
+} HistoryClass;
+
+/**
+ * A resource a finished task used, as shown, and sorted by, by historico.
+ */
+typedef enum HistoryColumn {
+    HCOLUMN_WALL,   //!< The time from launch to the last stage's reaping.
+    HCOLUMN_USER,   //!< The user CPU time.
+    HCOLUMN_SYS,    //!< The system CPU time.
+    HCOLUMN_RSS,    //!< The largest resident set size of any stage.
+    HCOLUMN_PEAK,   //!< The peak memory use of the task's cgroup.
+    HCOLUMN_MINFLT, //!< The number of minor page faults.
+    HCOLUMN_MAJFLT, //!< The number of major page faults.
+    HCOLUMN_VCSW,   //!< The number of voluntary context switches.
+    HCOLUMN_IVCSW,  //!< The number of involuntary context switches.
+} HistoryColumn;
+
+/**
+ * A historico query: a range of finished tasks, filters on them, and how
+ * they're listed. Every field not set in @p fields is ignored.
+ * Encoded as nine little endian u64s, in the order the fields are declared,
+ * followed by the command prefix.
+ */
+typedef struct HistoryQuery {
+    uint32_t fields;    //!< The HistoryQueryFields set.
+    uint64_t last;  //!< The number of most recent matching tasks.
+    uint64_t since_id;  //!< The lowest task id.
+    int64_t from_sec;   //!< The earliest end time, in seconds since the
+                        //!< epoch.
+    int64_t to_sec; //!< The end time all tasks ended before, in seconds since
+                    //!< the epoch.
+    int32_t exit_status;    //!< The exit status.
+    uint32_t end_class; //!< The HistoryClass.
+    uint32_t columns;   //!< The HistoryColumns shown, each as the bit
+                        //!< <tt>1 << column</tt>.
+    uint32_t sort_column;   //!< The HistoryColumn tasks are sorted by.
+    char const* prefix; //!< The command prefix, not owned, nor null
+                        //!< terminated.
+    size_t prefix_len;  //!< The command prefix's length.
+} HistoryQuery;
+
+/**
+ * An outcome returned by HistoryQuery functions.
+ */
+typedef enum HistoryQueryOutcome {
+    HQUERY_OK,  //!< No error.
+    HQUERY_ERR_UNKNOWN_FILTER,  //!< The filter isn't one of the known ones.
+    HQUERY_ERR_INV_VALUE,   //!< The filter's value is invalid.
+    HQUERY_ERR_TOO_LONG,    //!< The command prefix doesn't fit in a frame.
+    HQUERY_ERR_CORRUPT, //!< The encoded query is truncated.
+} HistoryQueryOutcome;
+
+/**
+ * Creates a HistoryQuery with no filters, which matches every finished task.
+ * <tt>O(1)</tt> complexity.
+ * @param init (output parameter) address of the HistoryQuery to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return a pointer to the initialized HistoryQuery with address @p init.
+ */
+HistoryQuery* hquery_new(HistoryQuery* init);
+
+/**
+ * Parses a filter, of the form @p key=value, and sets it in the HistoryQuery.
+ * The keys are @p last, @p since, @p from, @p to and @p status, whose values
+ * are decimal numbers, @p end, whose value is one of @p ok, @p failed,
+ * @p terminated, @p max-time and @p inactivity, @p cmd, whose value is the
+ * rest of the filter, and isn't copied, @p show, whose value is a comma
+ * separated list of column names (see <tt>hquery_column_name()</tt>), or
+ * @p all, and @p sort, whose value is a column name.
+ * If @p HISTORY_QUERY_RUNTIME_ASSERTS is set to @p 1, the following
+ * assertions are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(begin != NULL)</tt>;
+ * 3. <tt>assert(end != NULL)</tt>.
+ * <tt>O(end - begin)</tt> complexity.
+ * @param self address of the HistoryQuery. <b>Must not be @p NULL.</b>
+ * @param begin address of the filter's first character.
+ * <b>Must not be @p NULL.</b>
+ * @param end address of the filter's past the last character.
+ * <b>Must not be @p NULL.</b>
+ * @return @p HQUERY_ERR_UNKNOWN_FILTER if the key isn't known, otherwise
+ * @p HQUERY_ERR_INV_VALUE if the value is invalid, otherwise
+ * @p HQUERY_ERR_TOO_LONG if the command prefix is too long, otherwise
+ * @p HQUERY_OK.
+ */
+HistoryQueryOutcome hquery_parse_filter(
+    HistoryQuery* restrict self,
+    char const* begin,
+    char const* end
+);
+
+/**
+ * Returns the name of the HistoryColumn, as given to the @p show and @p sort
+ * filters.
+ * If @p HISTORY_QUERY_RUNTIME_ASSERTS is set to @p 1, the following
+ * assertion is made:
+ * 1. <tt>assert(column < HQUERY_COLUMNS)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param column the HistoryColumn. <b>Must be a valid HistoryColumn.</b>
+ * @return the name of the HistoryColumn.
+ */
+char const* hquery_column_name(HistoryColumn column);
+
+/**
+ * Returns the length of the encoded HistoryQuery.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the HistoryQuery. <b>Must not be @p NULL.</b>
+ * @return the length of the encoded HistoryQuery.
+ */
+size_t hquery_encoded_len(HistoryQuery const* self);
+
+/**
+ * Encodes the HistoryQuery.
+ * <tt>O(self->prefix_len)</tt> complexity.
+ * @param self address of the HistoryQuery. <b>Must not be @p NULL.</b>
+ * @param dst (output parameter) address to which the encoded HistoryQuery is
+ * stored. <b>Must have room for <tt>hquery_encoded_len(self)</tt>
+ * bytes.</b>
+ */
+void hquery_encode(
+    HistoryQuery const* restrict self,
+    unsigned char* restrict dst
+);
+
+/**
+ * Decodes a HistoryQuery. An empty query has no filters, as sent by older
+ * clients. The command prefix points into @p src.
+ * <tt>O(1)</tt> complexity.
+ * @param init (output parameter) address of the HistoryQuery to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param src the encoded HistoryQuery.
+ * @param len the encoded HistoryQuery's length.
+ * @return @p HQUERY_ERR_CORRUPT if @p src is too short, otherwise
+ * @p HQUERY_OK.
+ */
+HistoryQueryOutcome hquery_decode(
+    HistoryQuery* restrict init,
+    unsigned char const* restrict src,
+    size_t len
+);
+
+/**
+ * Returns the message associated with the HistoryQueryOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the HistoryQueryOutcome whose associated message is
+ * returned. If not a valid HistoryQueryOutcome, a message describing that the
+ * outcome is unknown is returned.
+ * @return the message associated with the HistoryQueryOutcome.
+ */
+char const* hquery_outcome_msg(HistoryQueryOutcome outcome);
+
+#endif  // PROTO_HISTORY_QUERY_H
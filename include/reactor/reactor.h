@@ -0,0 +1,175 @@
+#ifndef REACTOR_REACTOR_H
+#define REACTOR_REACTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define REACTOR_RUNTIME_ASSERTS 0
+
+/**
+ * The maximum amount of events dispatched by a single call to
+ * <tt>reactor_poll()</tt>.
+ */
+#define REACTOR_MAX_EVENTS 64
+
+struct ReactorSource;
+
+/**
+ * A function called by the Reactor when its source's file descriptor is ready.
+ * @param source the address of the ready ReactorSource.
+ * @param events the <tt>epoll(7)</tt> events that are ready.
+ */
+typedef void (*ReactorCallback)(struct ReactorSource* source, uint32_t events);
+
+/**
+ * A file descriptor registered within a Reactor, along with the callback to be
+ * called when it is ready, and a context pointer for the callback's use.
+ * ReactorSources are owned by the caller, and must outlive their registration.
+ */
+typedef struct ReactorSource {
+    int file_des;   //!< The watched file descriptor.
+    ReactorCallback callback;   //!< The callback called when ready.
+    void* ctx;  //!< A pointer available to the callback.
+} ReactorSource;
+
+/**
+ * An event loop that multiplexes several file descriptors with
+ * <tt>epoll(7)</tt>, dispatching a callback for each one that is ready.
+ */
+typedef struct Reactor {
+    int epoll_des;  //!< The underlying epoll file descriptor.
+    struct ReactorSource* ready[REACTOR_MAX_EVENTS];    //!< The sources being
+                                                        //!< dispatched.
+    size_t ready_len;   //!< The amount of sources being dispatched.
+    size_t ready_pos;   //!< The index of the source being dispatched.
+} Reactor;
+
+/**
+ * An outcome returned by Reactor functions.
+ */
+typedef enum ReactorOutcome {
+    REACTOR_OK, //!< No error.
+    REACTOR_ERR_CREATE_FAIL,    //!< Error occurred while creating the epoll.
+    REACTOR_ERR_CTL_FAIL,   //!< Error occurred while (un)registering a source.
+    REACTOR_ERR_WAIT_FAIL,  //!< Error occurred while waiting for events.
+    REACTOR_ERR_CLOSE_FAIL, //!< Error occurred while closing the epoll.
+} ReactorOutcome;
+
+/**
+ * Creates a Reactor with no registered sources.
+ * The Reactor must later be passed to <tt>reactor_drop()</tt>.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(init != NULL)</tt>.
+ * <tt>O(epoll_create1())</tt> complexity.
+ * @param init (output parameter) address of the Reactor to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return @p REACTOR_ERR_CREATE_FAIL if the epoll couldn't be created,
+ * otherwise @p REACTOR_OK.
+ */
+ReactorOutcome reactor_new(Reactor* init);
+
+/**
+ * Closes the Reactor's epoll file descriptor. The registered sources' file
+ * descriptors are left untouched.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>.
+ * <tt>O(close())</tt> complexity.
+ * @param self address of the Reactor to drop. <b>Must not be @p NULL.</b>
+ * @return @p REACTOR_ERR_CLOSE_FAIL if closing fails, otherwise @p REACTOR_OK.
+ */
+ReactorOutcome reactor_drop(Reactor* self);
+
+/**
+ * Registers a ReactorSource, to be dispatched when any of @p events is ready.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(source != NULL)</tt>.
+ * <tt>O(epoll_ctl())</tt> complexity.
+ * @param self address of the Reactor. <b>Must not be @p NULL.</b>
+ * @param source address of the ReactorSource to register.
+ * <b>Must not be @p NULL, and must outlive its registration.</b>
+ * @param events the <tt>epoll(7)</tt> events to watch.
+ * @return @p REACTOR_ERR_CTL_FAIL if registering fails, otherwise
+ * @p REACTOR_OK.
+ */
+ReactorOutcome reactor_add(
+    Reactor* restrict self,
+    ReactorSource* restrict source,
+    uint32_t events
+);
+
+/**
+ * Changes the events watched for an already registered ReactorSource.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(source != NULL)</tt>.
+ * <tt>O(epoll_ctl())</tt> complexity.
+ * @param self address of the Reactor. <b>Must not be @p NULL.</b>
+ * @param source address of the registered ReactorSource.
+ * <b>Must not be @p NULL.</b>
+ * @param events the <tt>epoll(7)</tt> events to watch.
+ * @return @p REACTOR_ERR_CTL_FAIL if modifying fails, otherwise
+ * @p REACTOR_OK.
+ */
+ReactorOutcome reactor_mod(
+    Reactor* restrict self,
+    ReactorSource* restrict source,
+    uint32_t events
+);
+
+/**
+ * Unregisters a ReactorSource. It is safe to free the ReactorSource right
+ * after this call, even from within a callback: pending dispatches of it in the
+ * current <tt>reactor_poll()</tt> call are discarded.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(source != NULL)</tt>.
+ * <tt>O(epoll_ctl() + REACTOR_MAX_EVENTS)</tt> complexity.
+ * @param self address of the Reactor. <b>Must not be @p NULL.</b>
+ * @param source address of the registered ReactorSource.
+ * <b>Must not be @p NULL.</b>
+ * @return @p REACTOR_ERR_CTL_FAIL if unregistering fails, otherwise
+ * @p REACTOR_OK.
+ */
+ReactorOutcome reactor_rm(Reactor* restrict self, ReactorSource* restrict source);
+
+/**
+ * Waits at most @p timeout_ms milliseconds for registered sources to become
+ * ready, and calls the callback of each ready source.
+ * Being interrupted by a signal is not considered an error.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>.
+ * <tt>O(epoll_wait() + ready sources' callbacks)</tt> complexity.
+ * @param self address of the Reactor. <b>Must not be @p NULL.</b>
+ * @param timeout_ms the maximum amount of milliseconds to wait, or @p -1 to
+ * wait indefinitely.
+ * @return @p REACTOR_ERR_WAIT_FAIL if waiting fails, otherwise @p REACTOR_OK.
+ */
+ReactorOutcome reactor_poll(Reactor* self, int timeout_ms);
+
+/**
+ * Returns the message associated with the ReactorOutcome.
+ * If @p REACTOR_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(outcome >= REACTOR_OK && outcome <= REACTOR_ERR_CLOSE_FAIL)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the ReactorOutcome whose associated message is returned. If
+ * not a valid ReactorOutcome, a message describing that the outcome is unknown
+ * is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the ReactorOutcome.
+ */
+char const* reactor_outcome_msg(ReactorOutcome outcome, int const* opt_errno);
+
+#endif  // REACTOR_REACTOR_H
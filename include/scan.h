@@ -0,0 +1,127 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define SCAN_RUNTIME_ASSERTS 0
+
+/**
+ * The classes of bytes the scanning functions look for, combined as a mask.
+ * Whitespace is that of the C locale, i.e. ASCII, so that it's classified a
+ * whole vector at a time.
+ */
+typedef enum ScanClass {
+    SCAN_NEWLINE = 1u << 0u,   //!< A newline character.
+    SCAN_SPACE = 1u << 1u, //!< A whitespace character, newlines included.
+    SCAN_PIPE = 1u << 2u,  //!< A @p '|' pipeline separator.
+} ScanClass;
+
+/**
+ * The instruction sets the scanning functions have kernels for, from the
+ * narrowest to the widest.
+ */
+typedef enum ScanIsa {
+    SCAN_ISA_PORTABLE,  //!< A byte at a time, in plain C.
+    SCAN_ISA_SSE2,  //!< 16 bytes at a time.
+    SCAN_ISA_AVX2,  //!< 32 bytes at a time.
+} ScanIsa;
+
+/**
+ * Limits the scanning functions to the kernels of @p isa and narrower ones,
+ * e.g. to compare them. By default, the widest one available is used. Not
+ * meant to be called while another thread scans.
+ * <tt>O(1)</tt> complexity.
+ * @param isa the widest instruction set to use.
+ * @return the widest instruction set used from now on, which is narrower than
+ * @p isa if the latter isn't available.
+ */
+ScanIsa scan_limit_isa(ScanIsa isa);
+
+/**
+ * Returns the address of the first byte in @p classes, scanning 32 or 16 bytes
+ * at a time with AVX2 or SSE2, if available.
+ * If @p SCAN_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(begin != NULL)</tt>;
+ * 2. <tt>assert(end != NULL)</tt>.
+ * <tt>O(end - begin)</tt> complexity.
+ * @param begin address of the first byte. <b>Must not be @p NULL.</b>
+ * @param end address of the past the last byte. <b>Must not be @p NULL.</b>
+ * @param classes the ScanClasses looked for.
+ * @return the address of the first byte in @p classes, or @p end if none is.
+ */
+char const* scan_find(char const* begin, char const* end, unsigned classes);
+
+/**
+ * Returns the address of the first byte not in @p classes, e.g. past a run of
+ * whitespace, scanning 32 or 16 bytes at a time with AVX2 or SSE2, if
+ * available.
+ * If @p SCAN_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(begin != NULL)</tt>;
+ * 2. <tt>assert(end != NULL)</tt>.
+ * <tt>O(end - begin)</tt> complexity.
+ * @param begin address of the first byte. <b>Must not be @p NULL.</b>
+ * @param end address of the past the last byte. <b>Must not be @p NULL.</b>
+ * @param classes the ScanClasses skipped.
+ * @return the address of the first byte not in @p classes, or @p end if
+ * every byte is.
+ */
+char const* scan_skip(char const* begin, char const* end, unsigned classes);
+
+/**
+ * Returns the address past the last byte not in @p classes, e.g. before a
+ * trailing run of whitespace. Scans a byte at a time, as such runs are short.
+ * If @p SCAN_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(begin != NULL)</tt>;
+ * 2. <tt>assert(end != NULL)</tt>.
+ * <tt>O(end - begin)</tt> complexity.
+ * @param begin address of the first byte. <b>Must not be @p NULL.</b>
+ * @param end address of the past the last byte. <b>Must not be @p NULL.</b>
+ * @param classes the ScanClasses skipped.
+ * @return the address past the last byte not in @p classes, or @p begin if
+ * every byte is.
+ */
+char const* scan_skip_back(
+    char const* begin,
+    char const* end,
+    unsigned classes
+);
+
+/**
+ * Returns the number of bytes in @p classes, counted 32 or 16 bytes at a time
+ * with AVX2 or SSE2, if available.
+ * If @p SCAN_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(begin != NULL)</tt>;
+ * 2. <tt>assert(end != NULL)</tt>.
+ * <tt>O(end - begin)</tt> complexity.
+ * @param begin address of the first byte. <b>Must not be @p NULL.</b>
+ * @param end address of the past the last byte. <b>Must not be @p NULL.</b>
+ * @param classes the ScanClasses counted.
+ * @return the number of bytes in @p classes.
+ */
+size_t scan_count(char const* begin, char const* end, unsigned classes);
+
+/**
+ * Returns the number of runs of bytes not in @p classes, e.g. of words
+ * separated by whitespace, counted 32 or 16 bytes at a time with AVX2 or SSE2,
+ * if available.
+ * If @p SCAN_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(begin != NULL)</tt>;
+ * 2. <tt>assert(end != NULL)</tt>.
+ * <tt>O(end - begin)</tt> complexity.
+ * @param begin address of the first byte. <b>Must not be @p NULL.</b>
+ * @param end address of the past the last byte. <b>Must not be @p NULL.</b>
+ * @param classes the ScanClasses separating the runs.
+ * @return the number of runs of bytes not in @p classes.
+ */
+size_t scan_count_runs(char const* begin, char const* end, unsigned classes);
+
+#endif  // SCAN_H
@@ -0,0 +1,207 @@
+#ifndef TASK_LAUNCHER_H
+#define TASK_LAUNCHER_H
+
+#include "task/task_arena.h"
+
+#include <sys/types.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define LAUNCHER_RUNTIME_ASSERTS 0
+
+/**
+ * The maximum number of relayed pipes of a Pipeline, so that the caller's ends
+ * fit in a single @p SCM_RIGHTS message.
+ */
+#define LAUNCHER_MAX_RELAYS 126ul
+
+/**
+ * A task's pipeline, tokenized once into the argument vectors of its stages,
+ * so that launching it requires no further parsing nor allocation.
+ * Its buffers are all allocated from a single TaskArena, sized once the
+ * command's stages and words are counted.
+ */
+typedef struct Pipeline {
+    TaskArena arena;    //!< The block owning every buffer below.
+    char* buf;  //!< A copy of the command line, with separators replaced by
+                //!< null characters.
+    char** args;    //!< The null terminated argument vectors of every stage,
+                    //!< one after the other.
+    char*** stages; //!< The argument vector of each stage.
+    pid_t* pids;    //!< The process id of each stage, once launched.
+    size_t stage_count; //!< The number of stages.
+    size_t relay_count; //!< The number of relayed pipes, once launched.
+    int relay_fds[2ul * LAUNCHER_MAX_RELAYS];   //!< For each relayed pipe, the
+                                                //!< read end of a stage's
+                                                //!< stdout and the write end
+                                                //!< of the next one's stdin.
+} Pipeline;
+
+/**
+ * An outcome returned by launcher functions.
+ */
+typedef enum LauncherOutcome {
+    LAUNCHER_OK,    //!< No error.
+    LAUNCHER_ERR_EMPTY_STAGE,   //!< A pipeline stage has no command.
+    LAUNCHER_ERR_ALLOC_FAIL,    //!< Error occurred while allocating memory.
+    LAUNCHER_ERR_PIPE_FAIL, //!< Error occurred while creating a pipe.
+    LAUNCHER_ERR_SPAWN_FAIL,    //!< Error occurred while spawning a stage.
+} LauncherOutcome;
+
+/**
+ * Tokenizes a command line into a Pipeline, with stages separated by @p '|'
+ * and arguments by whitespace.
+ * The Pipeline must later be passed to <tt>pipeline_drop()</tt>.
+ * If @p LAUNCHER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(init != NULL)</tt>;
+ * 2. <tt>assert(cmd != NULL)</tt>.
+ * <tt>O(len)</tt> complexity.
+ * @param init (output parameter) address of the Pipeline to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param cmd the command line, which needs not be null terminated.
+ * <b>Must not be @p NULL.</b>
+ * @param len the command line's length.
+ * @return @p LAUNCHER_ERR_ALLOC_FAIL if memory allocation fails, otherwise
+ * @p LAUNCHER_ERR_EMPTY_STAGE if a stage has no command, otherwise
+ * @p LAUNCHER_OK.
+ */
+LauncherOutcome pipeline_parse(Pipeline* init, char const* cmd, size_t len);
+
+/**
+ * Deallocates the Pipeline's buffers, at once. Launched stages are unaffected.
+ * <tt>O(free())</tt> complexity.
+ * @param self address of the Pipeline to drop. <b>Must not be @p NULL.</b>
+ */
+void pipeline_drop(Pipeline* self);
+
+/**
+ * Creates the pipe between a stage and the next one, whose ends are close on
+ * exec.
+ * If @p is_relayed is set and the Pipeline has at most
+ * @p LAUNCHER_MAX_RELAYS + 1 stages, two pipes are created instead, whose
+ * other ends are appended to the Pipeline's @p relay_fds, so the caller can
+ * relay the stages' traffic. Otherwise, both ends returned belong to the same
+ * pipe.
+ * If @p LAUNCHER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(out_fd != NULL)</tt>;
+ * 3. <tt>assert(next_in_fd != NULL)</tt>.
+ * <tt>O(pipe())</tt> complexity.
+ * @param self address of the Pipeline. <b>Must not be @p NULL.</b>
+ * @param is_relayed if the stages' traffic should be relayed by the caller.
+ * @param out_fd (output parameter) address to which the stage's stdout is
+ * stored. <b>Must not be @p NULL.</b>
+ * @param next_in_fd (output parameter) address to which the next stage's
+ * stdin is stored. <b>Must not be @p NULL.</b>
+ * @return @p LAUNCHER_ERR_PIPE_FAIL if creating a pipe fails, otherwise
+ * @p LAUNCHER_OK.
+ */
+LauncherOutcome pipeline_pipe(
+    Pipeline* restrict self,
+    bool is_relayed,
+    int* restrict out_fd,
+    int* restrict next_in_fd
+);
+
+/**
+ * Closes the caller's ends of the Pipeline's relayed pipes.
+ * <tt>O(relay_count * close())</tt> complexity.
+ * @param self address of the Pipeline. <b>Must not be @p NULL.</b>
+ */
+void pipeline_close_relays(Pipeline* self);
+
+/**
+ * Spawns every stage of the Pipeline with <tt>posix_spawnp()</tt>, each
+ * stage's stdout connected to the next stage's stdin, through the caller if
+ * @p is_relayed is set (see <tt>pipeline_pipe()</tt>). The first stage reads
+ * from @p /dev/null, and the last one writes to @p out_fd, or inherits the
+ * caller's stdout if it's @p -1.
+ * All stages join a new process group, whose id is the first stage's process
+ * id, and start with an empty signal mask and @p SIGPIPE's default action.
+ * If @p cgroup_fd isn't @p -1, each stage is cloned with
+ * <tt>pipeline_clone_stage()</tt> instead, joining the cgroup it's the
+ * @p cgroup.procs of before executing, so that nothing it forks is left out.
+ * If a stage fails to spawn, or to join the cgroup, the stages already spawned
+ * are killed, and the relayed pipes are closed.
+ * The stages are children of the caller, which must reap them, and close the
+ * relayed pipes.
+ * If @p LAUNCHER_RUNTIME_ASSERTS is set to @p 1, the following assertion is
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>.
+ * <tt>O(stage_count * posix_spawnp())</tt> complexity, or
+ * <tt>O(stage_count * clone())</tt> with a cgroup.
+ * @param self address of the Pipeline to launch. Its @p pids are set to the
+ * stages' process ids. <b>Must not be @p NULL.</b>
+ * @param is_relayed if the stages' traffic should be relayed by the caller.
+ * @param out_fd the last stage's stdout, or @p -1.
+ * @param cgroup_fd the @p cgroup.procs of the cgroup the stages are moved to,
+ * or @p -1.
+ * @return @p LAUNCHER_ERR_PIPE_FAIL if creating a pipe fails, otherwise
+ * @p LAUNCHER_ERR_SPAWN_FAIL if spawning a stage, or joining the cgroup, fails,
+ * otherwise @p LAUNCHER_OK.
+ */
+LauncherOutcome pipeline_launch(
+    Pipeline* self,
+    bool is_relayed,
+    int out_fd,
+    int cgroup_fd
+);
+
+/**
+ * Clones a single stage, which joins the cgroup whose @p cgroup.procs is
+ * @p cgroup_fd, unless it's @p -1, and the process group @p pgid, wires up its
+ * stdin and stdout, and executes, with an empty signal mask and the default
+ * action for every signal the caller handles, and for @p SIGPIPE. The stage
+ * runs on a stack of its own, sharing the caller's memory until it executes,
+ * as <tt>posix_spawnp()</tt> does, so that no page tables are copied however
+ * large the caller is. The caller is suspended until the stage either
+ * executes or fails to, which guarantees that the process group exists before
+ * the next stage joins it. A stage which fails exits with status @p 127.
+ * If @p LAUNCHER_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(argv != NULL)</tt>;
+ * 2. <tt>assert(pid != NULL)</tt>.
+ * <tt>O(clone())</tt> complexity.
+ * @param argv the stage's null terminated argument vector.
+ * <b>Must not be @p NULL.</b>
+ * @param in_fd the stage's stdin, or @p -1 for @p /dev/null.
+ * @param out_fd the stage's stdout, or @p -1 to inherit the caller's.
+ * @param cgroup_fd the @p cgroup.procs of the cgroup the stage joins, or
+ * @p -1.
+ * @param pgid the process group the stage joins, or @p 0 for a new one.
+ * @param is_sibling if the stage is made a child of the caller's parent,
+ * rather than of the caller.
+ * @param pid (output parameter) address to which the stage's process id is
+ * stored. <b>Must not be @p NULL.</b>
+ * @return @p 0 if the stage executed, otherwise an error number.
+ */
+int pipeline_clone_stage(
+    char* const* argv,
+    int in_fd,
+    int out_fd,
+    int cgroup_fd,
+    pid_t pgid,
+    bool is_sibling,
+    pid_t* pid
+);
+
+/**
+ * Returns the message associated with the LauncherOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the LauncherOutcome whose associated message is returned. If
+ * not a valid LauncherOutcome, a message describing that the outcome is
+ * unknown is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the LauncherOutcome.
+ */
+char const* launcher_outcome_msg(LauncherOutcome outcome, int const* opt_errno);
+
+#endif  // TASK_LAUNCHER_H
@@ -0,0 +1,106 @@
+#ifndef TASK_RELAY_H
+#define TASK_RELAY_H
+
+#include "reactor/reactor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define RELAY_RUNTIME_ASSERTS 0
+
+/**
+ * The maximum number of <tt>splice()</tt> calls of a single
+ * <tt>relay_pump()</tt>, so that a busy pipeline can't starve the event loop.
+ */
+#define RELAY_MAX_SPLICES 16ul
+
+/**
+ * A relay between two pipes: a stage's stdout, and the next stage's stdin.
+ * Data is moved between them with <tt>splice()</tt>, so it never enters user
+ * space, and the relay notes whenever some was moved.
+ */
+typedef struct Relay {
+    ReactorSource source;   //!< The read end of the stage's stdout.
+    ReactorSource sink; //!< The write end of the next stage's stdin.
+    uint64_t last_active;   //!< When data was last moved, as set by the
+                            //!< caller.
+    bool is_blocked;    //!< If the caller is waiting for the sink to drain.
+} Relay;
+
+/**
+ * An outcome returned by Relay functions.
+ */
+typedef enum RelayOutcome {
+    RELAY_OK,   //!< No error, and the source is drained.
+    RELAY_BLOCKED,  //!< The sink is full.
+    RELAY_EOF,  //!< The source is closed, and drained.
+    RELAY_ERR_FCNTL_FAIL,   //!< Error occurred while making the pipes non
+                            //!< blocking.
+    RELAY_ERR_SPLICE_FAIL,  //!< Error occurred while moving data, e.g. the
+                            //!< sink was closed.
+    RELAY_ERR_CLOSE_FAIL,   //!< Error occurred while closing the pipes.
+} RelayOutcome;
+
+/**
+ * Creates a Relay between two pipes, making the Relay's ends non blocking.
+ * The stages' ends are unaffected.
+ * The Relay owns both file descriptors, and must later be passed to
+ * <tt>relay_drop()</tt>, even if an error is returned.
+ * If @p RELAY_RUNTIME_ASSERTS is set to @p 1, the following assertion is made:
+ * 1. <tt>assert(init != NULL)</tt>.
+ * <tt>O(fcntl())</tt> complexity.
+ * @param init (output parameter) address of the Relay to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param source_fd the read end of the stage's stdout.
+ * @param sink_fd the write end of the next stage's stdin.
+ * @return @p RELAY_ERR_FCNTL_FAIL if making the pipes non blocking fails,
+ * otherwise @p RELAY_OK.
+ */
+RelayOutcome relay_new(Relay* init, int source_fd, int sink_fd);
+
+/**
+ * Closes both of the Relay's pipes, which signals EOF to the next stage, and
+ * @p SIGPIPE to the stage if it writes again. Dropping a dropped Relay has no
+ * effect.
+ * <tt>O(close())</tt> complexity.
+ * @param self address of the Relay to drop. <b>Must not be @p NULL.</b>
+ * @return @p RELAY_ERR_CLOSE_FAIL if closing either pipe fails, otherwise
+ * @p RELAY_OK.
+ */
+RelayOutcome relay_drop(Relay* self);
+
+/**
+ * Moves data from the source to the sink, until the source is drained, the
+ * sink is full, or @p RELAY_MAX_SPLICES calls to <tt>splice()</tt> are made.
+ * If @p RELAY_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(moved != NULL)</tt>.
+ * <tt>O(RELAY_MAX_SPLICES * splice())</tt> complexity.
+ * @param self address of the Relay. <b>Must not be @p NULL.</b>
+ * @param moved (output parameter) address to which the number of bytes moved
+ * is stored. <b>Must not be @p NULL.</b>
+ * @return @p RELAY_ERR_SPLICE_FAIL if moving data fails, otherwise
+ * @p RELAY_EOF if the source is closed and drained, otherwise
+ * @p RELAY_BLOCKED if the sink is full, otherwise @p RELAY_OK.
+ */
+RelayOutcome relay_pump(Relay* restrict self, size_t* restrict moved);
+
+/**
+ * Returns the message associated with the RelayOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the RelayOutcome whose associated message is returned. If not
+ * a valid RelayOutcome, a message describing that the outcome is unknown is
+ * returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the RelayOutcome.
+ */
+char const* relay_outcome_msg(RelayOutcome outcome, int const* opt_errno);
+
+#endif  // TASK_RELAY_H
@@ -1,14 +1,58 @@
 #ifndef TASK_TASK_H
 #define TASK_TASK_H
 
+#include "task/task_arena.h"
+
+#include <sys/resource.h>
 #include <sys/types.h>
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+struct Relay;
+
+/**
+ * How a task came to an end.
+ */
+typedef enum TaskEnd {
+    TASK_END_COMPLETED, //!< Its stages exited, or were killed by others.
+    TASK_END_TERMINATED,    //!< It was terminated by a client.
+    TASK_END_EXEC_TIMEOUT,  //!< It ran for longer than the maximum execution
+                            //!< time.
+    TASK_END_INACTIVE_TIMEOUT,  //!< A pipe between its stages was inactive for
+                                //!< longer than the maximum inactivity time.
+} TaskEnd;
 
 typedef struct Task {
     size_t task_id;
-    char const* task_name;
+    TaskArena arena;    //!< The block owning its name and relays, released
+                        //!< when it finishes.
+    char const* task_name;  //!< Its command, null terminated.
     pid_t process_group;
+    pid_t last_pid; //!< The last stage's process id, whose status is the
+                    //!< task's.
+    size_t live_stages; //!< The number of stages not yet reaped.
+    int exit_status;    //!< The last stage's wait status, once reaped.
+    struct timespec start_time; //!< When the task was launched.
+    struct timespec end_time;   //!< When the task's last stage was reaped.
+    struct rusage usage;    //!< The resources used by all reaped stages.
+    bool has_cgroup;    //!< If it runs in a cgroup of its own, named after
+                        //!< its id.
+    int64_t mem_peak_kib;   //!< The peak memory use of its cgroup, in KiB,
+                            //!< once finished, or zero if unknown.
+    size_t exec_timer;  //!< The timer enforcing the maximum execution time, or
+                        //!< @p SIZE_MAX if none.
+    TaskEnd end;    //!< How the task ended, or is being ended.
+    struct Relay* relays;   //!< The relays between its stages, while running.
+    size_t relay_count; //!< The number of relays.
+    size_t inactive_timer;  //!< The timer enforcing the maximum inactivity
+                            //!< time, or @p SIZE_MAX if none.
+    uint64_t max_inactive_ticks;    //!< The maximum inactivity time, in ticks
+                                    //!< of the timers' clock.
+    int spool_fd;   //!< The file the last stage's output is spooled to while
+                    //!< running, or @p -1 if none.
 } Task;
 
 #endif  // TASK_TASK_H
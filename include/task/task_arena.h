@@ -0,0 +1,71 @@
+#ifndef TASK_TASK_ARENA_H
+#define TASK_TASK_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_ARENA_RUNTIME_ASSERTS 0
+
+/**
+ * A bump allocator over a single block, owning everything a task, or its
+ * pipeline, needs for as long as it lives: its command, argument vectors,
+ * stage tables and relays. Its owner sizes the block up front, with
+ * <tt>tarena_size_of()</tt>, so that a task takes one allocation, however many
+ * stages it has, and everything it owns is released at once.
+ * Allocations never move, and are aligned for any type.
+ */
+typedef struct TaskArena {
+    char* buf;  //!< The block, or @p NULL if none.
+    size_t len; //!< The number of bytes allocated.
+    size_t cap; //!< The block's size.
+} TaskArena;
+
+/**
+ * Returns how much of a TaskArena's block an allocation of @p size bytes
+ * takes, i.e. @p size rounded up to the alignment of any type.
+ * <tt>O(1)</tt> complexity.
+ * @param size the allocation's size.
+ * @return the room taken by the allocation.
+ */
+size_t tarena_size_of(size_t size);
+
+/**
+ * Creates a TaskArena over a block of @p cap bytes.
+ * The TaskArena must later be passed to <tt>tarena_drop()</tt>.
+ * If @p TASK_ARENA_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(init != NULL)</tt>.
+ * <tt>O(malloc(cap))</tt> complexity.
+ * @param init (output parameter) address of the TaskArena to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param cap the block's size, the sum of <tt>tarena_size_of()</tt> of every
+ * allocation to be made.
+ * @return @p false if memory allocation fails, otherwise @p true.
+ */
+bool tarena_with_cap(TaskArena* init, size_t cap);
+
+/**
+ * Allocates @p size bytes from the TaskArena's block.
+ * If @p TASK_ARENA_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskArena. <b>Must not be @p NULL.</b>
+ * @param size the allocation's size.
+ * @return the allocation's address, or @p NULL if it doesn't fit in what's
+ * left of the block.
+ */
+void* tarena_alloc(TaskArena* self, size_t size);
+
+/**
+ * Deallocates the TaskArena's block, and so every allocation made from it.
+ * <tt>O(free(self->buf))</tt> complexity.
+ * @param self address of the TaskArena to drop. <b>Must not be @p NULL.</b>
+ */
+void tarena_drop(TaskArena* self);
+
+#endif  // TASK_TASK_ARENA_H
@@ -0,0 +1,208 @@
+#ifndef TASK_TASK_BOARD_H
+#define TASK_TASK_BOARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_BOARD_RUNTIME_ASSERTS 0
+
+/**
+ * The maximum length of a command on the board. Longer ones are truncated.
+ */
+#define TBOARD_CMD_SIZE 4080ul
+
+/**
+ * The state of a task on the board.
+ */
+typedef enum TaskBoardState {
+    TBOARD_RUNNING, //!< The task is running.
+    TBOARD_PENDING, //!< The task is queued, waiting to be launched.
+} TaskBoardState;
+
+/**
+ * The running and pending tasks, published by the server in shared memory, so
+ * that clients can list them without a round trip.
+ * Each task takes a fixed size entry, so that a task is added by writing a
+ * single entry, and removed by moving the last entry into its place, in
+ * <tt>O(1)</tt>, and the board only grows, so that readers never fault on
+ * a shrunk mapping. The tasks are therefore in no particular order, and the
+ * server tracks where each one is from what removals report.
+ * Every change is wrapped in a sequence lock: the sequence number is odd
+ * while the board is being written, and readers retry their copy if it was
+ * odd, or changed, meanwhile. Writers therefore never wait for readers.
+ */
+typedef struct TaskBoard {
+    int fd; //!< The shared memory object.
+    char* map;  //!< The object's mapping.
+    size_t map_len; //!< The length of the mapping, and of the object.
+    size_t len; //!< The number of tasks on the board.
+    bool is_valid;  //!< If the board mirrors the server's tasks. Once an update
+                    //!< fails, it's marked invalid, and readers ask the server.
+    char const* name;   //!< The shared memory object's name.
+} TaskBoard;
+
+/**
+ * A task, as copied from the board.
+ */
+typedef struct TaskBoardTask {
+    uint64_t task_id;   //!< The task's id.
+    TaskBoardState state;   //!< Whether the task is running or pending.
+    char const* cmd;    //!< The task's command, not null terminated.
+    size_t cmd_len; //!< The length of the task's command.
+} TaskBoardTask;
+
+/**
+ * A consistent copy of the board, taken by a reader.
+ */
+typedef struct TaskBoardSnapshot {
+    TaskBoardTask* tasks;   //!< The tasks.
+    size_t len; //!< The number of tasks.
+    char* cmds; //!< The buffer the tasks' commands point into.
+} TaskBoardSnapshot;
+
+/**
+ * An outcome returned by TaskBoard functions.
+ */
+typedef enum TaskBoardOutcome {
+    TBOARD_OK,  //!< No error.
+    TBOARD_ERR_OPEN_FAIL,   //!< Error occurred while opening the board.
+    TBOARD_ERR_MAP_FAIL,    //!< Error occurred while mapping or growing it.
+    TBOARD_ERR_ALLOC_FAIL,  //!< Error occurred while allocating memory.
+    TBOARD_ERR_STALE,   //!< The board isn't kept by a running server.
+    TBOARD_ERR_BUSY,    //!< The board kept changing while being copied.
+} TaskBoardOutcome;
+
+/**
+ * Creates the board, as the shared memory object @p name, replacing any left
+ * by a previous server, and marks it as kept by the calling process.
+ * The TaskBoard must later be passed to <tt>tboard_close()</tt>.
+ * If @p TASK_BOARD_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(init != NULL)</tt>;
+ * 2. <tt>assert(name != NULL)</tt>.
+ * <tt>O(mmap())</tt> complexity.
+ * @param init (output parameter) address of the TaskBoard to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param name the shared memory object's name, which must outlive the
+ * TaskBoard. <b>Must not be @p NULL.</b>
+ * @return @p TBOARD_ERR_OPEN_FAIL if creating the object fails, otherwise
+ * @p TBOARD_ERR_MAP_FAIL if sizing or mapping it fails, otherwise
+ * @p TBOARD_OK.
+ */
+TaskBoardOutcome tboard_open(TaskBoard* init, char const* name);
+
+/**
+ * Marks the board as no longer kept, so that readers no longer trust it, and
+ * removes it.
+ * <tt>O(munmap())</tt> complexity.
+ * @param self address of the TaskBoard to close. <b>Must not be @p NULL.</b>
+ */
+void tboard_close(TaskBoard* self);
+
+/**
+ * Adds a task at the end of the board. If the board can't grow, it's marked
+ * invalid, and every later change is ignored.
+ * If @p TASK_BOARD_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(cmd != NULL || cmd_len == 0ul)</tt>.
+ * <tt>O(cmd_len)</tt> amortized complexity.
+ * @param self address of the TaskBoard. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param state the task's state.
+ * @param cmd the task's command, truncated to @p TBOARD_CMD_SIZE bytes.
+ * @param cmd_len the command's length.
+ * @return @p TBOARD_ERR_MAP_FAIL if growing the board fails, otherwise
+ * @p TBOARD_OK.
+ */
+TaskBoardOutcome tboard_push(
+    TaskBoard* restrict self,
+    uint64_t task_id,
+    TaskBoardState state,
+    char const* restrict cmd,
+    size_t cmd_len
+);
+
+/**
+ * Changes the state of the task at @p index.
+ * If @p TASK_BOARD_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(!self->is_valid || index < self->len)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskBoard. <b>Must not be @p NULL.</b>
+ * @param index the task's index.
+ * @param state the task's new state.
+ */
+void tboard_set_state(TaskBoard* self, size_t index, TaskBoardState state);
+
+/**
+ * Removes the task at @p index, moving the last task into its place.
+ * If @p TASK_BOARD_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(moved_id != NULL)</tt>;
+ * 3. <tt>assert(!self->is_valid || index < self->len)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskBoard. <b>Must not be @p NULL.</b>
+ * @param index the task's index.
+ * @param moved_id (output parameter) address to which the id of the task
+ * moved into @p index is stored. <b>Must not be @p NULL.</b>
+ * @return @p true if a task was moved into @p index, otherwise @p false.
+ */
+bool tboard_rm(
+    TaskBoard* restrict self,
+    size_t index,
+    uint64_t* restrict moved_id
+);
+
+/**
+ * Copies the board named @p name, retrying while it's being written.
+ * The TaskBoardSnapshot must later be passed to
+ * <tt>tboard_snapshot_drop()</tt>, if successful.
+ * If @p TASK_BOARD_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(init != NULL)</tt>;
+ * 2. <tt>assert(name != NULL)</tt>.
+ * <tt>O(tasks + commands length)</tt> complexity, per attempt.
+ * @param init (output parameter) address of the TaskBoardSnapshot to
+ * initialize. <b>Must not be @p NULL.</b>
+ * @param name the shared memory object's name. <b>Must not be @p NULL.</b>
+ * @return @p TBOARD_ERR_OPEN_FAIL if there's no board, otherwise
+ * @p TBOARD_ERR_MAP_FAIL if mapping it fails, otherwise
+ * @p TBOARD_ERR_ALLOC_FAIL if memory allocation fails, otherwise
+ * @p TBOARD_ERR_STALE if its server is gone, or it's invalid, otherwise
+ * @p TBOARD_ERR_BUSY if it never stood still long enough to be copied,
+ * otherwise @p TBOARD_OK.
+ */
+TaskBoardOutcome tboard_snapshot(TaskBoardSnapshot* init, char const* name);
+
+/**
+ * Deallocates the TaskBoardSnapshot's memory.
+ * <tt>O(free())</tt> complexity.
+ * @param self address of the TaskBoardSnapshot to drop.
+ * <b>Must not be @p NULL.</b>
+ */
+void tboard_snapshot_drop(TaskBoardSnapshot* self);
+
+/**
+ * Returns the message associated with the TaskBoardOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the TaskBoardOutcome whose associated message is returned.
+ * If not a valid TaskBoardOutcome, a message describing that the outcome is
+ * unknown is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the TaskBoardOutcome.
+ */
+char const* tboard_outcome_msg(
+    TaskBoardOutcome outcome,
+    int const* opt_errno
+);
+
+#endif  // TASK_TASK_BOARD_H
@@ -0,0 +1,193 @@
+#ifndef TASK_TASK_CGROUP_H
+#define TASK_TASK_CGROUP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_CGROUP_RUNTIME_ASSERTS 0
+
+/**
+ * A controller enabled for the tasks' cgroups.
+ */
+typedef enum TaskCgroupController {
+    TCGROUP_MEMORY = 1u << 0u,  //!< Limits memory, and tracks its peak.
+    TCGROUP_CPU = 1u << 1u, //!< Limits CPU time.
+    TCGROUP_PIDS = 1u << 2u,    //!< Limits the number of processes.
+} TaskCgroupController;
+
+/**
+ * The resource limits of a task, each zero for no limit.
+ */
+typedef struct TaskLimits {
+    uint64_t memory_mib;    //!< The memory the task may use, in MiB.
+    uint64_t cpu_percent;   //!< The CPU time the task may use, in percent of
+                            //!< a CPU.
+    uint64_t pids;  //!< The number of processes the task may have.
+} TaskLimits;
+
+/**
+ * The resources a task used, as accounted by its cgroup, which, unlike the
+ * stages' rusage, includes processes which left the stages' process group.
+ */
+typedef struct TaskCgroupUsage {
+    int64_t utime_usec; //!< The user CPU time, in microseconds.
+    int64_t stime_usec; //!< The system CPU time, in microseconds.
+    int64_t mem_peak_kib;   //!< The peak memory use, in KiB, or zero if the
+                            //!< memory controller isn't enabled.
+} TaskCgroupUsage;
+
+/**
+ * A cgroup v2 subtree managed by the server, with a leaf cgroup per running
+ * task, named after the task's id, so that a task is limited, accounted and
+ * killed as a whole, however its processes fork or regroup.
+ */
+typedef struct TaskCgroups {
+    int dir_fd; //!< The subtree's directory.
+    unsigned controllers;   //!< The TaskCgroupController enabled for tasks.
+} TaskCgroups;
+
+/**
+ * An outcome returned by TaskCgroups functions.
+ */
+typedef enum TaskCgroupOutcome {
+    TCGROUP_OK, //!< No error.
+    TCGROUP_ERR_NO_CGROUP2, //!< No cgroup v2 hierarchy is mounted.
+    TCGROUP_ERR_OPEN_FAIL,  //!< Error occurred while creating or opening a
+                            //!< cgroup, or one of its files.
+    TCGROUP_ERR_READ_FAIL,  //!< Error occurred while reading a cgroup file.
+    TCGROUP_ERR_WRITE_FAIL, //!< Error occurred while writing a cgroup file.
+    TCGROUP_ERR_NO_CONTROLLER,  //!< A limit's controller isn't enabled.
+} TaskCgroupOutcome;
+
+/**
+ * Creates, or reuses, the subtree @p name at the root of the cgroup v2
+ * hierarchy, enabling as many of the memory, cpu and pids controllers for its
+ * leaves as the hierarchy allows, and removes the leaves a previous server
+ * left behind.
+ * The TaskCgroups must later be passed to <tt>tcgroup_close()</tt>.
+ * If @p TASK_CGROUP_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(init != NULL)</tt>;
+ * 2. <tt>assert(name != NULL)</tt>.
+ * <tt>O(leaves left behind)</tt> complexity.
+ * @param init (output parameter) address of the TaskCgroups to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param name the subtree's name. <b>Must not be @p NULL.</b>
+ * @return @p TCGROUP_ERR_NO_CGROUP2 if there's no cgroup v2 hierarchy,
+ * otherwise @p TCGROUP_ERR_OPEN_FAIL if creating or opening the subtree fails,
+ * or the caller can't write to it, otherwise @p TCGROUP_OK.
+ */
+TaskCgroupOutcome tcgroup_open(TaskCgroups* init, char const* name);
+
+/**
+ * Closes the subtree, which is kept for the next server, like the cgroups of
+ * tasks still running.
+ * <tt>O(close())</tt> complexity.
+ * @param self address of the TaskCgroups to close. <b>Must not be @p NULL.</b>
+ */
+void tcgroup_close(TaskCgroups* self);
+
+/**
+ * Creates a task's cgroup, and opens its @p cgroup.procs, to which a process
+ * writes "0" to join it.
+ * If @p TASK_CGROUP_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(procs_fd != NULL)</tt>.
+ * <tt>O(mkdir())</tt> complexity.
+ * @param self address of the TaskCgroups. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param procs_fd (output parameter) address to which the opened
+ * @p cgroup.procs, which must later be closed, is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p TCGROUP_ERR_OPEN_FAIL if creating the cgroup, or opening the
+ * file, fails, otherwise @p TCGROUP_OK.
+ */
+TaskCgroupOutcome tcgroup_add(
+    TaskCgroups* restrict self,
+    size_t task_id,
+    int* restrict procs_fd
+);
+
+/**
+ * Sets a task's cgroup's limits. Limits of zero are left unset.
+ * If @p TASK_CGROUP_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(limits != NULL)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskCgroups. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param limits the task's limits. <b>Must not be @p NULL.</b>
+ * @return @p TCGROUP_ERR_NO_CONTROLLER if a limit's controller isn't enabled,
+ * otherwise @p TCGROUP_ERR_OPEN_FAIL or @p TCGROUP_ERR_WRITE_FAIL if setting
+ * a limit fails, otherwise @p TCGROUP_OK.
+ */
+TaskCgroupOutcome tcgroup_limit(
+    TaskCgroups* restrict self,
+    size_t task_id,
+    TaskLimits const* restrict limits
+);
+
+/**
+ * Kills every process in a task's cgroup, through @p cgroup.kill.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskCgroups. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @return @p TCGROUP_ERR_OPEN_FAIL if the kernel has no @p cgroup.kill,
+ * otherwise @p TCGROUP_ERR_WRITE_FAIL if writing it fails, otherwise
+ * @p TCGROUP_OK.
+ */
+TaskCgroupOutcome tcgroup_kill(TaskCgroups* self, size_t task_id);
+
+/**
+ * Reads the resources a task's cgroup used.
+ * If @p TASK_CGROUP_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(usage != NULL)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskCgroups. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param usage (output parameter) address to which the usage is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p TCGROUP_ERR_OPEN_FAIL or @p TCGROUP_ERR_READ_FAIL if reading the
+ * CPU time fails, otherwise @p TCGROUP_OK.
+ */
+TaskCgroupOutcome tcgroup_usage(
+    TaskCgroups* restrict self,
+    size_t task_id,
+    TaskCgroupUsage* restrict usage
+);
+
+/**
+ * Removes a task's cgroup. If processes the task left behind are still in it,
+ * they're killed, and the cgroup is removed once they're gone, by the next
+ * server, if not by this call.
+ * <tt>O(rmdir())</tt> complexity.
+ * @param self address of the TaskCgroups. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ */
+void tcgroup_rm(TaskCgroups* self, size_t task_id);
+
+/**
+ * Returns the message associated with the TaskCgroupOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the TaskCgroupOutcome whose associated message is returned.
+ * If not a valid TaskCgroupOutcome, a message describing that the outcome is
+ * unknown is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the TaskCgroupOutcome.
+ */
+char const* tcgroup_outcome_msg(
+    TaskCgroupOutcome outcome,
+    int const* opt_errno
+);
+
+#endif  // TASK_TASK_CGROUP_H
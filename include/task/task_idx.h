@@ -0,0 +1,98 @@
+#ifndef TASK_TASK_IDX_H
+#define TASK_TASK_IDX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_IDX_RUNTIME_ASSERTS 0
+
+/**
+ * A slot of a TaskIdx, mapping a Task id to where the Task is stored.
+ */
+typedef struct TaskIdxEntry {
+    size_t task_id; //!< The Task id, or @p SIZE_MAX if the slot is empty.
+    size_t idx; //!< The Task's index in a TaskVec, or its TaskHandle.
+} TaskIdxEntry;
+
+/**
+ * An open addressing hash table, with linear probing, mapping Task ids to
+ * their indexes in a TaskVec, or to their handles in a TaskSlotMap, so that
+ * Tasks are found by id without scanning. It must be kept in sync with the
+ * container by its owner.
+ * Task ids are consecutive, so they're spread by fibonacci hashing, and the
+ * table is kept at most half full, so probe sequences stay short.
+ */
+typedef struct TaskIdx {
+    TaskIdxEntry* buf;  //!< A dynamically allocated buffer of entries.
+    size_t len; //!< The number of occupied entries.
+    size_t cap; //!< The number of entries, zero or a power of two.
+} TaskIdx;
+
+/**
+ * Creates an empty TaskIdx.
+ * The TaskIdx must later be passed to <tt>tidx_drop()</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param init (output parameter) the address of the TaskIdx to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return a pointer to the initialized TaskIdx with address @p init.
+ */
+TaskIdx* tidx_new(TaskIdx* init);
+
+/**
+ * Deallocates the storage associated with a TaskIdx.
+ * <tt>O(free(self->buf))</tt> complexity.
+ * @param self the address of the TaskIdx whose store shall be deallocated.
+ * <b>Must not be @p NULL.</b>
+ */
+void tidx_drop(TaskIdx* self);
+
+/**
+ * Returns the number of Task ids in the TaskIdx.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskIdx. <b>Must not be @p NULL.</b>
+ * @return the number of Task ids in the TaskIdx.
+ */
+size_t tidx_len(TaskIdx const* self);
+
+/**
+ * Looks up the index of the Task with id @p tid.
+ * Expected <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskIdx. <b>Must not be @p NULL.</b>
+ * @param tid the Task id to look up. <b>Must not be @p SIZE_MAX.</b>
+ * @param opt_idx (output parameter) optional address of a size type to which is
+ * stored the Task's index, if found. If @p NULL, it is unused.
+ * @return @p true if the Task id was found, @p false otherwise.
+ */
+bool tidx_get(
+    TaskIdx const* restrict self,
+    size_t tid,
+    size_t* restrict opt_idx
+);
+
+/**
+ * Maps the Task id @p tid to the index @p idx, replacing any previous mapping.
+ * If the TaskIdx would be over half full, it's grown first, and if that
+ * allocation fails, @p false is returned and the TaskIdx is left unchanged.
+ * Amortized expected <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskIdx. <b>Must not be @p NULL.</b>
+ * @param tid the Task id. <b>Must not be @p SIZE_MAX.</b>
+ * @param idx the Task's index.
+ * @return @p true if the mapping was stored, @p false otherwise.
+ */
+bool tidx_put(TaskIdx* self, size_t tid, size_t idx);
+
+/**
+ * Removes the mapping of the Task id @p tid. Following entries are shifted
+ * back, so no tombstones are left behind.
+ * Expected <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskIdx. <b>Must not be @p NULL.</b>
+ * @param tid the Task id. <b>Must not be @p SIZE_MAX.</b>
+ * @return @p true if the Task id was found and removed, @p false otherwise.
+ */
+bool tidx_rm(TaskIdx* self, size_t tid);
+
+#endif  // TASK_TASK_IDX_H
@@ -0,0 +1,319 @@
+#ifndef TASK_TASK_JOURNAL_H
+#define TASK_TASK_JOURNAL_H
+
+#include "proto/history_query.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_JOURNAL_RUNTIME_ASSERTS 0
+
+/**
+ * The name of the records file, within the TaskJournal's directory.
+ */
+#define TJOURNAL_FILENAME "history"
+
+/**
+ * The name of the strings file, within the TaskJournal's directory.
+ */
+#define TJOURNAL_STR_FILENAME "history.str"
+
+/**
+ * The name of the task ids index file, within the TaskJournal's directory.
+ */
+#define TJOURNAL_IDS_FILENAME "history.ids"
+
+/**
+ * The size of a TaskRecord.
+ */
+#define TJOURNAL_RECORD_SIZE 128ul
+
+/**
+ * The most records a query checks against filters its indexes don't answer,
+ * i.e. a command prefix, or an exit status other than zero.
+ */
+#define TJOURNAL_MAX_SCANNED 65536ul
+
+struct Task;
+
+/**
+ * A finished task, as recorded in the journal. Every field has a fixed width,
+ * and the record is mapped straight from the file, in the host's byte order.
+ */
+typedef struct TaskRecord {
+    uint32_t checksum;  //!< The FNV-1a hash of the rest of the record, and
+                        //!< of the command.
+    uint32_t end;   //!< How the task ended, a TaskEnd.
+    uint64_t task_id;   //!< The task's id.
+    int32_t exit_status;    //!< The last stage's wait status.
+    uint32_t cmd_len;   //!< The length of the task's command.
+    uint64_t cmd_off;   //!< The offset of the task's command in the strings
+                        //!< file.
+    int64_t start_sec;  //!< When the task was launched, in seconds.
+    int64_t start_nsec; //!< And nanoseconds.
+    int64_t end_sec;    //!< When the task's last stage was reaped, in seconds.
+    int64_t end_nsec;   //!< And nanoseconds.
+    int64_t utime_usec; //!< The user CPU time of all stages, or of the
+                        //!< task's cgroup if it had one, in microseconds.
+    int64_t stime_usec; //!< The system CPU time of all stages, or of the
+                        //!< task's cgroup if it had one, in microseconds.
+    int64_t max_rss_kib;    //!< The largest resident set size of any stage,
+                            //!< in KiB.
+    int64_t min_flt;    //!< The number of minor page faults.
+    int64_t maj_flt;    //!< The number of major page faults.
+    int64_t nvcsw;  //!< The number of voluntary context switches.
+    int64_t nivcsw; //!< The number of involuntary context switches.
+    int64_t mem_peak_kib;   //!< The peak memory use of the task's cgroup, in
+                            //!< KiB, or zero if unknown.
+} TaskRecord;
+
+/**
+ * An append only file of the journal, mapped into memory with room to grow.
+ */
+typedef struct TaskJournalFile {
+    int fd; //!< The file.
+    char const* map;    //!< The file's mapping, or @p NULL if none.
+    size_t map_len; //!< The length of the mapping.
+    uint64_t len;   //!< The file's length.
+} TaskJournalFile;
+
+/**
+ * Visits a record matching a query.
+ * @param ctx the context passed along with the visitor.
+ * @param record the matching record.
+ * @return @p false to stop the query, otherwise @p true.
+ */
+typedef bool (*TaskRecordVisitor)(void* ctx, TaskRecord const* record);
+
+/**
+ * An intern table entry, i.e. a command already in the strings file.
+ */
+typedef struct TaskJournalStr {
+    uint64_t off;   //!< The command's offset in the strings file.
+    uint32_t len;   //!< The command's length.
+    uint32_t hash;  //!< The command's hash, or @p 0 if the entry is empty.
+} TaskJournalStr;
+
+/**
+ * A durable, append only journal of finished tasks: a file of fixed size
+ * TaskRecords, in the order the tasks finished, and a file of the commands
+ * they refer to, each stored once no matter how many tasks ran it.
+ * Appended records are held in memory until flushed, which syncs the strings
+ * file before writing them, so that a record never reaches the disk before
+ * its command, even if the page cache is lost. Each record is checksummed
+ * along with its command, so a crash of the server at any point leaves at
+ * most a torn record at the end, and a crash of the system at most loses the
+ * records not yet written back, both of which are dropped when the journal
+ * is opened, along with some unreferenced bytes in the strings file.
+ * Queries are answered from secondary indexes, appended to along with the
+ * records: a file mapping each task id to its record, and, for each
+ * HistoryClass, a file listing its records in order. Along with records being
+ * sorted by end time, these let a query find its range with a binary search,
+ * or a direct lookup, and then only visit the records it's filtered to.
+ * Every file is mapped into memory with room to grow, so that opening the
+ * journal reads nothing but the last record, and records are served straight
+ * from the page cache, however many there are.
+ * Commands are interned among those appended since the journal was opened,
+ * so that opening it doesn't read the strings file either.
+ */
+typedef struct TaskJournal {
+    TaskJournalFile recs;   //!< The records.
+    TaskJournalFile strs;   //!< The commands.
+    TaskJournalFile ids;    //!< For each task id, the index of its record
+                            //!< plus one, or zero if none, as u64s.
+    TaskJournalFile classes[HQUERY_CLASSES];    //!< For each HistoryClass, the
+                                                //!< indexes of its records, as
+                                                //!< u64s.
+    size_t len; //!< The number of records written.
+    TaskRecord* pending;    //!< The records appended but not yet written.
+    size_t pending_len; //!< The number of records not yet written.
+    size_t pending_cap; //!< The capacity of @p pending.
+    uint64_t synced_strs_len;   //!< The length of the strings file as of its
+                                //!< last sync.
+    TaskJournalStr* interned;   //!< The intern table, with open addressing.
+    size_t interned_len;    //!< The number of commands interned.
+    size_t interned_cap;    //!< The intern table's capacity, a power of two.
+} TaskJournal;
+
+/**
+ * An outcome returned by TaskJournal functions.
+ */
+typedef enum TaskJournalOutcome {
+    TJOURNAL_OK,    //!< No error.
+    TJOURNAL_ERR_ALLOC_FAIL,    //!< Error occurred while allocating memory.
+    TJOURNAL_ERR_OPEN_FAIL, //!< Error occurred while opening a file.
+    TJOURNAL_ERR_MAP_FAIL,  //!< Error occurred while mapping a file.
+    TJOURNAL_ERR_WRITE_FAIL,    //!< Error occurred while writing or syncing
+                                //!< a file.
+    TJOURNAL_ERR_CLOSE_FAIL,    //!< Error occurred while closing a file.
+    TJOURNAL_ERR_TOO_BROAD, //!< The query would check too many records.
+} TaskJournalOutcome;
+
+/**
+ * Opens, creating them if needed, the journal's files within @p dirname, and
+ * maps them. A torn record at the end is dropped, and the last record is
+ * indexed if it isn't. If the indexes don't account for every record, e.g.
+ * if they were deleted, they're rebuilt, in <tt>O(len)</tt>.
+ * The TaskJournal must later be passed to <tt>tjournal_close()</tt>.
+ * If @p TASK_JOURNAL_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(init != NULL)</tt>;
+ * 2. <tt>assert(dirname != NULL)</tt>.
+ * <tt>O(mmap())</tt> complexity.
+ * @param init (output parameter) address of the TaskJournal to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param dirname the directory holding the files. <b>Must not be @p NULL.</b>
+ * @return @p TJOURNAL_ERR_OPEN_FAIL if opening a file fails, otherwise
+ * @p TJOURNAL_ERR_MAP_FAIL if mapping a file fails, otherwise
+ * @p TJOURNAL_ERR_WRITE_FAIL if dropping a torn record, or indexing records,
+ * fails, otherwise
+ * @p TJOURNAL_OK.
+ */
+TaskJournalOutcome tjournal_open(TaskJournal* init, char const* dirname);
+
+/**
+ * Flushes the records not yet written, then unmaps and closes the
+ * TaskJournal's files.
+ * <tt>O(tjournal_flush())</tt> complexity.
+ * @param self address of the TaskJournal to close.
+ * <b>Must not be @p NULL.</b>
+ * @return @p TJOURNAL_ERR_WRITE_FAIL or @p TJOURNAL_ERR_MAP_FAIL if flushing
+ * fails, otherwise @p TJOURNAL_ERR_CLOSE_FAIL if closing a file fails,
+ * otherwise @p TJOURNAL_OK.
+ */
+TaskJournalOutcome tjournal_close(TaskJournal* self);
+
+/**
+ * Returns the number of records written, i.e. not counting those appended
+ * since the last flush.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskJournal. <b>Must not be @p NULL.</b>
+ * @return the number of records written.
+ */
+size_t tjournal_len(TaskJournal const* self);
+
+/**
+ * Appends a finished task's command, if not interned, and holds its record
+ * until the next <tt>tjournal_flush()</tt>, so that the commands of the tasks
+ * finishing together are synced at once.
+ * If @p TASK_JOURNAL_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(task != NULL)</tt>.
+ * <tt>O(command length + pwrite())</tt> amortized complexity.
+ * @param self address of the TaskJournal. <b>Must not be @p NULL.</b>
+ * @param task address of the finished task. <b>Must not be @p NULL.</b>
+ * @return @p TJOURNAL_ERR_WRITE_FAIL if writing the command fails, otherwise
+ * @p TJOURNAL_ERR_MAP_FAIL if growing a mapping fails, otherwise
+ * @p TJOURNAL_ERR_ALLOC_FAIL if holding the record fails, otherwise
+ * @p TJOURNAL_OK.
+ */
+TaskJournalOutcome tjournal_append(
+    TaskJournal* restrict self,
+    struct Task const* restrict task
+);
+
+/**
+ * Syncs the strings file, if commands were appended since it last was, then
+ * writes and indexes the records appended since the last flush. Meant to be
+ * called once per batch of finished tasks, and before querying, as records
+ * not yet written aren't visible.
+ * If writing a record fails, it and those after it are kept for the next
+ * flush.
+ * <tt>O(fdatasync() + records appended)</tt> complexity.
+ * @param self address of the TaskJournal. <b>Must not be @p NULL.</b>
+ * @return @p TJOURNAL_ERR_WRITE_FAIL if syncing or writing a file fails,
+ * otherwise @p TJOURNAL_ERR_MAP_FAIL if growing a mapping fails, otherwise
+ * @p TJOURNAL_OK.
+ */
+TaskJournalOutcome tjournal_flush(TaskJournal* self);
+
+/**
+ * Returns the record at @p index, i.e. of the <tt>index + 1</tt>th task to
+ * finish, if its checksum holds.
+ * If @p TASK_JOURNAL_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(index < self->len)</tt>.
+ * <tt>O(command length)</tt> complexity.
+ * @param self address of the TaskJournal. <b>Must not be @p NULL.</b>
+ * @param index the record's index. <b>Must be less than the number of
+ * records.</b>
+ * @return the address of the record, valid until the TaskJournal is next
+ * appended to, or @p NULL if it's corrupt.
+ */
+TaskRecord const* tjournal_get(TaskJournal const* self, size_t index);
+
+/**
+ * Returns the command of a record returned by <tt>tjournal_get()</tt>, which
+ * is @p record->cmd_len bytes long, and not null terminated.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskJournal. <b>Must not be @p NULL.</b>
+ * @param record address of the record. <b>Must not be @p NULL.</b>
+ * @return the address of the command, valid until the TaskJournal is next
+ * appended to.
+ */
+char const* tjournal_cmd(TaskJournal const* self, TaskRecord const* record);
+
+/**
+ * Visits, in the order the tasks finished, or by id if the query starts from
+ * a task id, every valid record matching @p query.
+ * The records are taken from the ids index, if the query starts from a task
+ * id, otherwise from the index of the query's HistoryClass, if any, otherwise
+ * from the records themselves, in which last two cases the time range is
+ * found by binary search. The remaining filters are then checked on each
+ * record, so that the cost is that of the records in range, filtered or not,
+ * plus a logarithmic search.
+ * As the event loop waits on queries, those with a filter no index answers,
+ * a command prefix or an exit status other than zero, check at most
+ * @p TJOURNAL_MAX_SCANNED records: if more are in range, the query is
+ * refused, unless it asks for the last matching records, which are then
+ * searched for among the last @p TJOURNAL_MAX_SCANNED records in range only.
+ * End times are assumed to be in order, which only a step back of the system
+ * clock breaks.
+ * If @p TASK_JOURNAL_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(query != NULL)</tt>;
+ * 3. <tt>assert(visitor != NULL)</tt>.
+ * <tt>O(log(len) + records in range)</tt> complexity, the records in range
+ * being at most @p TJOURNAL_MAX_SCANNED if a filter no index answers is set.
+ * @param self address of the TaskJournal. <b>Must not be @p NULL.</b>
+ * @param query address of the query. <b>Must not be @p NULL.</b>
+ * @param visitor the function called with each matching record.
+ * <b>Must not be @p NULL.</b>
+ * @param ctx the context passed to @p visitor.
+ * @return @p TJOURNAL_ERR_TOO_BROAD if more than @p TJOURNAL_MAX_SCANNED
+ * records are in range of a query with a filter no index answers, in which
+ * case, if it asks for the last matching records, those found among the last
+ * @p TJOURNAL_MAX_SCANNED were visited, and otherwise none were, otherwise
+ * @p TJOURNAL_OK.
+ */
+TaskJournalOutcome tjournal_query(
+    TaskJournal const* self,
+    HistoryQuery const* query,
+    TaskRecordVisitor visitor,
+    void* ctx
+);
+
+/**
+ * Returns the message associated with the TaskJournalOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the TaskJournalOutcome whose associated message is returned.
+ * If not a valid TaskJournalOutcome, a message describing that the outcome is
+ * unknown is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the TaskJournalOutcome.
+ */
+char const* tjournal_outcome_msg(
+    TaskJournalOutcome outcome,
+    int const* opt_errno
+);
+
+#endif  // TASK_TASK_JOURNAL_H
@@ -0,0 +1,284 @@
+#ifndef TASK_TASK_LOG_H
+#define TASK_TASK_LOG_H
+
+#include "codec/lz.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_LOG_RUNTIME_ASSERTS 0
+
+/**
+ * The name of the log file, within the TaskLog's directory.
+ */
+#define TLOG_FILENAME "log.lz"
+
+/**
+ * The name of the index file, within the TaskLog's directory.
+ */
+#define TLOG_IDX_FILENAME "log.lz.idx"
+
+/**
+ * The name of the file holding the first task id not yet reserved, within
+ * the TaskLog's directory.
+ */
+#define TLOG_IDS_FILENAME "log.lz.ids"
+
+/**
+ * The number of task ids reserved at once, so that giving out an id seldom
+ * writes the ids file.
+ */
+#define TLOG_IDS_BLOCK 1024ul
+
+/**
+ * The size of an index entry.
+ */
+#define TLOG_IDX_ENTRY_SIZE 24ul
+
+/**
+ * The maximum number of output bytes a frame holds.
+ */
+#define TLOG_FRAME_SIZE LZ_MAX_BLOCK_SIZE
+
+/**
+ * The size of a frame's header.
+ */
+#define TLOG_FRAME_HEADER_SIZE 12ul
+
+/**
+ * The magic number a frame's header starts with.
+ */
+#define TLOG_FRAME_MAGIC 0x315a4c54u
+
+/**
+ * Where a task's output is in the log. Also serves as a cursor, which
+ * <tt>tlog_read()</tt> advances through the output.
+ */
+typedef struct TaskLogEntry {
+    uint64_t frame_off; //!< The offset in the log of the frame the output
+                        //!< starts in.
+    uint64_t skip;  //!< The output's offset within the frame's bytes.
+    uint64_t len;   //!< The output's length.
+} TaskLogEntry;
+
+/**
+ * A task's output whose frame isn't written yet.
+ */
+typedef struct TaskLogPending {
+    size_t task_id; //!< The task's id.
+    TaskLogEntry entry; //!< Where the task's output is.
+} TaskLogPending;
+
+/**
+ * Part of a task's output, read from a single frame.
+ */
+typedef struct TaskLogChunk {
+    char const* data;   //!< The chunk's bytes, or @p NULL if they're stored
+                        //!< uncompressed in the log.
+    uint64_t file_off;  //!< If @p data is @p NULL, the chunk's offset in the
+                        //!< log.
+    size_t len; //!< The chunk's length.
+} TaskLogChunk;
+
+/**
+ * The output of every finished task, appended to a single log file, and
+ * indexed by task id in a file of fixed width entries, so that looking up a
+ * task's output takes a single read, and the number of files stays constant
+ * no matter how many tasks run.
+ * The outputs are concatenated and cut into frames of up to
+ * @p TLOG_FRAME_SIZE bytes, each compressed on its own, so that small outputs
+ * share a frame, and reading an output only decompresses the frames it spans.
+ * A frame's header is three little endian 32 bit integers: the magic number,
+ * the number of output bytes, and the number of bytes that follow, which are
+ * stored uncompressed if equal to the former, as happens when compression
+ * doesn't pay off.
+ * Each index entry is three little endian 64 bit integers: the offset of the
+ * frame the output starts in plus one, or zero if the task has no output
+ * recorded, the output's offset within the frame's bytes, and the output's
+ * length.
+ * While running, a task's output is spooled to an anonymous file, which is
+ * appended to the open frame once the task finishes, so that the outputs of
+ * concurrent tasks aren't interleaved. The open frame is written once full,
+ * or when flushed, and only then are the index entries of the outputs ending
+ * in it, so that they never point past the log's end.
+ * Task ids are given out by the TaskLog, and reserved a block at a time in a
+ * file of their own, as a single little endian 64 bit integer, so that an id
+ * given out to a task whose output was never recorded isn't given out again
+ * after a restart.
+ */
+typedef struct TaskLog {
+    int dir_fd; //!< The directory holding the files.
+    int log_fd; //!< The log file.
+    int idx_fd; //!< The index file.
+    int ids_fd; //!< The ids file.
+    uint64_t next_id;   //!< The next task id to give out.
+    uint64_t reserved_id;   //!< The first task id not yet reserved.
+    uint64_t log_len;   //!< The log file's length, which is where the open
+                        //!< frame will be written.
+    char* frame;    //!< The open frame's bytes.
+    size_t frame_len;   //!< The number of bytes in the open frame.
+    char* packed;   //!< A frame's header and compressed bytes.
+    char* unpacked; //!< The bytes of the last frame decompressed.
+    uint64_t unpacked_off;  //!< The offset of the last frame decompressed,
+                            //!< or @p UINT64_MAX if none.
+    uint64_t unpacked_next; //!< The offset of the frame after it.
+    size_t unpacked_len;    //!< The number of bytes it holds.
+    TaskLogPending* pending;    //!< The outputs ending in the open frame.
+    size_t pending_len; //!< The number of outputs ending in the open frame.
+    size_t pending_cap; //!< The capacity of @p pending.
+} TaskLog;
+
+/**
+ * An outcome returned by TaskLog functions.
+ */
+typedef enum TaskLogOutcome {
+    TLOG_OK,    //!< No error.
+    TLOG_NOT_FOUND, //!< The task has no output recorded.
+    TLOG_ERR_ALLOC_FAIL,    //!< Error occurred while allocating memory.
+    TLOG_ERR_CORRUPT,   //!< A frame of the log is corrupt.
+    TLOG_ERR_OPEN_FAIL, //!< Error occurred while opening a file.
+    TLOG_ERR_READ_FAIL, //!< Error occurred while reading a file.
+    TLOG_ERR_WRITE_FAIL,    //!< Error occurred while writing a file.
+    TLOG_ERR_CLOSE_FAIL,    //!< Error occurred while closing a file.
+} TaskLogOutcome;
+
+/**
+ * Opens, creating them if needed, the log, index and ids files within
+ * @p dirname. Task ids are given out past both the last one reserved and the
+ * highest one whose output was recorded.
+ * The TaskLog must later be passed to <tt>tlog_close()</tt>.
+ * If @p TASK_LOG_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(init != NULL)</tt>;
+ * 2. <tt>assert(dirname != NULL)</tt>.
+ * <tt>O(open())</tt> complexity.
+ * @param init (output parameter) address of the TaskLog to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @param dirname the directory holding the files. <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_ALLOC_FAIL if allocating the frame buffers fails,
+ * otherwise @p TLOG_ERR_OPEN_FAIL if opening a file fails, otherwise
+ * @p TLOG_ERR_READ_FAIL if reading the ids file or querying the index's size
+ * fails, otherwise @p TLOG_OK.
+ */
+TaskLogOutcome tlog_open(TaskLog* init, char const* dirname);
+
+/**
+ * Flushes the open frame, and closes the TaskLog's files.
+ * <tt>O(tlog_flush())</tt> complexity.
+ * @param self address of the TaskLog to close. <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_WRITE_FAIL if flushing the open frame fails, otherwise
+ * @p TLOG_ERR_CLOSE_FAIL if closing a file fails, otherwise @p TLOG_OK.
+ */
+TaskLogOutcome tlog_close(TaskLog* self);
+
+/**
+ * Gives out the next task id, reserving another @p TLOG_IDS_BLOCK of them
+ * first, and syncing the ids file, whenever the reserved ones run out, so that
+ * task ids keep growing across restarts, even if the server is killed.
+ * <tt>O(1)</tt> amortized complexity.
+ * @param self address of the TaskLog. <b>Must not be @p NULL.</b>
+ * @param task_id (output parameter) address to which the task id is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_WRITE_FAIL if reserving more task ids fails, otherwise
+ * @p TLOG_OK.
+ */
+TaskLogOutcome tlog_next_id(TaskLog* restrict self, size_t* restrict task_id);
+
+/**
+ * Creates an anonymous spool file, in the TaskLog's directory, to which a
+ * task writes its output while running. The spool file is close on exec.
+ * <tt>O(open())</tt> complexity.
+ * @param self address of the TaskLog. <b>Must not be @p NULL.</b>
+ * @param spool_fd (output parameter) address to which the spool file is
+ * stored. <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_OPEN_FAIL if creating the file fails, otherwise
+ * @p TLOG_OK.
+ */
+TaskLogOutcome tlog_spool(TaskLog const* restrict self, int* restrict spool_fd);
+
+/**
+ * Appends a finished task's spool file to the open frame, writing the frame
+ * whenever it fills up, and records where. The spool file isn't closed.
+ * <tt>O(spool size)</tt> complexity.
+ * @param self address of the TaskLog. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param spool_fd the task's spool file.
+ * @return @p TLOG_ERR_READ_FAIL if reading the spool file fails, otherwise
+ * @p TLOG_ERR_ALLOC_FAIL if recording where fails, otherwise
+ * @p TLOG_ERR_WRITE_FAIL if writing the log or index fails, otherwise
+ * @p TLOG_OK.
+ */
+TaskLogOutcome tlog_append(TaskLog* self, size_t task_id, int spool_fd);
+
+/**
+ * Compresses and writes the open frame, if not empty, followed by the index
+ * entries of the outputs ending in it. Meant for when the server is idle, so
+ * that the outputs of finished tasks aren't held in memory indefinitely.
+ * <tt>O(TLOG_FRAME_SIZE + pending outputs)</tt> complexity.
+ * @param self address of the TaskLog. <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_WRITE_FAIL if writing the log or index fails, otherwise
+ * @p TLOG_OK.
+ */
+TaskLogOutcome tlog_flush(TaskLog* self);
+
+/**
+ * Looks up where a task's output is in the log, or in the open frame.
+ * <tt>O(pending outputs + pread())</tt> complexity.
+ * @param self address of the TaskLog. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param entry (output parameter) address to which the output's location is
+ * stored. <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_READ_FAIL if reading the index fails, otherwise
+ * @p TLOG_NOT_FOUND if the task has no output recorded, otherwise @p TLOG_OK.
+ */
+TaskLogOutcome tlog_find(
+    TaskLog const* restrict self,
+    size_t task_id,
+    TaskLogEntry* restrict entry
+);
+
+/**
+ * Reads the next chunk of a task's output, from a single frame, and advances
+ * @p entry past it. Compressed frames are decompressed, and the last one is
+ * kept, so that reading the outputs sharing it doesn't decompress it again.
+ * Uncompressed frames aren't read at all: the chunk's location in the log is
+ * returned instead, so that the caller may copy it within the kernel.
+ * If @p TASK_LOG_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(entry != NULL)</tt>;
+ * 3. <tt>assert(entry->len > 0)</tt>;
+ * 4. <tt>assert(chunk != NULL)</tt>.
+ * <tt>O(TLOG_FRAME_SIZE)</tt> complexity.
+ * @param self address of the TaskLog. <b>Must not be @p NULL.</b>
+ * @param entry address of where the rest of the output is, as found by
+ * <tt>tlog_find()</tt>. <b>Must not be @p NULL</b>, and the output must not be
+ * empty.
+ * @param chunk (output parameter) address to which the chunk is stored. Its
+ * bytes are valid until the TaskLog is next used. <b>Must not be @p NULL.</b>
+ * @return @p TLOG_ERR_READ_FAIL if reading the log fails, otherwise
+ * @p TLOG_ERR_CORRUPT if the frame is corrupt, otherwise @p TLOG_OK.
+ */
+TaskLogOutcome tlog_read(
+    TaskLog* restrict self,
+    TaskLogEntry* restrict entry,
+    TaskLogChunk* restrict chunk
+);
+
+/**
+ * Returns the message associated with the TaskLogOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the TaskLogOutcome whose associated message is returned. If
+ * not a valid TaskLogOutcome, a message describing that the outcome is unknown
+ * is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the TaskLogOutcome.
+ */
+char const* tlog_outcome_msg(TaskLogOutcome outcome, int const* opt_errno);
+
+#endif  // TASK_TASK_LOG_H
@@ -0,0 +1,138 @@
+#ifndef TASK_TASK_QUEUE_H
+#define TASK_TASK_QUEUE_H
+
+#include "task/task_cgroup.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_QUEUE_RUNTIME_ASSERTS 0
+
+/**
+ * A task waiting to be launched.
+ */
+typedef struct PendingTask {
+    size_t task_id; //!< The id the task was given when submitted.
+    char* cmd;  //!< A copy of the task's command line, null terminated.
+    size_t cmd_len; //!< The command line's length.
+    TaskLimits limits;  //!< The task's resource limits.
+} PendingTask;
+
+/**
+ * The tasks admitted but not yet launched, in the order they were submitted,
+ * as a circular buffer, so that tasks are pushed and popped in
+ * <tt>O(1)</tt>.
+ */
+typedef struct TaskQueue {
+    PendingTask* buf;   //!< A dynamically allocated circular buffer.
+    size_t begin;   //!< The index of the first task.
+    size_t len; //!< The number of tasks.
+    size_t cap; //!< The buffer's capacity, zero or a power of two.
+} TaskQueue;
+
+/**
+ * Creates an empty TaskQueue.
+ * The TaskQueue must later be passed to <tt>tqueue_drop()</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param init (output parameter) address of the TaskQueue to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return a pointer to the initialized TaskQueue with address @p init.
+ */
+TaskQueue* tqueue_new(TaskQueue* init);
+
+/**
+ * Deallocates the TaskQueue, along with its tasks' command lines.
+ * <tt>O(len)</tt> complexity.
+ * @param self address of the TaskQueue to drop. <b>Must not be @p NULL.</b>
+ */
+void tqueue_drop(TaskQueue* self);
+
+/**
+ * Returns the number of tasks in the TaskQueue.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskQueue. <b>Must not be @p NULL.</b>
+ * @return the number of tasks.
+ */
+size_t tqueue_len(TaskQueue const* self);
+
+/**
+ * Returns the task @p index places from the front of the TaskQueue.
+ * If @p TASK_QUEUE_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(index < self->len)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskQueue. <b>Must not be @p NULL.</b>
+ * @param index the task's place. <b>Must be less than the number of
+ * tasks.</b>
+ * @return the address of the task, valid until the TaskQueue is next
+ * modified.
+ */
+PendingTask const* tqueue_get(TaskQueue const* self, size_t index);
+
+/**
+ * Copies a task's command line, and pushes it at the back of the TaskQueue.
+ * If @p TASK_QUEUE_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(cmd != NULL)</tt>;
+ * 3. <tt>assert(limits != NULL)</tt>.
+ * Amortized <tt>O(cmd_len)</tt> complexity.
+ * @param self address of the TaskQueue. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param cmd the task's command line, which needs not be null terminated.
+ * <b>Must not be @p NULL.</b>
+ * @param cmd_len the command line's length.
+ * @param limits the task's resource limits. <b>Must not be @p NULL.</b>
+ * @return @p false if memory allocation fails, otherwise @p true.
+ */
+bool tqueue_push(
+    TaskQueue* restrict self,
+    size_t task_id,
+    char const* restrict cmd,
+    size_t cmd_len,
+    TaskLimits const* restrict limits
+);
+
+/**
+ * Pops the task at the front of the TaskQueue, if any, handing its command
+ * line, which must later be passed to <tt>free()</tt>, to the caller.
+ * If @p TASK_QUEUE_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(task != NULL)</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskQueue. <b>Must not be @p NULL.</b>
+ * @param task (output parameter) address to which the task is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p false if the TaskQueue is empty, otherwise @p true.
+ */
+bool tqueue_pop(TaskQueue* restrict self, PendingTask* restrict task);
+
+/**
+ * Removes the task with id @p task_id, if queued, keeping the others in
+ * order, and hands its command line, which must later be passed to
+ * <tt>free()</tt>, to the caller.
+ * If @p TASK_QUEUE_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(task != NULL)</tt>.
+ * <tt>O(len)</tt> complexity.
+ * @param self address of the TaskQueue. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param task (output parameter) address to which the task is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p false if no task with id @p task_id is queued, otherwise
+ * @p true.
+ */
+bool tqueue_rm(
+    TaskQueue* restrict self,
+    size_t task_id,
+    PendingTask* restrict task
+);
+
+#endif  // TASK_TASK_QUEUE_H
@@ -0,0 +1,170 @@
+#ifndef TASK_TASK_SCHED_H
+#define TASK_TASK_SCHED_H
+
+#include "task/task_idx.h"
+#include "task/task_queue.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_SCHED_RUNTIME_ASSERTS 0
+
+/**
+ * The number of priority levels. Priorities range from @p 0 to
+ * <tt>TSCHED_LEVELS - 1</tt>, and greater ones are launched first.
+ */
+#define TSCHED_LEVELS 4ul
+
+/**
+ * An owner's pending tasks, at a single priority level.
+ */
+typedef struct SchedOwner {
+    size_t owner;   //!< Who submitted the tasks.
+    TaskQueue tasks;    //!< The tasks, in the order they were submitted.
+    size_t next_active; //!< The next owner with pending tasks at the level,
+                        //!< while this one has any.
+} SchedOwner;
+
+/**
+ * The pending tasks of a priority level, queued per owner. The owners with
+ * pending tasks form a circular list, which is served round-robin, a task at a
+ * time, so that an owner with many tasks queued doesn't hold up the others.
+ */
+typedef struct SchedLevel {
+    SchedOwner* owners; //!< The owners seen since the level was last empty.
+    size_t owners_len;  //!< The number of owners.
+    size_t owners_cap;  //!< The owners buffer's capacity.
+    TaskIdx owners_idx; //!< Maps owners to their index.
+    size_t last_active; //!< The index of the owner last served, whose next is
+                        //!< served next, or @p SIZE_MAX if none has tasks.
+} SchedLevel;
+
+/**
+ * The tasks admitted but not yet launched, from several owners, e.g. users, at
+ * several priority levels. The next task is picked from the greatest level
+ * with pending tasks, from its owners in turn, in <tt>O(TSCHED_LEVELS)</tt>,
+ * however many tasks and owners there are.
+ */
+typedef struct TaskSched {
+    SchedLevel levels[TSCHED_LEVELS];   //!< The levels, by priority.
+    size_t len; //!< The number of pending tasks.
+} TaskSched;
+
+/**
+ * Creates an empty TaskSched.
+ * The TaskSched must later be passed to <tt>tsched_drop()</tt>.
+ * <tt>O(TSCHED_LEVELS)</tt> complexity.
+ * @param init (output parameter) address of the TaskSched to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return a pointer to the initialized TaskSched with address @p init.
+ */
+TaskSched* tsched_new(TaskSched* init);
+
+/**
+ * Deallocates the TaskSched, along with its tasks' command lines.
+ * <tt>O(len + owners)</tt> complexity.
+ * @param self address of the TaskSched to drop. <b>Must not be @p NULL.</b>
+ */
+void tsched_drop(TaskSched* self);
+
+/**
+ * Returns the number of pending tasks.
+ * <tt>O(1)</tt> complexity.
+ * @param self address of the TaskSched. <b>Must not be @p NULL.</b>
+ * @return the number of pending tasks.
+ */
+size_t tsched_len(TaskSched const* self);
+
+/**
+ * Copies a task's command line, and queues it behind its owner's other tasks
+ * of the same priority.
+ * If @p TASK_SCHED_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(priority < TSCHED_LEVELS)</tt>;
+ * 3. <tt>assert(owner != SIZE_MAX)</tt>;
+ * 4. <tt>assert(cmd != NULL)</tt>;
+ * 5. <tt>assert(limits != NULL)</tt>.
+ * Amortized expected <tt>O(cmd_len)</tt> complexity.
+ * @param self address of the TaskSched. <b>Must not be @p NULL.</b>
+ * @param priority the task's priority. <b>Must be less than
+ * @p TSCHED_LEVELS.</b>
+ * @param owner who submitted the task. <b>Must not be @p SIZE_MAX.</b>
+ * @param task_id the task's id.
+ * @param cmd the task's command line, which needs not be null terminated.
+ * <b>Must not be @p NULL.</b>
+ * @param cmd_len the command line's length.
+ * @param limits the task's resource limits. <b>Must not be @p NULL.</b>
+ * @return @p false if memory allocation fails, otherwise @p true.
+ */
+bool tsched_push(
+    TaskSched* restrict self,
+    size_t priority,
+    size_t owner,
+    size_t task_id,
+    char const* restrict cmd,
+    size_t cmd_len,
+    TaskLimits const* restrict limits
+);
+
+/**
+ * Picks the next task to launch, if any: the oldest task of the next owner in
+ * turn, at the greatest priority with pending tasks. Its command line must
+ * later be passed to <tt>free()</tt>.
+ * If @p TASK_SCHED_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(task != NULL)</tt>.
+ * <tt>O(TSCHED_LEVELS)</tt> complexity.
+ * @param self address of the TaskSched. <b>Must not be @p NULL.</b>
+ * @param task (output parameter) address to which the task is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p false if there are no pending tasks, otherwise @p true.
+ */
+bool tsched_pop(TaskSched* restrict self, PendingTask* restrict task);
+
+/**
+ * Removes the task with id @p task_id, if pending. Its command line must later
+ * be passed to <tt>free()</tt>.
+ * If @p TASK_SCHED_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(task != NULL)</tt>.
+ * <tt>O(len)</tt> complexity.
+ * @param self address of the TaskSched. <b>Must not be @p NULL.</b>
+ * @param task_id the task's id.
+ * @param task (output parameter) address to which the task is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p false if no task with id @p task_id is pending, otherwise
+ * @p true.
+ */
+bool tsched_rm(
+    TaskSched* restrict self,
+    size_t task_id,
+    PendingTask* restrict task
+);
+
+/**
+ * Calls @p fn on every pending task, from the greatest priority to the least,
+ * and from each level's owners in turn, until it returns @p false.
+ * If @p TASK_SCHED_RUNTIME_ASSERTS is set to @p 1, the following assertions
+ * are made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(fn != NULL)</tt>.
+ * <tt>O(len)</tt> complexity.
+ * @param self address of the TaskSched. <b>Must not be @p NULL.</b>
+ * @param fn the function called with @p ctx, each task, and its priority.
+ * <b>Must not be @p NULL.</b>
+ * @param ctx passed to @p fn.
+ */
+void tsched_for_each(
+    TaskSched const* self,
+    bool (*fn)(void* ctx, PendingTask const* task, size_t priority),
+    void* ctx
+);
+
+#endif  // TASK_TASK_SCHED_H
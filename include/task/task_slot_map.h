@@ -0,0 +1,167 @@
+#ifndef TASK_TASK_SLOT_MAP_H
+#define TASK_TASK_SLOT_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TASK_SLOT_MAP_RUNTIME_ASSERTS 0
+
+/**
+ * The number of low bits of a TaskHandle holding its slot. The remaining high
+ * bits hold the slot's generation.
+ */
+#define TASK_HANDLE_SLOT_BITS (sizeof(size_t) * 4ul)
+
+struct Task;
+
+/**
+ * A stable reference to a Task in a TaskSlotMap: its slot, and the slot's
+ * generation when the Task was inserted. Once the Task is removed, the slot's
+ * generation changes, so the handle is detected as stale even if the slot is
+ * reused.
+ */
+typedef size_t TaskHandle;
+
+/**
+ * A slot of a TaskSlotMap.
+ */
+typedef struct TaskSlot {
+    size_t gen; //!< Incremented whenever the slot's Task is removed.
+    size_t dense_idx;   //!< The Task's index in the dense array, if occupied,
+                        //!< otherwise the next free slot.
+} TaskSlot;
+
+/**
+ * A container of Tasks with stable handles, <tt>O(1)</tt> insertion and
+ * removal, and contiguous iteration.
+ * Tasks are stored densely, so they're iterated like a TaskVec, and removed by
+ * moving the last Task into their place. Handles point to slots, which track
+ * where in the dense array each Task currently is. Free slots form a list.
+ */
+typedef struct TaskSlotMap {
+    struct Task* dense; //!< The Tasks, contiguously.
+    size_t* dense_slots;    //!< The slot of each Task in the dense array.
+    size_t len; //!< The number of Tasks.
+    size_t cap; //!< The capacity of the dense arrays.
+    TaskSlot* slots;    //!< The slots, occupied or free.
+    size_t slots_len;   //!< The number of slots ever used.
+    size_t slots_cap;   //!< The capacity of the slots array.
+    size_t free_head;   //!< The first free slot, or @p SIZE_MAX if none.
+} TaskSlotMap;
+
+/**
+ * Creates an empty TaskSlotMap.
+ * The TaskSlotMap must later be passed to <tt>tsmap_drop()</tt>.
+ * <tt>O(1)</tt> complexity.
+ * @param init (output parameter) the address of the TaskSlotMap to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return a pointer to the initialized TaskSlotMap with address @p init.
+ */
+TaskSlotMap* tsmap_new(TaskSlotMap* init);
+
+/**
+ * Deallocates the storage associated with a TaskSlotMap.
+ * <tt>O(free())</tt> complexity.
+ * @param self the address of the TaskSlotMap whose store shall be deallocated.
+ * <b>Must not be @p NULL.</b>
+ */
+void tsmap_drop(TaskSlotMap* self);
+
+/**
+ * Returns the number of Tasks in the TaskSlotMap.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @return the number of Tasks in the TaskSlotMap.
+ */
+size_t tsmap_len(TaskSlotMap const* self);
+
+/**
+ * Returns a readonly iterator to the first Task. Iteration order is arbitrary,
+ * and changes when Tasks are removed.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @return a readonly iterator to the first Task.
+ */
+struct Task const* tsmap_begin(TaskSlotMap const* self);
+
+/**
+ * Returns a mutable iterator to the first Task. Iteration order is arbitrary,
+ * and changes when Tasks are removed.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @return a mutable iterator to the first Task.
+ */
+struct Task* tsmap_begin_mut(TaskSlotMap* self);
+
+/**
+ * Returns an iterator to the end of the TaskSlotMap, i.e. a pointer to the
+ * past-the-end Task.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @return an iterator to the end of the TaskSlotMap.
+ */
+struct Task const* tsmap_end(TaskSlotMap const* self);
+
+/**
+ * Inserts a Task in the TaskSlotMap. The Task is shallow copied by means of
+ * the assignment operator @p =.
+ * If a reallocation occurs, reading from pointers to Tasks previously owned by
+ * the TaskSlotMap is undefined, but handles remain valid.
+ * If a reallocation fails, @p false is returned, and the TaskSlotMap is left
+ * unchanged.
+ * Amortized <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @param task the address of the Task to insert. <b>Must not be @p NULL.</b>
+ * @param handle (output parameter) the address to which the inserted Task's
+ * handle is stored. <b>Must not be @p NULL.</b>
+ * @return @p true if the Task was successfully inserted, @p false otherwise.
+ */
+bool tsmap_insert(
+    TaskSlotMap* restrict self,
+    struct Task const* restrict task,
+    TaskHandle* restrict handle
+);
+
+/**
+ * Returns a readonly pointer to the Task referenced by @p handle, or @p NULL
+ * if the handle is stale.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @param handle the Task's handle.
+ * @return a readonly pointer to the Task, or @p NULL if the handle is stale.
+ */
+struct Task const* tsmap_get(TaskSlotMap const* self, TaskHandle handle);
+
+/**
+ * Returns a mutable pointer to the Task referenced by @p handle, or @p NULL
+ * if the handle is stale.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @param handle the Task's handle.
+ * @return a mutable pointer to the Task, or @p NULL if the handle is stale.
+ */
+struct Task* tsmap_get_mut(TaskSlotMap* self, TaskHandle handle);
+
+/**
+ * Removes the Task referenced by @p handle, by moving the last Task of the
+ * dense array into its place, and frees its slot.
+ * If @p opt_task isn't @p NULL, the removed Task is shallow copied to it by
+ * means of the assignment operator @p =.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TaskSlotMap. <b>Must not be @p NULL.</b>
+ * @param handle the Task's handle.
+ * @param opt_task (output parameter) optional address of a Task to which the
+ * removed Task is shallow copied. If @p NULL, it is unused.
+ * @return @p true if the Task was removed, @p false if the handle is stale.
+ */
+bool tsmap_rm(
+    TaskSlotMap* restrict self,
+    TaskHandle handle,
+    struct Task* restrict opt_task
+);
+
+#endif  // TASK_TASK_SLOT_MAP_H
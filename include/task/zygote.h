@@ -0,0 +1,143 @@
+#ifndef TASK_ZYGOTE_H
+#define TASK_ZYGOTE_H
+
+#include "task/launcher.h"
+
+#include <sys/types.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define ZYGOTE_RUNTIME_ASSERTS 0
+
+/**
+ * The maximum length of a command line sent to the Zygote.
+ */
+#define ZYGOTE_MAX_CMD 4096ul
+
+/**
+ * The maximum number of stages of a command line sent to the Zygote.
+ */
+#define ZYGOTE_MAX_STAGES (ZYGOTE_MAX_CMD / 2ul + 1ul)
+
+/**
+ * A small helper process, forked before the server grows, which launches
+ * pipelines on the server's behalf. Forking from its small address space keeps
+ * launch latency flat regardless of the server's memory, and the stages it
+ * launches are made children of the server, which reaps them as usual.
+ */
+typedef struct Zygote {
+    int sock_des;   //!< The server's end of the socket pair.
+    pid_t pid;  //!< The Zygote's process id.
+} Zygote;
+
+/**
+ * The result of launching a pipeline through the Zygote.
+ */
+typedef struct ZygoteLaunch {
+    LauncherOutcome outcome;    //!< The outcome of parsing and launching.
+    int launch_errno;   //!< The error number, if @p outcome is an error.
+    size_t stage_count; //!< The number of stages launched.
+    size_t relay_count; //!< The number of relayed pipes.
+    pid_t pids[ZYGOTE_MAX_STAGES];  //!< The process id of each stage.
+    int relay_fds[2ul * LAUNCHER_MAX_RELAYS];   //!< The caller's ends of the
+                                                //!< relayed pipes, as in a
+                                                //!< Pipeline, received along
+                                                //!< with the reply.
+} ZygoteLaunch;
+
+/**
+ * An outcome returned by Zygote functions.
+ */
+typedef enum ZygoteOutcome {
+    ZYGOTE_OK,  //!< No error.
+    ZYGOTE_ERR_TOO_LARGE,   //!< Command longer than @p ZYGOTE_MAX_CMD.
+    ZYGOTE_ERR_SOCKET_FAIL, //!< Error occurred while creating the socket pair.
+    ZYGOTE_ERR_FORK_FAIL,   //!< Error occurred while forking the Zygote.
+    ZYGOTE_ERR_SEND_FAIL,   //!< Error occurred while sending a request.
+    ZYGOTE_ERR_RECV_FAIL,   //!< Error occurred while receiving a reply, or
+                            //!< the Zygote is gone.
+    ZYGOTE_ERR_CLOSE_FAIL,  //!< Error occurred while closing the socket.
+} ZygoteOutcome;
+
+/**
+ * Forks the Zygote. It should be called as early as possible, while the
+ * caller's address space is still small. The Zygote runs in a session of its
+ * own, with the caller's signal mask and dispositions at the time of the call,
+ * and exits once its socket is closed.
+ * The Zygote must later be passed to <tt>zygote_drop()</tt>.
+ * If @p ZYGOTE_RUNTIME_ASSERTS is set to @p 1, the following assertion is
+ * made:
+ * 1. <tt>assert(init != NULL)</tt>.
+ * <tt>O(fork())</tt> complexity.
+ * @param init (output parameter) address of the Zygote to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return @p ZYGOTE_ERR_SOCKET_FAIL if creating the socket pair fails,
+ * otherwise @p ZYGOTE_ERR_FORK_FAIL if forking fails, otherwise @p ZYGOTE_OK.
+ */
+ZygoteOutcome zygote_new(Zygote* init);
+
+/**
+ * Closes the socket to the Zygote, which exits in turn.
+ * <tt>O(close())</tt> complexity.
+ * @param self address of the Zygote to drop. <b>Must not be @p NULL.</b>
+ * @return @p ZYGOTE_ERR_CLOSE_FAIL if closing the socket fails, otherwise
+ * @p ZYGOTE_OK.
+ */
+ZygoteOutcome zygote_drop(Zygote* self);
+
+/**
+ * Asks the Zygote to parse and launch a pipeline, as <tt>pipeline_launch()</tt>
+ * would, and waits for the stages' process ids. Each stage joins the cgroup
+ * of @p cgroup_fd, if any, before executing, so that none of its children
+ * escape it. The last stage's stdout, the cgroup's @p cgroup.procs, and the
+ * caller's ends of the relayed pipes, are passed over the socket. The latter
+ * are owned by the caller.
+ * If @p ZYGOTE_RUNTIME_ASSERTS is set to @p 1, the following assertions are
+ * made:
+ * 1. <tt>assert(self != NULL)</tt>;
+ * 2. <tt>assert(cmd != NULL)</tt>;
+ * 3. <tt>assert(launch != NULL)</tt>.
+ * <tt>O(stage_count * fork())</tt> complexity, on the Zygote's small address
+ * space.
+ * @param self address of the Zygote. <b>Must not be @p NULL.</b>
+ * @param cmd the command line, which needs not be null terminated.
+ * <b>Must not be @p NULL.</b>
+ * @param len the command line's length.
+ * @param is_relayed if the stages' traffic should be relayed by the caller.
+ * @param out_fd the last stage's stdout, or @p -1 to inherit the Zygote's.
+ * @param cgroup_fd the @p cgroup.procs of the cgroup the stages join, or
+ * @p -1.
+ * @param launch (output parameter) address of the launch's result, only
+ * meaningful if @p ZYGOTE_OK is returned. <b>Must not be @p NULL.</b>
+ * @return @p ZYGOTE_ERR_TOO_LARGE if @p len exceeds @p ZYGOTE_MAX_CMD,
+ * otherwise @p ZYGOTE_ERR_SEND_FAIL or @p ZYGOTE_ERR_RECV_FAIL if talking to
+ * the Zygote fails, otherwise @p ZYGOTE_OK.
+ */
+ZygoteOutcome zygote_launch(
+    Zygote* restrict self,
+    char const* restrict cmd,
+    size_t len,
+    bool is_relayed,
+    int out_fd,
+    int cgroup_fd,
+    ZygoteLaunch* restrict launch
+);
+
+/**
+ * Returns the message associated with the ZygoteOutcome.
+ * <tt>O(1)</tt> complexity.
+ * @param outcome the ZygoteOutcome whose associated message is returned. If
+ * not a valid ZygoteOutcome, a message describing that the outcome is unknown
+ * is returned.
+ * @param opt_errno optional address of an error number whose description is
+ * appended to the message. If @p NULL, it is unused.
+ * @return the message associated with the ZygoteOutcome.
+ */
+char const* zygote_outcome_msg(ZygoteOutcome outcome, int const* opt_errno);
+
+#endif  // TASK_ZYGOTE_H
@@ -0,0 +1,153 @@
+#ifndef TIMER_TIMER_WHEEL_H
+#define TIMER_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * If set to @p 1, perform runtime assertions on possibly invalid function
+ * arguments.
+ */
+#define TIMER_WHEEL_RUNTIME_ASSERTS 0
+
+/**
+ * The number of levels of a TimerWheel.
+ */
+#define TWHEEL_LEVELS 4ul
+
+/**
+ * The number of bits of a tick indexing a level's slots.
+ */
+#define TWHEEL_SLOT_BITS 6ul
+
+/**
+ * The number of slots of each level of a TimerWheel.
+ */
+#define TWHEEL_SLOTS (1ul << TWHEEL_SLOT_BITS)
+
+/**
+ * An id which is never assigned to a timer.
+ */
+#define TWHEEL_NO_TIMER SIZE_MAX
+
+/**
+ * A pending timer, linked into one of the TimerWheel's slots.
+ */
+typedef struct TimerNode {
+    uint64_t expiry;    //!< The tick at which the timer expires.
+    size_t data;    //!< Caller defined data.
+    uint32_t tag;   //!< Caller defined tag, e.g. the timer's kind.
+    uint32_t slot;  //!< The slot the timer is linked into, as an index of
+                    //!< the flattened slots.
+    size_t prev;    //!< The previous node in the slot, or @p TWHEEL_NO_TIMER.
+    size_t next;    //!< The next node in the slot, or in the free list.
+} TimerNode;
+
+/**
+ * A hierarchical timer wheel: each level has @p TWHEEL_SLOTS slots, and each
+ * slot of a level spans as many ticks as the whole level below. Timers are
+ * placed in the lowest level whose span covers them, and cascade down a level
+ * whenever the level below wraps around, so each tick costs <tt>O(1)</tt>
+ * amortized, no matter how many timers are pending.
+ * Timers are stored in a pool, and referred to by their index in it, which
+ * stays valid until the timer expires or is cancelled.
+ */
+typedef struct TimerWheel {
+    TimerNode* nodes;   //!< The pool of timers.
+    size_t nodes_len;   //!< The number of pool entries ever used.
+    size_t nodes_cap;   //!< The capacity of the pool.
+    size_t free_head;   //!< The first free pool entry, or @p TWHEEL_NO_TIMER.
+    size_t len; //!< The number of pending timers.
+    uint64_t now;   //!< The current tick.
+    size_t slots[TWHEEL_LEVELS][TWHEEL_SLOTS];  //!< The first timer of each
+                                                //!< slot.
+} TimerWheel;
+
+/**
+ * Called for every expired timer, with the timer's tag and data.
+ */
+typedef void (*TimerCallback)(void* ctx, uint32_t tag, size_t data);
+
+/**
+ * Creates an empty TimerWheel, at tick @p 0.
+ * The TimerWheel must later be passed to <tt>twheel_drop()</tt>.
+ * <tt>O(TWHEEL_LEVELS * TWHEEL_SLOTS)</tt> complexity.
+ * @param init (output parameter) the address of the TimerWheel to initialize.
+ * <b>Must not be @p NULL.</b>
+ * @return a pointer to the initialized TimerWheel with address @p init.
+ */
+TimerWheel* twheel_new(TimerWheel* init);
+
+/**
+ * Deallocates the storage associated with a TimerWheel.
+ * <tt>O(free())</tt> complexity.
+ * @param self the address of the TimerWheel. <b>Must not be @p NULL.</b>
+ */
+void twheel_drop(TimerWheel* self);
+
+/**
+ * Returns the number of pending timers.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TimerWheel. <b>Must not be @p NULL.</b>
+ * @return the number of pending timers.
+ */
+size_t twheel_len(TimerWheel const* self);
+
+/**
+ * Returns the current tick, i.e. the number of ticks the TimerWheel was
+ * advanced by.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TimerWheel. <b>Must not be @p NULL.</b>
+ * @return the current tick.
+ */
+uint64_t twheel_now(TimerWheel const* self);
+
+/**
+ * Adds a timer expiring @p delay ticks from now, or one tick from now if
+ * @p delay is @p 0.
+ * If growing the pool fails, @p false is returned.
+ * Amortized <tt>O(1)</tt> complexity.
+ * @param self the address of the TimerWheel. <b>Must not be @p NULL.</b>
+ * @param delay the number of ticks until the timer expires.
+ * @param tag caller defined tag, passed to the TimerCallback.
+ * @param data caller defined data, passed to the TimerCallback.
+ * @param id (output parameter) address to which the timer's id is stored.
+ * <b>Must not be @p NULL.</b>
+ * @return @p true if the timer was added, @p false otherwise.
+ */
+bool twheel_add(
+    TimerWheel* restrict self,
+    uint64_t delay,
+    uint32_t tag,
+    size_t data,
+    size_t* restrict id
+);
+
+/**
+ * Cancels a pending timer.
+ * <tt>O(1)</tt> complexity.
+ * @param self the address of the TimerWheel. <b>Must not be @p NULL.</b>
+ * @param id the id of a pending timer.
+ */
+void twheel_cancel(TimerWheel* self, size_t id);
+
+/**
+ * Advances the TimerWheel by @p ticks, calling @p callback for every timer
+ * that expires, in expiry order. Timers may be added and cancelled from
+ * within @p callback.
+ * <tt>O(ticks + expired timers)</tt> amortized complexity.
+ * @param self the address of the TimerWheel. <b>Must not be @p NULL.</b>
+ * @param ticks the number of ticks elapsed.
+ * @param callback the function called for every expired timer.
+ * <b>Must not be @p NULL.</b>
+ * @param ctx passed to @p callback.
+ */
+void twheel_advance(
+    TimerWheel* self,
+    uint64_t ticks,
+    TimerCallback callback,
+    void* ctx
+);
+
+#endif  // TIMER_TIMER_WHEEL_H
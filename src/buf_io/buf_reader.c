@@ -1,10 +1,15 @@
 #include "buf_io/buf_reader.h"
 
+#include "scan.h"
+
 #include <unistd.h>
 
 #include <sys/uio.h>
 
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -16,15 +21,125 @@
 #define thread_local _Thread_local
 #endif  // thread_local
 
-#define try_read_(fd, buf, n) \
-    if (read(fd, buf, n) == -1l) return BR_ERR_READ_FAIL
-
-#define try_readv_(fd, iov, iovcnt) \
-    if (readv(fd, iov, iovcnt) == -1l) return BR_ERR_READ_FAIL
-
 #define DEFAULT_CAP 8192ul
 #define OUTCOME_MSG_SIZE 1024ul
 
+/**
+ * Returns the index past the buffered bytes' first segment, i.e. of those up
+ * to the end of the buffer.
+ */
+static size_t first_end_(BufReader const* const self) {
+    return self->end < self->cap ? self->end : self->cap;
+}
+
+/**
+ * Reads once from the file into the free space, which may wrap around the end
+ * of the buffer, and so takes both segments of a single <tt>readv(2)</tt>.
+ * <b>The buffer must not be full.</b>
+ */
+static BrOutcome fill_(BufReader* const self, size_t* const read_bytes) {
+    if (self->begin == self->end) {
+        self->begin = 0ul;
+        self->end = 0ul;
+    }
+    struct iovec iov[2];
+    int iov_count = 1;
+    if (self->end < self->cap) {
+        iov[0] = (struct iovec) {
+            .iov_base = self->buf + self->end,
+            .iov_len = self->cap - self->end
+        };
+        if (self->begin > 0ul) {
+            iov[1] = (struct iovec) {
+                .iov_base = self->buf,
+                .iov_len = self->begin
+            };
+            iov_count = 2;
+        }
+    } else {
+        iov[0] = (struct iovec) {
+            .iov_base = self->buf + (self->end - self->cap),
+            .iov_len = self->begin - (self->end - self->cap)
+        };
+    }
+    ssize_t read_len;
+    while ((read_len = readv(self->file_des, iov, iov_count)) == -1l) {
+        if (errno != EINTR) {
+            return BR_ERR_READ_FAIL;
+        }
+    }
+    self->end += (size_t) read_len;
+    *read_bytes = (size_t) read_len;
+    return BR_OK;
+}
+
+static void consume_(BufReader* const self, size_t const n) {
+    self->begin += n;
+    if (self->begin == self->end) {
+        self->begin = 0ul;
+        self->end = 0ul;
+    } else if (self->begin >= self->cap) {
+        self->begin -= self->cap;
+        self->end -= self->cap;
+    }
+}
+
+static void reverse_(char* const buf, size_t const len) {
+    for (size_t i = 0ul, j = len; i + 1ul < j; ++i) {
+        --j;
+        char const c = buf[i];
+        buf[i] = buf[j];
+        buf[j] = c;
+    }
+}
+
+/**
+ * Rotates the buffer so that the buffered bytes start at its beginning, in
+ * place.
+ */
+static void linearize_(BufReader* const self) {
+    reverse_(self->buf, self->begin);
+    reverse_(self->buf + self->begin, self->cap - self->begin);
+    reverse_(self->buf, self->cap);
+    self->end -= self->begin;
+    self->begin = 0ul;
+}
+
+/**
+ * Returns the offset, from the first buffered byte, of the first newline at or
+ * after @p from, or @p SIZE_MAX if there's none.
+ */
+static size_t find_newline_(BufReader const* const self, size_t const from) {
+    size_t const first_end = first_end_(self);
+    size_t const first_len = first_end - self->begin;
+    if (from < first_len) {
+        char const* const first_begin = self->buf + self->begin;
+        char const* const newline = scan_find(
+            first_begin + from,
+            first_begin + first_len,
+            SCAN_NEWLINE
+        );
+        if (newline != first_begin + first_len) {
+            return (size_t) (newline - first_begin);
+        }
+    }
+    if (self->end <= self->cap) {
+        return SIZE_MAX;
+    }
+    size_t const second_from = from > first_len ? from - first_len : 0ul;
+    size_t const second_len = self->end - self->cap;
+    if (second_from >= second_len) {
+        return SIZE_MAX;
+    }
+    char const* const newline = scan_find(
+        self->buf + second_from,
+        self->buf + second_len,
+        SCAN_NEWLINE
+    );
+    return newline != self->buf + second_len ?
+        first_len + (size_t) (newline - self->buf) : SIZE_MAX;
+}
+
 BrOutcome br_with_default_cap(BufReader* const init, int const file_des) {
     static_assert(
         DEFAULT_CAP > 0ul,
@@ -33,7 +148,7 @@ BrOutcome br_with_default_cap(BufReader* const init, int const file_des) {
 
 #   if BUF_READER_RUNTIME_ASSERTS
     assert(init != NULL);
-    assert(file_des > 0);
+    assert(file_des >= 0);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
     init->buf = malloc(DEFAULT_CAP);
@@ -54,7 +169,7 @@ BrOutcome br_with_cap(
 ) {
 #   if BUF_READER_RUNTIME_ASSERTS
     assert(init != NULL);
-    assert(file_des > 0);
+    assert(file_des >= 0);
     assert(capacity > 0ul);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
@@ -77,7 +192,7 @@ void br_with_buf(
 ) {
 #   if BUF_READER_RUNTIME_ASSERTS
     assert(init != NULL);
-    assert(file_des > 0);
+    assert(file_des >= 0);
     assert(buf != NULL);
     assert(buf_size > 0ul);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
@@ -132,7 +247,7 @@ char* br_replace_buf(
 int br_replace_file(BufReader* const self, int const new_file_des) {
 #   if BUF_READER_RUNTIME_ASSERTS
     assert(self != NULL);
-    assert(new_file_des > 0);
+    assert(new_file_des >= 0);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
     int const old_descriptor = self->file_des;
@@ -174,15 +289,12 @@ char* br_internal_buf_mut(BufReader* const self) {
     return self->buf;
 }
 
-// TODO: implement.
 size_t br_available_bytes(BufReader const* const self) {
 #   if BUF_READER_RUNTIME_ASSERTS
     assert(self != NULL);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
-    (void) self;
-
-    return 0ul;
+    return self->end - self->begin;
 }
 
 size_t br_cap(BufReader const* const self) {
@@ -193,11 +305,10 @@ size_t br_cap(BufReader const* const self) {
     return self->cap;
 }
 
-// TODO: implement.
 BrOutcome br_read(
     BufReader* const restrict self,
     char* const restrict buf,
-    size_t n,
+    size_t const n,
     size_t* const restrict read_bytes
 ) {
 #   if BUF_READER_RUNTIME_ASSERTS
@@ -206,15 +317,45 @@ BrOutcome br_read(
     assert(read_bytes != NULL);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
-    (void) self;
-    (void) buf;
-    (void) n;
-    (void) read_bytes;
-
+    size_t done = 0ul;
+    while (done < n) {
+        if (self->begin == self->end) {
+            size_t filled;
+            // reads that would fill the buffer anyway bypass it
+            if (n - done >= self->cap) {
+                ssize_t read_len;
+                while ((read_len =
+                    read(self->file_des, buf + done, n - done)) == -1l
+                ) {
+                    if (errno != EINTR) {
+                        *read_bytes = done;
+                        return BR_ERR_READ_FAIL;
+                    }
+                }
+                if (read_len == 0l) {
+                    break;
+                }
+                done += (size_t) read_len;
+                continue;
+            }
+            if (fill_(self, &filled) != BR_OK) {
+                *read_bytes = done;
+                return BR_ERR_READ_FAIL;
+            }
+            if (filled == 0ul) {
+                break;
+            }
+        }
+        size_t chunk = first_end_(self) - self->begin;
+        chunk = chunk < n - done ? chunk : n - done;
+        memcpy(buf + done, self->buf + self->begin, chunk);
+        consume_(self, chunk);
+        done += chunk;
+    }
+    *read_bytes = done;
     return BR_OK;
 }
 
-// TODO: implement.
 BrOutcome br_read_line(
     BufReader* const restrict self,
     char* const restrict buf,
@@ -227,36 +368,124 @@ BrOutcome br_read_line(
     assert(read_bytes != NULL);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
-    (void) self;
-    (void) buf;
-    (void) n;
-    (void) read_bytes;
-
+    size_t done = 0ul;
+    while (done < n) {
+        if (self->begin == self->end) {
+            size_t filled;
+            if (fill_(self, &filled) != BR_OK) {
+                *read_bytes = done;
+                return BR_ERR_READ_FAIL;
+            }
+            if (filled == 0ul) {
+                break;
+            }
+        }
+        size_t chunk = first_end_(self) - self->begin;
+        chunk = chunk < n - done ? chunk : n - done;
+        char const* const src = self->buf + self->begin;
+        char const* const newline = scan_find(src, src + chunk, SCAN_NEWLINE);
+        if (newline != src + chunk) {
+            size_t const line_len = (size_t) (newline - src);
+            memcpy(buf + done, src, line_len);
+            consume_(self, line_len + 1ul);
+            done += line_len;
+            break;
+        }
+        memcpy(buf + done, src, chunk);
+        consume_(self, chunk);
+        done += chunk;
+    }
+    *read_bytes = done;
     return BR_OK;
 }
 
-// TODO: implement.
 BrOutcome br_read_char(BufReader* const restrict self, char* const restrict c) {
 #   if BUF_READER_RUNTIME_ASSERTS
     assert(self != NULL);
     assert(c != NULL);
 #   endif  // BUF_READER_RUNTIME_ASSERTS
 
-    (void) self;
-    (void) c;
+    if (self->begin == self->end) {
+        size_t filled;
+        if (fill_(self, &filled) != BR_OK) {
+            return BR_ERR_READ_FAIL;
+        }
+        if (filled == 0ul) {
+            return BR_EOF;
+        }
+    }
+    *c = self->buf[self->begin];
+    consume_(self, 1ul);
+    return BR_OK;
+}
 
+BrOutcome br_peek_line(
+    BufReader* const restrict self,
+    char const** const restrict line,
+    size_t* const restrict line_len
+) {
+#   if BUF_READER_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(line != NULL);
+    assert(line_len != NULL);
+#   endif  // BUF_READER_RUNTIME_ASSERTS
+
+    // bytes already searched aren't searched again after a refill
+    size_t searched = 0ul;
+    size_t len;
+    for (;;) {
+        size_t const available = self->end - self->begin;
+        size_t const newline = find_newline_(self, searched);
+        if (newline != SIZE_MAX) {
+            len = newline + 1ul;
+            break;
+        }
+        if (available == self->cap) {
+            len = available;
+            break;
+        }
+        searched = available;
+        size_t filled;
+        if (fill_(self, &filled) != BR_OK) {
+            return BR_ERR_READ_FAIL;
+        }
+        if (filled == 0ul) {
+            if (available == 0ul) {
+                *line = NULL;
+                *line_len = 0ul;
+                return BR_EOF;
+            }
+            len = available;
+            break;
+        }
+    }
+    if (self->begin + len > self->cap) {
+        linearize_(self);
+    }
+    *line = self->buf + self->begin;
+    *line_len = len;
     return BR_OK;
 }
 
+void br_consume(BufReader* const self, size_t const n) {
+#   if BUF_READER_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(n <= br_available_bytes(self));
+#   endif  // BUF_READER_RUNTIME_ASSERTS
+
+    consume_(self, n);
+}
+
 char const* br_outcome_msg(
     BrOutcome const outcome,
     int const* const opt_errno
 ) {
     static_assert(
         BR_OK == 0 &&
-            BR_ERR_ALLOC_FAIL == 1 &&
-            BR_ERR_READ_FAIL == 2 &&
-            BR_ERR_CLOSE_FAIL == 3,
+            BR_EOF == 1 &&
+            BR_ERR_ALLOC_FAIL == 2 &&
+            BR_ERR_READ_FAIL == 3 &&
+            BR_ERR_CLOSE_FAIL == 4,
         "Unexpected BrOutcome enumerate values"
     );
 
@@ -266,6 +495,7 @@ char const* br_outcome_msg(
 
     static char const* const msgs[] = {
         "success",
+        "end of file reached",
         "failed allocating dynamic memory for the BufReader",
         "failed reading from the file descriptor",
         "failed closing the file",
@@ -286,7 +516,9 @@ char const* br_outcome_msg(
             );
             return msg_with_err;
         }
+        return msgs[outcome];
     case BR_OK:
+    case BR_EOF:
         return msgs[outcome];
     default:
         return msgs[sizeof msgs / sizeof *msgs - 1];
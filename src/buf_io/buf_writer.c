@@ -27,7 +27,10 @@
 #define is_at_max_cap_(self) ((self)->pos == (self)->cap)
 
 #define try_flush_(self) \
-    if (self->pos > 0ul) try_write_(self->file_des, self->buf, self->pos)
+    if ((self)->pos > 0ul) { \
+        try_write_((self)->file_des, (self)->buf, (self)->pos); \
+        (self)->pos = 0ul; \
+    }
 
 #define DEFAULT_CAP 8192ul
 #define OUTCOME_MSG_SIZE 1024ul
@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+
+#include "buf_io/write_queue.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/sendfile.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define FIRST_ALLOC_CAP 4096ul
+#define OUTCOME_MSG_SIZE 1024ul
+
+/**
+ * The maximum number of bytes of the file range moved by a single system call.
+ */
+#define FILE_CHUNK_SIZE (1ul << 20ul)
+
+/**
+ * Ensures there's room for @p n more bytes past the end, compacting the
+ * pending bytes to the beginning of the buffer before growing it.
+ */
+static bool reserve_(WriteQueue* const self, size_t const n) {
+    if (self->cap - self->end >= n) {
+        return true;
+    }
+    size_t const pending = self->end - self->begin;
+    if (self->begin > 0ul) {
+        memmove(self->buf, self->buf + self->begin, pending);
+        self->begin = 0ul;
+        self->end = pending;
+        if (self->cap - self->end >= n) {
+            return true;
+        }
+    }
+    size_t new_cap = self->cap != 0ul ? self->cap : FIRST_ALLOC_CAP;
+    size_t needed;
+    if (__builtin_add_overflow(pending, n, &needed)) {
+        return false;
+    }
+    while (new_cap < needed) {
+        if (__builtin_mul_overflow(new_cap, 2ul, &new_cap)) {
+            return false;
+        }
+    }
+    char* const new_buf = realloc(self->buf, new_cap);
+    if (!new_buf) {
+        return false;
+    }
+    self->buf = new_buf;
+    self->cap = new_cap;
+    return true;
+}
+
+void wq_new(WriteQueue* const init) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    init->buf = NULL;
+    init->begin = 0ul;
+    init->end = 0ul;
+    init->cap = 0ul;
+    init->file_des = -1;
+    init->file_off = 0u;
+    init->file_left = 0u;
+}
+
+void wq_drop(WriteQueue* const self) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    free(self->buf);
+    self->buf = NULL;
+    self->begin = 0ul;
+    self->end = 0ul;
+    self->cap = 0ul;
+    self->file_des = -1;
+    self->file_left = 0u;
+}
+
+size_t wq_pending_bytes(WriteQueue const* const self) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    return self->end - self->begin + (size_t) self->file_left;
+}
+
+bool wq_is_empty(WriteQueue const* const self) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    return self->end == self->begin && self->file_left == 0u;
+}
+
+WqOutcome wq_push(
+    WriteQueue* const restrict self,
+    char const* const restrict buf,
+    size_t const n
+) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(buf != NULL || n == 0ul);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    if (n == 0ul) {
+        return WQ_OK;
+    }
+    if (!reserve_(self, n)) {
+        return WQ_ERR_ALLOC_FAIL;
+    }
+    memcpy(self->buf + self->end, buf, n);
+    self->end += n;
+    return WQ_OK;
+}
+
+WqOutcome wq_push_line(
+    WriteQueue* const restrict self,
+    char const* const restrict buf,
+    size_t const n
+) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(buf != NULL || n == 0ul);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    if (n == SIZE_MAX || !reserve_(self, n + 1ul)) {
+        return WQ_ERR_ALLOC_FAIL;
+    }
+    memcpy(self->buf + self->end, buf, n);
+    self->end += n;
+    self->buf[self->end++] = '\n';
+    return WQ_OK;
+}
+
+WqOutcome wq_push_file(
+    WriteQueue* const self,
+    int const file_des,
+    uint64_t const offset,
+    uint64_t const len
+) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(self->file_des == -1);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    if (
+        self->file_des != -1 ||
+        offset > (uint64_t) INT64_MAX ||
+        len > (uint64_t) INT64_MAX - offset
+    ) {
+        return WQ_ERR_BAD_RANGE;
+    }
+    if (len == 0u) {
+        return WQ_OK;
+    }
+    self->file_des = file_des;
+    self->file_off = offset;
+    self->file_left = len;
+    return WQ_OK;
+}
+
+/**
+ * Moves as much of the file range as possible to @p file_des, within the
+ * kernel.
+ */
+static WqOutcome flush_file_(WriteQueue* const self, int const file_des) {
+    bool can_splice = true;
+    while (self->file_left > 0u) {
+        size_t const chunk_len = self->file_left < FILE_CHUNK_SIZE ?
+            (size_t) self->file_left : FILE_CHUNK_SIZE;
+        off_t off = (off_t) self->file_off;
+        ssize_t moved;
+        if (can_splice) {
+            moved = splice(
+                self->file_des,
+                &off,
+                file_des,
+                NULL,
+                chunk_len,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK
+            );
+            // splice() needs a pipe on one end
+            if (moved == -1l && errno == EINVAL) {
+                can_splice = false;
+                continue;
+            }
+        } else {
+            moved = sendfile(file_des, self->file_des, &off, chunk_len);
+        }
+        if (moved == -1l) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return WQ_PENDING;
+            }
+            return WQ_ERR_WRITE_FAIL;
+        }
+        if (moved == 0l) {
+            // the file is shorter than the range
+            errno = ENODATA;
+            return WQ_ERR_WRITE_FAIL;
+        }
+        self->file_off += (uint64_t) moved;
+        self->file_left -= (uint64_t) moved;
+    }
+    self->file_des = -1;
+    return WQ_OK;
+}
+
+WqOutcome wq_flush(WriteQueue* const self, int const file_des) {
+#   if WRITE_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // WRITE_QUEUE_RUNTIME_ASSERTS
+
+    while (self->begin != self->end) {
+        ssize_t const written =
+            write(file_des, self->buf + self->begin, self->end - self->begin);
+        if (written == -1l) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return WQ_PENDING;
+            }
+            return WQ_ERR_WRITE_FAIL;
+        }
+        self->begin += (size_t) written;
+    }
+    self->begin = 0ul;
+    self->end = 0ul;
+    return self->file_left > 0u ? flush_file_(self, file_des) : WQ_OK;
+}
+
+char const* wq_outcome_msg(
+    WqOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        WQ_OK == 0 &&
+            WQ_PENDING == 1 &&
+            WQ_ERR_ALLOC_FAIL == 2 &&
+            WQ_ERR_WRITE_FAIL == 3 &&
+            WQ_ERR_BAD_RANGE == 4,
+        "Unexpected WqOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "the file descriptor would block",
+        "failed allocating dynamic memory for the WriteQueue",
+        "failed writing to the file descriptor",
+        "the file range can't be queued",
+        "unknown WriteQueue error"
+    };
+    switch (outcome) {
+    case WQ_ERR_ALLOC_FAIL:
+    case WQ_ERR_WRITE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case WQ_OK:
+    case WQ_PENDING:
+    case WQ_ERR_BAD_RANGE:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
@@ -1,238 +1,414 @@
+#define _GNU_SOURCE
+
 #include "argus_conf.h"
+#include "buf_io/buf_reader.h"
 #include "buf_io/buf_writer.h"
 #include "comfy_io.h"
 #include "parse_size.h"
+#include "proto/frame.h"
+#include "proto/history_query.h"
+#include "scan.h"
+#include "task/task_board.h"
+#include "task/task_cgroup.h"
 
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
-#include <ctype.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
 #include <errno.h>
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define try_write_cmd_(cmd, argv) \
-    if (write_cmd(cmd, (char const**) argv) == EXIT_FAILURE) return EXIT_FAILURE
-
-#define try_write_cmd_i_(cmd, arg_start, line_end) \
-    if (write_cmd_i(cmd, arg_start, line_end) == EXIT_FAILURE) \
+#define try_write_exec_frame_(flags, limits, task, task_len) \
+    if (write_exec_frame(flags, limits, task, task_len) == EXIT_FAILURE) \
         return EXIT_FAILURE
 
+#define try_write_size_frame_(opcode, value) \
+    if (write_size_frame(opcode, value) == EXIT_FAILURE) return EXIT_FAILURE
+
 #define LINE_BUF_SIZE 8192ul
 
+/**
+ * The maximum number of bytes of a reply moved by a single splice(2).
+ */
+#define SPLICE_SIZE (1ul << 20ul)
+
 static char const* const program_name = "argus";
 static int commands_fd;
-static int running_tasks_fd;
-static int finished_tasks_fd;
+static bool is_connected;
 static BufWriter commands_writter;
 
-static char const arg_strs[][2] = {
-    "e ", "t ", "m ", "i ", "l ", "r ", "h ",
-};
+static uint32_t next_request_id;
 
 typedef enum {
     EXEC_TASK,
     END_TASK,
     SET_ACTIVE_TIMEOUT,
     SET_INACTIVE_TIMEOUT,
+    SET_MAX_RUNNING,
     LIST_RUNNING_TASKS,
     LIST_FINISHED_TASKS,
+    OUTPUT,
     HELP,
 } Command;
 
-static int write_cmd(Command const cmd, char const* const argv[const]) {
-    switch (cmd) {
-        case EXEC_TASK:
-        case END_TASK:
-        case SET_ACTIVE_TIMEOUT:
-        case SET_INACTIVE_TIMEOUT: {
-            BwOutcome const bw_write_outcome =
-                bw_write(
-                    &commands_writter,
-                    arg_strs[cmd],
-                    sizeof arg_strs[cmd]
-                );
-            if (bw_write_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed writing a command to the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_write_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            BwOutcome const bw_write_line_outcome =
-                bw_write_line(
-                    &commands_writter,
-                    argv[2],
-                    strlen(argv[2])
-                );
-            if (bw_write_line_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed writing a command to the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_write_line_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            BwOutcome const bw_flush_outcome = bw_flush(&commands_writter);
-            if (bw_flush_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed flushing commands from the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_flush_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            break;
-        }
-        case LIST_RUNNING_TASKS:
-        case LIST_FINISHED_TASKS: {
-            BwOutcome const bw_write_line_outcome =
-                bw_write_line(
-                    &commands_writter,
-                    arg_strs[cmd],
-                    sizeof arg_strs[cmd]
-                );
-            if (bw_write_line_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed writing a command to the commands fifo buffered"
-                        " writer:  %s.",
-                    bw_outcome_msg(bw_write_line_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            BwOutcome const bw_flush_outcome = bw_flush(&commands_writter);
-            if (bw_flush_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed flushing commands from the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_flush_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            break;
+/**
+ * Connects to the server's commands socket, or, if the server isn't listening
+ * on one, opens the commands fifo.
+ */
+static int open_commands(void) {
+    int const fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd != -1) {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        strncpy(
+            addr.sun_path,
+            commands_socketname,
+            sizeof addr.sun_path - 1ul
+        );
+        if (connect(fd, (struct sockaddr const*) &addr, sizeof addr) == 0) {
+            is_connected = true;
+            return fd;
         }
-        case HELP:
-            break;
-        default:
-            break;
+        close(fd);
+    }
+    return open(commands_fifoname, O_WRONLY);
+}
+
+/**
+ * Buffers a single frame in the commands fifo writer. The writer only ever
+ * flushes whole frames, each write(2) at most PIPE_BUF bytes, so they're never
+ * interleaved with other clients' frames.
+ */
+static int queue_frame(
+    FrameOpcode const opcode,
+    uint16_t const flags,
+    void const* const payload,
+    size_t const len
+) {
+    FrameOutcome const write_outcome =
+        frame_write(
+            &commands_writter,
+            &(FrameHeader) {
+                .opcode = opcode,
+                .flags = flags,
+                .request_id = next_request_id++,
+                .client_pid = (uint32_t) getpid()
+            },
+            payload,
+            len
+        );
+    if (write_outcome != FRAME_OK) {
+        program_eprintln(
+            "Failed writing a command to the commands fifo: %s.",
+            frame_outcome_msg(write_outcome, &errno)
+        );
+        return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
 }
 
-static int write_cmd_i(
-    Command const cmd,
-    char const* const arg_start,
-    char const* const line_end
+static int flush_frames(void) {
+    BwOutcome const bw_flush_outcome = bw_flush(&commands_writter);
+    if (bw_flush_outcome != BW_OK) {
+        program_eprintln(
+            "Failed flushing commands from the commands fifo buffered"
+                " writer: %s.",
+            bw_outcome_msg(bw_flush_outcome, &errno)
+        );
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Writes a single frame to the commands fifo right away.
+ */
+static int write_frame(
+    FrameOpcode const opcode,
+    void const* const payload,
+    size_t const len
 ) {
-    switch (cmd) {
-        case EXEC_TASK:
-        case END_TASK:
-        case SET_ACTIVE_TIMEOUT:
-        case SET_INACTIVE_TIMEOUT: {
-            BwOutcome const bw_write_outcome =
-                bw_write(
-                    &commands_writter,
-                    arg_strs[cmd],
-                    sizeof arg_strs[cmd]
-                );
-            if (bw_write_outcome != BW_OK) {
-                eprintln(
-                    "Failed writing a command to the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_write_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            BwOutcome const bw_write_line_outcome =
-                bw_write_line(
-                    &commands_writter,
-                    arg_start,
-                    line_end - arg_start
-                );
-            if (bw_write_line_outcome != BW_OK) {
-                eprintln(
-                    "Failed writing a command to the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_write_line_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            BwOutcome const bw_flush_outcome = bw_flush(&commands_writter);
-            if (bw_flush_outcome != BW_OK) {
-                eprintln(
-                    "Failed flushing commands from the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_flush_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            break;
-        }
-        case LIST_RUNNING_TASKS:
-        case LIST_FINISHED_TASKS: {
-            BwOutcome const bw_write_line_outcome =
-                bw_write_line(
-                    &commands_writter,
-                    arg_strs[cmd],
-                    sizeof arg_strs[cmd]
-                );
-            if (bw_write_line_outcome != BW_OK) {
-                eprintln(
-                    "Failed writing a command to the commands fifo buffered"
-                        " writer:  %s.",
-                    bw_outcome_msg(bw_write_line_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            BwOutcome const bw_flush_outcome = bw_flush(&commands_writter);
-            if (bw_flush_outcome != BW_OK) {
-                eprintln(
-                    "Failed flushing commands from the commands fifo buffered"
-                        " writer: %s.",
-                    bw_outcome_msg(bw_flush_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            break;
+    if (queue_frame(opcode, 0u, payload, len) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    return flush_frames();
+}
+
+/**
+ * Buffers a task's frame in the commands fifo writer, at the priority in
+ * @p flags, and with @p limits ahead of the task if @p flags tells so.
+ */
+static int queue_exec_frame(
+    uint16_t const flags,
+    TaskLimits const* const limits,
+    char const* const task,
+    size_t const task_len
+) {
+    FrameOpcode const opcode = FRAME_OP_EXEC_TASK;
+    if (!(flags & FRAME_EXEC_LIMITS)) {
+        return queue_frame(opcode, flags, task, task_len);
+    }
+    static unsigned char payload[FRAME_MAX_PAYLOAD];
+    if (task_len > FRAME_MAX_PAYLOAD - FRAME_EXEC_LIMITS_SIZE) {
+        program_eprintln(
+            "Failed writing a command to the commands fifo: %s.",
+            frame_outcome_msg(FRAME_ERR_TOO_LARGE, NULL)
+        );
+        return EXIT_FAILURE;
+    }
+    frame_put_u64(payload, limits->memory_mib);
+    frame_put_u64(payload + 8, limits->cpu_percent);
+    frame_put_u64(payload + 16, limits->pids);
+    memcpy(payload + FRAME_EXEC_LIMITS_SIZE, task, task_len);
+    return queue_frame(
+        opcode,
+        flags,
+        payload,
+        FRAME_EXEC_LIMITS_SIZE + task_len
+    );
+}
+
+/**
+ * Writes a task's frame to the commands fifo right away, as
+ * <tt>queue_exec_frame()</tt> buffers it.
+ */
+static int write_exec_frame(
+    uint16_t const flags,
+    TaskLimits const* const limits,
+    char const* const task,
+    size_t const task_len
+) {
+    if (queue_exec_frame(flags, limits, task, task_len) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    return flush_frames();
+}
+
+/**
+ * Returns the limit a word such as "memoria=256" sets, or @p NULL if it's not
+ * a limit, and stores where its value starts in @p value.
+ */
+static uint64_t* limit_of_word(
+    char const* const begin,
+    char const* const end,
+    TaskLimits* const limits,
+    char const** const value
+) {
+    char const* const words[] = {
+        memory_limit_word,
+        cpu_limit_word,
+        pids_limit_word
+    };
+    uint64_t* const fields[] = {
+        &limits->memory_mib,
+        &limits->cpu_percent,
+        &limits->pids
+    };
+    for (size_t i = 0ul; i < sizeof words / sizeof *words; ++i) {
+        size_t const word_len = strlen(words[i]);
+        if ((size_t) (end - begin) >= word_len &&
+            strncmp(begin, words[i], word_len) == 0
+        ) {
+            *value = begin + word_len;
+            return fields[i];
         }
-        case HELP:
-            break;
-        default:
-            break;
     }
+    return NULL;
+}
+
+/**
+ * Parses the value of a task's limit, and marks the flags of its frames,
+ * @p flags, as carrying limits.
+ */
+static int parse_limit(
+    char const* const begin,
+    char const* const end,
+    uint64_t* const limit,
+    uint16_t* const flags
+) {
+    size_t value;
+    char maybe_inv_char;
+    ParseSizeOutcome const parse_outcome =
+        parse_size_slice(begin, end, &value, &maybe_inv_char);
+    if (parse_outcome != PARSE_SIZE_OK) {
+        eprintf(
+            "Failed to parse task limit: %s",
+            parse_size_outcome_msg(parse_outcome)
+        );
+        if (parse_outcome == PARSE_SIZE_ERR_INV_CHAR) {
+            eprintf(" '%c'", maybe_inv_char);
+        }
+        eputs(".");
+        return EXIT_FAILURE;
+    }
+    *limit = value;
+    *flags |= FRAME_EXEC_LIMITS;
     return EXIT_SUCCESS;
 }
 
-static bool is_empty_str(char const* begin, char const* const end) {
-    for ( ; begin != end; ++begin) {
-        if (!isspace(*begin)) {
-            false;
+/**
+ * Parses a task's priority, from 0 to 3, and stores it in the flags of its
+ * frames, @p flags.
+ */
+static int parse_priority(
+    char const* const begin,
+    char const* const end,
+    uint16_t* const flags
+) {
+    size_t priority;
+    char maybe_inv_char;
+    ParseSizeOutcome const parse_outcome =
+        parse_size_slice(begin, end, &priority, &maybe_inv_char);
+    if (parse_outcome != PARSE_SIZE_OK) {
+        eprintf(
+            "Failed to parse task priority: %s",
+            parse_size_outcome_msg(parse_outcome)
+        );
+        if (parse_outcome == PARSE_SIZE_ERR_INV_CHAR) {
+            eprintf(" '%c'", maybe_inv_char);
         }
+        eputs(".");
+        return EXIT_FAILURE;
     }
-    return true;
+    if (priority > FRAME_EXEC_PRIORITY >> FRAME_EXEC_PRIORITY_SHIFT) {
+        eprintln(
+            "Task priority must be at most %u.",
+            FRAME_EXEC_PRIORITY >> FRAME_EXEC_PRIORITY_SHIFT
+        );
+        return EXIT_FAILURE;
+    }
+    *flags = (uint16_t) (priority << FRAME_EXEC_PRIORITY_SHIFT);
+    return EXIT_SUCCESS;
+}
+
+static int write_size_frame(FrameOpcode const opcode, size_t const value) {
+    unsigned char payload[8];
+    frame_put_u64(payload, value);
+    return write_frame(opcode, payload, sizeof payload);
+}
+
+/**
+ * Sets a historico filter, of the form key=value, in @p query.
+ */
+static int add_history_filter(
+    HistoryQuery* const restrict query,
+    char const* const begin,
+    char const* const end
+) {
+    HistoryQueryOutcome const parse_outcome =
+        hquery_parse_filter(query, begin, end);
+    if (parse_outcome != HQUERY_OK) {
+        program_eprintln(
+            "Invalid filter '%.*s': %s.",
+            (int) (end - begin),
+            begin,
+            hquery_outcome_msg(parse_outcome)
+        );
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the string slice without leading and trailing whitespace.
+ */
+static char const* trim_str(
+    char const* begin,
+    char const** const end
+) {
+    begin = scan_skip(begin, *end, SCAN_SPACE);
+    *end = scan_skip_back(begin, *end, SCAN_SPACE);
+    return begin;
+}
+
+static bool is_empty_str(char const* const begin, char const* const end) {
+    return scan_skip(begin, end, SCAN_SPACE) == end;
+}
+
+/**
+ * Sets the historico filters of an interactive line in @p query: whitespace
+ * separated words, except for cmd=, whose value is the rest of the line.
+ */
+static int parse_history_filters(
+    HistoryQuery* const restrict query,
+    char const* i,
+    char const* line_end
+) {
+    static char const prefix_key[] = "cmd=";
+    size_t const prefix_key_len = sizeof prefix_key - 1ul;
+    i = trim_str(i, &line_end);
+    while (i != line_end) {
+        char const* const word_start = i;
+        if ((size_t) (line_end - i) >= prefix_key_len &&
+            strncmp(i, prefix_key, prefix_key_len) == 0
+        ) {
+            i = line_end;
+        } else {
+            i = scan_find(i, line_end, SCAN_SPACE);
+        }
+        if (add_history_filter(query, word_start, i) == EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        i = scan_skip(i, line_end, SCAN_SPACE);
+    }
+    return EXIT_SUCCESS;
 }
 
 static void print_help(void) {
     printf(
         "Usage: %s [options]\n"
         "Options:\n"
-        "  -%c [task1 | task2 | ...]\t%s.\n"
+        "  -%c [-%c n] [limit ...] [task1 | ...]\t%s.\n"
+        "  -%c [-%c n] [limit ...] -%c file\t%s.\n"
+        "  -%c n\t\t\t\t%s.\n"
         "  -%c n\t\t\t\t%s.\n"
         "  -%c n\t\t\t\t%s.\n"
         "  -%c n\t\t\t\t%s.\n"
         "  -%c\t\t\t\t%s.\n"
+        "  -%c [filter ...]\t\t%s.\n"
+        "  -%c n\t\t\t\t%s.\n"
         "  -%c\t\t\t\t%s.\n"
-        "  -%c\t\t\t\t%s.\n",
+        "Filters:\n"
+        "  last=n\t\t\tOnly the last n matching tasks.\n"
+        "  since=n\t\t\tOnly tasks with id n or greater.\n"
+        "  from=s, to=s\t\t\tOnly tasks which ended in [from, to), in"
+            " seconds since the epoch.\n"
+        "  status=n\t\t\tOnly tasks which exited with status n.\n"
+        "  end=how\t\t\tOnly tasks which ended as one of ok, failed,"
+            " terminated,\n"
+        "\t\t\t\tmax-time or inactivity.\n"
+        "  cmd=prefix\t\t\tOnly tasks whose command starts with prefix.\n"
+        "  show=col,...\t\t\tShow what each task used, of wall, user,"
+            " sys, rss,\n"
+        "\t\t\t\tpeak, minflt, majflt, vcsw and ivcsw, or all.\n"
+        "  sort=col\t\t\tList tasks by a column, greatest first.\n"
+        "Limits, enforced when tasks run in cgroups (0 for none):\n"
+        "  memoria=n\t\t\tAt most n MiB of memory.\n"
+        "  cpu=n\t\t\t\tAt most n percent of a CPU.\n"
+        "  processos=n\t\t\tAt most n processes.\n",
         program_name,
-        EXEC_TASK_FLAG, "Execute a task",
+        EXEC_TASK_FLAG, PRIORITY_FLAG, "Execute a task, of priority n, from 0"
+            " to 3 (1 by default), greater ones launched first when queued",
+        EXEC_TASK_FLAG, PRIORITY_FLAG, BATCH_FILE_FLAG, "Execute every line"
+            " of a file as a task ('-' for stdin), and print their ids",
         END_TASK_FLAG, "End a task with id 'n'",
         SET_ACTIVE_TIMEOUT_FLAG, "Set a timeout of n seconds for task activity",
         SET_INACTIVE_TIMEOUT_FLAG, "Set a timeout of n seconds for task"
             " inactivity",
+        SET_MAX_RUNNING_FLAG, "Run at most n tasks at once, queueing the"
+            " rest (0 for no maximum)",
         LIST_RUNNING_TASKS_FLAG, "List all active tasks",
-        LIST_FINISHED_TASKS_FLAG, "List all finished tasks",
+        LIST_FINISHED_TASKS_FLAG, "List the finished tasks matching every"
+            " filter",
+        OUTPUT_FLAG, "Print the output of the task with id 'n'",
         HELP_FLAG, "Display this message"
     );
 }
@@ -246,32 +422,454 @@ static void close_commands_fifo(void) {
     }
 }
 
-static void close_running_tasks_fifo(void) {
-    if (close(running_tasks_fd) == -1) {
+static void drop_commands_writer(void) {
+    BwOutcome const drop_outcome = bw_drop(&commands_writter);
+    if (drop_outcome != BW_OK) {
         program_eprintln(
-            "Failed closing the running tasks fifo: %s.",
+            "Failed dropping the commands fifo buffered writer: %s.",
+            bw_outcome_msg(drop_outcome, &errno)
+        );
+    }
+}
+
+/**
+ * Opens the read end of a reply fifo without blocking, so that it's already
+ * open by the time the server replies to the command sent afterwards.
+ */
+static int open_reply_fifo(char const* const fifoname) {
+    int const fd = open(fifoname, O_RDONLY | O_NONBLOCK);
+    if (fd == -1) {
+        program_eprintln(
+            "Failed opening reply fifo '%s': %s.",
+            fifoname,
             strerror(errno)
         );
     }
+    return fd;
 }
 
-static void close_finished_tasks_fifo(void) {
-    if (close(finished_tasks_fd) == -1) {
+/**
+ * Waits for the server to open the reply fifo, and copies the reply to stdout
+ * until the server closes it.
+ */
+static int print_reply(int const reply_fd) {
+    struct pollfd poll_fd = { .fd = reply_fd, .events = POLLIN };
+    while (poll(&poll_fd, 1, -1) == -1) {
+        if (errno != EINTR) {
+            program_eprintln(
+                "Failed waiting for the server's reply: %s.",
+                strerror(errno)
+            );
+            return EXIT_FAILURE;
+        }
+    }
+    int const flags = fcntl(reply_fd, F_GETFL);
+    if (flags == -1 || fcntl(reply_fd, F_SETFL, flags & ~O_NONBLOCK) == -1) {
         program_eprintln(
-            "Failed closing the finished tasks fifo: %s.",
+            "Failed configuring the reply fifo: %s.",
             strerror(errno)
         );
+        return EXIT_FAILURE;
+    }
+    // the reply is a pipe, so it can be moved to stdout within the kernel,
+    // unless stdout doesn't support splice(), e.g. if it's a terminal
+    for (;;) {
+        ssize_t const spliced = splice(
+            reply_fd,
+            NULL,
+            STDOUT_FILENO,
+            NULL,
+            SPLICE_SIZE,
+            SPLICE_F_MOVE
+        );
+        if (spliced == 0l) {
+            return EXIT_SUCCESS;
+        }
+        if (spliced == -1l) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL) {
+                break;
+            }
+            program_eprintln(
+                "Failed writing the server's reply: %s.",
+                strerror(errno)
+            );
+            return EXIT_FAILURE;
+        }
+    }
+    for (;;) {
+        char line_buf[LINE_BUF_SIZE];
+        ssize_t const read_bytes = read(reply_fd, line_buf, LINE_BUF_SIZE);
+        if (read_bytes == -1l) {
+            if (errno == EINTR) {
+                continue;
+            }
+            program_eprintln(
+                "Failed reading the server's reply: %s.",
+                strerror(errno)
+            );
+            return EXIT_FAILURE;
+        }
+        if (read_bytes == 0l) {
+            return EXIT_SUCCESS;
+        }
+        if (write(STDOUT_FILENO, line_buf, read_bytes) == -1l) {
+            program_eprintln(
+                "Failed writing the server's reply: %s.",
+                strerror(errno)
+            );
+            return EXIT_FAILURE;
+        }
     }
 }
 
-static void drop_commands_writer(void) {
-    BwOutcome const drop_outcome = bw_drop(&commands_writter);
-    if (drop_outcome != BW_OK) {
+static char reply_fifoname[REPLY_FIFONAME_SIZE];
+
+static void unlink_reply_fifo(void) {
+    if (unlink(reply_fifoname) == -1) {
         program_eprintln(
-            "Failed dropping the commands fifo buffered writer: %s.",
-            bw_outcome_msg(drop_outcome, &errno)
+            "Failed removing reply fifo '%s': %s.",
+            reply_fifoname,
+            strerror(errno)
+        );
+    }
+}
+
+/**
+ * Creates the client's own reply fifo, named after its process id, unless
+ * already created. It's removed on exit.
+ */
+static int make_reply_fifo(void) {
+    static bool is_made = false;
+    if (is_made) {
+        return EXIT_SUCCESS;
+    }
+    snprintf(
+        reply_fifoname,
+        REPLY_FIFONAME_SIZE,
+        reply_fifoname_fmt,
+        (unsigned) getpid()
+    );
+    if (mkfifo(reply_fifoname, 0600) == -1) {
+        program_eprintln(
+            "Failed creating reply fifo '%s': %s.",
+            reply_fifoname,
+            strerror(errno)
+        );
+        return EXIT_FAILURE;
+    }
+    atexit(unlink_reply_fifo);
+    is_made = true;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Receives the read end of a reply pipe, which the server passes over the
+ * commands socket.
+ */
+static int recv_reply_pipe(void) {
+    unsigned char header[FRAME_HEADER_SIZE];
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct iovec iov = { .iov_base = header, .iov_len = sizeof header };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof control.buf
+    };
+    ssize_t received;
+    do {
+        received = recvmsg(commands_fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (received == -1l && errno == EINTR);
+    if (received == -1l) {
+        program_eprintln(
+            "Failed receiving the server's reply: %s.",
+            strerror(errno)
+        );
+        return -1;
+    }
+    struct cmsghdr const* const cmsg = CMSG_FIRSTHDR(&msg);
+    if (received == 0l || !cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS
+    ) {
+        program_eputs("The server closed the connection without replying.");
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof fd);
+    return fd;
+}
+
+/**
+ * Prepares for the reply to the next request. Over the commands fifo, the
+ * client's own reply fifo is opened before the request is sent, and stored in
+ * @p reply_fd. Over the commands socket, the reply comes with its own pipe,
+ * and @p reply_fd is set to @p -1.
+ */
+static int open_reply(int* const reply_fd) {
+    *reply_fd = -1;
+    if (is_connected) {
+        return EXIT_SUCCESS;
+    }
+    if (make_reply_fifo() == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    *reply_fd = open_reply_fifo(reply_fifoname);
+    return *reply_fd == -1 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Copies the reply to the request sent since <tt>open_reply()</tt> to stdout.
+ */
+static int finish_reply(int reply_fd) {
+    if (reply_fd == -1 && (reply_fd = recv_reply_pipe()) == -1) {
+        return EXIT_FAILURE;
+    }
+    int const print_outcome = print_reply(reply_fd);
+    close(reply_fd);
+    return print_outcome;
+}
+
+/**
+ * Sends a request to the server, and copies its reply to stdout. The reply
+ * comes through a pipe passed over the commands socket, or the client's own
+ * fifo, so that any number of clients may be waiting for replies at once.
+ */
+static int print_request(
+    FrameOpcode const opcode,
+    void const* const payload,
+    size_t const len
+) {
+    int reply_fd;
+    if (open_reply(&reply_fd) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (write_frame(opcode, payload, len) == EXIT_FAILURE) {
+        if (reply_fd != -1) {
+            close(reply_fd);
+        }
+        return EXIT_FAILURE;
+    }
+    return finish_reply(reply_fd);
+}
+
+/**
+ * Orders running tasks before pending ones, and each by id, i.e. pending ones
+ * in the order they'll be launched.
+ */
+static int cmp_board_tasks(void const* const a, void const* const b) {
+    TaskBoardTask const* const x = a;
+    TaskBoardTask const* const y = b;
+    if (x->state != y->state) {
+        return x->state == TBOARD_RUNNING ? -1 : 1;
+    }
+    return (x->task_id > y->task_id) - (x->task_id < y->task_id);
+}
+
+/**
+ * Copies the running and pending tasks from the board the server publishes in
+ * shared memory to stdout, without a round trip to the server.
+ * Returns @p false if there's no board, or it can't be trusted, e.g. if its
+ * server is gone, in which case the server should be asked instead. Otherwise,
+ * stores whether printing succeeded in @p print_outcome.
+ */
+static bool print_running_tasks(int* const print_outcome) {
+    TaskBoardSnapshot snapshot;
+    if (tboard_snapshot(&snapshot, running_tasks_shmname) != TBOARD_OK) {
+        return false;
+    }
+    BufWriter writer;
+    BwOutcome write_outcome = bw_with_default_cap(&writer, STDOUT_FILENO);
+    if (write_outcome != BW_OK) {
+        tboard_snapshot_drop(&snapshot);
+        return false;
+    }
+    if (snapshot.len > 0ul) {
+        qsort(
+            snapshot.tasks,
+            snapshot.len,
+            sizeof *snapshot.tasks,
+            cmp_board_tasks
+        );
+    }
+    for (size_t i = 0ul; i < snapshot.len && write_outcome == BW_OK; ++i) {
+        char prefix[48];
+        int const prefix_len = snprintf(
+            prefix,
+            sizeof prefix,
+            snapshot.tasks[i].state == TBOARD_PENDING ?
+                "#%" PRIu64 ", pending: " :
+                "#%" PRIu64 ": ",
+            snapshot.tasks[i].task_id
+        );
+        write_outcome = bw_write(&writer, prefix, (size_t) prefix_len);
+        if (write_outcome == BW_OK) {
+            write_outcome = bw_write_line(
+                &writer,
+                snapshot.tasks[i].cmd,
+                snapshot.tasks[i].cmd_len
+            );
+        }
+    }
+    if (write_outcome == BW_OK) {
+        write_outcome = bw_drop(&writer);
+    } else {
+        bw_drop(&writer);
+    }
+    tboard_snapshot_drop(&snapshot);
+    if (write_outcome != BW_OK) {
+        program_eprintln(
+            "Failed printing the running tasks: %s.",
+            bw_outcome_msg(write_outcome, &errno)
+        );
+    }
+    *print_outcome = write_outcome == BW_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+    return true;
+}
+
+/**
+ * Asks the server for a finished task's output, and copies it to stdout.
+ */
+static int print_output(size_t const task_id) {
+    unsigned char payload[8];
+    frame_put_u64(payload, task_id);
+    return print_request(FRAME_OP_GET_OUTPUT, payload, sizeof payload);
+}
+
+/**
+ * Asks the server for the finished tasks matching @p query, and copies them
+ * to stdout.
+ */
+static int print_history(HistoryQuery const* const query) {
+    unsigned char payload[FRAME_MAX_PAYLOAD];
+    hquery_encode(query, payload);
+    return print_request(
+        FRAME_OP_LIST_FINISHED_TASKS,
+        payload,
+        hquery_encoded_len(query)
+    );
+}
+
+/**
+ * Submits every non empty line of @p path (or of stdin, if @p path is "-") as
+ * a task, at the priority in @p flags, and with @p limits if @p flags tells
+ * so, streaming the frames through the
+ * commands fifo writer, so that a single write(2) carries as many tasks as fit
+ * in PIPE_BUF. The server replies with the assigned task ids, in order, once
+ * the batch is over.
+ */
+static int exec_batch(
+    char const* const path,
+    uint16_t const flags,
+    TaskLimits const* const limits
+) {
+    bool const is_stdin = strcmp(path, "-") == 0;
+    int const tasks_fd =
+        is_stdin ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+    if (tasks_fd == -1) {
+        program_eprintln(
+            "Failed opening tasks file '%s': %s.",
+            path,
+            strerror(errno)
+        );
+        return EXIT_FAILURE;
+    }
+    BufReader tasks_reader;
+    BrOutcome const reader_init_outcome =
+        br_with_cap(&tasks_reader, tasks_fd, LINE_BUF_SIZE);
+    if (reader_init_outcome != BR_OK) {
+        program_eprintln(
+            "Failed initializing the tasks file buffered reader: %s.",
+            br_outcome_msg(reader_init_outcome, &errno)
+        );
+        if (!is_stdin) {
+            close(tasks_fd);
+        }
+        return EXIT_FAILURE;
+    }
+
+    int reply_fd;
+    if (open_reply(&reply_fd) == EXIT_FAILURE) {
+        br_drop(&tasks_reader);
+        if (!is_stdin) {
+            close(tasks_fd);
+        }
+        return EXIT_FAILURE;
+    }
+
+    // lines are queued straight from the reader's buffer, and any longer than
+    // it are skipped part by part
+    size_t const max_task_len = flags & FRAME_EXEC_LIMITS ?
+        FRAME_MAX_PAYLOAD - FRAME_EXEC_LIMITS_SIZE :
+        FRAME_MAX_PAYLOAD;
+    size_t line_num = 0ul;
+    bool is_skipping = false;
+    BrOutcome read_outcome;
+    char const* line;
+    size_t line_len;
+    while ((read_outcome =
+        br_peek_line(&tasks_reader, &line, &line_len)) == BR_OK
+    ) {
+        br_consume(&tasks_reader, line_len);
+        bool const was_skipping = is_skipping;
+        is_skipping =
+            line_len == LINE_BUF_SIZE && line[line_len - 1ul] != '\n';
+        if (was_skipping) {
+            continue;
+        }
+        ++line_num;
+        char const* task_end = line + line_len;
+        char const* const task_start = trim_str(line, &task_end);
+        size_t const task_len = task_end - task_start;
+        if (task_len == 0ul) {
+            continue;
+        }
+        if (is_skipping || task_len > max_task_len) {
+            program_eprintln(
+                "Skipping task on line %zu: longer than %zu bytes.",
+                line_num,
+                max_task_len
+            );
+            continue;
+        }
+        if (queue_exec_frame(
+            FRAME_EXEC_BATCH | flags,
+            limits,
+            task_start,
+            task_len
+        ) == EXIT_FAILURE) {
+            br_drop(&tasks_reader);
+            if (!is_stdin) {
+                close(tasks_fd);
+            }
+            return EXIT_FAILURE;
+        }
+    }
+    if (read_outcome != BR_EOF) {
+        program_eprintln(
+            "Failed reading tasks file '%s': %s.",
+            path,
+            br_outcome_msg(read_outcome, &errno)
         );
     }
+    br_drop(&tasks_reader);
+    if (!is_stdin) {
+        close(tasks_fd);
+    }
+    if (queue_frame(
+        FRAME_OP_EXEC_TASK,
+        FRAME_EXEC_BATCH | FRAME_EXEC_BATCH_END,
+        NULL,
+        0ul
+    ) == EXIT_FAILURE || flush_frames() == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    return finish_reply(reply_fd);
 }
 
 static Command* find_cmd(
@@ -287,10 +885,14 @@ static Command* find_cmd(
         *cmd = SET_ACTIVE_TIMEOUT;
     } else if (strncmp(word_start, set_inactive_timeout_cmd, word_len) == 0) {
         *cmd = SET_INACTIVE_TIMEOUT;
+    } else if (strncmp(word_start, set_max_running_cmd, word_len) == 0) {
+        *cmd = SET_MAX_RUNNING;
     } else if (strncmp(word_start, list_running_tasks_cmd, word_len) == 0) {
         *cmd = LIST_RUNNING_TASKS;
     } else if (strncmp(word_start, list_finished_tasks_cmd, word_len) == 0) {
         *cmd = LIST_FINISHED_TASKS;
+    } else if (strncmp(word_start, output_cmd, word_len) == 0) {
+        *cmd = OUTPUT;
     } else if (strncmp(word_start, help_cmd, word_len) == 0) {
         *cmd = HELP;
     } else {
@@ -301,7 +903,7 @@ static Command* find_cmd(
 
 int main(int argc, char* argv[]) {
     if (argc == 1) {  // no args, interactive mode
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -310,28 +912,8 @@ int main(int argc, char* argv[]) {
         }
         atexit(close_commands_fifo);
 
-        if ((running_tasks_fd = open(running_tasks_fifoname, O_RDONLY)) == -1) {
-            program_eprintln(
-                "Failed opening the running tasks fifo: %s.",
-                strerror(errno)
-            );
-            return EXIT_FAILURE;
-        }
-        atexit(close_running_tasks_fifo);
-
-        if ((finished_tasks_fd = open(finished_tasks_fifoname, O_RDONLY)) ==
-            -1
-        ) {
-            program_eprintln(
-                "Failed opening the finished tasks fifo: %s.",
-                strerror(errno)
-            );
-            return EXIT_FAILURE;
-        }
-        atexit(close_finished_tasks_fifo);
-
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -341,25 +923,41 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
+        BufReader stdin_reader;
+        BrOutcome const stdin_reader_init_outcome =
+            br_with_cap(&stdin_reader, STDIN_FILENO, LINE_BUF_SIZE);
+        if (stdin_reader_init_outcome != BR_OK) {
+            program_eprintln(
+                "Failed initializing the stdin buffered reader: %s.",
+                br_outcome_msg(stdin_reader_init_outcome, &errno)
+            );
+            return EXIT_FAILURE;
+        }
+
         for (;;) {
-            char line_buf[LINE_BUF_SIZE];
-            ssize_t const read_bytes =
-                read(STDIN_FILENO, line_buf, LINE_BUF_SIZE);
-            if (read_bytes == -1l) {
+            // parsed in place, as the line stays put until the next peek
+            char const* line;
+            size_t line_len;
+            BrOutcome const read_outcome =
+                br_peek_line(&stdin_reader, &line, &line_len);
+            if (read_outcome == BR_EOF) {
+                br_drop(&stdin_reader);
+                return EXIT_SUCCESS;
+            }
+            if (read_outcome != BR_OK) {
                 eprintln(
                     "Failed reading a line from stdin: %s.",
-                    strerror(errno)
+                    br_outcome_msg(read_outcome, &errno)
                 );
+                br_drop(&stdin_reader);
                 return EXIT_FAILURE;
             }
-            if (read_bytes == 0ul) {
-                return EXIT_SUCCESS;
-            }
-            char const* const line_end = line_buf + read_bytes;
-            char const* i = line_buf;
-            while (i != line_end && isspace(*i)) ++i;
-            char const* const first_word_start = i;
-            while (i != line_end && !isspace(*i)) ++i;
+            br_consume(&stdin_reader, line_len);
+            char const* const line_end = line + line_len;
+            char const* i = line;
+            char const* const first_word_start =
+                scan_skip(i, line_end, SCAN_SPACE);
+            i = scan_find(first_word_start, line_end, SCAN_SPACE);
             size_t const first_word_len = i - first_word_start;
             if (first_word_len == 0ul) {
                 eputs("Expected a command");
@@ -382,7 +980,65 @@ int main(int argc, char* argv[]) {
                     eputs("Expected a task to execute.");
                     continue;
                 }
-                try_write_cmd_i_(EXEC_TASK, i, line_end);
+                char const* task_end = line_end;
+                char const* task_start = trim_str(i, &task_end);
+                uint16_t flags =
+                    FRAME_EXEC_DEFAULT_PRIORITY << FRAME_EXEC_PRIORITY_SHIFT;
+                char const* const first_end =
+                    scan_find(task_start, task_end, SCAN_SPACE);
+                if (first_end - task_start == 2 && task_start[0] == '-' &&
+                    task_start[1] == PRIORITY_FLAG
+                ) {
+                    char const* const priority_start =
+                        scan_skip(first_end, task_end, SCAN_SPACE);
+                    char const* const priority_end =
+                        scan_find(priority_start, task_end, SCAN_SPACE);
+                    if (parse_priority(
+                        priority_start,
+                        priority_end,
+                        &flags
+                    ) == EXIT_FAILURE) {
+                        continue;
+                    }
+                    task_start =
+                        scan_skip(priority_end, task_end, SCAN_SPACE);
+                }
+                TaskLimits limits = {
+                    .memory_mib = 0u,
+                    .cpu_percent = 0u,
+                    .pids = 0u
+                };
+                bool is_limit_valid = true;
+                for (;;) {
+                    char const* const word_end =
+                        scan_find(task_start, task_end, SCAN_SPACE);
+                    char const* value;
+                    uint64_t* const limit =
+                        limit_of_word(task_start, word_end, &limits, &value);
+                    if (!limit) {
+                        break;
+                    }
+                    if (parse_limit(value, word_end, limit, &flags) ==
+                        EXIT_FAILURE
+                    ) {
+                        is_limit_valid = false;
+                        break;
+                    }
+                    task_start = scan_skip(word_end, task_end, SCAN_SPACE);
+                }
+                if (!is_limit_valid) {
+                    continue;
+                }
+                if (task_start == task_end) {
+                    eputs("Expected a task to execute.");
+                    continue;
+                }
+                try_write_exec_frame_(
+                    flags,
+                    &limits,
+                    task_start,
+                    task_end - task_start
+                );
                 break;
             }
 
@@ -406,7 +1062,7 @@ int main(int argc, char* argv[]) {
                     eputs(".");
                     continue;
                 }
-                try_write_cmd_i_(END_TASK, i, line_end);
+                try_write_size_frame_(FRAME_OP_END_TASK, task_id);
                 break;
             }
 
@@ -435,7 +1091,10 @@ int main(int argc, char* argv[]) {
                     eputs(".");
                     continue;
                 }
-                try_write_cmd_i_(SET_ACTIVE_TIMEOUT, i, line_end);
+                try_write_size_frame_(
+                    FRAME_OP_SET_ACTIVE_TIMEOUT,
+                    active_task_timeout
+                );
                 break;
             }
 
@@ -464,51 +1123,93 @@ int main(int argc, char* argv[]) {
                     eputs(".");
                     continue;
                 }
-                try_write_cmd_i_(SET_INACTIVE_TIMEOUT, i, line_end);
+                try_write_size_frame_(
+                    FRAME_OP_SET_INACTIVE_TIMEOUT,
+                    inactive_task_timeout
+                );
                 break;
             }
 
-            case LIST_RUNNING_TASKS: {
-                try_write_cmd_i_(LIST_RUNNING_TASKS, i, line_end);
-                for (;;) {
-                    char line_buf[LINE_BUF_SIZE];
-                    ssize_t const read_bytes =
-                        read(running_tasks_fd, line_buf, LINE_BUF_SIZE);
-                    if (read_bytes == -1l) {
-                        eprintln(
-                            "Failed reading a line from the running tasks fifo"
-                                " : %s",
-                            strerror(errno)
-                        );
-                        return EXIT_FAILURE;
-                    }
-                    if (read_bytes != 0l) {
-                        write(STDOUT_FILENO, line_buf, read_bytes);
-                    } else {
-                        break;
+            case SET_MAX_RUNNING: {
+                if (is_empty_str(i, line_end)) {
+                    eputs("Expected maximum number of running tasks");
+                    continue;
+                }
+                size_t max_running_tasks;
+                char maybe_inv_char;
+                ParseSizeOutcome const parse_outcome =
+                    parse_size_slice(
+                        i,
+                        line_end,
+                        &max_running_tasks,
+                        &maybe_inv_char
+                    );
+                if (parse_outcome != PARSE_SIZE_OK) {
+                    eprintf(
+                        "Failed to parse maximum number of running tasks: %s",
+                        parse_size_outcome_msg(parse_outcome)
+                    );
+                    if (parse_outcome == PARSE_SIZE_ERR_INV_CHAR) {
+                        eprintf(" '%c'", maybe_inv_char);
                     }
+                    eputs(".");
+                    continue;
+                }
+                try_write_size_frame_(
+                    FRAME_OP_SET_MAX_RUNNING,
+                    max_running_tasks
+                );
+                break;
+            }
+
+            case LIST_RUNNING_TASKS: {
+                int print_outcome;
+                if (!print_running_tasks(&print_outcome)) {
+                    print_outcome =
+                        print_request(FRAME_OP_LIST_RUNNING_TASKS, NULL, 0ul);
+                }
+                if (print_outcome == EXIT_FAILURE) {
+                    return EXIT_FAILURE;
                 }
                 break;
             }
 
             case LIST_FINISHED_TASKS: {
-                try_write_cmd_i_(LIST_FINISHED_TASKS, i, line_end);
-                for (;;) {
-                    char line_buf[LINE_BUF_SIZE];
-                    ssize_t const read_bytes =
-                        read(finished_tasks_fd, line_buf, LINE_BUF_SIZE);
-                    if (read_bytes == -1l) {
-                        eprintln(
-                            "Failed reading a line from the finished tasks fifo"
-                            " : %s",
-                            strerror(errno)
-                        );
-                    }
-                    if (read_bytes != 0l) {
-                        write(STDOUT_FILENO, line_buf, read_bytes);
-                    } else {
-                        break;
+                HistoryQuery query;
+                hquery_new(&query);
+                if (parse_history_filters(&query, i, line_end) ==
+                        EXIT_FAILURE
+                ) {
+                    continue;
+                }
+                if (print_history(&query) == EXIT_FAILURE) {
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+
+            case OUTPUT: {
+                if (is_empty_str(i, line_end)) {
+                    eputs("Expected task id.");
+                    continue;
+                }
+                size_t task_id;
+                char maybe_inv_char;
+                ParseSizeOutcome const parse_outcome =
+                    parse_size_slice(i, line_end, &task_id, &maybe_inv_char);
+                if (parse_outcome != PARSE_SIZE_OK) {
+                    eprintf(
+                        "Failed to parse task id: %s",
+                        parse_size_outcome_msg(parse_outcome)
+                    );
+                    if (parse_outcome == PARSE_SIZE_ERR_INV_CHAR) {
+                        eprintf(" '%c'", maybe_inv_char);
                     }
+                    eputs(".");
+                    continue;
+                }
+                if (print_output(task_id) == EXIT_FAILURE) {
+                    return EXIT_FAILURE;
                 }
                 break;
             }
@@ -539,7 +1240,7 @@ int main(int argc, char* argv[]) {
             program_eputs("Expected a task to execute.");
             return EXIT_FAILURE;
         }
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -549,7 +1250,7 @@ int main(int argc, char* argv[]) {
         atexit(close_commands_fifo);
 
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -559,7 +1260,64 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
-        try_write_cmd_(EXEC_TASK, argv);
+        int arg = 2;
+        uint16_t flags =
+            FRAME_EXEC_DEFAULT_PRIORITY << FRAME_EXEC_PRIORITY_SHIFT;
+        if (argv[arg][0] == '-' && argv[arg][1] == PRIORITY_FLAG &&
+            argv[arg][2] == '\0'
+        ) {
+            if (argc < arg + 3) {
+                program_eputs("Expected a task priority and a task.");
+                return EXIT_FAILURE;
+            }
+            char const* const priority = argv[arg + 1];
+            if (parse_priority(
+                priority,
+                priority + strlen(priority),
+                &flags
+            ) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+            arg += 2;
+        }
+        TaskLimits limits = {
+            .memory_mib = 0u,
+            .cpu_percent = 0u,
+            .pids = 0u
+        };
+        char const* value;
+        for (uint64_t* limit;
+            arg < argc && (limit = limit_of_word(
+                argv[arg],
+                argv[arg] + strlen(argv[arg]),
+                &limits,
+                &value
+            ));
+            ++arg
+        ) {
+            if (parse_limit(
+                value,
+                value + strlen(value),
+                limit,
+                &flags
+            ) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+        }
+        if (arg == argc) {
+            program_eputs("Expected a task to execute.");
+            return EXIT_FAILURE;
+        }
+        if (argv[arg][0] == '-' && argv[arg][1] == BATCH_FILE_FLAG &&
+            argv[arg][2] == '\0'
+        ) {
+            if (argc < arg + 2) {
+                program_eputs("Expected a tasks file.");
+                return EXIT_FAILURE;
+            }
+            return exec_batch(argv[arg + 1], flags, &limits);
+        }
+        try_write_exec_frame_(flags, &limits, argv[arg], strlen(argv[arg]));
         break;
     }
 
@@ -584,7 +1342,7 @@ int main(int argc, char* argv[]) {
             return EXIT_FAILURE;
         }
 
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -594,7 +1352,7 @@ int main(int argc, char* argv[]) {
         atexit(close_commands_fifo);
 
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -604,7 +1362,7 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
-        try_write_cmd_(END_TASK, argv);
+        try_write_size_frame_(FRAME_OP_END_TASK, task_id);
         break;
     }
 
@@ -629,7 +1387,7 @@ int main(int argc, char* argv[]) {
             return EXIT_FAILURE;
         }
 
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -639,7 +1397,7 @@ int main(int argc, char* argv[]) {
         atexit(close_commands_fifo);
 
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -649,7 +1407,10 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
-        try_write_cmd_(SET_ACTIVE_TIMEOUT, argv);
+        try_write_size_frame_(
+            FRAME_OP_SET_ACTIVE_TIMEOUT,
+            active_task_timeout
+        );
         break;
     }
 
@@ -674,7 +1435,7 @@ int main(int argc, char* argv[]) {
             return EXIT_FAILURE;
         }
 
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -684,7 +1445,7 @@ int main(int argc, char* argv[]) {
         atexit(close_commands_fifo);
 
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -694,12 +1455,35 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
-        try_write_cmd_(SET_INACTIVE_TIMEOUT, argv);
+        try_write_size_frame_(
+            FRAME_OP_SET_INACTIVE_TIMEOUT,
+            inactive_task_timeout
+        );
         break;
     }
 
-    case LIST_RUNNING_TASKS_FLAG: {
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+    case SET_MAX_RUNNING_FLAG: {
+        if (argc < 3) {
+            program_eputs("Expected maximum number of running tasks.");
+            return EXIT_FAILURE;
+        }
+        size_t max_running_tasks;
+        char maybe_inv_char;
+        ParseSizeOutcome const parse_outcome =
+            parse_size(argv[2], &max_running_tasks, &maybe_inv_char);
+        if (parse_outcome != PARSE_SIZE_OK) {
+            program_eprintf(
+                "Failed to parse maximum number of running tasks: %s",
+                parse_size_outcome_msg(parse_outcome)
+            );
+            if (parse_outcome == PARSE_SIZE_ERR_INV_CHAR) {
+                eprintf(" '%c'", maybe_inv_char);
+            }
+            eputs(".");
+            return EXIT_FAILURE;
+        }
+
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -709,7 +1493,7 @@ int main(int argc, char* argv[]) {
         atexit(close_commands_fifo);
 
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -719,39 +1503,55 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
-        try_write_cmd_(LIST_RUNNING_TASKS, argv);
+        try_write_size_frame_(
+            FRAME_OP_SET_MAX_RUNNING,
+            max_running_tasks
+        );
+        break;
+    }
 
-        if ((running_tasks_fd = open(running_tasks_fifoname, O_RDONLY)) == -1) {
+    case LIST_RUNNING_TASKS_FLAG: {
+        int print_outcome;
+        if (print_running_tasks(&print_outcome)) {
+            return print_outcome;
+        }
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
-                "Failed opening the running tasks fifo: %s.",
+                "Failed opening the commands fifo: %s.",
                 strerror(errno)
             );
             return EXIT_FAILURE;
         }
-        atexit(close_running_tasks_fifo);
+        atexit(close_commands_fifo);
 
-        for (;;) {
-            char line_buf[LINE_BUF_SIZE];
-            ssize_t const read_bytes =
-                read(running_tasks_fd, line_buf, LINE_BUF_SIZE);
-            if (read_bytes == -1l) {
-                program_eprintln(
-                    "Failed reading a line from the running tasks fifo: %s.",
-                    strerror(errno)
-                );
-                return EXIT_FAILURE;
-            }
-            if (read_bytes != 0l) {
-                write(STDOUT_FILENO, line_buf, read_bytes);
-            } else {
-                break;
-            }
+        BwOutcome const commands_fifo_writer_init_outcome =
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
+        if (commands_fifo_writer_init_outcome != BW_OK) {
+            program_eprintln(
+                "Failed initializing the commands fifo buffered writer: %s.",
+                bw_outcome_msg(commands_fifo_writer_init_outcome, &errno)
+            );
+            return EXIT_FAILURE;
         }
-        break;
+        atexit(drop_commands_writer);
+
+        return print_request(FRAME_OP_LIST_RUNNING_TASKS, NULL, 0ul);
     }
 
     case LIST_FINISHED_TASKS_FLAG: {
-        if ((commands_fd = open(commands_fifoname, O_WRONLY)) == -1) {
+        HistoryQuery query;
+        hquery_new(&query);
+        for (int arg = 2; arg < argc; ++arg) {
+            if (add_history_filter(
+                &query,
+                argv[arg],
+                argv[arg] + strlen(argv[arg])
+            ) == EXIT_FAILURE) {
+                return EXIT_FAILURE;
+            }
+        }
+
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
                 "Failed opening the commands fifo: %s.",
                 strerror(errno)
@@ -761,7 +1561,7 @@ int main(int argc, char* argv[]) {
         atexit(close_commands_fifo);
 
         BwOutcome const commands_fifo_writer_init_outcome =
-            bw_with_default_cap(&commands_writter, commands_fd);
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
         if (commands_fifo_writer_init_outcome != BW_OK) {
             program_eprintln(
                 "Failed initializing the commands fifo buffered writer: %s.",
@@ -771,36 +1571,51 @@ int main(int argc, char* argv[]) {
         }
         atexit(drop_commands_writer);
 
-        try_write_cmd_(LIST_FINISHED_TASKS, argv);
+        return print_history(&query);
+    }
 
-        if ((finished_tasks_fd = open(finished_tasks_fifoname, O_RDONLY)) ==
-            -1
-        ) {
+    case OUTPUT_FLAG: {
+        if (argc < 3) {
+            program_eputs("Expected task id.");
+            return EXIT_FAILURE;
+        }
+        size_t task_id;
+        char maybe_inv_char;
+        ParseSizeOutcome const parse_outcome =
+            parse_size(argv[2], &task_id, &maybe_inv_char);
+        if (parse_outcome != PARSE_SIZE_OK) {
+            program_eprintf(
+                "Failed to parse task id: %s",
+                parse_size_outcome_msg(parse_outcome)
+            );
+            if (parse_outcome == PARSE_SIZE_ERR_INV_CHAR) {
+                eprintf(" '%c'", maybe_inv_char);
+            }
+            eputs(".");
+            return EXIT_FAILURE;
+        }
+
+        if ((commands_fd = open_commands()) == -1) {
             program_eprintln(
-                "Failed opening the finished tasks fifo: %s.",
+                "Failed opening the commands fifo: %s.",
                 strerror(errno)
             );
             return EXIT_FAILURE;
         }
-        atexit(close_finished_tasks_fifo);
+        atexit(close_commands_fifo);
 
-        for (;;) {
-            char line_buf[LINE_BUF_SIZE];
-            ssize_t const read_bytes =
-                read(finished_tasks_fd, line_buf, LINE_BUF_SIZE);
-            if (read_bytes == -1l) {
-                program_eprintln(
-                    "Failed reading a line from the finished tasks fifo: %s.",
-                    strerror(errno)
-                );
-            }
-            if (read_bytes == -1l) {
-                write(STDOUT_FILENO, line_buf, read_bytes);
-            } else {
-                break;
-            }
+        BwOutcome const commands_fifo_writer_init_outcome =
+            bw_with_cap(&commands_writter, commands_fd, FRAME_MAX_SIZE);
+        if (commands_fifo_writer_init_outcome != BW_OK) {
+            program_eprintln(
+                "Failed initializing the commands fifo buffered writer: %s.",
+                bw_outcome_msg(commands_fifo_writer_init_outcome, &errno)
+            );
+            return EXIT_FAILURE;
         }
-        break;
+        atexit(drop_commands_writer);
+
+        return print_output(task_id);
     }
 
     case HELP_FLAG: {
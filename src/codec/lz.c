@@ -0,0 +1,194 @@
+#include "codec/lz.h"
+
+#if LZ_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // LZ_RUNTIME_ASSERTS
+
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_MATCH 4ul
+#define MAX_OFFSET 65535ul
+#define RUN_MASK 15ul
+
+/**
+ * The number of bits of a hash table index. The table takes 16 KiB of stack.
+ */
+#define HASH_BITS 12u
+
+/**
+ * How fast the search skips ahead when no match is found: by one more byte
+ * every <tt>1 << SKIP_SHIFT</tt> bytes of literals.
+ */
+#define SKIP_SHIFT 6u
+
+static uint32_t read_u32_(unsigned char const* const ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof value);
+    return value;
+}
+
+static size_t hash_(uint32_t const seq) {
+    return (size_t) ((seq * 2654435761u) >> (32u - HASH_BITS));
+}
+
+/**
+ * Writes the remainder of a length that didn't fit in a token's nibble.
+ */
+static unsigned char* put_len_(unsigned char* out, size_t rest) {
+    for ( ; rest >= 255ul; rest -= 255ul) {
+        *out++ = 255u;
+    }
+    *out++ = (unsigned char) rest;
+    return out;
+}
+
+static bool get_len_(
+    unsigned char const** const in,
+    unsigned char const* const in_end,
+    size_t* const len
+) {
+    unsigned char byte;
+    do {
+        if (*in == in_end) {
+            return false;
+        }
+        byte = *(*in)++;
+        *len += byte;
+    } while (byte == 255u);
+    return true;
+}
+
+/**
+ * Writes a token, its literals, and its match, unless @p match_len is zero,
+ * which ends the block.
+ */
+static unsigned char* put_seq_(
+    unsigned char* out,
+    unsigned char const* const lits,
+    size_t const lit_len,
+    size_t const offset,
+    size_t const match_len
+) {
+    size_t const match_code = match_len > 0ul ? match_len - MIN_MATCH : 0ul;
+    *out++ = (unsigned char) (
+        (lit_len < RUN_MASK ? lit_len : RUN_MASK) << 4ul |
+            (match_code < RUN_MASK ? match_code : RUN_MASK)
+    );
+    if (lit_len >= RUN_MASK) {
+        out = put_len_(out, lit_len - RUN_MASK);
+    }
+    memcpy(out, lits, lit_len);
+    out += lit_len;
+    if (match_len == 0ul) {
+        return out;
+    }
+    *out++ = (unsigned char) (offset & 0xfful);
+    *out++ = (unsigned char) (offset >> 8ul);
+    if (match_code >= RUN_MASK) {
+        out = put_len_(out, match_code - RUN_MASK);
+    }
+    return out;
+}
+
+size_t lz_compress(
+    char const* const restrict src,
+    size_t const len,
+    char* const restrict dst
+) {
+#   if LZ_RUNTIME_ASSERTS
+    assert(src != NULL || len == 0ul);
+    assert(dst != NULL);
+    assert(len <= LZ_MAX_BLOCK_SIZE);
+#   endif  // LZ_RUNTIME_ASSERTS
+
+    unsigned char const* const in = (unsigned char const*) src;
+    unsigned char* out = (unsigned char*) dst;
+    // a stale or zeroed entry is caught by comparing the bytes it points to
+    uint32_t table[1ul << HASH_BITS];
+    memset(table, 0, sizeof table);
+    size_t anchor = 0ul;
+    size_t pos = 0ul;
+    while (len >= MIN_MATCH && pos <= len - MIN_MATCH) {
+        uint32_t const seq = read_u32_(in + pos);
+        size_t const hash = hash_(seq);
+        size_t const ref = table[hash];
+        table[hash] = (uint32_t) pos;
+        if (ref >= pos || pos - ref > MAX_OFFSET ||
+            read_u32_(in + ref) != seq
+        ) {
+            pos += 1ul + ((pos - anchor) >> SKIP_SHIFT);
+            continue;
+        }
+        size_t match_len = MIN_MATCH;
+        while (pos + match_len < len &&
+            in[ref + match_len] == in[pos + match_len]
+        ) {
+            ++match_len;
+        }
+        out = put_seq_(out, in + anchor, pos - anchor, pos - ref, match_len);
+        pos += match_len;
+        anchor = pos;
+    }
+    out = put_seq_(out, in + anchor, len - anchor, 0ul, 0ul);
+    return (size_t) (out - (unsigned char*) dst);
+}
+
+bool lz_decompress(
+    char const* const restrict src,
+    size_t const len,
+    char* const restrict dst,
+    size_t const dst_len
+) {
+#   if LZ_RUNTIME_ASSERTS
+    assert(src != NULL || len == 0ul);
+    assert(dst != NULL || dst_len == 0ul);
+#   endif  // LZ_RUNTIME_ASSERTS
+
+    unsigned char const* in = (unsigned char const*) src;
+    unsigned char const* const in_end = in + len;
+    unsigned char* const out = (unsigned char*) dst;
+    size_t pos = 0ul;
+    for (;;) {
+        if (in == in_end) {
+            return false;
+        }
+        size_t const token = *in++;
+        size_t lit_len = token >> 4ul;
+        if (lit_len == RUN_MASK && !get_len_(&in, in_end, &lit_len)) {
+            return false;
+        }
+        if (lit_len > (size_t) (in_end - in) || lit_len > dst_len - pos) {
+            return false;
+        }
+        memcpy(out + pos, in, lit_len);
+        in += lit_len;
+        pos += lit_len;
+        if (in == in_end) {
+            return pos == dst_len;
+        }
+
+        if (in_end - in < 2l) {
+            return false;
+        }
+        size_t const offset = (size_t) in[0] | (size_t) in[1] << 8ul;
+        in += 2;
+        size_t match_len = token & RUN_MASK;
+        if (match_len == RUN_MASK && !get_len_(&in, in_end, &match_len)) {
+            return false;
+        }
+        match_len += MIN_MATCH;
+        if (offset == 0ul || offset > pos || match_len > dst_len - pos) {
+            return false;
+        }
+        // a match may overlap the bytes it produces, to encode runs
+        if (offset >= match_len) {
+            memcpy(out + pos, out + pos - offset, match_len);
+        } else {
+            for (size_t i = 0ul; i < match_len; ++i) {
+                out[pos + i] = out[pos + i - offset];
+            }
+        }
+        pos += match_len;
+    }
+}
@@ -64,7 +64,7 @@ ParseSizeOutcome parse_size_slice(
         return PARSE_SIZE_ERR_NEGATIVE;
     }
     bool digits_found = false;
-    if (isdigit(begin)) {
+    if (isdigit(*begin)) {
         digits_found = true;
         *size = *begin - '0';
         ++begin;
@@ -0,0 +1,285 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "proto/frame.h"
+
+#include "buf_io/buf_writer.h"
+
+#include <limits.h>
+#include <unistd.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define DECODER_CAP (16ul * FRAME_MAX_SIZE)
+#define OUTCOME_MSG_SIZE 1024ul
+
+static_assert(
+    FRAME_MAX_SIZE <= PIPE_BUF,
+    "Expected frames to be written atomically to fifos"
+);
+static_assert(
+    FRAME_MAX_PAYLOAD <= UINT16_MAX,
+    "Expected frame payload lengths to fit in a u16"
+);
+
+static void put_u16_(unsigned char* const dst, uint16_t const value) {
+    dst[0] = (unsigned char) value;
+    dst[1] = (unsigned char) (value >> 8u);
+}
+
+static uint16_t get_u16_(unsigned char const* const src) {
+    return (uint16_t) (src[0] | (src[1] << 8u));
+}
+
+static void put_u32_(unsigned char* const dst, uint32_t const value) {
+    for (size_t i = 0ul; i < 4ul; ++i) {
+        dst[i] = (unsigned char) (value >> (8ul * i));
+    }
+}
+
+static uint32_t get_u32_(unsigned char const* const src) {
+    uint32_t value = 0u;
+    for (size_t i = 0ul; i < 4ul; ++i) {
+        value |= (uint32_t) src[i] << (8ul * i);
+    }
+    return value;
+}
+
+void frame_put_u64(unsigned char* const dst, uint64_t const value) {
+    for (size_t i = 0ul; i < 8ul; ++i) {
+        dst[i] = (unsigned char) (value >> (8ul * i));
+    }
+}
+
+uint64_t frame_get_u64(unsigned char const* const src) {
+    uint64_t value = 0u;
+    for (size_t i = 0ul; i < 8ul; ++i) {
+        value |= (uint64_t) src[i] << (8ul * i);
+    }
+    return value;
+}
+
+void frame_encode_header(
+    FrameHeader const* const restrict header,
+    unsigned char* const restrict dst
+) {
+#   if FRAME_RUNTIME_ASSERTS
+    assert(header != NULL);
+    assert(dst != NULL);
+#   endif  // FRAME_RUNTIME_ASSERTS
+
+    dst[0] = FRAME_MAGIC;
+    dst[1] = FRAME_VERSION;
+    dst[2] = header->opcode;
+    dst[3] = 0u;
+    put_u16_(dst + 4, header->flags);
+    put_u16_(dst + 6, header->len);
+    put_u32_(dst + 8, header->request_id);
+    put_u32_(dst + 12, header->client_pid);
+}
+
+FrameOutcome frame_write(
+    BufWriter* const restrict writer,
+    FrameHeader const* const restrict header,
+    void const* const restrict payload,
+    size_t const len
+) {
+#   if FRAME_RUNTIME_ASSERTS
+    assert(writer != NULL);
+    assert(header != NULL);
+    assert(payload != NULL || len == 0ul);
+#   endif  // FRAME_RUNTIME_ASSERTS
+
+    if (len > FRAME_MAX_PAYLOAD) {
+        return FRAME_ERR_TOO_LARGE;
+    }
+    if (bw_cap(writer) - bw_used_bytes(writer) < FRAME_HEADER_SIZE + len &&
+        bw_flush(writer) != BW_OK
+    ) {
+        return FRAME_ERR_WRITE_FAIL;
+    }
+    FrameHeader sized_header = *header;
+    sized_header.len = (uint16_t) len;
+    unsigned char encoded[FRAME_HEADER_SIZE];
+    frame_encode_header(&sized_header, encoded);
+    if (bw_write(writer, (char const*) encoded, FRAME_HEADER_SIZE) != BW_OK ||
+        (len > 0ul && bw_write(writer, payload, len) != BW_OK)
+    ) {
+        return FRAME_ERR_WRITE_FAIL;
+    }
+    return FRAME_OK;
+}
+
+FrameOutcome fdec_new(FrameDecoder* const init) {
+#   if FRAME_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // FRAME_RUNTIME_ASSERTS
+
+    init->buf = malloc(DECODER_CAP);
+    if (!init->buf) {
+        return FRAME_ERR_ALLOC_FAIL;
+    }
+    init->begin = 0ul;
+    init->end = 0ul;
+    init->cap = DECODER_CAP;
+    return FRAME_OK;
+}
+
+void fdec_drop(FrameDecoder* const self) {
+#   if FRAME_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // FRAME_RUNTIME_ASSERTS
+
+    free(self->buf);
+}
+
+FrameOutcome fdec_fill(FrameDecoder* const self, int const file_des) {
+#   if FRAME_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // FRAME_RUNTIME_ASSERTS
+
+    if (self->begin == self->end) {
+        self->begin = 0ul;
+        self->end = 0ul;
+    } else if (self->cap - self->end < FRAME_MAX_SIZE) {
+        memmove(self->buf, self->buf + self->begin, self->end - self->begin);
+        self->end -= self->begin;
+        self->begin = 0ul;
+    }
+    for (;;) {
+        ssize_t const read_bytes =
+            read(file_des, self->buf + self->end, self->cap - self->end);
+        if (read_bytes == -1l) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ?
+                FRAME_PENDING : FRAME_ERR_READ_FAIL;
+        }
+        if (read_bytes == 0l) {
+            return FRAME_EOF;
+        }
+        self->end += (size_t) read_bytes;
+        return FRAME_OK;
+    }
+}
+
+/**
+ * Skips the byte at the beginning, and every byte until the next frame magic.
+ */
+static void resync_(FrameDecoder* const self) {
+    ++self->begin;
+    unsigned char const* const next_magic =
+        memchr(self->buf + self->begin, FRAME_MAGIC, self->end - self->begin);
+    self->begin = next_magic ?
+        (size_t) ((char const*) next_magic - self->buf) : self->end;
+}
+
+FrameOutcome fdec_next(
+    FrameDecoder* const restrict self,
+    FrameHeader* const restrict header,
+    char const** const restrict payload
+) {
+#   if FRAME_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(header != NULL);
+    assert(payload != NULL);
+#   endif  // FRAME_RUNTIME_ASSERTS
+
+    size_t const available = self->end - self->begin;
+    if (available == 0ul) {
+        return FRAME_PENDING;
+    }
+    unsigned char const* const src =
+        (unsigned char const*) self->buf + self->begin;
+    if (src[0] != FRAME_MAGIC ||
+        (available >= 2ul && src[1] != FRAME_VERSION)
+    ) {
+        resync_(self);
+        return FRAME_ERR_CORRUPT;
+    }
+    if (available < FRAME_HEADER_SIZE) {
+        return FRAME_PENDING;
+    }
+    uint16_t const len = get_u16_(src + 6);
+    if (len > FRAME_MAX_PAYLOAD) {
+        resync_(self);
+        return FRAME_ERR_CORRUPT;
+    }
+    if (available < FRAME_HEADER_SIZE + len) {
+        return FRAME_PENDING;
+    }
+    header->opcode = src[2];
+    header->flags = get_u16_(src + 4);
+    header->len = len;
+    header->request_id = get_u32_(src + 8);
+    header->client_pid = get_u32_(src + 12);
+    *payload = self->buf + self->begin + FRAME_HEADER_SIZE;
+    self->begin += FRAME_HEADER_SIZE + len;
+    return FRAME_OK;
+}
+
+char const* frame_outcome_msg(
+    FrameOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        FRAME_OK == 0 &&
+            FRAME_PENDING == 1 &&
+            FRAME_EOF == 2 &&
+            FRAME_ERR_TOO_LARGE == 3 &&
+            FRAME_ERR_CORRUPT == 4 &&
+            FRAME_ERR_ALLOC_FAIL == 5 &&
+            FRAME_ERR_READ_FAIL == 6 &&
+            FRAME_ERR_WRITE_FAIL == 7,
+        "Unexpected FrameOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "incomplete frame",
+        "end of file reached",
+        "frame payload is too large",
+        "corrupt frame stream, skipped bytes",
+        "failed allocating dynamic memory for the FrameDecoder",
+        "failed reading from the file descriptor",
+        "failed writing to the file descriptor",
+        "unknown frame error"
+    };
+    switch (outcome) {
+    case FRAME_ERR_ALLOC_FAIL:
+    case FRAME_ERR_READ_FAIL:
+    case FRAME_ERR_WRITE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case FRAME_OK:
+    case FRAME_PENDING:
+    case FRAME_EOF:
+    case FRAME_ERR_TOO_LARGE:
+    case FRAME_ERR_CORRUPT:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
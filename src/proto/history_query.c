@@ -0,0 +1,295 @@
+#include "proto/history_query.h"
+
+#include "parse_size.h"
+#include "proto/frame.h"
+
+#include <assert.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+static_assert(
+    HQUERY_HEADER_SIZE == 9ul * 8ul,
+    "Expected a HistoryQuery to be encoded as nine u64s"
+);
+
+static char const* const class_names[HQUERY_CLASSES] = {
+    [HCLASS_OK] = "ok",
+    [HCLASS_FAILED] = "failed",
+    [HCLASS_TERMINATED] = "terminated",
+    [HCLASS_EXEC_TIMEOUT] = "max-time",
+    [HCLASS_INACTIVE_TIMEOUT] = "inactivity"
+};
+
+static char const* const column_names[HQUERY_COLUMNS] = {
+    [HCOLUMN_WALL] = "wall",
+    [HCOLUMN_USER] = "user",
+    [HCOLUMN_SYS] = "sys",
+    [HCOLUMN_RSS] = "rss",
+    [HCOLUMN_PEAK] = "peak",
+    [HCOLUMN_MINFLT] = "minflt",
+    [HCOLUMN_MAJFLT] = "majflt",
+    [HCOLUMN_VCSW] = "vcsw",
+    [HCOLUMN_IVCSW] = "ivcsw"
+};
+
+static bool is_key_(
+    char const* const begin,
+    char const* const eq,
+    char const* const key
+) {
+    size_t const len = (size_t) (eq - begin);
+    return strlen(key) == len && strncmp(begin, key, len) == 0;
+}
+
+static bool parse_value_(
+    char const* const begin,
+    char const* const end,
+    uint64_t const max,
+    uint64_t* const value
+) {
+    size_t parsed;
+    if (parse_size_slice(begin, end, &parsed, NULL) != PARSE_SIZE_OK ||
+        parsed > max
+    ) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+/**
+ * Finds the column named by the characters in [begin, end).
+ */
+static bool parse_column_(
+    char const* const begin,
+    char const* const end,
+    uint32_t* const column
+) {
+    for (size_t i = 0ul; i < HQUERY_COLUMNS; ++i) {
+        if (is_key_(begin, end, column_names[i])) {
+            *column = (uint32_t) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+HistoryQuery* hquery_new(HistoryQuery* const init) {
+#   if HISTORY_QUERY_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // HISTORY_QUERY_RUNTIME_ASSERTS
+
+    *init = (HistoryQuery) {
+        .fields = 0u,
+        .last = 0u,
+        .since_id = 0u,
+        .from_sec = 0,
+        .to_sec = 0,
+        .exit_status = 0,
+        .end_class = 0u,
+        .columns = 0u,
+        .sort_column = 0u,
+        .prefix = NULL,
+        .prefix_len = 0ul
+    };
+    return init;
+}
+
+HistoryQueryOutcome hquery_parse_filter(
+    HistoryQuery* const restrict self,
+    char const* const begin,
+    char const* const end
+) {
+#   if HISTORY_QUERY_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(begin != NULL);
+    assert(end != NULL);
+#   endif  // HISTORY_QUERY_RUNTIME_ASSERTS
+
+    char const* const eq = memchr(begin, '=', (size_t) (end - begin));
+    if (!eq) {
+        return HQUERY_ERR_UNKNOWN_FILTER;
+    }
+    char const* const value = eq + 1;
+    uint64_t number;
+    if (is_key_(begin, eq, "cmd")) {
+        if ((size_t) (end - value) > FRAME_MAX_PAYLOAD - HQUERY_HEADER_SIZE) {
+            return HQUERY_ERR_TOO_LONG;
+        }
+        self->fields |= HQUERY_PREFIX;
+        self->prefix = value;
+        self->prefix_len = (size_t) (end - value);
+    } else if (is_key_(begin, eq, "end")) {
+        for (size_t i = 0ul; i < HQUERY_CLASSES; ++i) {
+            if (is_key_(value, end, class_names[i])) {
+                self->fields |= HQUERY_CLASS;
+                self->end_class = (uint32_t) i;
+                return HQUERY_OK;
+            }
+        }
+        return HQUERY_ERR_INV_VALUE;
+    } else if (is_key_(begin, eq, "show")) {
+        uint32_t columns = 0u;
+        if (is_key_(value, end, "all")) {
+            columns = (1u << HQUERY_COLUMNS) - 1u;
+        } else {
+            for (char const* i = value; i <= end;) {
+                char const* const comma = memchr(i, ',', (size_t) (end - i));
+                char const* const name_end = comma ? comma : end;
+                uint32_t column;
+                if (!parse_column_(i, name_end, &column)) {
+                    return HQUERY_ERR_INV_VALUE;
+                }
+                columns |= 1u << column;
+                i = name_end + 1;
+            }
+        }
+        self->fields |= HQUERY_SHOW;
+        self->columns = columns;
+    } else if (is_key_(begin, eq, "sort")) {
+        uint32_t column;
+        if (!parse_column_(value, end, &column)) {
+            return HQUERY_ERR_INV_VALUE;
+        }
+        self->fields |= HQUERY_SORT;
+        self->sort_column = column;
+    } else if (is_key_(begin, eq, "last")) {
+        if (!parse_value_(value, end, UINT64_MAX, &number)) {
+            return HQUERY_ERR_INV_VALUE;
+        }
+        self->fields |= HQUERY_LAST;
+        self->last = number;
+    } else if (is_key_(begin, eq, "since")) {
+        if (!parse_value_(value, end, UINT64_MAX, &number)) {
+            return HQUERY_ERR_INV_VALUE;
+        }
+        self->fields |= HQUERY_SINCE;
+        self->since_id = number;
+    } else if (is_key_(begin, eq, "from")) {
+        if (!parse_value_(value, end, INT64_MAX, &number)) {
+            return HQUERY_ERR_INV_VALUE;
+        }
+        self->fields |= HQUERY_FROM;
+        self->from_sec = (int64_t) number;
+    } else if (is_key_(begin, eq, "to")) {
+        if (!parse_value_(value, end, INT64_MAX, &number)) {
+            return HQUERY_ERR_INV_VALUE;
+        }
+        self->fields |= HQUERY_TO;
+        self->to_sec = (int64_t) number;
+    } else if (is_key_(begin, eq, "status")) {
+        if (!parse_value_(value, end, 255u, &number)) {
+            return HQUERY_ERR_INV_VALUE;
+        }
+        self->fields |= HQUERY_STATUS;
+        self->exit_status = (int32_t) number;
+    } else {
+        return HQUERY_ERR_UNKNOWN_FILTER;
+    }
+    return HQUERY_OK;
+}
+
+size_t hquery_encoded_len(HistoryQuery const* const self) {
+#   if HISTORY_QUERY_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // HISTORY_QUERY_RUNTIME_ASSERTS
+
+    return HQUERY_HEADER_SIZE + self->prefix_len;
+}
+
+void hquery_encode(
+    HistoryQuery const* const restrict self,
+    unsigned char* const restrict dst
+) {
+#   if HISTORY_QUERY_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(dst != NULL);
+#   endif  // HISTORY_QUERY_RUNTIME_ASSERTS
+
+    frame_put_u64(dst, self->fields);
+    frame_put_u64(dst + 8, self->last);
+    frame_put_u64(dst + 16, self->since_id);
+    frame_put_u64(dst + 24, (uint64_t) self->from_sec);
+    frame_put_u64(dst + 32, (uint64_t) self->to_sec);
+    frame_put_u64(dst + 40, (uint64_t) (int64_t) self->exit_status);
+    frame_put_u64(dst + 48, self->end_class);
+    frame_put_u64(dst + 56, self->columns);
+    frame_put_u64(dst + 64, self->sort_column);
+    if (self->prefix_len > 0ul) {
+        memcpy(dst + HQUERY_HEADER_SIZE, self->prefix, self->prefix_len);
+    }
+}
+
+HistoryQueryOutcome hquery_decode(
+    HistoryQuery* const restrict init,
+    unsigned char const* const restrict src,
+    size_t const len
+) {
+#   if HISTORY_QUERY_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(src != NULL || len == 0ul);
+#   endif  // HISTORY_QUERY_RUNTIME_ASSERTS
+
+    hquery_new(init);
+    if (len == 0ul) {
+        return HQUERY_OK;
+    }
+    if (len < HQUERY_HEADER_SIZE) {
+        return HQUERY_ERR_CORRUPT;
+    }
+    init->fields = (uint32_t) frame_get_u64(src);
+    init->last = frame_get_u64(src + 8);
+    init->since_id = frame_get_u64(src + 16);
+    init->from_sec = (int64_t) frame_get_u64(src + 24);
+    init->to_sec = (int64_t) frame_get_u64(src + 32);
+    init->exit_status = (int32_t) (int64_t) frame_get_u64(src + 40);
+    init->end_class = (uint32_t) frame_get_u64(src + 48);
+    init->columns =
+        (uint32_t) frame_get_u64(src + 56) & ((1u << HQUERY_COLUMNS) - 1u);
+    init->sort_column = (uint32_t) frame_get_u64(src + 64);
+    if (init->end_class >= HQUERY_CLASSES) {
+        init->fields &= ~(uint32_t) HQUERY_CLASS;
+    }
+    if (init->sort_column >= HQUERY_COLUMNS) {
+        init->fields &= ~(uint32_t) HQUERY_SORT;
+    }
+    init->prefix = (char const*) src + HQUERY_HEADER_SIZE;
+    init->prefix_len = len - HQUERY_HEADER_SIZE;
+    return HQUERY_OK;
+}
+
+char const* hquery_column_name(HistoryColumn const column) {
+#   if HISTORY_QUERY_RUNTIME_ASSERTS
+    assert(column < HQUERY_COLUMNS);
+#   endif  // HISTORY_QUERY_RUNTIME_ASSERTS
+
+    return column_names[column];
+}
+
+char const* hquery_outcome_msg(HistoryQueryOutcome const outcome) {
+    static_assert(
+        HQUERY_OK == 0 &&
+            HQUERY_ERR_UNKNOWN_FILTER == 1 &&
+            HQUERY_ERR_INV_VALUE == 2 &&
+            HQUERY_ERR_TOO_LONG == 3 &&
+            HQUERY_ERR_CORRUPT == 4,
+        "Unexpected HistoryQueryOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "unknown filter, expected one of last, since, from, to, status, end,"
+            " cmd, show or sort",
+        "invalid filter value",
+        "command prefix is too long",
+        "truncated query",
+        "unknown history query error"
+    };
+    if (outcome < HQUERY_OK || outcome > HQUERY_ERR_CORRUPT) {
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+    return msgs[outcome];
+}
@@ -0,0 +1,181 @@
+#include "reactor/reactor.h"
+
+#include <unistd.h>
+
+#include <sys/epoll.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+ReactorOutcome reactor_new(Reactor* const init) {
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    init->epoll_des = epoll_create1(EPOLL_CLOEXEC);
+    if (init->epoll_des == -1) {
+        return REACTOR_ERR_CREATE_FAIL;
+    }
+    init->ready_len = 0ul;
+    init->ready_pos = 0ul;
+    return REACTOR_OK;
+}
+
+ReactorOutcome reactor_drop(Reactor* const self) {
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    return close(self->epoll_des) == -1 ? REACTOR_ERR_CLOSE_FAIL : REACTOR_OK;
+}
+
+ReactorOutcome reactor_add(
+    Reactor* const restrict self,
+    ReactorSource* const restrict source,
+    uint32_t const events
+) {
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(source != NULL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    struct epoll_event event = { .events = events, .data.ptr = source };
+    if (epoll_ctl(self->epoll_des, EPOLL_CTL_ADD, source->file_des, &event) ==
+        -1
+    ) {
+        return REACTOR_ERR_CTL_FAIL;
+    }
+    return REACTOR_OK;
+}
+
+ReactorOutcome reactor_mod(
+    Reactor* const restrict self,
+    ReactorSource* const restrict source,
+    uint32_t const events
+) {
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(source != NULL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    struct epoll_event event = { .events = events, .data.ptr = source };
+    if (epoll_ctl(self->epoll_des, EPOLL_CTL_MOD, source->file_des, &event) ==
+        -1
+    ) {
+        return REACTOR_ERR_CTL_FAIL;
+    }
+    return REACTOR_OK;
+}
+
+ReactorOutcome reactor_rm(
+    Reactor* const restrict self,
+    ReactorSource* const restrict source
+) {
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(source != NULL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    // discard pending dispatches, since the source may be freed right after
+    for (size_t i = self->ready_pos; i < self->ready_len; ++i) {
+        if (self->ready[i] == source) {
+            self->ready[i] = NULL;
+        }
+    }
+    if (epoll_ctl(self->epoll_des, EPOLL_CTL_DEL, source->file_des, NULL) ==
+        -1
+    ) {
+        return REACTOR_ERR_CTL_FAIL;
+    }
+    return REACTOR_OK;
+}
+
+ReactorOutcome reactor_poll(Reactor* const self, int const timeout_ms) {
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    int const ready_count =
+        epoll_wait(self->epoll_des, events, REACTOR_MAX_EVENTS, timeout_ms);
+    if (ready_count == -1) {
+        return errno == EINTR ? REACTOR_OK : REACTOR_ERR_WAIT_FAIL;
+    }
+    for (int i = 0; i < ready_count; ++i) {
+        self->ready[i] = events[i].data.ptr;
+    }
+    self->ready_len = (size_t) ready_count;
+    for (self->ready_pos = 0ul;
+        self->ready_pos < self->ready_len;
+        ++self->ready_pos
+    ) {
+        ReactorSource* const source = self->ready[self->ready_pos];
+        if (source) {
+            source->callback(source, events[self->ready_pos].events);
+        }
+    }
+    self->ready_len = 0ul;
+    self->ready_pos = 0ul;
+    return REACTOR_OK;
+}
+
+char const* reactor_outcome_msg(
+    ReactorOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        REACTOR_OK == 0 &&
+            REACTOR_ERR_CREATE_FAIL == 1 &&
+            REACTOR_ERR_CTL_FAIL == 2 &&
+            REACTOR_ERR_WAIT_FAIL == 3 &&
+            REACTOR_ERR_CLOSE_FAIL == 4,
+        "Unexpected ReactorOutcome enumerate values"
+    );
+
+#   if REACTOR_RUNTIME_ASSERTS
+    assert(outcome >= REACTOR_OK && outcome <= REACTOR_ERR_CLOSE_FAIL);
+#   endif  // REACTOR_RUNTIME_ASSERTS
+
+    static char const* const msgs[] = {
+        "success",
+        "failed creating the epoll instance",
+        "failed (un)registering a file descriptor",
+        "failed waiting for events",
+        "failed closing the epoll instance",
+        "unknown Reactor error"
+    };
+    switch (outcome) {
+    case REACTOR_ERR_CREATE_FAIL:
+    case REACTOR_ERR_CTL_FAIL:
+    case REACTOR_ERR_WAIT_FAIL:
+    case REACTOR_ERR_CLOSE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case REACTOR_OK:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
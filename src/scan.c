@@ -0,0 +1,290 @@
+#include "scan.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__SSE2__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SCAN_HAS_X86 1
+#include <immintrin.h>
+#else
+#define SCAN_HAS_X86 0
+#endif
+
+static bool is_in_(char const c, unsigned const classes) {
+    unsigned char const byte = (unsigned char) c;
+    return ((classes & SCAN_SPACE) &&
+            (byte == ' ' || (byte >= '\t' && byte <= '\r'))) ||
+        ((classes & SCAN_NEWLINE) && byte == '\n') ||
+        ((classes & SCAN_PIPE) && byte == '|');
+}
+
+/**
+ * The widest instruction set available, and the widest one used, or @p -1
+ * until checked.
+ */
+static int available_isa_ = -1;
+static int used_isa_ = -1;
+
+/**
+ * Returns the widest instruction set used, which is only checked once, as
+ * SSE2 is always available where it's compiled for.
+ */
+static ScanIsa isa_(void) {
+    if (available_isa_ == -1) {
+#       if SCAN_HAS_X86
+        __builtin_cpu_init();
+        available_isa_ = __builtin_cpu_supports("avx2") ?
+            SCAN_ISA_AVX2 : SCAN_ISA_SSE2;
+#       else
+        available_isa_ = SCAN_ISA_PORTABLE;
+#       endif  // SCAN_HAS_X86
+        used_isa_ = available_isa_;
+    }
+    return (ScanIsa) used_isa_;
+}
+
+#if SCAN_HAS_X86
+
+/**
+ * Returns a mask of the 16 bytes at @p src in @p classes, the lowest bit being
+ * that of the first byte.
+ */
+static uint32_t mask_sse2_(char const* const src, unsigned const classes) {
+    __m128i const bytes = _mm_loadu_si128((__m128i const*) src);
+    __m128i matches = _mm_setzero_si128();
+    if (classes & SCAN_SPACE) {
+        // '\t' to '\r', as signed bytes, so that non ASCII ones never match
+        __m128i const is_ctrl_space = _mm_and_si128(
+            _mm_cmpgt_epi8(bytes, _mm_set1_epi8('\t' - 1)),
+            _mm_cmplt_epi8(bytes, _mm_set1_epi8('\r' + 1))
+        );
+        matches = _mm_or_si128(
+            is_ctrl_space,
+            _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '))
+        );
+    } else if (classes & SCAN_NEWLINE) {
+        matches = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+    }
+    if (classes & SCAN_PIPE) {
+        matches =
+            _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('|')));
+    }
+    return (uint32_t) _mm_movemask_epi8(matches);
+}
+
+/**
+ * Returns a mask of the 32 bytes at @p src in @p classes, the lowest bit being
+ * that of the first byte.
+ */
+__attribute__((target("avx2")))
+static uint32_t mask_avx2_(char const* const src, unsigned const classes) {
+    __m256i const bytes = _mm256_loadu_si256((__m256i const*) src);
+    __m256i matches = _mm256_setzero_si256();
+    if (classes & SCAN_SPACE) {
+        __m256i const is_ctrl_space = _mm256_and_si256(
+            _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('\t' - 1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), bytes)
+        );
+        matches = _mm256_or_si256(
+            is_ctrl_space,
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '))
+        );
+    } else if (classes & SCAN_NEWLINE) {
+        matches = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+    }
+    if (classes & SCAN_PIPE) {
+        matches = _mm256_or_si256(
+            matches,
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('|'))
+        );
+    }
+    return (uint32_t) _mm256_movemask_epi8(matches);
+}
+
+/**
+ * Defines the kernels of an instruction set, over its mask function, each
+ * going over whole vectors only, and returning where it stopped, so that the
+ * rest is left to narrower ones.
+ */
+#define DEFINE_KERNELS_(isa, width, attr)                                     \
+    attr static char const* find_##isa##_(                                    \
+        char const* i,                                                        \
+        char const* const end,                                                \
+        unsigned const classes,                                               \
+        bool const is_skip                                                    \
+    ) {                                                                       \
+        uint32_t const flip = is_skip ? (uint32_t) ((1ull << width) - 1u) : 0u;\
+        for (; end - i >= width; i += width) {                                \
+            uint32_t const mask = mask_##isa##_(i, classes) ^ flip;           \
+            if (mask) {                                                       \
+                return i + __builtin_ctz(mask);                               \
+            }                                                                 \
+        }                                                                     \
+        return i;                                                             \
+    }                                                                         \
+                                                                              \
+    attr static char const* count_##isa##_(                                   \
+        char const* i,                                                        \
+        char const* const end,                                                \
+        unsigned const classes,                                               \
+        size_t* const count                                                   \
+    ) {                                                                       \
+        for (; end - i >= width; i += width) {                                \
+            *count += (size_t) __builtin_popcount(                            \
+                mask_##isa##_(i, classes)                                     \
+            );                                                                \
+        }                                                                     \
+        return i;                                                             \
+    }                                                                         \
+                                                                              \
+    attr static char const* count_runs_##isa##_(                              \
+        char const* i,                                                        \
+        char const* const end,                                                \
+        unsigned const classes,                                               \
+        size_t* const runs,                                                   \
+        bool* const is_in_run                                                 \
+    ) {                                                                       \
+        uint32_t const full = (uint32_t) ((1ull << width) - 1u);              \
+        for (; end - i >= width; i += width) {                                \
+            uint32_t const in_run = ~mask_##isa##_(i, classes) & full;        \
+            uint32_t const starts =                                           \
+                in_run & ~((in_run << 1u) | (uint32_t) *is_in_run);           \
+            *runs += (size_t) __builtin_popcount(starts & full);              \
+            *is_in_run = (in_run >> (width - 1)) & 1u;                        \
+        }                                                                     \
+        return i;                                                             \
+    }
+
+DEFINE_KERNELS_(avx2, 32, __attribute__((target("avx2"))))
+DEFINE_KERNELS_(sse2, 16, )
+
+#endif  // SCAN_HAS_X86
+
+static char const* find_(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes,
+    bool const is_skip
+) {
+    char const* i = begin;
+#   if SCAN_HAS_X86
+    ScanIsa const isa = isa_();
+    if (isa >= SCAN_ISA_AVX2) {
+        i = find_avx2_(i, end, classes, is_skip);
+    }
+    if (isa >= SCAN_ISA_SSE2) {
+        i = find_sse2_(i, end, classes, is_skip);
+    }
+#   endif  // SCAN_HAS_X86
+    while (i != end && is_in_(*i, classes) == is_skip) {
+        ++i;
+    }
+    return i;
+}
+
+char const* scan_find(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes
+) {
+#   if SCAN_RUNTIME_ASSERTS
+    assert(begin != NULL);
+    assert(end != NULL);
+#   endif  // SCAN_RUNTIME_ASSERTS
+
+    return find_(begin, end, classes, false);
+}
+
+char const* scan_skip(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes
+) {
+#   if SCAN_RUNTIME_ASSERTS
+    assert(begin != NULL);
+    assert(end != NULL);
+#   endif  // SCAN_RUNTIME_ASSERTS
+
+    return find_(begin, end, classes, true);
+}
+
+char const* scan_skip_back(
+    char const* const begin,
+    char const* end,
+    unsigned const classes
+) {
+#   if SCAN_RUNTIME_ASSERTS
+    assert(begin != NULL);
+    assert(end != NULL);
+#   endif  // SCAN_RUNTIME_ASSERTS
+
+    while (end != begin && is_in_(end[-1], classes)) {
+        --end;
+    }
+    return end;
+}
+
+size_t scan_count(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes
+) {
+#   if SCAN_RUNTIME_ASSERTS
+    assert(begin != NULL);
+    assert(end != NULL);
+#   endif  // SCAN_RUNTIME_ASSERTS
+
+    size_t count = 0ul;
+    char const* i = begin;
+#   if SCAN_HAS_X86
+    ScanIsa const isa = isa_();
+    if (isa >= SCAN_ISA_AVX2) {
+        i = count_avx2_(i, end, classes, &count);
+    }
+    if (isa >= SCAN_ISA_SSE2) {
+        i = count_sse2_(i, end, classes, &count);
+    }
+#   endif  // SCAN_HAS_X86
+    for (; i != end; ++i) {
+        count += is_in_(*i, classes);
+    }
+    return count;
+}
+
+size_t scan_count_runs(
+    char const* const begin,
+    char const* const end,
+    unsigned const classes
+) {
+#   if SCAN_RUNTIME_ASSERTS
+    assert(begin != NULL);
+    assert(end != NULL);
+#   endif  // SCAN_RUNTIME_ASSERTS
+
+    size_t runs = 0ul;
+    bool is_in_run = false;
+    char const* i = begin;
+#   if SCAN_HAS_X86
+    ScanIsa const isa = isa_();
+    if (isa >= SCAN_ISA_AVX2) {
+        i = count_runs_avx2_(i, end, classes, &runs, &is_in_run);
+    }
+    if (isa >= SCAN_ISA_SSE2) {
+        i = count_runs_sse2_(i, end, classes, &runs, &is_in_run);
+    }
+#   endif  // SCAN_HAS_X86
+    for (; i != end; ++i) {
+        bool const is_in = !is_in_(*i, classes);
+        runs += is_in && !is_in_run;
+        is_in_run = is_in;
+    }
+    return runs;
+}
+
+ScanIsa scan_limit_isa(ScanIsa const isa) {
+    isa_();
+    used_isa_ = (int) isa < available_isa_ ? (int) isa : available_isa_;
+    return (ScanIsa) used_isa_;
+}
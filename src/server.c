@@ -1,132 +1,2545 @@
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 
 #include "argus_conf.h"
-#include "buf_io/buf_writer.h"
+#include "buf_io/write_queue.h"
 #include "comfy_io.h"
-#include "parse_size.h"
+#include "proto/frame.h"
+#include "proto/history_query.h"
+#include "reactor/reactor.h"
+#include "task/launcher.h"
+#include "task/relay.h"
 #include "task/task.h"
-#include "task/task_vec.h"
+#include "task/task_board.h"
+#include "task/task_cgroup.h"
+#include "task/task_idx.h"
+#include "task/task_journal.h"
+#include "task/task_log.h"
+#include "task/task_queue.h"
+#include "task/task_sched.h"
+#include "task/task_slot_map.h"
+#include "task/zygote.h"
+#include "timer/timer_wheel.h"
 
 #include <fcntl.h>
 #include <signal.h>
 #include <unistd.h>
 
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 
-#include <ctype.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
-#define LINE_BUF_SIZE 8192ul
+/**
+ * The period of the timers' clock, in nanoseconds. A task is killed at most
+ * one tick after its maximum execution time.
+ */
+#define TIMER_TICK_NSECS 100000000l
+
+/**
+ * The number of ticks of the timers' clock per second.
+ */
+#define TIMER_TICKS_PER_SEC (1000000000ul / TIMER_TICK_NSECS)
+
+/**
+ * The number of seconds running tasks are given to exit once the server is
+ * asked to stop, before being killed.
+ */
+#define SHUTDOWN_GRACE_SECS 5ul
+
+/**
+ * The kinds of timers in the server's timer wheel.
+ */
+typedef enum TimerKind {
+    TIMER_EXEC, //!< A task's maximum execution time.
+    TIMER_INACTIVE, //!< A task's maximum inactivity time.
+    TIMER_SHUTDOWN, //!< The running tasks' time left to exit on shutdown.
+} TimerKind;
+
+/**
+ * A reply being written to a client through a non blocking fifo.
+ * Owns the fifo's file descriptor, and frees itself once fully written.
+ */
+typedef struct Reply {
+    ReactorSource source;   //!< The fifo's write end, watched for EPOLLOUT.
+    WriteQueue queue;   //!< The bytes pending to be written.
+    TaskLogEntry output;    //!< The rest of a task's output to be written,
+                            //!< once the queue is drained.
+    bool is_registered; //!< If the fifo is registered in the reactor.
+    uint32_t client_pid;    //!< The client of a batch reply.
+    struct Reply* next_batch;   //!< The next batch still being submitted.
+} Reply;
+
+/**
+ * A client connected to the commands socket. Every packet it sends holds
+ * whole frames, and every reply is written to a pipe whose read end is passed
+ * to it, so that replies never go through the socket.
+ */
+typedef struct Connection {
+    ReactorSource source;   //!< The connected socket, watched for EPOLLIN.
+    FrameDecoder decoder;   //!< The frames received.
+    pid_t pid;  //!< The client's process id, vouched for by the kernel.
+    uid_t uid;  //!< The client's user id, vouched for by the kernel.
+} Connection;
+
+/**
+ * A finished task matching a sorted historico query, and the value of the
+ * column it's sorted by.
+ */
+typedef struct SortedRecord {
+    int64_t key;    //!< The value of the sort column.
+    TaskRecord const* record;   //!< The task's record, in the journal's
+                                //!< mapping.
+} SortedRecord;
+
+/**
+ * A historico reply being built.
+ */
+typedef struct HistoryReply {
+    WriteQueue* queue;  //!< The reply's queue.
+    HistoryQuery const* query;  //!< The query replied to.
+    SortedRecord* sorted;   //!< The matching tasks, if they're sorted.
+    size_t sorted_len;  //!< The number of matching tasks.
+    size_t sorted_cap;  //!< The capacity of @p sorted.
+} HistoryReply;
 
 static char const* const program_name = "argus_server";
 static int commands_fd;
-static int running_tasks_fd;
-static int finished_tasks_fd;
-static TaskVec running_tasks;
-static TaskVec finished_tasks;
-static BufWriter running_tasks_writer;
-static BufWriter finished_tasks_writer;
-static size_t total_tasks;
-
-static size_t count_char(char const* s, char const c) {
-    size_t count = 0ul;
-    for ( ; *s; ++s) {
-        if (*s == c) {
-            ++count;
-        }
-    }
-    return count;
-}
-
-static size_t count_words(char const* s) {
-    size_t count = 0ul;
-    while (*s) {
-        while (isspace(*s)) {
-            ++s;
-        }
-        if (*s) {
-            ++count;
-            while (*s && !isspace(*s)) {
-                ++s;
+static int commands_keepalive_fd;
+static int listen_fd;
+static ReactorSource listen_source;
+static int signals_fd;
+static Reactor reactor;
+static Zygote zygote;
+static bool has_zygote;
+static TaskCgroups task_cgroups;
+static bool has_cgroups;
+static FrameDecoder commands_decoder;
+static ReactorSource commands_source;
+static ReactorSource signals_source;
+static int timers_fd;
+static ReactorSource timers_source;
+static TimerWheel timers;
+static bool are_timers_armed;
+static size_t exec_timeout_secs;
+static size_t inactive_timeout_secs;
+static size_t max_running_tasks;
+static TaskSlotMap running_tasks;
+static TaskIdx running_tasks_idx;
+static TaskSched pending_tasks;
+static TaskBoard running_board;
+static bool has_board;
+static TaskIdx board_tasks_idx;
+static TaskIdx stage_pids;
+static TaskJournal finished_tasks;
+static TaskLog task_log;
+static bool is_running = true;
+static bool is_stopping;
+
+/**
+ * Replies to batches whose tasks are still being submitted, at most one per
+ * client. There are rarely more than a handful, so a list suffices.
+ */
+static Reply* pending_batches;
+
+static void close_commands_fifo(void) {
+    if (
+        (commands_fd != -1 && close(commands_fd) == -1) ||
+        close(commands_keepalive_fd) == -1
+    ) {
+        program_eprintln(
+            "Failed closing commands fifo: %s.",
+            strerror(errno)
+        );
+    }
+}
+
+static void close_commands_socket(void) {
+    if (close(listen_fd) == -1 || unlink(commands_socketname) == -1) {
+        program_eprintln(
+            "Failed closing commands socket: %s.",
+            strerror(errno)
+        );
+    }
+}
+
+static void close_signals_fd(void) {
+    if (close(signals_fd) == -1) {
+        program_eprintln(
+            "Failed closing the signals file descriptor: %s.",
+            strerror(errno)
+        );
+    }
+}
+
+static void close_running_board(void) {
+    tboard_close(&running_board);
+}
+
+static void drop_commands_decoder(void) {
+    fdec_drop(&commands_decoder);
+}
+
+static void drop_zygote(void) {
+    if (!has_zygote) {
+        return;
+    }
+    ZygoteOutcome const drop_outcome = zygote_drop(&zygote);
+    if (drop_outcome != ZYGOTE_OK) {
+        program_eprintln(
+            "Failed dropping the zygote: %s.",
+            zygote_outcome_msg(drop_outcome, &errno)
+        );
+    }
+}
+
+static void close_task_cgroups(void) {
+    tcgroup_close(&task_cgroups);
+}
+
+static void drop_timers(void) {
+    twheel_drop(&timers);
+    if (close(timers_fd) == -1) {
+        program_eprintln(
+            "Failed closing the timers file descriptor: %s.",
+            strerror(errno)
+        );
+    }
+}
+
+static void close_task_journal(void) {
+    TaskJournalOutcome const close_outcome = tjournal_close(&finished_tasks);
+    if (close_outcome != TJOURNAL_OK) {
+        program_eprintln(
+            "Failed closing the task journal: %s.",
+            tjournal_outcome_msg(close_outcome, &errno)
+        );
+    }
+}
+
+static void close_task_log(void) {
+    TaskLogOutcome const close_outcome = tlog_close(&task_log);
+    if (close_outcome != TLOG_OK) {
+        program_eprintln(
+            "Failed closing the task log: %s.",
+            tlog_outcome_msg(close_outcome, &errno)
+        );
+    }
+}
+
+static void drop_reactor(void) {
+    ReactorOutcome const drop_outcome = reactor_drop(&reactor);
+    if (drop_outcome != REACTOR_OK) {
+        program_eprintln(
+            "Failed dropping the reactor: %s.",
+            reactor_outcome_msg(drop_outcome, &errno)
+        );
+    }
+}
+
+static void drop_task_vecs(void) {
+    Task* const running_begin = tsmap_begin_mut(&running_tasks);
+    Task* const running_end = running_begin + tsmap_len(&running_tasks);
+    for (Task* i = running_begin; i != running_end; ++i) {
+        for (size_t j = 0ul; j < i->relay_count; ++j) {
+            relay_drop(i->relays + j);
+        }
+        if (i->spool_fd != -1) {
+            close(i->spool_fd);
+        }
+        tarena_drop(&i->arena);
+    }
+    tsmap_drop(&running_tasks);
+    tidx_drop(&running_tasks_idx);
+    tsched_drop(&pending_tasks);
+    tidx_drop(&board_tasks_idx);
+    tidx_drop(&stage_pids);
+}
+
+static void forget_batch(Reply const* const reply) {
+    for (Reply** i = &pending_batches; *i; i = &(*i)->next_batch) {
+        if (*i == reply) {
+            *i = reply->next_batch;
+            return;
+        }
+    }
+}
+
+static void reply_free(Reply* const reply) {
+    if (reply->is_registered) {
+        ReactorOutcome const rm_outcome = reactor_rm(&reactor, &reply->source);
+        if (rm_outcome != REACTOR_OK) {
+            program_eprintln(
+                "Failed unregistering a reply fifo: %s.",
+                reactor_outcome_msg(rm_outcome, &errno)
+            );
+        }
+    }
+    forget_batch(reply);
+    if (close(reply->source.file_des) == -1) {
+        program_eprintln(
+            "Failed closing a reply fifo: %s.",
+            strerror(errno)
+        );
+    }
+    wq_drop(&reply->queue);
+    free(reply);
+}
+
+/**
+ * Writes as much of the reply as the fifo takes, refilling the queue from the
+ * task log one frame at a time, so that a large output is never held in
+ * memory whole.
+ */
+static WqOutcome reply_flush(Reply* const reply) {
+    for (;;) {
+        WqOutcome const flush_outcome =
+            wq_flush(&reply->queue, reply->source.file_des);
+        if (flush_outcome != WQ_OK || reply->output.len == 0u) {
+            return flush_outcome;
+        }
+        TaskLogChunk chunk;
+        TaskLogOutcome const read_outcome =
+            tlog_read(&task_log, &reply->output, &chunk);
+        if (read_outcome != TLOG_OK) {
+            program_eprintln(
+                "Failed reading the task log: %s.",
+                tlog_outcome_msg(read_outcome, &errno)
+            );
+            reply->output.len = 0u;
+            return WQ_OK;
+        }
+        WqOutcome const push_outcome = chunk.data ?
+            wq_push(&reply->queue, chunk.data, chunk.len) :
+            wq_push_file(
+                &reply->queue,
+                task_log.log_fd,
+                chunk.file_off,
+                chunk.len
+            );
+        if (push_outcome != WQ_OK) {
+            return push_outcome;
+        }
+    }
+}
+
+static void on_reply_writable(ReactorSource* const source, uint32_t const events) {
+    Reply* const reply = source->ctx;
+    WqOutcome const flush_outcome =
+        events & EPOLLERR ? WQ_ERR_WRITE_FAIL : reply_flush(reply);
+    if (flush_outcome == WQ_PENDING) {
+        return;
+    }
+    if (flush_outcome != WQ_OK) {
+        program_eprintln(
+            "Failed writing a reply: %s.",
+            wq_outcome_msg(flush_outcome, &errno)
+        );
+    }
+    reply_free(reply);
+}
+
+/**
+ * Creates a reply written to @p fd, which must be non blocking, and which the
+ * reply takes ownership of.
+ */
+static Reply* reply_new(int const fd) {
+    Reply* const reply = malloc(sizeof *reply);
+    if (!reply) {
+        program_eprintln(
+            "Failed allocating a reply: %s.",
+            strerror(errno)
+        );
+        close(fd);
+        return NULL;
+    }
+    reply->source = (ReactorSource) {
+        .file_des = fd,
+        .callback = on_reply_writable,
+        .ctx = reply
+    };
+    wq_new(&reply->queue);
+    reply->output.len = 0u;
+    reply->is_registered = false;
+    reply->client_pid = 0u;
+    reply->next_batch = NULL;
+    return reply;
+}
+
+/**
+ * Opens the write end of a reply fifo without blocking. The client is expected
+ * to have opened the read end before sending its command; if it hasn't, there's
+ * no one to reply to, and @p NULL is returned.
+ */
+static Reply* reply_open(char const* const fifoname) {
+    int const fd = open(fifoname, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        if (errno != ENXIO) {
+            program_eprintln(
+                "Failed opening reply fifo '%s': %s.",
+                fifoname,
+                strerror(errno)
+            );
+        }
+        return NULL;
+    }
+    return reply_new(fd);
+}
+
+/**
+ * Opens a reply through a pipe, whose read end is passed to the client over
+ * its connection, along with the header of the request replied to.
+ */
+static Reply* reply_open_pipe(
+    Connection const* const conn,
+    FrameHeader const* const header
+) {
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1 ||
+        fcntl(pipe_fds[1], F_SETFL, O_NONBLOCK) == -1
+    ) {
+        program_eprintln(
+            "Failed creating a reply pipe: %s.",
+            strerror(errno)
+        );
+        return NULL;
+    }
+    unsigned char encoded[FRAME_HEADER_SIZE];
+    FrameHeader reply_header = *header;
+    reply_header.len = 0u;
+    frame_encode_header(&reply_header, encoded);
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof control);
+    struct iovec iov = { .iov_base = encoded, .iov_len = sizeof encoded };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof control.buf
+    };
+    struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &pipe_fds[0], sizeof(int));
+    ssize_t sent;
+    do {
+        sent = sendmsg(
+            conn->source.file_des,
+            &msg,
+            MSG_DONTWAIT | MSG_NOSIGNAL
+        );
+    } while (sent == -1l && errno == EINTR);
+    int const send_errno = errno;
+    close(pipe_fds[0]);
+    if (sent == -1l) {
+        if (send_errno != EPIPE && send_errno != ECONNRESET) {
+            program_eprintln(
+                "Failed passing a reply pipe to client %d: %s.",
+                (int) conn->pid,
+                strerror(send_errno)
+            );
+        }
+        close(pipe_fds[1]);
+        return NULL;
+    }
+    return reply_new(pipe_fds[1]);
+}
+
+/**
+ * Opens a reply to the client of a request: a pipe passed over its
+ * connection, if it's connected, otherwise the client's own fifo.
+ */
+static Reply* reply_open_client(
+    FrameHeader const* const header,
+    Connection const* const opt_conn
+) {
+    if (opt_conn) {
+        return reply_open_pipe(opt_conn, header);
+    }
+    char fifoname[REPLY_FIFONAME_SIZE];
+    snprintf(
+        fifoname,
+        REPLY_FIFONAME_SIZE,
+        reply_fifoname_fmt,
+        (unsigned) header->client_pid
+    );
+    return reply_open(fifoname);
+}
+
+/**
+ * Writes as much of the reply as possible right away, and leaves the rest to
+ * be written by the reactor once the client drains the fifo, so that a slow
+ * client never stalls the server.
+ */
+static void reply_send(Reply* const reply) {
+    WqOutcome const flush_outcome = reply_flush(reply);
+    if (flush_outcome == WQ_PENDING) {
+        ReactorOutcome const add_outcome = reply->is_registered ?
+            reactor_mod(&reactor, &reply->source, EPOLLOUT) :
+            reactor_add(&reactor, &reply->source, EPOLLOUT);
+        if (add_outcome == REACTOR_OK) {
+            reply->is_registered = true;
+            return;
+        }
+        program_eprintln(
+            "Failed registering a reply fifo: %s.",
+            reactor_outcome_msg(add_outcome, &errno)
+        );
+    } else if (flush_outcome != WQ_OK) {
+        program_eprintln(
+            "Failed writing a reply: %s.",
+            wq_outcome_msg(flush_outcome, &errno)
+        );
+    }
+    reply_free(reply);
+}
+
+/**
+ * Queues a task's line of listar or historico: its id, how it ended if it's
+ * finished, i.e. if @p opt_end isn't @p NULL, the resources it used, as
+ * formatted in @p columns, and its command line.
+ */
+static WqOutcome push_task_line(
+    WriteQueue* const queue,
+    size_t const task_id,
+    TaskEnd const* const opt_end,
+    int const exit_status,
+    char const* const columns,
+    size_t const columns_len,
+    char const* const cmd,
+    size_t const cmd_len
+) {
+    char prefix[64];
+    int prefix_len;
+    if (!opt_end) {
+        prefix_len = snprintf(prefix, sizeof prefix, "#%zu", task_id);
+    } else if (*opt_end == TASK_END_TERMINATED) {
+        prefix_len = snprintf(
+            prefix,
+            sizeof prefix,
+            "#%zu, terminated",
+            task_id
+        );
+    } else if (*opt_end == TASK_END_EXEC_TIMEOUT) {
+        prefix_len = snprintf(
+            prefix,
+            sizeof prefix,
+            "#%zu, max execution time",
+            task_id
+        );
+    } else if (*opt_end == TASK_END_INACTIVE_TIMEOUT) {
+        prefix_len = snprintf(
+            prefix,
+            sizeof prefix,
+            "#%zu, inactivity timeout",
+            task_id
+        );
+    } else if (WIFEXITED(exit_status)) {
+        prefix_len = snprintf(
+            prefix,
+            sizeof prefix,
+            "#%zu, exit status %d",
+            task_id,
+            WEXITSTATUS(exit_status)
+        );
+    } else {
+        prefix_len = snprintf(
+            prefix,
+            sizeof prefix,
+            "#%zu, killed by signal %d",
+            task_id,
+            WTERMSIG(exit_status)
+        );
+    }
+    WqOutcome push_outcome = wq_push(queue, prefix, (size_t) prefix_len);
+    if (push_outcome == WQ_OK && columns_len > 0ul) {
+        push_outcome = wq_push(queue, columns, columns_len);
+    }
+    if (push_outcome == WQ_OK) {
+        push_outcome = wq_push(queue, ": ", 2ul);
+    }
+    if (push_outcome != WQ_OK) {
+        return push_outcome;
+    }
+    return wq_push_line(queue, cmd, cmd_len);
+}
+
+static bool push_pending_task(
+    void* const ctx,
+    PendingTask const* const task,
+    size_t const priority
+) {
+    (void) priority;
+
+    WriteQueue* const queue = ctx;
+    char prefix[64];
+    int const prefix_len = snprintf(
+        prefix,
+        sizeof prefix,
+        "#%zu, pending: ",
+        task->task_id
+    );
+    WqOutcome push_outcome = wq_push(queue, prefix, (size_t) prefix_len);
+    if (push_outcome == WQ_OK) {
+        push_outcome = wq_push_line(queue, task->cmd, task->cmd_len);
+    }
+    if (push_outcome != WQ_OK) {
+        program_eprintln(
+            "Failed queueing a task: %s.",
+            wq_outcome_msg(push_outcome, &errno)
+        );
+        return false;
+    }
+    return true;
+}
+
+static void reply_running_tasks(
+    FrameHeader const* const header,
+    Connection const* const opt_conn
+) {
+    Reply* const reply = reply_open_client(header, opt_conn);
+    if (!reply) {
+        return;
+    }
+    Task const* const end = tsmap_end(&running_tasks);
+    for (Task const* i = tsmap_begin(&running_tasks); i != end; ++i) {
+        WqOutcome const push_outcome = push_task_line(
+            &reply->queue,
+            i->task_id,
+            NULL,
+            0,
+            NULL,
+            0ul,
+            i->task_name,
+            strlen(i->task_name)
+        );
+        if (push_outcome != WQ_OK) {
+            program_eprintln(
+                "Failed queueing a task: %s.",
+                wq_outcome_msg(push_outcome, &errno)
+            );
+            reply_send(reply);
+            return;
+        }
+    }
+    // pending tasks follow, roughly in the order they'll be launched
+    tsched_for_each(&pending_tasks, push_pending_task, &reply->queue);
+    reply_send(reply);
+}
+
+/**
+ * Returns the value of a HistoryColumn of a finished task. Times are in
+ * microseconds, and memory in KiB.
+ */
+static int64_t record_column(
+    TaskRecord const* const record,
+    HistoryColumn const column
+) {
+    switch (column) {
+    case HCOLUMN_WALL:
+        return (record->end_sec - record->start_sec) * 1000000 +
+            (record->end_nsec - record->start_nsec) / 1000;
+    case HCOLUMN_USER:
+        return record->utime_usec;
+    case HCOLUMN_SYS:
+        return record->stime_usec;
+    case HCOLUMN_RSS:
+        return record->max_rss_kib;
+    case HCOLUMN_PEAK:
+        return record->mem_peak_kib;
+    case HCOLUMN_MINFLT:
+        return record->min_flt;
+    case HCOLUMN_MAJFLT:
+        return record->maj_flt;
+    case HCOLUMN_VCSW:
+        return record->nvcsw;
+    case HCOLUMN_IVCSW:
+        return record->nivcsw;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Formats the shown columns of a finished task, e.g.
+ * ", user 0.120s, rss 2048KiB", and returns the formatted length.
+ */
+static size_t format_columns(
+    TaskRecord const* const record,
+    uint32_t const columns,
+    char* const buf,
+    size_t const size
+) {
+    size_t len = 0ul;
+    for (size_t i = 0ul; i < HQUERY_COLUMNS && len < size; ++i) {
+        if (!(columns & 1u << i)) {
+            continue;
+        }
+        HistoryColumn const column = (HistoryColumn) i;
+        int64_t const value = record_column(record, column);
+        char const* const name = hquery_column_name(column);
+        int column_len;
+        switch (column) {
+        case HCOLUMN_WALL:
+        case HCOLUMN_USER:
+        case HCOLUMN_SYS:
+            column_len = snprintf(
+                buf + len,
+                size - len,
+                ", %s %" PRId64 ".%03" PRId64 "s",
+                name,
+                value / 1000000,
+                value % 1000000 / 1000
+            );
+            break;
+        case HCOLUMN_RSS:
+        case HCOLUMN_PEAK:
+            column_len = snprintf(
+                buf + len,
+                size - len,
+                ", %s %" PRId64 "KiB",
+                name,
+                value
+            );
+            break;
+        default:
+            column_len = snprintf(
+                buf + len,
+                size - len,
+                ", %s %" PRId64,
+                name,
+                value
+            );
+            break;
+        }
+        len += (size_t) column_len;
+    }
+    return len < size ? len : size - 1ul;
+}
+
+static bool push_finished_task(
+    HistoryReply const* const reply,
+    TaskRecord const* const record
+) {
+    char columns[256];
+    size_t const columns_len = reply->query->fields & HQUERY_SHOW ?
+        format_columns(record, reply->query->columns, columns, sizeof columns) :
+        0ul;
+    TaskEnd const end = (TaskEnd) record->end;
+    WqOutcome const push_outcome = push_task_line(
+        reply->queue,
+        (size_t) record->task_id,
+        &end,
+        record->exit_status,
+        columns,
+        columns_len,
+        tjournal_cmd(&finished_tasks, record),
+        record->cmd_len
+    );
+    if (push_outcome != WQ_OK) {
+        program_eprintln(
+            "Failed queueing a task: %s.",
+            wq_outcome_msg(push_outcome, &errno)
+        );
+        return false;
+    }
+    return true;
+}
+
+static bool visit_finished_task(
+    void* const ctx,
+    TaskRecord const* const record
+) {
+    HistoryReply* const reply = ctx;
+    if (!(reply->query->fields & HQUERY_SORT)) {
+        return push_finished_task(reply, record);
+    }
+    if (reply->sorted_len == reply->sorted_cap) {
+        size_t const new_cap =
+            reply->sorted_cap == 0ul ? 64ul : reply->sorted_cap * 2ul;
+        SortedRecord* const new_sorted =
+            realloc(reply->sorted, new_cap * sizeof *reply->sorted);
+        if (!new_sorted) {
+            program_eprintln(
+                "Failed sorting the finished tasks: %s.",
+                strerror(errno)
+            );
+            return false;
+        }
+        reply->sorted = new_sorted;
+        reply->sorted_cap = new_cap;
+    }
+    reply->sorted[reply->sorted_len++] = (SortedRecord) {
+        .key = record_column(
+            record,
+            (HistoryColumn) reply->query->sort_column
+        ),
+        .record = record
+    };
+    return true;
+}
+
+/**
+ * Sorts by the column's value, greatest first, then by id.
+ */
+static int cmp_sorted_records(void const* const a, void const* const b) {
+    SortedRecord const* const x = a;
+    SortedRecord const* const y = b;
+    if (x->key != y->key) {
+        return x->key < y->key ? 1 : -1;
+    }
+    return (x->record->task_id > y->record->task_id) -
+        (x->record->task_id < y->record->task_id);
+}
+
+/**
+ * Writes the tasks recorded as finished since the last flush to the task
+ * journal, syncing their commands at once.
+ */
+static void flush_finished_tasks(void) {
+    TaskJournalOutcome const flush_outcome = tjournal_flush(&finished_tasks);
+    if (flush_outcome != TJOURNAL_OK) {
+        program_eprintln(
+            "Failed writing the task journal: %s.",
+            tjournal_outcome_msg(flush_outcome, &errno)
+        );
+    }
+}
+
+/**
+ * Queues a line of a historico reply that isn't a task, e.g. why it's empty.
+ */
+static void push_history_note(
+    Reply* const reply,
+    char const* const fmt,
+    ...
+) {
+    char msg[256];
+    va_list args;
+    va_start(args, fmt);
+    int const msg_len = vsnprintf(msg, sizeof msg, fmt, args);
+    va_end(args);
+    if (msg_len < 0) {
+        return;
+    }
+    WqOutcome const push_outcome = wq_push(
+        &reply->queue,
+        msg,
+        (size_t) msg_len < sizeof msg ? (size_t) msg_len : sizeof msg - 1u
+    );
+    if (push_outcome != WQ_OK) {
+        program_eprintln(
+            "Failed queueing a history reply: %s.",
+            wq_outcome_msg(push_outcome, &errno)
+        );
+    }
+}
+
+/**
+ * Replies historico straight from the task journal's mapping, querying its
+ * indexes so that only the matching tasks are read. Corrupt records are
+ * skipped. Sorted replies gather the matching records first, which stay
+ * mapped while the reply is built.
+ */
+static void reply_finished_tasks(
+    FrameHeader const* const header,
+    char const* const payload,
+    Connection const* const opt_conn
+) {
+    Reply* const reply = reply_open_client(header, opt_conn);
+    if (!reply) {
+        return;
+    }
+    HistoryQuery query;
+    HistoryQueryOutcome const decode_outcome =
+        hquery_decode(&query, (unsigned char const*) payload, header->len);
+    if (decode_outcome != HQUERY_OK) {
+        program_eprintln(
+            "Failed decoding a history query: %s.",
+            hquery_outcome_msg(decode_outcome)
+        );
+        // the client waits on the reply, so it's told why it's empty
+        push_history_note(
+            reply,
+            "Invalid history query: %s.\n",
+            hquery_outcome_msg(decode_outcome)
+        );
+        reply_send(reply);
+        return;
+    }
+    // tasks that just finished are only visible once written
+    flush_finished_tasks();
+    HistoryReply history = {
+        .queue = &reply->queue,
+        .query = &query,
+        .sorted = NULL,
+        .sorted_len = 0ul,
+        .sorted_cap = 0ul
+    };
+    TaskJournalOutcome const query_outcome =
+        tjournal_query(&finished_tasks, &query, visit_finished_task, &history);
+    if (history.sorted_len > 0ul) {
+        qsort(
+            history.sorted,
+            history.sorted_len,
+            sizeof *history.sorted,
+            cmp_sorted_records
+        );
+    }
+    for (size_t i = 0ul; i < history.sorted_len; ++i) {
+        if (!push_finished_task(&history, history.sorted[i].record)) {
+            break;
+        }
+    }
+    free(history.sorted);
+    // the client is told which tasks weren't searched, after those that were
+    if (query_outcome == TJOURNAL_ERR_TOO_BROAD) {
+        push_history_note(
+            reply,
+            (query.fields & HQUERY_LAST) ?
+                "Only the last %lu finished tasks in range were searched,"
+                    " narrow the range with since=, from= or to=.\n" :
+                "Too many finished tasks in range to search by command or"
+                    " exit status, narrow the range with last=, since=, from="
+                    " or to=.\n",
+            TJOURNAL_MAX_SCANNED
+        );
+    }
+    reply_send(reply);
+}
+
+/**
+ * Publishes a task on the tasks board, indexing where it was put by id, or
+ * marks it as running if it's already there, pending.
+ */
+static void publish_task(
+    size_t const task_id,
+    TaskBoardState const state,
+    char const* const cmd,
+    size_t const cmd_len
+) {
+    if (!has_board) {
+        return;
+    }
+    size_t index;
+    if (tidx_get(&board_tasks_idx, task_id, &index)) {
+        tboard_set_state(&running_board, index, state);
+        return;
+    }
+    index = running_board.len;
+    TaskBoardOutcome const board_outcome =
+        tboard_push(&running_board, task_id, state, cmd, cmd_len);
+    // clients ask the server instead from now on
+    if (board_outcome != TBOARD_OK) {
+        program_eprintln(
+            "Failed publishing a task: %s.",
+            tboard_outcome_msg(board_outcome, &errno)
+        );
+        return;
+    }
+    // without knowing where the task is, it couldn't be removed, so the board
+    // is given up on
+    if (!tidx_put(&board_tasks_idx, task_id, index)) {
+        program_eprintln(
+            "Failed indexing the tasks board: %s.",
+            strerror(errno)
+        );
+        tboard_close(&running_board);
+        has_board = false;
+    }
+}
+
+/**
+ * Removes a task from the tasks board, if it's there, and reindexes the task
+ * moved into its place.
+ */
+static void unpublish_task(size_t const task_id) {
+    size_t index;
+    if (!has_board || !tidx_get(&board_tasks_idx, task_id, &index)) {
+        return;
+    }
+    tidx_rm(&board_tasks_idx, task_id);
+    uint64_t moved_id;
+    if (tboard_rm(&running_board, index, &moved_id)) {
+        // the moved task is already indexed, so reindexing it never allocates
+        tidx_put(&board_tasks_idx, (size_t) moved_id, index);
+    }
+}
+
+/**
+ * Inserts a Task in the running tasks, indexes its handle by id, and publishes
+ * it on the tasks board.
+ */
+static bool push_running_task(Task const* const task, TaskHandle* const handle) {
+    if (!tsmap_insert(&running_tasks, task, handle)) {
+        return false;
+    }
+    if (!tidx_put(&running_tasks_idx, task->task_id, *handle)) {
+        tsmap_rm(&running_tasks, *handle, NULL);
+        return false;
+    }
+    publish_task(
+        task->task_id,
+        TBOARD_RUNNING,
+        task->task_name,
+        strlen(task->task_name)
+    );
+    return true;
+}
+
+static Task* find_running_task(
+    size_t const task_id,
+    TaskHandle* const handle
+) {
+    if (!tidx_get(&running_tasks_idx, task_id, handle)) {
+        return NULL;
+    }
+    return tsmap_get_mut(&running_tasks, *handle);
+}
+
+static bool rm_running_task(TaskHandle const handle, Task* const opt_task) {
+    Task removed;
+    if (!tsmap_rm(&running_tasks, handle, &removed)) {
+        return false;
+    }
+    unpublish_task(removed.task_id);
+    tidx_rm(&running_tasks_idx, removed.task_id);
+    if (opt_task) {
+        *opt_task = removed;
+    }
+    return true;
+}
+
+/**
+ * Launches the task's pipeline through the zygote, or from the server itself if
+ * there's no zygote, and stores the stages' process ids in @p launch.
+ */
+static LauncherOutcome launch_task(
+    char const* const cmd,
+    size_t const cmd_len,
+    bool const is_relayed,
+    int const out_fd,
+    int const cgroup_fd,
+    ZygoteLaunch* const launch
+) {
+    if (has_zygote) {
+        ZygoteOutcome const zygote_outcome = zygote_launch(
+            &zygote,
+            cmd,
+            cmd_len,
+            is_relayed,
+            out_fd,
+            cgroup_fd,
+            launch
+        );
+        if (zygote_outcome == ZYGOTE_OK) {
+            errno = launch->launch_errno;
+            return launch->outcome;
+        }
+        program_eprintln(
+            "Launching tasks from the server from now on: %s.",
+            zygote_outcome_msg(zygote_outcome, &errno)
+        );
+        drop_zygote();
+        has_zygote = false;
+    }
+
+    Pipeline pipeline;
+    LauncherOutcome launch_outcome = pipeline_parse(&pipeline, cmd, cmd_len);
+    if (launch_outcome != LAUNCHER_OK) {
+        return launch_outcome;
+    }
+    if (pipeline.stage_count > ZYGOTE_MAX_STAGES) {
+        pipeline_drop(&pipeline);
+        errno = E2BIG;
+        return LAUNCHER_ERR_SPAWN_FAIL;
+    }
+    launch_outcome =
+        pipeline_launch(&pipeline, is_relayed, out_fd, cgroup_fd);
+    if (launch_outcome == LAUNCHER_OK) {
+        launch->stage_count = pipeline.stage_count;
+        launch->relay_count = pipeline.relay_count;
+        memcpy(
+            launch->pids,
+            pipeline.pids,
+            pipeline.stage_count * sizeof *pipeline.pids
+        );
+        memcpy(
+            launch->relay_fds,
+            pipeline.relay_fds,
+            2ul * pipeline.relay_count * sizeof *pipeline.relay_fds
+        );
+    }
+    int const launch_errno = errno;
+    pipeline_drop(&pipeline);
+    errno = launch_errno;
+    return launch_outcome;
+}
+
+/**
+ * Indexes every stage of a running task by process id, so that the task is
+ * found when the stage is reaped.
+ */
+static bool index_stages(ZygoteLaunch const* const launch, TaskHandle const handle) {
+    for (size_t i = 0ul; i < launch->stage_count; ++i) {
+        if (!tidx_put(&stage_pids, (size_t) launch->pids[i], handle)) {
+            for (size_t j = 0ul; j < i; ++j) {
+                tidx_rm(&stage_pids, (size_t) launch->pids[j]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Keeps the timers' clock ticking only while there are pending timers, so the
+ * server sleeps when idle.
+ */
+static void arm_timers(void) {
+    bool const should_arm = twheel_len(&timers) > 0ul;
+    if (should_arm == are_timers_armed) {
+        return;
+    }
+    struct timespec const period = {
+        .tv_sec = 0,
+        .tv_nsec = should_arm ? TIMER_TICK_NSECS : 0l
+    };
+    struct itimerspec const spec = {
+        .it_interval = period,
+        .it_value = period
+    };
+    if (timerfd_settime(timers_fd, 0, &spec, NULL) == -1) {
+        program_eprintln(
+            "Failed setting the timers' clock: %s.",
+            strerror(errno)
+        );
+        return;
+    }
+    are_timers_armed = should_arm;
+}
+
+/**
+ * Starts the timer of a task's maximum execution time, if one is set.
+ */
+static void start_exec_timer(Task* const task, TaskHandle const handle) {
+    task->exec_timer = TWHEEL_NO_TIMER;
+    if (exec_timeout_secs == 0ul) {
+        return;
+    }
+    uint64_t delay;
+    if (__builtin_mul_overflow(
+        (uint64_t) exec_timeout_secs,
+        (uint64_t) TIMER_TICKS_PER_SEC,
+        &delay
+    )) {
+        delay = UINT64_MAX;
+    }
+    if (!twheel_add(&timers, delay, TIMER_EXEC, handle, &task->exec_timer)) {
+        program_eprintln(
+            "Failed starting the execution timer of task '%s'.",
+            task->task_name
+        );
+        task->exec_timer = TWHEEL_NO_TIMER;
+        return;
+    }
+    arm_timers();
+}
+
+/**
+ * Stops relaying a pipe, closing both of its ends.
+ */
+static void close_relay(Relay* const relay) {
+    if (relay->source.file_des == -1) {
+        return;
+    }
+    reactor_rm(&reactor, &relay->source);
+    if (relay->is_blocked) {
+        reactor_rm(&reactor, &relay->sink);
+    }
+    RelayOutcome const drop_outcome = relay_drop(relay);
+    if (drop_outcome != RELAY_OK) {
+        program_eprintln(
+            "Failed closing a relay: %s.",
+            relay_outcome_msg(drop_outcome, &errno)
+        );
+    }
+}
+
+static void drop_relays(Task* const task) {
+    for (size_t i = 0ul; i < task->relay_count; ++i) {
+        close_relay(task->relays + i);
+    }
+    // their memory is the task's, and goes with it
+    task->relays = NULL;
+    task->relay_count = 0ul;
+}
+
+/**
+ * Moves whatever a stage wrote to the next stage, and notes the time if any
+ * was moved. While the next stage's pipe is full, the relay waits for it to
+ * drain, instead of for the stage to write.
+ */
+static void pump_relay(Relay* const relay) {
+    size_t moved;
+    RelayOutcome const pump_outcome = relay_pump(relay, &moved);
+    if (moved > 0ul) {
+        relay->last_active = twheel_now(&timers);
+    }
+    switch (pump_outcome) {
+    case RELAY_OK:
+        break;
+    case RELAY_BLOCKED:
+        if (reactor_mod(&reactor, &relay->source, 0u) != REACTOR_OK ||
+            reactor_add(&reactor, &relay->sink, EPOLLOUT) != REACTOR_OK
+        ) {
+            program_eprintln(
+                "Failed waiting for a relay's sink: %s.",
+                strerror(errno)
+            );
+            close_relay(relay);
+            break;
+        }
+        relay->is_blocked = true;
+        break;
+    case RELAY_EOF:
+        close_relay(relay);
+        break;
+    default:
+        // the next stage exiting early is business as usual
+        if (errno != EPIPE) {
+            program_eprintln(
+                "Failed relaying between stages: %s.",
+                relay_outcome_msg(pump_outcome, &errno)
+            );
+        }
+        close_relay(relay);
+        break;
+    }
+}
+
+static void on_relay_readable(
+    ReactorSource* const source,
+    uint32_t const events
+) {
+    (void) events;
+
+    pump_relay(source->ctx);
+}
+
+static void on_relay_writable(
+    ReactorSource* const sink,
+    uint32_t const events
+) {
+    (void) events;
+
+    Relay* const relay = sink->ctx;
+    relay->is_blocked = false;
+    if (reactor_rm(&reactor, &relay->sink) != REACTOR_OK ||
+        reactor_mod(&reactor, &relay->source, EPOLLIN) != REACTOR_OK
+    ) {
+        program_eprintln(
+            "Failed resuming a relay: %s.",
+            strerror(errno)
+        );
+        close_relay(relay);
+        return;
+    }
+    pump_relay(relay);
+}
+
+/**
+ * Starts relaying the pipes between a task's stages, whose ends are owned by
+ * the task from then on, even if starting fails.
+ */
+static bool start_relays(
+    Task* const task,
+    int const* const relay_fds,
+    size_t const relay_count
+) {
+    task->relays = NULL;
+    task->relay_count = 0ul;
+    if (relay_count == 0ul) {
+        return true;
+    }
+    task->relays =
+        tarena_alloc(&task->arena, relay_count * sizeof *task->relays);
+    if (!task->relays) {
+        for (size_t i = 0ul; i < 2ul * relay_count; ++i) {
+            close(relay_fds[i]);
+        }
+        return false;
+    }
+    task->relay_count = relay_count;
+    uint64_t const now = twheel_now(&timers);
+    bool is_ok = true;
+    for (size_t i = 0ul; i < relay_count; ++i) {
+        Relay* const relay = task->relays + i;
+        RelayOutcome const init_outcome =
+            relay_new(relay, relay_fds[2ul * i], relay_fds[2ul * i + 1ul]);
+        relay->source.callback = on_relay_readable;
+        relay->sink.callback = on_relay_writable;
+        relay->last_active = now;
+        if (!is_ok) {
+            continue;
+        }
+        if (init_outcome != RELAY_OK) {
+            program_eprintln(
+                "Failed starting a relay: %s.",
+                relay_outcome_msg(init_outcome, &errno)
+            );
+            is_ok = false;
+        } else if (reactor_add(&reactor, &relay->source, EPOLLIN) !=
+            REACTOR_OK
+        ) {
+            program_eprintln(
+                "Failed registering a relay: %s.",
+                strerror(errno)
+            );
+            is_ok = false;
+        }
+        if (!is_ok) {
+            // not yet registered, so closed without the reactor's knowledge
+            relay_drop(relay);
+        }
+    }
+    return is_ok;
+}
+
+/**
+ * Starts the timer of a task's maximum inactivity time, if one is set and the
+ * task's pipes are relayed.
+ */
+static void start_inactive_timer(Task* const task, TaskHandle const handle) {
+    task->inactive_timer = TWHEEL_NO_TIMER;
+    task->max_inactive_ticks = 0u;
+    if (inactive_timeout_secs == 0ul || task->relay_count == 0ul) {
+        return;
+    }
+    if (__builtin_mul_overflow(
+        (uint64_t) inactive_timeout_secs,
+        (uint64_t) TIMER_TICKS_PER_SEC,
+        &task->max_inactive_ticks
+    )) {
+        task->max_inactive_ticks = UINT64_MAX;
+    }
+    if (!twheel_add(
+        &timers,
+        task->max_inactive_ticks,
+        TIMER_INACTIVE,
+        handle,
+        &task->inactive_timer
+    )) {
+        program_eprintln(
+            "Failed starting the inactivity timer of task '%s'.",
+            task->task_name
+        );
+        task->inactive_timer = TWHEEL_NO_TIMER;
+        return;
+    }
+    arm_timers();
+}
+
+/**
+ * Signals every process of a running task: through its cgroup, which kills
+ * them, if it has one and the kernel supports it, or through its process
+ * group otherwise.
+ */
+static bool signal_task(Task const* const task, int const signum) {
+    if (task->has_cgroup &&
+        tcgroup_kill(&task_cgroups, task->task_id) == TCGROUP_OK
+    ) {
+        return true;
+    }
+    return kill(-(task->process_group), signum) != -1 || errno == ESRCH;
+}
+
+/**
+ * Kills a task which failed to become a running one, and removes its cgroup,
+ * if its processes are gone by then, or the next server does.
+ */
+static void abort_task(Task const* const task) {
+    signal_task(task, SIGKILL);
+    if (task->has_cgroup) {
+        tcgroup_rm(&task_cgroups, task->task_id);
+    }
+}
+
+/**
+ * Creates a task's cgroup, and sets its limits, if there are cgroups.
+ * Returns the cgroup's @p cgroup.procs, which the stages join, or @p -1 if
+ * the task runs without one.
+ */
+static int add_task_cgroup(
+    size_t const task_id,
+    char const* const cmd,
+    size_t const cmd_len,
+    TaskLimits const* const limits
+) {
+    bool const has_limits = limits->memory_mib > 0u ||
+        limits->cpu_percent > 0u ||
+        limits->pids > 0u;
+    if (!has_cgroups) {
+        if (has_limits) {
+            program_eprintln(
+                "Ignoring the limits of task '%.*s', as there are no cgroups.",
+                (int) cmd_len,
+                cmd
+            );
+        }
+        return -1;
+    }
+    int procs_fd;
+    TaskCgroupOutcome const add_outcome =
+        tcgroup_add(&task_cgroups, task_id, &procs_fd);
+    if (add_outcome != TCGROUP_OK) {
+        program_eprintln(
+            "Running task '%.*s' without a cgroup: %s.",
+            (int) cmd_len,
+            cmd,
+            tcgroup_outcome_msg(add_outcome, &errno)
+        );
+        return -1;
+    }
+    if (has_limits) {
+        TaskCgroupOutcome const limit_outcome =
+            tcgroup_limit(&task_cgroups, task_id, limits);
+        if (limit_outcome != TCGROUP_OK) {
+            program_eprintln(
+                "Running task '%.*s' without its limits: %s.",
+                (int) cmd_len,
+                cmd,
+                tcgroup_outcome_msg(limit_outcome, &errno)
+            );
+        }
+    }
+    return procs_fd;
+}
+
+/**
+ * Launches a task, already given its id, and moves it to the running tasks.
+ */
+static bool exec_task(
+    size_t const task_id,
+    char const* const cmd,
+    size_t const cmd_len,
+    TaskLimits const* const limits
+) {
+    // without a spool, the output goes wherever the server's does
+    int spool_fd;
+    TaskLogOutcome const spool_outcome = tlog_spool(&task_log, &spool_fd);
+    if (spool_outcome != TLOG_OK) {
+        program_eprintln(
+            "Failed spooling the output of task '%.*s': %s.",
+            (int) cmd_len,
+            cmd,
+            tlog_outcome_msg(spool_outcome, &errno)
+        );
+    }
+
+    int const procs_fd = add_task_cgroup(task_id, cmd, cmd_len, limits);
+    static ZygoteLaunch launch;
+    LauncherOutcome const launch_outcome = launch_task(
+        cmd,
+        cmd_len,
+        inactive_timeout_secs > 0ul,
+        spool_fd,
+        procs_fd,
+        &launch
+    );
+    int const launch_errno = errno;
+    if (procs_fd != -1) {
+        close(procs_fd);
+    }
+    if (launch_outcome != LAUNCHER_OK) {
+        program_eprintln(
+            "Failed launching task '%.*s': %s.",
+            (int) cmd_len,
+            cmd,
+            launcher_outcome_msg(launch_outcome, &launch_errno)
+        );
+        if (procs_fd != -1) {
+            tcgroup_rm(&task_cgroups, task_id);
+        }
+        if (spool_fd != -1) {
+            close(spool_fd);
+        }
+        return false;
+    }
+
+    // the task's name and relays share one block, sized now that the number
+    // of relays is known, and released at once when the task finishes
+    Task task = {
+        .task_id = task_id,
+        .process_group = launch.pids[0],
+        .last_pid = launch.pids[launch.stage_count - 1ul],
+        .live_stages = launch.stage_count,
+        .exit_status = 0,
+        .has_cgroup = procs_fd != -1,
+        .mem_peak_kib = 0,
+        .exec_timer = TWHEEL_NO_TIMER,
+        .end = TASK_END_COMPLETED,
+        .inactive_timer = TWHEEL_NO_TIMER,
+        .spool_fd = spool_fd
+    };
+    if (!tarena_with_cap(
+        &task.arena,
+        tarena_size_of(cmd_len + 1ul) +
+            tarena_size_of(launch.relay_count * sizeof *task.relays)
+    )) {
+        program_eprintln(
+            "Failed allocating task '%.*s': %s.",
+            (int) cmd_len,
+            cmd,
+            strerror(errno)
+        );
+        abort_task(&task);
+        for (size_t i = 0ul; i < 2ul * launch.relay_count; ++i) {
+            close(launch.relay_fds[i]);
+        }
+        if (spool_fd != -1) {
+            close(spool_fd);
+        }
+        return false;
+    }
+    char* const task_name = tarena_alloc(&task.arena, cmd_len + 1ul);
+    memcpy(task_name, cmd, cmd_len);
+    task_name[cmd_len] = '\0';
+    task.task_name = task_name;
+    clock_gettime(CLOCK_REALTIME, &task.start_time);
+    if (!start_relays(&task, launch.relay_fds, launch.relay_count)) {
+        program_eputs("Failed relaying a task's pipes.");
+        abort_task(&task);
+        drop_relays(&task);
+        if (spool_fd != -1) {
+            close(spool_fd);
+        }
+        tarena_drop(&task.arena);
+        return false;
+    }
+    TaskHandle handle;
+    if (!push_running_task(&task, &handle)) {
+        program_eputs("Failed registering a running task.");
+        abort_task(&task);
+        drop_relays(&task);
+        if (spool_fd != -1) {
+            close(spool_fd);
+        }
+        tarena_drop(&task.arena);
+        return false;
+    }
+    if (!index_stages(&launch, handle)) {
+        program_eputs("Failed indexing a running task's stages.");
+        abort_task(&task);
+        rm_running_task(handle, NULL);
+        drop_relays(&task);
+        if (spool_fd != -1) {
+            close(spool_fd);
+        }
+        tarena_drop(&task.arena);
+        return false;
+    }
+    Task* const running = tsmap_get_mut(&running_tasks, handle);
+    start_exec_timer(running, handle);
+    start_inactive_timer(running, handle);
+    return true;
+}
+
+static bool has_room_to_run(void) {
+    return max_running_tasks == 0ul ||
+        tsmap_len(&running_tasks) < max_running_tasks;
+}
+
+/**
+ * Returns who submitted a task, whose pending tasks take turns with other
+ * owners': the client's user, vouched for by the kernel, if it's connected, or
+ * its process otherwise, as the fifo doesn't tell whose clients are.
+ */
+static size_t frame_owner(
+    FrameHeader const* const header,
+    Connection const* const opt_conn
+) {
+    if (opt_conn) {
+        return (size_t) opt_conn->uid;
+    }
+    return ((size_t) 1ul << 32u) | (size_t) header->client_pid;
+}
+
+/**
+ * Admits a task, giving it an id, and launches it right away if fewer tasks
+ * than the maximum are running, and none is pending, or schedules it
+ * otherwise.
+ */
+static bool submit_task(
+    FrameHeader const* const header,
+    char const* const payload,
+    Connection const* const opt_conn,
+    size_t* const task_id
+) {
+    char const* cmd = payload;
+    size_t cmd_len = header->len;
+    TaskLimits limits = { .memory_mib = 0u, .cpu_percent = 0u, .pids = 0u };
+    if (header->flags & FRAME_EXEC_LIMITS) {
+        if (cmd_len <= FRAME_EXEC_LIMITS_SIZE) {
+            program_eputs("Failed submitting a task without a command.");
+            return false;
+        }
+        unsigned char const* const limits_buf = (unsigned char const*) payload;
+        limits.memory_mib = frame_get_u64(limits_buf);
+        limits.cpu_percent = frame_get_u64(limits_buf + 8);
+        limits.pids = frame_get_u64(limits_buf + 16);
+        cmd += FRAME_EXEC_LIMITS_SIZE;
+        cmd_len -= FRAME_EXEC_LIMITS_SIZE;
+    }
+    if (is_stopping) {
+        program_eputs("Refusing a task while shutting down.");
+        return false;
+    }
+    size_t id;
+    TaskLogOutcome const id_outcome = tlog_next_id(&task_log, &id);
+    if (id_outcome != TLOG_OK) {
+        program_eprintln(
+            "Failed reserving a task id: %s.",
+            tlog_outcome_msg(id_outcome, &errno)
+        );
+        return false;
+    }
+    if (has_room_to_run() && tsched_len(&pending_tasks) == 0ul) {
+        if (!exec_task(id, cmd, cmd_len, &limits)) {
+            return false;
+        }
+    } else {
+        size_t const priority = (size_t) (header->flags & FRAME_EXEC_PRIORITY)
+            >> FRAME_EXEC_PRIORITY_SHIFT;
+        if (!tsched_push(
+            &pending_tasks,
+            priority,
+            frame_owner(header, opt_conn),
+            id,
+            cmd,
+            cmd_len,
+            &limits
+        )) {
+            program_eprintln(
+                "Failed queueing task '%.*s': %s.",
+                (int) cmd_len,
+                cmd,
+                strerror(errno)
+            );
+            return false;
+        }
+        publish_task(id, TBOARD_PENDING, cmd, cmd_len);
+    }
+    *task_id = id;
+    return true;
+}
+
+/**
+ * Records a pending task as finished, without it ever having run, so that the
+ * id its client was given stands for something.
+ */
+static void drop_pending_task(
+    PendingTask* const task,
+    TaskEnd const end,
+    int const exit_status
+) {
+    unpublish_task(task->task_id);
+    Task dropped = {
+        .task_id = task->task_id,
+        .task_name = task->cmd,
+        .exit_status = exit_status,
+        .end = end
+    };
+    clock_gettime(CLOCK_REALTIME, &dropped.start_time);
+    dropped.end_time = dropped.start_time;
+    TaskJournalOutcome const journal_outcome =
+        tjournal_append(&finished_tasks, &dropped);
+    if (journal_outcome != TJOURNAL_OK) {
+        program_eprintln(
+            "Failed recording unrun task '%s': %s.",
+            task->cmd,
+            tjournal_outcome_msg(journal_outcome, &errno)
+        );
+    }
+    free(task->cmd);
+    task->cmd = NULL;
+}
+
+/**
+ * Records a pending task as terminated, without it ever having run.
+ */
+static void cancel_pending_task(PendingTask* const task) {
+    drop_pending_task(task, TASK_END_TERMINATED, 0);
+}
+
+/**
+ * Launches pending tasks, as scheduled, while fewer tasks than the maximum are
+ * running.
+ */
+static void launch_pending_tasks(void) {
+    PendingTask task;
+    while (has_room_to_run() && tsched_pop(&pending_tasks, &task)) {
+        if (!exec_task(task.task_id, task.cmd, task.cmd_len, &task.limits)) {
+            // recorded as failed, with the status a shell exits with when it
+            // can't run a command
+            drop_pending_task(&task, TASK_END_COMPLETED, 127 << 8);
+        }
+        free(task.cmd);
+    }
+}
+
+/**
+ * Returns the reply to the client's batch, opening the client's fifo if the
+ * batch just started. The fifo is registered without events, so that the
+ * reactor reports an error if the client goes away mid batch.
+ */
+static Reply* batch_reply(
+    FrameHeader const* const header,
+    Connection const* const opt_conn
+) {
+    for (Reply* i = pending_batches; i; i = i->next_batch) {
+        if (i->client_pid == header->client_pid) {
+            return i;
+        }
+    }
+    Reply* const reply = reply_open_client(header, opt_conn);
+    if (!reply) {
+        return NULL;
+    }
+    ReactorOutcome const add_outcome =
+        reactor_add(&reactor, &reply->source, 0u);
+    if (add_outcome != REACTOR_OK) {
+        program_eprintln(
+            "Failed registering a reply fifo: %s.",
+            reactor_outcome_msg(add_outcome, &errno)
+        );
+        reply_free(reply);
+        return NULL;
+    }
+    reply->is_registered = true;
+    reply->client_pid = header->client_pid;
+    reply->next_batch = pending_batches;
+    pending_batches = reply;
+    return reply;
+}
+
+/**
+ * Executes a task of a batch, and queues its id, or "failed" if it couldn't be
+ * executed, so that the client can match ids to tasks by position. The ids
+ * are only sent once the batch is over.
+ */
+static void exec_batch_task(
+    FrameHeader const* const header,
+    char const* const payload,
+    Connection const* const opt_conn
+) {
+    Reply* const reply = batch_reply(header, opt_conn);
+    if (header->len > 0u) {
+        size_t task_id;
+        bool const is_executed =
+            submit_task(header, payload, opt_conn, &task_id);
+        if (reply) {
+            char id_buf[32];
+            int const id_len = is_executed ?
+                snprintf(id_buf, sizeof id_buf, "%zu", task_id) :
+                snprintf(id_buf, sizeof id_buf, "failed");
+            WqOutcome const push_outcome =
+                wq_push_line(&reply->queue, id_buf, (size_t) id_len);
+            if (push_outcome != WQ_OK) {
+                program_eprintln(
+                    "Failed queueing a task id: %s.",
+                    wq_outcome_msg(push_outcome, &errno)
+                );
             }
         }
     }
-    return count;
+    if (reply && header->flags & FRAME_EXEC_BATCH_END) {
+        forget_batch(reply);
+        reply_send(reply);
+    }
+}
+
+/**
+ * Signals every stage of a running task to terminate. The task is moved to
+ * the finished tasks once its stages are reaped. A pending task is moved to
+ * them right away.
+ */
+static void end_task(size_t const task_id) {
+    TaskHandle handle;
+    Task* const task = find_running_task(task_id, &handle);
+    if (!task) {
+        PendingTask pending;
+        if (tsched_rm(&pending_tasks, task_id, &pending)) {
+            cancel_pending_task(&pending);
+        }
+        return;
+    }
+    if (task->end == TASK_END_COMPLETED) {
+        task->end = TASK_END_TERMINATED;
+    }
+    if (!signal_task(task, SIGTERM)) {
+        program_eprintln(
+            "Failed killing task '%s' with group process id %d: %s.",
+            task->task_name,
+            task->process_group,
+            strerror(errno)
+        );
+    }
+}
+
+/**
+ * Replies the output of a finished task to the client's own fifo, or why
+ * there's none. The output is read from the task log a frame at a time, as
+ * the client drains the fifo, so a large one doesn't hold up the event loop,
+ * and uncompressed frames are spliced to the fifo without entering the
+ * server's memory.
+ */
+static void reply_output(
+    FrameHeader const* const header,
+    Connection const* const opt_conn,
+    size_t const task_id
+) {
+    Reply* const reply = reply_open_client(header, opt_conn);
+    if (!reply) {
+        return;
+    }
+    TaskLogEntry entry;
+    TaskLogOutcome const find_outcome =
+        tlog_find(&task_log, task_id, &entry);
+    WqOutcome push_outcome = WQ_OK;
+    if (find_outcome == TLOG_OK) {
+        reply->output = entry;
+    } else {
+        if (find_outcome != TLOG_NOT_FOUND) {
+            program_eprintln(
+                "Failed looking up the output of task #%zu: %s.",
+                task_id,
+                tlog_outcome_msg(find_outcome, &errno)
+            );
+        }
+        TaskHandle handle;
+        char msg[64];
+        int const msg_len = snprintf(
+            msg,
+            sizeof msg,
+            find_running_task(task_id, &handle) ?
+                "Task #%zu is still running.\n" :
+                "Task #%zu has no output recorded.\n",
+            task_id
+        );
+        push_outcome = wq_push(&reply->queue, msg, (size_t) msg_len);
+    }
+    if (push_outcome != WQ_OK) {
+        program_eprintln(
+            "Failed queueing a task's output: %s.",
+            wq_outcome_msg(push_outcome, &errno)
+        );
+    }
+    reply_send(reply);
+}
+
+/**
+ * Carries out a request, from the commands fifo, or from a connection, if
+ * @p opt_conn isn't @p NULL.
+ */
+static void handle_frame(
+    FrameHeader const* const header,
+    char const* const payload,
+    Connection const* const opt_conn
+) {
+    switch (header->opcode) {
+    case FRAME_OP_EXEC_TASK:
+        if (header->flags & FRAME_EXEC_BATCH) {
+            exec_batch_task(header, payload, opt_conn);
+        } else if (header->len > 0u) {
+            size_t task_id;
+            submit_task(header, payload, opt_conn, &task_id);
+        }
+        break;
+    case FRAME_OP_END_TASK:
+        if (header->len == 8u) {
+            end_task(frame_get_u64((unsigned char const*) payload));
+        }
+        break;
+    case FRAME_OP_SET_ACTIVE_TIMEOUT:
+        if (header->len == 8u) {
+            exec_timeout_secs =
+                frame_get_u64((unsigned char const*) payload);
+        }
+        break;
+    case FRAME_OP_SET_INACTIVE_TIMEOUT:
+        if (header->len == 8u) {
+            inactive_timeout_secs =
+                frame_get_u64((unsigned char const*) payload);
+        }
+        break;
+    case FRAME_OP_SET_MAX_RUNNING:
+        if (header->len == 8u) {
+            max_running_tasks =
+                frame_get_u64((unsigned char const*) payload);
+            launch_pending_tasks();
+        }
+        break;
+    case FRAME_OP_LIST_RUNNING_TASKS:
+        reply_running_tasks(header, opt_conn);
+        break;
+    case FRAME_OP_LIST_FINISHED_TASKS:
+        reply_finished_tasks(header, payload, opt_conn);
+        break;
+    case FRAME_OP_GET_OUTPUT:
+        if (header->len == 8u) {
+            reply_output(
+                header,
+                opt_conn,
+                frame_get_u64((unsigned char const*) payload)
+            );
+        }
+        break;
+    default:
+        program_eprintln(
+            "Ignoring frame with unknown opcode %u from client %u.",
+            (unsigned) header->opcode,
+            (unsigned) header->client_pid
+        );
+        break;
+    }
 }
 
-static void close_commands_fifo(void) {
-    if (close(commands_fd) == 1) {
+/**
+ * Reopens the commands fifo's read end, after reading it failed. The frames
+ * clients already wrote are kept by the fifo meanwhile, as the server holds a
+ * write end of its own, and any frame read in part is resynced past. If
+ * reopening fails, commands are only taken from the socket.
+ */
+static void reopen_commands_fifo(void) {
+    ReactorOutcome const rm_outcome = reactor_rm(&reactor, &commands_source);
+    if (rm_outcome != REACTOR_OK) {
         program_eprintln(
-            "Failed closing commands fifo: %s.",
+            "Failed unregistering the commands fifo: %s.",
+            reactor_outcome_msg(rm_outcome, &errno)
+        );
+    }
+    close(commands_fd);
+    commands_fd =
+        open(commands_fifoname, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (commands_fd == -1) {
+        program_eprintln(
+            "Taking commands from the socket only: %s.",
             strerror(errno)
         );
+        return;
+    }
+    commands_source.file_des = commands_fd;
+    ReactorOutcome const add_outcome =
+        reactor_add(&reactor, &commands_source, EPOLLIN);
+    if (add_outcome != REACTOR_OK) {
+        program_eprintln(
+            "Taking commands from the socket only: %s.",
+            reactor_outcome_msg(add_outcome, &errno)
+        );
+        close(commands_fd);
+        commands_fd = -1;
+    }
+}
+
+/**
+ * Decodes and dispatches every frame available in the commands fifo. Frames
+ * may arrive split across several reads, or several to a single read.
+ */
+static void on_commands_readable(
+    ReactorSource* const source,
+    uint32_t const events
+) {
+    (void) events;
+
+    for (;;) {
+        FrameOutcome const fill_outcome =
+            fdec_fill(&commands_decoder, source->file_des);
+        if (fill_outcome == FRAME_PENDING || fill_outcome == FRAME_EOF) {
+            return;
+        }
+        if (fill_outcome != FRAME_OK) {
+            program_eprintln(
+                "Failed reading from the commands fifo, reopening it: %s.",
+                frame_outcome_msg(fill_outcome, &errno)
+            );
+            reopen_commands_fifo();
+            return;
+        }
+        for (;;) {
+            FrameHeader header;
+            char const* payload;
+            FrameOutcome const next_outcome =
+                fdec_next(&commands_decoder, &header, &payload);
+            if (next_outcome == FRAME_PENDING) {
+                break;
+            }
+            if (next_outcome != FRAME_OK) {
+                program_eprintln(
+                    "Failed decoding a command: %s.",
+                    frame_outcome_msg(next_outcome, NULL)
+                );
+                continue;
+            }
+            handle_frame(&header, payload, NULL);
+        }
     }
 }
 
-static void close_running_tasks_fifo(void) {
-    if (close(running_tasks_fd) == -1) {
+static void close_connection(Connection* const conn) {
+    ReactorOutcome const rm_outcome = reactor_rm(&reactor, &conn->source);
+    if (rm_outcome != REACTOR_OK) {
+        program_eprintln(
+            "Failed unregistering a connection: %s.",
+            reactor_outcome_msg(rm_outcome, &errno)
+        );
+    }
+    if (close(conn->source.file_des) == -1) {
         program_eprintln(
-            "Failed closing the running tasks fifo: %s.",
+            "Failed closing a connection: %s.",
             strerror(errno)
         );
     }
+    fdec_drop(&conn->decoder);
+    free(conn);
+}
+
+/**
+ * Decodes and dispatches every frame a connected client sent. Each read
+ * returns a single packet, of whole frames, whose client pid is replaced by
+ * the one the kernel vouches for.
+ */
+static void on_connection_readable(
+    ReactorSource* const source,
+    uint32_t const events
+) {
+    (void) events;
+
+    Connection* const conn = source->ctx;
+    for (;;) {
+        FrameOutcome const fill_outcome =
+            fdec_fill(&conn->decoder, source->file_des);
+        if (fill_outcome == FRAME_PENDING) {
+            return;
+        }
+        if (fill_outcome != FRAME_OK) {
+            if (fill_outcome != FRAME_EOF && errno != ECONNRESET) {
+                program_eprintln(
+                    "Failed reading from client %d: %s.",
+                    (int) conn->pid,
+                    frame_outcome_msg(fill_outcome, &errno)
+                );
+            }
+            close_connection(conn);
+            return;
+        }
+        for (;;) {
+            FrameHeader header;
+            char const* payload;
+            FrameOutcome const next_outcome =
+                fdec_next(&conn->decoder, &header, &payload);
+            if (next_outcome == FRAME_PENDING) {
+                break;
+            }
+            if (next_outcome != FRAME_OK) {
+                program_eprintln(
+                    "Failed decoding a command from client %d: %s.",
+                    (int) conn->pid,
+                    frame_outcome_msg(next_outcome, NULL)
+                );
+                continue;
+            }
+            header.client_pid = (uint32_t) conn->pid;
+            handle_frame(&header, payload, conn);
+        }
+    }
 }
 
-static void close_finished_tasks_fifo(void) {
-    if (close(finished_tasks_fd) == -1) {
+static void accept_connection(int const fd) {
+    struct ucred cred;
+    socklen_t cred_len = sizeof cred;
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == -1) {
+        program_eprintln(
+            "Failed reading a client's credentials: %s.",
+            strerror(errno)
+        );
+        close(fd);
+        return;
+    }
+    Connection* const conn = malloc(sizeof *conn);
+    if (!conn) {
         program_eprintln(
-            "Failed closing the finished tasks fifo: %s.",
+            "Failed allocating a connection: %s.",
             strerror(errno)
         );
+        close(fd);
+        return;
+    }
+    FrameOutcome const decoder_outcome = fdec_new(&conn->decoder);
+    if (decoder_outcome != FRAME_OK) {
+        program_eprintln(
+            "Failed initializing a connection's decoder: %s.",
+            frame_outcome_msg(decoder_outcome, &errno)
+        );
+        free(conn);
+        close(fd);
+        return;
+    }
+    conn->source = (ReactorSource) {
+        .file_des = fd,
+        .callback = on_connection_readable,
+        .ctx = conn
+    };
+    conn->pid = cred.pid;
+    conn->uid = cred.uid;
+    ReactorOutcome const add_outcome =
+        reactor_add(&reactor, &conn->source, EPOLLIN);
+    if (add_outcome != REACTOR_OK) {
+        program_eprintln(
+            "Failed registering a connection: %s.",
+            reactor_outcome_msg(add_outcome, &errno)
+        );
+        fdec_drop(&conn->decoder);
+        free(conn);
+        close(fd);
     }
 }
 
-static void drop_running_tasks_writer(void) {
-    BwOutcome const drop_outcome = bw_drop(&running_tasks_writer);
-    if (drop_outcome != BW_OK) {
+static void on_listener_readable(
+    ReactorSource* const source,
+    uint32_t const events
+) {
+    (void) events;
+
+    for (;;) {
+        int const fd = accept4(
+            source->file_des,
+            NULL,
+            NULL,
+            SOCK_NONBLOCK | SOCK_CLOEXEC
+        );
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                program_eprintln(
+                    "Failed accepting a connection: %s.",
+                    strerror(errno)
+                );
+            }
+            return;
+        }
+        accept_connection(fd);
+    }
+}
+
+/**
+ * Listens for clients on the commands socket, replacing a stale one left by
+ * a previous run.
+ */
+static bool listen_commands_socket(void) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strncpy(addr.sun_path, commands_socketname, sizeof addr.sun_path - 1ul);
+    listen_fd = socket(
+        AF_UNIX,
+        SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC,
+        0
+    );
+    if (listen_fd == -1) {
+        return false;
+    }
+    if ((unlink(commands_socketname) == -1 && errno != ENOENT) ||
+        bind(listen_fd, (struct sockaddr const*) &addr, sizeof addr) == -1 ||
+        chmod(commands_socketname, 0666) == -1 ||
+        listen(listen_fd, SOMAXCONN) == -1
+    ) {
+        int const listen_errno = errno;
+        close(listen_fd);
+        errno = listen_errno;
+        return false;
+    }
+    return true;
+}
+
+static void add_timeval(struct timeval* const sum, struct timeval const* const x) {
+    sum->tv_sec += x->tv_sec;
+    sum->tv_usec += x->tv_usec;
+    if (sum->tv_usec >= 1000000) {
+        ++sum->tv_sec;
+        sum->tv_usec -= 1000000;
+    }
+}
+
+/**
+ * Accumulates a stage's resource usage into its task's. Times and counters are
+ * summed, and the maximum resident set size is the largest of any stage.
+ */
+static void add_usage(struct rusage* const sum, struct rusage const* const x) {
+    add_timeval(&sum->ru_utime, &x->ru_utime);
+    add_timeval(&sum->ru_stime, &x->ru_stime);
+    if (x->ru_maxrss > sum->ru_maxrss) {
+        sum->ru_maxrss = x->ru_maxrss;
+    }
+    sum->ru_minflt += x->ru_minflt;
+    sum->ru_majflt += x->ru_majflt;
+    sum->ru_inblock += x->ru_inblock;
+    sum->ru_oublock += x->ru_oublock;
+    sum->ru_nvcsw += x->ru_nvcsw;
+    sum->ru_nivcsw += x->ru_nivcsw;
+}
+
+/**
+ * Replaces a finished task's CPU times with its cgroup's, which include the
+ * processes that left its process group, and records its peak memory use,
+ * then removes the cgroup.
+ */
+static void account_task_cgroup(Task* const task) {
+    TaskCgroupUsage usage;
+    TaskCgroupOutcome const usage_outcome =
+        tcgroup_usage(&task_cgroups, task->task_id, &usage);
+    if (usage_outcome == TCGROUP_OK) {
+        task->usage.ru_utime = (struct timeval) {
+            .tv_sec = (time_t) (usage.utime_usec / 1000000),
+            .tv_usec = (suseconds_t) (usage.utime_usec % 1000000)
+        };
+        task->usage.ru_stime = (struct timeval) {
+            .tv_sec = (time_t) (usage.stime_usec / 1000000),
+            .tv_usec = (suseconds_t) (usage.stime_usec % 1000000)
+        };
+        task->mem_peak_kib = usage.mem_peak_kib;
+    } else {
         program_eprintln(
-            "Failed dropping the running tasks fifo buffered writer: %s.",
-            bw_outcome_msg(drop_outcome, &errno)
+            "Failed reading the resource usage of task '%s': %s.",
+            task->task_name,
+            tcgroup_outcome_msg(usage_outcome, &errno)
         );
     }
+    tcgroup_rm(&task_cgroups, task->task_id);
 }
 
-static void drop_finished_tasks_writer(void) {
-    BwOutcome const drop_outcome = bw_drop(&finished_tasks_writer);
-    if (drop_outcome != BW_OK) {
+/**
+ * Moves a running task, all of whose stages were reaped, to the finished
+ * tasks.
+ */
+static void finish_task(TaskHandle const handle) {
+    Task finished;
+    if (!rm_running_task(handle, &finished)) {
+        return;
+    }
+    clock_gettime(CLOCK_REALTIME, &finished.end_time);
+    if (finished.exec_timer != TWHEEL_NO_TIMER) {
+        twheel_cancel(&timers, finished.exec_timer);
+        finished.exec_timer = TWHEEL_NO_TIMER;
+    }
+    if (finished.inactive_timer != TWHEEL_NO_TIMER) {
+        twheel_cancel(&timers, finished.inactive_timer);
+        finished.inactive_timer = TWHEEL_NO_TIMER;
+    }
+    arm_timers();
+    drop_relays(&finished);
+    if (finished.has_cgroup) {
+        account_task_cgroup(&finished);
+    }
+    if (finished.spool_fd != -1) {
+        TaskLogOutcome const append_outcome =
+            tlog_append(&task_log, finished.task_id, finished.spool_fd);
+        if (append_outcome != TLOG_OK) {
+            program_eprintln(
+                "Failed recording the output of task '%s': %s.",
+                finished.task_name,
+                tlog_outcome_msg(append_outcome, &errno)
+            );
+        }
+        close(finished.spool_fd);
+        finished.spool_fd = -1;
+    }
+    // outputs share frames while tasks keep finishing, and are written out
+    // once the server goes idle
+    if (tsmap_len(&running_tasks) == 0ul) {
+        TaskLogOutcome const flush_outcome = tlog_flush(&task_log);
+        if (flush_outcome != TLOG_OK) {
+            program_eprintln(
+                "Failed writing the task log: %s.",
+                tlog_outcome_msg(flush_outcome, &errno)
+            );
+        }
+    }
+    TaskJournalOutcome const journal_outcome =
+        tjournal_append(&finished_tasks, &finished);
+    if (journal_outcome != TJOURNAL_OK) {
         program_eprintln(
-            "Failed dropping the finished tasks fifo buffered writer: %s.",
-            bw_outcome_msg(drop_outcome, &errno)
+            "Failed recording finished task '%s': %s.",
+            finished.task_name,
+            tjournal_outcome_msg(journal_outcome, &errno)
         );
     }
+    tarena_drop(&finished.arena);
+    // the last task to exit on shutdown lets the server stop
+    if (is_stopping && tsmap_len(&running_tasks) == 0ul) {
+        is_running = false;
+    }
 }
 
-static void drop_task_vecs(void) {
-    tvec_drop(&running_tasks);
-    tvec_drop(&finished_tasks);
+static void reap_stage(
+    pid_t const pid,
+    int const status,
+    struct rusage const* const usage
+) {
+    TaskHandle handle;
+    if (!tidx_get(&stage_pids, (size_t) pid, &handle)) {
+        return;
+    }
+    tidx_rm(&stage_pids, (size_t) pid);
+    Task* const task = tsmap_get_mut(&running_tasks, handle);
+    if (!task) {
+        return;
+    }
+    add_usage(&task->usage, usage);
+    if (pid == task->last_pid) {
+        task->exit_status = status;
+    }
+    if (--task->live_stages == 0ul) {
+        finish_task(handle);
+    }
+}
+
+/**
+ * Reaps every child that exited, since a single SIGCHLD may stand for many.
+ */
+static void reap_children(void) {
+    for (;;) {
+        int status;
+        struct rusage usage;
+        pid_t const pid = wait4(-1, &status, WNOHANG, &usage);
+        if (pid == -1 && errno == EINTR) {
+            continue;
+        }
+        if (pid <= 0) {
+            break;
+        }
+        reap_stage(pid, status, &usage);
+    }
+    // the reaped tasks made room for as many pending ones
+    if (!is_stopping) {
+        launch_pending_tasks();
+    }
 }
 
-static void server_sighandler(int const signum) {
-    Task const* const end = tvec_end(&running_tasks);
-    switch (signum) {
-    case SIGINT:
-    case SIGTERM:
-        for (Task* i = tvec_begin_mut(&running_tasks); i != end; ++i) {
-            kill(-(i->process_group), signum);
+/**
+ * Checks if any of a task's relayed pipes was inactive for too long. The check
+ * is lazy: rather than restarting the timer on every byte relayed, the timer
+ * is restarted on expiry for whatever time the least recently active pipe has
+ * left.
+ */
+static bool is_inactive(Task* const task, TaskHandle const handle) {
+    task->inactive_timer = TWHEEL_NO_TIMER;
+    uint64_t const now = twheel_now(&timers);
+    uint64_t least_active = UINT64_MAX;
+    for (size_t i = 0ul; i < task->relay_count; ++i) {
+        Relay const* const relay = task->relays + i;
+        if (relay->source.file_des != -1 && relay->last_active < least_active) {
+            least_active = relay->last_active;
         }
-        exit(0);
+    }
+    // once every pipe is closed, there's nothing left to watch
+    if (least_active == UINT64_MAX) {
+        return false;
+    }
+    uint64_t const inactive_ticks = now - least_active;
+    if (inactive_ticks >= task->max_inactive_ticks) {
+        return true;
+    }
+    if (!twheel_add(
+        &timers,
+        task->max_inactive_ticks - inactive_ticks,
+        TIMER_INACTIVE,
+        handle,
+        &task->inactive_timer
+    )) {
+        program_eprintln(
+            "Failed restarting the inactivity timer of task '%s'.",
+            task->task_name
+        );
+        task->inactive_timer = TWHEEL_NO_TIMER;
+    }
+    return false;
+}
+
+static void terminate_running_tasks(int const signum) {
+    Task const* const end = tsmap_end(&running_tasks);
+    for (Task const* i = tsmap_begin(&running_tasks); i != end; ++i) {
+        signal_task(i, signum);
+    }
+}
+
+/**
+ * Kills the process group of a task whose timer expired, or every running
+ * task once the shutdown's grace period is over. The tasks are moved to the
+ * finished tasks once their stages are reaped.
+ */
+static void on_timer_expired(
+    void* const ctx,
+    uint32_t const tag,
+    size_t const data
+) {
+    (void) ctx;
+
+    if ((TimerKind) tag == TIMER_SHUTDOWN) {
+        terminate_running_tasks(SIGKILL);
+        return;
+    }
+    Task* const task = tsmap_get_mut(&running_tasks, data);
+    if (!task) {
+        return;
+    }
+    TaskEnd end = TASK_END_COMPLETED;
+    switch ((TimerKind) tag) {
+    case TIMER_EXEC:
+        task->exec_timer = TWHEEL_NO_TIMER;
+        end = TASK_END_EXEC_TIMEOUT;
         break;
-    default:
+    case TIMER_INACTIVE:
+        if (!is_inactive(task, data)) {
+            return;
+        }
+        end = TASK_END_INACTIVE_TIMEOUT;
         break;
+    case TIMER_SHUTDOWN:
+        return;
+    }
+    if (task->end == TASK_END_COMPLETED) {
+        task->end = end;
+    }
+    if (!signal_task(task, SIGKILL)) {
+        program_eprintln(
+            "Failed killing task '%s' with group process id %d: %s.",
+            task->task_name,
+            task->process_group,
+            strerror(errno)
+        );
+    }
+}
+
+static void on_timers_readable(
+    ReactorSource* const source,
+    uint32_t const events
+) {
+    (void) events;
+
+    uint64_t ticks;
+    ssize_t const read_bytes = read(source->file_des, &ticks, sizeof ticks);
+    if (read_bytes != (ssize_t) sizeof ticks) {
+        return;
+    }
+    twheel_advance(&timers, ticks, on_timer_expired, NULL);
+    arm_timers();
+}
+
+static void cancel_pending_tasks(void) {
+    PendingTask task;
+    while (tsched_pop(&pending_tasks, &task)) {
+        cancel_pending_task(&task);
+    }
+}
+
+/**
+ * Stops the server, once the running tasks, asked to end, exit, or are killed
+ * after @p SHUTDOWN_GRACE_SECS, so that they're all recorded as finished
+ * before the journal is closed. Pending tasks are cancelled right away, and no
+ * more are accepted. Asking again kills the running tasks at once.
+ */
+static void stop_server(void) {
+    if (is_stopping) {
+        terminate_running_tasks(SIGKILL);
+        return;
+    }
+    is_stopping = true;
+    cancel_pending_tasks();
+    if (tsmap_len(&running_tasks) == 0ul) {
+        is_running = false;
+        return;
+    }
+    Task* const end = (Task*) tsmap_end(&running_tasks);
+    for (Task* i = tsmap_begin_mut(&running_tasks); i != end; ++i) {
+        if (i->end == TASK_END_COMPLETED) {
+            i->end = TASK_END_TERMINATED;
+        }
+        // only the process group, so that the tasks may exit on their own
+        kill(-(i->process_group), SIGTERM);
+    }
+    size_t grace_timer;
+    if (!twheel_add(
+        &timers,
+        SHUTDOWN_GRACE_SECS * TIMER_TICKS_PER_SEC,
+        TIMER_SHUTDOWN,
+        0ul,
+        &grace_timer
+    )) {
+        program_eputs("Failed starting the shutdown timer.");
+        terminate_running_tasks(SIGKILL);
+        return;
+    }
+    arm_timers();
+}
+
+static void on_signals_readable(
+    ReactorSource* const source,
+    uint32_t const events
+) {
+    (void) events;
+
+    for (;;) {
+        struct signalfd_siginfo info;
+        ssize_t const read_bytes = read(source->file_des, &info, sizeof info);
+        if (read_bytes != (ssize_t) sizeof info) {
+            return;
+        }
+        switch (info.ssi_signo) {
+        case SIGCHLD:
+            reap_children();
+            break;
+        case SIGINT:
+        case SIGTERM:
+            stop_server();
+            break;
+        default:
+            break;
+        }
     }
 }
 
 int main(void) {
+    // forked before anything else, while the server's address space is small
+    ZygoteOutcome const zygote_init_outcome = zygote_new(&zygote);
+    if (zygote_init_outcome == ZYGOTE_OK) {
+        has_zygote = true;
+        atexit(drop_zygote);
+    } else {
+        program_eprintln(
+            "Launching tasks from the server: %s.",
+            zygote_outcome_msg(zygote_init_outcome, &errno)
+        );
+    }
+
     if (mkdir(server_dirname, 0777) != 0 && errno != EEXIST) {
         program_eprintln(
             "Failed creating server directory: %s.",
@@ -143,23 +2556,56 @@ int main(void) {
         return EXIT_FAILURE;
     }
 
-    if (mkfifo(running_tasks_fifoname, 0666) != 0 && errno != EEXIST) {
+    TaskLogOutcome const log_open_outcome =
+        tlog_open(&task_log, server_dirname);
+    if (log_open_outcome != TLOG_OK) {
         program_eprintln(
-            "Failed creating running tasks fifo: %s.",
-            strerror(errno)
+            "Failed opening the task log: %s.",
+            tlog_outcome_msg(log_open_outcome, &errno)
         );
         return EXIT_FAILURE;
     }
+    atexit(close_task_log);
+    TaskJournalOutcome const journal_open_outcome =
+        tjournal_open(&finished_tasks, server_dirname);
+    if (journal_open_outcome != TJOURNAL_OK) {
+        program_eprintln(
+            "Failed opening the task journal: %s.",
+            tjournal_outcome_msg(journal_open_outcome, &errno)
+        );
+        return EXIT_FAILURE;
+    }
+    atexit(close_task_journal);
+
+    // each task runs in a cgroup of its own, if the server may manage some,
+    // and within its process group alone otherwise
+    TaskCgroupOutcome const cgroups_open_outcome =
+        tcgroup_open(&task_cgroups, tasks_cgroup_name);
+    if (cgroups_open_outcome == TCGROUP_OK) {
+        has_cgroups = true;
+        atexit(close_task_cgroups);
+    } else {
+        program_eprintln(
+            "Running tasks without cgroups: %s.",
+            tcgroup_outcome_msg(cgroups_open_outcome, &errno)
+        );
+    }
 
-    if (mkfifo(finished_tasks_fifoname, 0666) != 0 && errno != EEXIST) {
+    // the read end is opened without blocking for a client, and the server
+    // keeps a write end of its own so that the fifo never reports EOF when the
+    // last client closes it
+    if ((commands_fd =
+        open(commands_fifoname, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) == -1
+    ) {
         program_eprintln(
-            "Failed creating finished tasks fifo: %s.",
+            "Failed opening the commands fifo: %s.",
             strerror(errno)
         );
         return EXIT_FAILURE;
     }
-
-    if ((commands_fd = open(commands_fifoname, O_RDONLY | O_CLOEXEC)) == -1) {
+    if ((commands_keepalive_fd =
+        open(commands_fifoname, O_WRONLY | O_CLOEXEC)) == -1
+    ) {
         program_eprintln(
             "Failed opening the commands fifo: %s.",
             strerror(errno)
@@ -168,265 +2614,141 @@ int main(void) {
     }
     atexit(close_commands_fifo);
 
-    if ((running_tasks_fd =
-        open(running_tasks_fifoname, O_WRONLY | O_CREAT | O_CLOEXEC, 0666) == -1
-    )) {
+    if (!listen_commands_socket()) {
         program_eprintln(
-            "Failed opening the running tasks fifo: %s.",
+            "Failed listening on the commands socket: %s.",
             strerror(errno)
         );
         return EXIT_FAILURE;
     }
-    atexit(close_running_tasks_fifo);
+    atexit(close_commands_socket);
+
+    FrameOutcome const decoder_init_outcome = fdec_new(&commands_decoder);
+    if (decoder_init_outcome != FRAME_OK) {
+        program_eprintln(
+            "Failed initializing the commands decoder: %s.",
+            frame_outcome_msg(decoder_init_outcome, &errno)
+        );
+        return EXIT_FAILURE;
+    }
+    atexit(drop_commands_decoder);
+
+    tsmap_new(&running_tasks);
+    tidx_new(&running_tasks_idx);
+    tsched_new(&pending_tasks);
+    tidx_new(&board_tasks_idx);
+    tidx_new(&stage_pids);
+    atexit(drop_task_vecs);
+
+    TaskBoardOutcome const board_open_outcome =
+        tboard_open(&running_board, running_tasks_shmname);
+    if (board_open_outcome == TBOARD_OK) {
+        has_board = true;
+        atexit(close_running_board);
+    } else {
+        program_eprintln(
+            "Listing running tasks through the server only: %s.",
+            tboard_outcome_msg(board_open_outcome, &errno)
+        );
+    }
 
-    if ((finished_tasks_fd =
-        open(finished_tasks_fifoname, O_WRONLY | O_CREAT | O_CLOEXEC , 0666) ==
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGCHLD);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &signals, NULL) == -1 ||
+        signal(SIGPIPE, SIG_IGN) == SIG_ERR
+    ) {
+        program_eprintln(
+            "Failed setting the server's signal mask: %s.",
+            strerror(errno)
+        );
+        return EXIT_FAILURE;
+    }
+    if ((signals_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC)) ==
         -1
-    )) {
+    ) {
         program_eprintln(
-            "Failed opening the finished tasks fifo: %s.",
+            "Failed creating the signals file descriptor: %s.",
             strerror(errno)
         );
         return EXIT_FAILURE;
     }
-    atexit(close_finished_tasks_fifo);
+    atexit(close_signals_fd);
 
-    BwOutcome const running_tasks_writer_init_outcome =
-        bw_with_default_cap(&running_tasks_writer, running_tasks_fd);
-    if (running_tasks_writer_init_outcome != BW_OK) {
+    if ((timers_fd = timerfd_create(
+        CLOCK_MONOTONIC,
+        TFD_NONBLOCK | TFD_CLOEXEC
+    )) == -1) {
         program_eprintln(
-            "Failed initializing the running tasks fifo buffered writer:"
-                " %s.",
-            bw_outcome_msg(running_tasks_writer_init_outcome, &errno)
+            "Failed creating the timers file descriptor: %s.",
+            strerror(errno)
         );
         return EXIT_FAILURE;
     }
-    atexit(drop_running_tasks_writer);
+    twheel_new(&timers);
+    atexit(drop_timers);
 
-    BwOutcome const finished_tasks_writer_init_outcome =
-        bw_with_default_cap(&finished_tasks_writer, finished_tasks_fd);
-    if (finished_tasks_writer_init_outcome != BW_OK) {
+    ReactorOutcome const reactor_init_outcome = reactor_new(&reactor);
+    if (reactor_init_outcome != REACTOR_OK) {
         program_eprintln(
-            "Failed initializing the finished tasks fifo buffered writer:"
-                " %s.",
-            bw_outcome_msg(finished_tasks_writer_init_outcome, &errno)
+            "Failed initializing the reactor: %s.",
+            reactor_outcome_msg(reactor_init_outcome, &errno)
         );
         return EXIT_FAILURE;
     }
-    atexit(drop_finished_tasks_writer);
-
-    TaskVec running_tasks;
-    tvec_new(&running_tasks);
-    TaskVec finished_tasks;
-    tvec_new(&finished_tasks);
-    atexit(drop_task_vecs);
+    atexit(drop_reactor);
 
-    struct sigaction action = { 0 };
-	action.sa_handler = server_sighandler;
-	if (sigaction(SIGTERM, &action, NULL) == -1 ||
-        sigaction(SIGINT, &action, NULL) == -1
-    ) {
+    commands_source = (ReactorSource) {
+        .file_des = commands_fd,
+        .callback = on_commands_readable,
+        .ctx = NULL
+    };
+    listen_source = (ReactorSource) {
+        .file_des = listen_fd,
+        .callback = on_listener_readable,
+        .ctx = NULL
+    };
+    signals_source = (ReactorSource) {
+        .file_des = signals_fd,
+        .callback = on_signals_readable,
+        .ctx = NULL
+    };
+    timers_source = (ReactorSource) {
+        .file_des = timers_fd,
+        .callback = on_timers_readable,
+        .ctx = NULL
+    };
+    ReactorOutcome add_outcome = reactor_add(&reactor, &commands_source, EPOLLIN);
+    if (add_outcome == REACTOR_OK) {
+        add_outcome = reactor_add(&reactor, &listen_source, EPOLLIN);
+    }
+    if (add_outcome == REACTOR_OK) {
+        add_outcome = reactor_add(&reactor, &signals_source, EPOLLIN);
+    }
+    if (add_outcome == REACTOR_OK) {
+        add_outcome = reactor_add(&reactor, &timers_source, EPOLLIN);
+    }
+    if (add_outcome != REACTOR_OK) {
         program_eprintln(
-            "Failed setting server signal handler: %s.",
-            strerror(errno)
+            "Failed registering the server's file descriptors: %s.",
+            reactor_outcome_msg(add_outcome, &errno)
         );
         return EXIT_FAILURE;
     }
 
-    for (;;) {
-        char line_buf[LINE_BUF_SIZE];
-        ssize_t const read_bytes =
-            read(commands_fd, line_buf, LINE_BUF_SIZE);
-        if (read_bytes == -1l) {
+    while (is_running) {
+        ReactorOutcome const poll_outcome = reactor_poll(&reactor, -1);
+        if (poll_outcome != REACTOR_OK) {
             program_eprintln(
-                "Failed reading a line from the commands fifo: %s.",
-                strerror(errno)
+                "Failed polling for events: %s.",
+                reactor_outcome_msg(poll_outcome, &errno)
             );
             return EXIT_FAILURE;
         }
-        if (read_bytes == 0ul) {
-            continue;
-        }
-        line_buf[read_bytes] = '\0';
-
-        switch (line_buf[0]) {
-        case EXEC_TASK_FLAG: {
-            pid_t const pid = fork();
-            switch (pid) {
-            case -1:
-                program_eprintln(
-                    "Failed creating a new process: %s.",
-                    strerror(errno)
-                );
-                return EXIT_FAILURE;
-            case 0:
-                break;
-            default:
-                tvec_push(&running_tasks, &(Task) {
-                    .task_id = total_tasks++,
-                    .task_name = line_buf + 2ul,
-                    .process_group = pid
-                });
-
-                continue;
-                break;
-            }
-            setsid();
-            // line_buf[] = "e p1 arg1 arg2 | p2 | p3\0"
-            // cmd_start = "p1 arg1 arg2 | p2 | p3\0"
-            char* const cmd_start = strndup(line_buf + 2ul, read_bytes);
-            size_t const proc_count = count_char(cmd_start, '|') + 1ul;
-            size_t const procs_size = proc_count * sizeof(char*);
-            char** const procs = malloc(procs_size);
-            char* const* const procs_end = procs + procs_size;
-
-            procs[0] = strtok(cmd_start, "|");
-            for (char** i = procs + 1; i != procs_end; ++i) {
-                *i = strtok(NULL, "|");
-            }
-            // procs[] = { "p1 arg1 arg2 \0, p2\0, p3\0"}
-
-            for (char* const* proc_i = procs; proc_i != procs_end; ++proc_i) {
-                // argc = 3
-                size_t const argc = count_words(*proc_i);
-                char** const argv = malloc((argc + 1) * sizeof(char*));
-                char** argv_i = argv;
-                argv[argc] = NULL;
-                // argv[] = { _ _ _ NULL }
-
-                // *proc_i = "p1 arg1 arg2\0"
-                char* char_i = *proc_i;
-                while (*char_i) {
-                    *argv_i++ = char_i;
-                    while (*char_i && !isspace(*char_i)) {
-                        ++char_i;
-                    }
-                    *char_i++ = '\0';
-                }
-                // proc_i = "{ p1\0 arg1\0 arg2\0, p2\0, p3\0 }"
-                // argv[] = { p1\0, arg1\0, arg2\0, NULL }
-
-                int pipe_fd[2];
-                pipe(pipe_fd);
-
-                pid_t const pid = fork();
-                switch (pid) {
-                case -1:
-                    program_eprintln(
-                        "Failed creating a new process: %s.",
-                        strerror(errno)
-                    );
-                    return EXIT_FAILURE;
-                case 0: {
-                    setsid();
-                    dup2(pipe_fd[0], STDIN_FILENO);
-                    execv(cmd_start, argv);
-                    break;
-                }
-                default:
-                    dup2(pipe_fd[1], STDOUT_FILENO);
-                    break;
-                }
-            }
-            free(procs);
-            free(cmd_start);
-        }
-        break;
-
-        case END_TASK_FLAG: {
-            size_t task_id;
-            if (parse_size_slice(
-                line_buf + 2,
-                line_buf + read_bytes,
-                &task_id, NULL) != PARSE_SIZE_OK
-            ) {
-                break;
-            }
-            size_t task_idx;
-            Task* const scheduled_for_deletion =
-                tvec_search_by_tid_mut(&running_tasks, task_id, &task_idx);
-            if (!scheduled_for_deletion) {
-                break;
-            }
-            if (kill(-(scheduled_for_deletion->process_group), SIGTERM) == -1) {
-                program_eprintln(
-                    "Failed killing task '%s' with group process id %d: %s.",
-                    scheduled_for_deletion->task_name,
-                    scheduled_for_deletion->process_group,
-                    strerror(errno)
-                );
-                return EXIT_FAILURE;
-            }
-            tvec_rm_ord_at(&running_tasks, task_idx);
-            break;
-        }
-
-        case SET_ACTIVE_TIMEOUT_FLAG: { break; }
-        case SET_INACTIVE_TIMEOUT_FLAG: { break; }
-
-        case LIST_RUNNING_TASKS_FLAG: {
-            Task const* const end = tvec_end(&running_tasks);
-            for (Task const* i = tvec_begin(&running_tasks); i != end; ++i) {
-                BwOutcome const write_line_outcome =
-                    bw_write_line(
-                        &running_tasks_writer,
-                        i->task_name,
-                        strlen(i->task_name)
-                    );
-                if (write_line_outcome != BW_OK) {
-                    program_eprintln(
-                        "Failed writing a line from the running tasks fifo"
-                            " buffered writer: %s.",
-                        bw_outcome_msg(write_line_outcome, &errno)
-                    );
-                    return EXIT_FAILURE;
-                }
-            }
-            BwOutcome const bw_flush_outcome = bw_flush(&running_tasks_writer);
-            if (bw_flush_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed flushing the running tasks from the running fifo"
-                        " buffered writer: %s.",
-                    bw_outcome_msg(bw_flush_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-            break;
-
-            break;
-        }
-
-        case LIST_FINISHED_TASKS_FLAG: {
-            Task const* const end = tvec_end(&finished_tasks);
-            for (Task const* i = tvec_begin(&finished_tasks); i != end; ++i) {
-                BwOutcome const write_line_outcome =
-                    bw_write_line(
-                        &finished_tasks_writer,
-                        i->task_name,
-                        strlen(i->task_name)
-                    );
-                if (write_line_outcome != BW_OK) {
-                    program_eprintln(
-                        "Failed writing a line from the finished tasks fifo"
-                            " buffered writer: %s.",
-                        bw_outcome_msg(write_line_outcome, &errno)
-                    );
-                    return EXIT_FAILURE;
-                }
-            }
-            BwOutcome const bw_flush_outcome = bw_flush(&finished_tasks_writer);
-            if (bw_flush_outcome != BW_OK) {
-                program_eprintln(
-                    "Failed flushing the finished tasks from the finished fifo"
-                        " buffered writer: %s.",
-                    bw_outcome_msg(bw_flush_outcome, &errno)
-                );
-                return EXIT_FAILURE;
-            }
-        }
-
-        default:
-            break;
-        }
+        // the tasks finished by the events just handled are journaled together
+        flush_finished_tasks();
     }
+    return EXIT_SUCCESS;
 }
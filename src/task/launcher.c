@@ -0,0 +1,495 @@
+#define _GNU_SOURCE
+
+#include "task/launcher.h"
+
+#include "scan.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+extern char** environ;
+
+LauncherOutcome pipeline_parse(
+    Pipeline* const init,
+    char const* const cmd,
+    size_t const len
+) {
+#   if LAUNCHER_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(cmd != NULL);
+#   endif  // LAUNCHER_RUNTIME_ASSERTS
+
+    unsigned const separators = SCAN_SPACE | SCAN_PIPE;
+    size_t const stage_count = 1ul + scan_count(cmd, cmd + len, SCAN_PIPE);
+    size_t const word_count = scan_count_runs(cmd, cmd + len, separators);
+
+    size_t const args_size = (word_count + stage_count) * sizeof *init->args;
+    size_t const stages_size = stage_count * sizeof *init->stages;
+    size_t const pids_size = stage_count * sizeof *init->pids;
+    init->stage_count = stage_count;
+    init->relay_count = 0ul;
+    if (!tarena_with_cap(
+        &init->arena,
+        tarena_size_of(len + 1ul) +
+            tarena_size_of(args_size) +
+            tarena_size_of(stages_size) +
+            tarena_size_of(pids_size)
+    )) {
+        init->buf = NULL;
+        init->args = NULL;
+        init->stages = NULL;
+        init->pids = NULL;
+        return LAUNCHER_ERR_ALLOC_FAIL;
+    }
+    // the block is sized for all of them, so none fails
+    init->buf = tarena_alloc(&init->arena, len + 1ul);
+    init->args = tarena_alloc(&init->arena, args_size);
+    init->stages = tarena_alloc(&init->arena, stages_size);
+    init->pids = tarena_alloc(&init->arena, pids_size);
+    memcpy(init->buf, cmd, len);
+    init->buf[len] = '\0';
+
+    char** arg_i = init->args;
+    size_t stage_i = 0ul;
+    init->stages[0] = arg_i;
+    char* i = init->buf;
+    char* const end = init->buf + len;
+    for (;;) {
+        // separator runs are short, so they're terminated byte by byte
+        char* const word = (char*) scan_skip(i, end, separators);
+        for (; i != word; ++i) {
+            if (*i == '|') {
+                if (arg_i == init->stages[stage_i]) {
+                    pipeline_drop(init);
+                    return LAUNCHER_ERR_EMPTY_STAGE;
+                }
+                *arg_i++ = NULL;
+                init->stages[++stage_i] = arg_i;
+            }
+            *i = '\0';
+        }
+        if (word == end) {
+            break;
+        }
+        *arg_i++ = word;
+        i = (char*) scan_find(word, end, separators);
+    }
+    if (arg_i == init->stages[stage_i]) {
+        pipeline_drop(init);
+        return LAUNCHER_ERR_EMPTY_STAGE;
+    }
+    *arg_i = NULL;
+    return LAUNCHER_OK;
+}
+
+void pipeline_drop(Pipeline* const self) {
+#   if LAUNCHER_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // LAUNCHER_RUNTIME_ASSERTS
+
+    tarena_drop(&self->arena);
+    self->buf = NULL;
+    self->args = NULL;
+    self->stages = NULL;
+    self->pids = NULL;
+    self->stage_count = 0ul;
+}
+
+LauncherOutcome pipeline_pipe(
+    Pipeline* const restrict self,
+    bool const is_relayed,
+    int* const restrict out_fd,
+    int* const restrict next_in_fd
+) {
+#   if LAUNCHER_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(out_fd != NULL);
+    assert(next_in_fd != NULL);
+#   endif  // LAUNCHER_RUNTIME_ASSERTS
+
+    int out_pipe[2];
+    if (pipe2(out_pipe, O_CLOEXEC) == -1) {
+        return LAUNCHER_ERR_PIPE_FAIL;
+    }
+    if (!is_relayed || self->stage_count - 1ul > LAUNCHER_MAX_RELAYS) {
+        *out_fd = out_pipe[1];
+        *next_in_fd = out_pipe[0];
+        return LAUNCHER_OK;
+    }
+    int in_pipe[2];
+    if (pipe2(in_pipe, O_CLOEXEC) == -1) {
+        int const pipe_errno = errno;
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        errno = pipe_errno;
+        return LAUNCHER_ERR_PIPE_FAIL;
+    }
+    *out_fd = out_pipe[1];
+    *next_in_fd = in_pipe[0];
+    self->relay_fds[2ul * self->relay_count] = out_pipe[0];
+    self->relay_fds[2ul * self->relay_count + 1ul] = in_pipe[1];
+    ++self->relay_count;
+    return LAUNCHER_OK;
+}
+
+void pipeline_close_relays(Pipeline* const self) {
+#   if LAUNCHER_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // LAUNCHER_RUNTIME_ASSERTS
+
+    for (size_t i = 0ul; i < 2ul * self->relay_count; ++i) {
+        close(self->relay_fds[i]);
+    }
+    self->relay_count = 0ul;
+}
+
+/**
+ * Spawns a single stage, reading from @p in_fd and, unless it's @p -1, writing
+ * to @p out_fd. Returns an error number, like <tt>posix_spawnp()</tt>.
+ */
+static int spawn_stage_(
+    char* const* const argv,
+    int const in_fd,
+    int const out_fd,
+    pid_t const pgid,
+    pid_t* const pid
+) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    int err = posix_spawn_file_actions_init(&actions);
+    if (err != 0) {
+        return err;
+    }
+    if ((err = posix_spawnattr_init(&attr)) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return err;
+    }
+
+    sigset_t empty_set;
+    sigset_t default_set;
+    sigemptyset(&empty_set);
+    sigemptyset(&default_set);
+    sigaddset(&default_set, SIGPIPE);
+
+    // the pipe ends are close on exec, only their duplicates survive exec
+    if (in_fd == -1) {
+        err = posix_spawn_file_actions_addopen(
+            &actions,
+            STDIN_FILENO,
+            "/dev/null",
+            O_RDONLY,
+            0
+        );
+    } else {
+        err = posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    }
+    if (err == 0 && out_fd != -1) {
+        err = posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    }
+    if (err == 0) {
+        err = posix_spawnattr_setflags(
+            &attr,
+            POSIX_SPAWN_SETPGROUP |
+                POSIX_SPAWN_SETSIGMASK |
+                POSIX_SPAWN_SETSIGDEF
+        );
+    }
+    if (err == 0) {
+        err = posix_spawnattr_setpgroup(&attr, pgid);
+    }
+    if (err == 0) {
+        err = posix_spawnattr_setsigmask(&attr, &empty_set);
+    }
+    if (err == 0) {
+        err = posix_spawnattr_setsigdefault(&attr, &default_set);
+    }
+    if (err == 0) {
+        err = posix_spawnp(pid, argv[0], &actions, &attr, argv, environ);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return err;
+}
+
+/**
+ * The size of a cloned stage's stack, besides room for a copy of its
+ * arguments, which <tt>execvp()</tt> makes if it falls back to the shell.
+ */
+#define CLONE_STACK_SIZE (64ul << 10ul)
+
+/**
+ * What a cloned stage is given, and what it reports back, through the memory
+ * it shares with the caller.
+ */
+typedef struct CloneStage {
+    char* const* argv;  //!< The stage's null terminated argument vector.
+    int in_fd;  //!< The stage's stdin, or @p -1 for @p /dev/null.
+    int out_fd; //!< The stage's stdout, or @p -1 to inherit the caller's.
+    int cgroup_fd;  //!< The @p cgroup.procs the stage joins, or @p -1.
+    pid_t pgid; //!< The process group the stage joins, or @p 0.
+    int err;    //!< The error number if executing fails, or @p 0.
+} CloneStage;
+
+/**
+ * Runs within a stage's process, on its own stack, but sharing the caller's
+ * memory: resets the signal handlers it inherited, lest they run on that
+ * memory, joins the task's cgroup, if any, and the pipeline's process group,
+ * wires up stdin and stdout, and executes the stage. If executing fails, the
+ * error number is stored for the caller.
+ */
+static int exec_stage_(void* const arg) {
+    CloneStage* const stage = arg;
+
+    // the caller blocked every signal, so none is handled until now
+    for (int signum = 1; signum < NSIG; ++signum) {
+        struct sigaction action;
+        if (sigaction(signum, NULL, &action) == 0 &&
+            (signum == SIGPIPE || action.sa_handler != SIG_IGN) &&
+            action.sa_handler != SIG_DFL
+        ) {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigaction(signum, &action, NULL);
+        }
+    }
+    sigset_t empty_set;
+    sigemptyset(&empty_set);
+    sigprocmask(SIG_SETMASK, &empty_set, NULL);
+
+    // joining before executing leaves nothing the stage forks out of the
+    // cgroup
+    int err = 0;
+    if (stage->cgroup_fd != -1 && write(stage->cgroup_fd, "0", 1ul) == -1l) {
+        err = errno;
+    } else if (setpgid(0, stage->pgid) == -1) {
+        err = errno;
+    } else if (stage->in_fd == -1) {
+        int const null_fd = open("/dev/null", O_RDONLY);
+        if (null_fd == -1 || dup2(null_fd, STDIN_FILENO) == -1) {
+            err = errno;
+        }
+    } else if (dup2(stage->in_fd, STDIN_FILENO) == -1) {
+        err = errno;
+    }
+    if (
+        err == 0 &&
+        stage->out_fd != -1 &&
+        dup2(stage->out_fd, STDOUT_FILENO) == -1
+    ) {
+        err = errno;
+    }
+    if (err == 0) {
+        execvp(stage->argv[0], stage->argv);
+        err = errno;
+    }
+    stage->err = err;
+    _exit(127);
+}
+
+int pipeline_clone_stage(
+    char* const* const argv,
+    int const in_fd,
+    int const out_fd,
+    int const cgroup_fd,
+    pid_t const pgid,
+    bool const is_sibling,
+    pid_t* const pid
+) {
+#   if LAUNCHER_RUNTIME_ASSERTS
+    assert(argv != NULL);
+    assert(pid != NULL);
+#   endif  // LAUNCHER_RUNTIME_ASSERTS
+
+    size_t argc = 0ul;
+    while (argv[argc]) {
+        ++argc;
+    }
+    size_t const page_size = (size_t) sysconf(_SC_PAGESIZE);
+    size_t const stack_size =
+        (CLONE_STACK_SIZE + (argc + 2ul) * sizeof *argv + page_size - 1ul) /
+        page_size * page_size;
+    void* const stack = mmap(
+        NULL,
+        stack_size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+        -1,
+        0
+    );
+    if (stack == MAP_FAILED) {
+        return errno;
+    }
+
+    // the stage shares the caller's memory rather than copying it, as with
+    // posix_spawnp(), and CLONE_PARENT makes the caller's parent its own
+    CloneStage stage = {
+        .argv = argv,
+        .in_fd = in_fd,
+        .out_fd = out_fd,
+        .cgroup_fd = cgroup_fd,
+        .pgid = pgid,
+        .err = 0
+    };
+    sigset_t all_set;
+    sigset_t old_set;
+    sigfillset(&all_set);
+    sigprocmask(SIG_SETMASK, &all_set, &old_set);
+    int const flags =
+        (is_sibling ? CLONE_PARENT : 0) | CLONE_VM | CLONE_VFORK | SIGCHLD;
+    int const clone_ret =
+        clone(exec_stage_, (char*) stack + stack_size, flags, &stage);
+    int const clone_errno = errno;
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+    munmap(stack, stack_size);
+
+    if (clone_ret == -1) {
+        return clone_errno;
+    }
+    *pid = clone_ret;
+    return stage.err;
+}
+
+LauncherOutcome pipeline_launch(
+    Pipeline* const self,
+    bool const is_relayed,
+    int const out_fd,
+    int const cgroup_fd
+) {
+#   if LAUNCHER_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // LAUNCHER_RUNTIME_ASSERTS
+
+    self->relay_count = 0ul;
+    int in_fd = -1;
+    for (size_t i = 0ul; i < self->stage_count; ++i) {
+        bool const is_last = i + 1ul == self->stage_count;
+        int stage_out_fd = is_last ? out_fd : -1;
+        int next_in_fd = -1;
+        if (!is_last &&
+            pipeline_pipe(self, is_relayed, &stage_out_fd, &next_in_fd) !=
+                LAUNCHER_OK
+        ) {
+            int const pipe_errno = errno;
+            if (in_fd != -1) {
+                close(in_fd);
+            }
+            if (i > 0ul) {
+                kill(-self->pids[0], SIGKILL);
+            }
+            pipeline_close_relays(self);
+            errno = pipe_errno;
+            return LAUNCHER_ERR_PIPE_FAIL;
+        }
+
+        // a stage joins its cgroup before executing, which posix_spawnp()
+        // can't do, so that nothing it forks is left out, and is cloned as
+        // cheaply
+        pid_t const pgid = i > 0ul ? self->pids[0] : 0;
+        int const err = cgroup_fd != -1 ?
+            pipeline_clone_stage(
+                self->stages[i],
+                in_fd,
+                stage_out_fd,
+                cgroup_fd,
+                pgid,
+                false,
+                self->pids + i
+            ) :
+            spawn_stage_(
+                self->stages[i],
+                in_fd,
+                stage_out_fd,
+                pgid,
+                self->pids + i
+            );
+
+        if (in_fd != -1) {
+            close(in_fd);
+        }
+        if (!is_last) {
+            close(stage_out_fd);
+        }
+        in_fd = next_in_fd;
+
+        if (err != 0) {
+            if (in_fd != -1) {
+                close(in_fd);
+            }
+            if (i > 0ul) {
+                kill(-self->pids[0], SIGKILL);
+            }
+            pipeline_close_relays(self);
+            errno = err;
+            return LAUNCHER_ERR_SPAWN_FAIL;
+        }
+    }
+    return LAUNCHER_OK;
+}
+
+char const* launcher_outcome_msg(
+    LauncherOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        LAUNCHER_OK == 0 &&
+            LAUNCHER_ERR_EMPTY_STAGE == 1 &&
+            LAUNCHER_ERR_ALLOC_FAIL == 2 &&
+            LAUNCHER_ERR_PIPE_FAIL == 3 &&
+            LAUNCHER_ERR_SPAWN_FAIL == 4,
+        "Unexpected LauncherOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "a pipeline stage has no command",
+        "failed allocating dynamic memory for the Pipeline",
+        "failed creating a pipe between stages",
+        "failed spawning a pipeline stage",
+        "unknown launcher error"
+    };
+    switch (outcome) {
+    case LAUNCHER_ERR_ALLOC_FAIL:
+    case LAUNCHER_ERR_PIPE_FAIL:
+    case LAUNCHER_ERR_SPAWN_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case LAUNCHER_OK:
+    case LAUNCHER_ERR_EMPTY_STAGE:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
@@ -0,0 +1,178 @@
+#define _GNU_SOURCE
+
+#include "task/relay.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+/**
+ * The maximum number of bytes moved by a single <tt>splice()</tt>, larger than
+ * any pipe's default capacity.
+ */
+#define SPLICE_SIZE (1ul << 20ul)
+
+static bool set_nonblock_(int const fd) {
+    int const flags = fcntl(fd, F_GETFL);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+RelayOutcome relay_new(
+    Relay* const init,
+    int const source_fd,
+    int const sink_fd
+) {
+#   if RELAY_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // RELAY_RUNTIME_ASSERTS
+
+    init->source = (ReactorSource) {
+        .file_des = source_fd,
+        .callback = NULL,
+        .ctx = init
+    };
+    init->sink = (ReactorSource) {
+        .file_des = sink_fd,
+        .callback = NULL,
+        .ctx = init
+    };
+    init->last_active = 0u;
+    init->is_blocked = false;
+    // each end is a file description of its own, so the stages' ends stay
+    // blocking
+    if (!set_nonblock_(source_fd) || !set_nonblock_(sink_fd)) {
+        return RELAY_ERR_FCNTL_FAIL;
+    }
+    return RELAY_OK;
+}
+
+RelayOutcome relay_drop(Relay* const self) {
+#   if RELAY_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // RELAY_RUNTIME_ASSERTS
+
+    bool is_closed = true;
+    if (self->source.file_des != -1) {
+        is_closed = close(self->source.file_des) != -1;
+        self->source.file_des = -1;
+    }
+    if (self->sink.file_des != -1) {
+        is_closed = close(self->sink.file_des) != -1 && is_closed;
+        self->sink.file_des = -1;
+    }
+    return is_closed ? RELAY_OK : RELAY_ERR_CLOSE_FAIL;
+}
+
+RelayOutcome relay_pump(
+    Relay* const restrict self,
+    size_t* const restrict moved
+) {
+#   if RELAY_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(moved != NULL);
+#   endif  // RELAY_RUNTIME_ASSERTS
+
+    *moved = 0ul;
+    for (size_t i = 0ul; i < RELAY_MAX_SPLICES; ++i) {
+        ssize_t const spliced = splice(
+            self->source.file_des,
+            NULL,
+            self->sink.file_des,
+            NULL,
+            SPLICE_SIZE,
+            SPLICE_F_MOVE | SPLICE_F_NONBLOCK
+        );
+        if (spliced > 0l) {
+            *moved += (size_t) spliced;
+            continue;
+        }
+        if (spliced == 0l) {
+            return RELAY_EOF;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN) {
+            return RELAY_ERR_SPLICE_FAIL;
+        }
+        // splice() doesn't tell an empty source from a full sink
+        struct pollfd fds[] = {
+            { .fd = self->source.file_des, .events = POLLIN },
+            { .fd = self->sink.file_des, .events = POLLOUT }
+        };
+        if (poll(fds, 2ul, 0) == -1) {
+            return RELAY_ERR_SPLICE_FAIL;
+        }
+        if (!(fds[0].revents & (POLLIN | POLLHUP))) {
+            return RELAY_OK;
+        }
+        if (!(fds[1].revents & (POLLOUT | POLLERR))) {
+            return RELAY_BLOCKED;
+        }
+    }
+    return RELAY_OK;
+}
+
+char const* relay_outcome_msg(
+    RelayOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        RELAY_OK == 0 &&
+            RELAY_BLOCKED == 1 &&
+            RELAY_EOF == 2 &&
+            RELAY_ERR_FCNTL_FAIL == 3 &&
+            RELAY_ERR_SPLICE_FAIL == 4 &&
+            RELAY_ERR_CLOSE_FAIL == 5,
+        "Unexpected RelayOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "the relay's sink is full",
+        "the relay's source is closed",
+        "failed making the relay's pipes non blocking",
+        "failed moving data between the relay's pipes",
+        "failed closing the relay's pipes",
+        "unknown relay error"
+    };
+    switch (outcome) {
+    case RELAY_ERR_FCNTL_FAIL:
+    case RELAY_ERR_SPLICE_FAIL:
+    case RELAY_ERR_CLOSE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case RELAY_OK:
+    case RELAY_BLOCKED:
+    case RELAY_EOF:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
@@ -0,0 +1,51 @@
+#include "task/task_arena.h"
+
+#if TASK_ARENA_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // TASK_ARENA_RUNTIME_ASSERTS
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+#define ALIGN (alignof(max_align_t))
+
+size_t tarena_size_of(size_t const size) {
+    return (size + (ALIGN - 1ul)) & ~(ALIGN - 1ul);
+}
+
+bool tarena_with_cap(TaskArena* const init, size_t const cap) {
+#   if TASK_ARENA_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // TASK_ARENA_RUNTIME_ASSERTS
+
+    // malloc(3) aligns for any type, so every rounded allocation is aligned
+    init->buf = malloc(cap > 0ul ? cap : 1ul);
+    init->len = 0ul;
+    init->cap = init->buf ? cap : 0ul;
+    return init->buf != NULL;
+}
+
+void* tarena_alloc(TaskArena* const self, size_t const size) {
+#   if TASK_ARENA_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_ARENA_RUNTIME_ASSERTS
+
+    size_t const rounded = tarena_size_of(size);
+    if (rounded < size || rounded > self->cap - self->len) {
+        return NULL;
+    }
+    void* const alloc = self->buf + self->len;
+    self->len += rounded;
+    return alloc;
+}
+
+void tarena_drop(TaskArena* const self) {
+#   if TASK_ARENA_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_ARENA_RUNTIME_ASSERTS
+
+    free(self->buf);
+    self->buf = NULL;
+    self->len = 0ul;
+    self->cap = 0ul;
+}
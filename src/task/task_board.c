@@ -0,0 +1,503 @@
+#define _GNU_SOURCE
+
+#include "task/task_board.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+#define BOARD_MAGIC 0x64726f62u
+#define HEADER_SIZE 64ul
+#define ENTRY_SIZE 4096ul
+
+/**
+ * The number of entries the board starts with room for. The object is sparse,
+ * so the room only takes memory once written to.
+ */
+#define FIRST_CAP 64ul
+
+/**
+ * How many times a reader tries to copy the board before giving up, yielding
+ * the processor between attempts, so that a writer preempted mid change can
+ * finish it.
+ */
+#define SNAPSHOT_ATTEMPTS 1024ul
+
+/**
+ * The start of the board. The sequence number is odd while the board is being
+ * written, and the owner's process id is zero if the board is invalid.
+ */
+typedef struct BoardHeader {
+    uint32_t magic; //!< @p BOARD_MAGIC.
+    int32_t owner_pid;  //!< The server keeping the board, or zero.
+    _Atomic uint64_t seq;   //!< The sequence number.
+    uint64_t len;   //!< The number of entries.
+    char reserved[HEADER_SIZE - 24ul];  //!< Zero.
+} BoardHeader;
+
+typedef struct BoardEntry {
+    uint64_t task_id;   //!< The task's id.
+    uint32_t cmd_len;   //!< The length of the task's command.
+    uint32_t state; //!< The task's TaskBoardState.
+    char cmd[TBOARD_CMD_SIZE];  //!< The task's command.
+} BoardEntry;
+
+static_assert(
+    sizeof(BoardHeader) == HEADER_SIZE && sizeof(BoardEntry) == ENTRY_SIZE,
+    "Unexpected board layout"
+);
+
+static BoardHeader* header_(TaskBoard const* const self) {
+    return (BoardHeader*) self->map;
+}
+
+static BoardEntry* entry_(TaskBoard const* const self, size_t const index) {
+    return (BoardEntry*) (self->map + HEADER_SIZE + index * ENTRY_SIZE);
+}
+
+static void begin_write_(BoardHeader* const header) {
+    uint64_t const seq =
+        atomic_load_explicit(&header->seq, memory_order_relaxed);
+    atomic_store_explicit(&header->seq, seq + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void end_write_(BoardHeader* const header) {
+    uint64_t const seq =
+        atomic_load_explicit(&header->seq, memory_order_relaxed);
+    atomic_store_explicit(&header->seq, seq + 1u, memory_order_release);
+}
+
+static void invalidate_(TaskBoard* const self) {
+    BoardHeader* const header = header_(self);
+    begin_write_(header);
+    header->owner_pid = 0;
+    end_write_(header);
+    self->is_valid = false;
+}
+
+/**
+ * Doubles the board's room, growing the object before the mapping, so that
+ * readers mapping the object's whole size never fault.
+ */
+static bool grow_(TaskBoard* const self) {
+    size_t new_len;
+    if (__builtin_mul_overflow(self->map_len, 2ul, &new_len) ||
+        ftruncate(self->fd, (off_t) new_len) == -1
+    ) {
+        return false;
+    }
+    void* const new_map =
+        mremap(self->map, self->map_len, new_len, MREMAP_MAYMOVE);
+    if (new_map == MAP_FAILED) {
+        return false;
+    }
+    self->map = new_map;
+    self->map_len = new_len;
+    return true;
+}
+
+TaskBoardOutcome tboard_open(TaskBoard* const init, char const* const name) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(name != NULL);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    *init = (TaskBoard) {
+        .fd = -1,
+        .map = NULL,
+        .map_len = HEADER_SIZE + FIRST_CAP * ENTRY_SIZE,
+        .len = 0ul,
+        .is_valid = false,
+        .name = name
+    };
+    // readable by every client, whatever the server's umask
+    init->fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (init->fd == -1) {
+        return TBOARD_ERR_OPEN_FAIL;
+    }
+    if (fchmod(init->fd, 0644) == -1) {
+        int const chmod_errno = errno;
+        close(init->fd);
+        shm_unlink(name);
+        errno = chmod_errno;
+        return TBOARD_ERR_OPEN_FAIL;
+    }
+    void* map = MAP_FAILED;
+    if (ftruncate(init->fd, (off_t) init->map_len) == 0) {
+        map = mmap(
+            NULL,
+            init->map_len,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED,
+            init->fd,
+            0
+        );
+    }
+    if (map == MAP_FAILED) {
+        int const map_errno = errno;
+        close(init->fd);
+        shm_unlink(name);
+        errno = map_errno;
+        return TBOARD_ERR_MAP_FAIL;
+    }
+    init->map = map;
+    init->is_valid = true;
+    BoardHeader* const header = header_(init);
+    begin_write_(header);
+    header->magic = BOARD_MAGIC;
+    header->owner_pid = (int32_t) getpid();
+    header->len = 0u;
+    end_write_(header);
+    return TBOARD_OK;
+}
+
+void tboard_close(TaskBoard* const self) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    if (!self->map) {
+        return;
+    }
+    // readers that mapped it already see it's no longer kept
+    invalidate_(self);
+    munmap(self->map, self->map_len);
+    close(self->fd);
+    shm_unlink(self->name);
+    self->map = NULL;
+    self->fd = -1;
+}
+
+TaskBoardOutcome tboard_push(
+    TaskBoard* const restrict self,
+    uint64_t const task_id,
+    TaskBoardState const state,
+    char const* const restrict cmd,
+    size_t const cmd_len
+) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(cmd != NULL || cmd_len == 0ul);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    if (!self->is_valid) {
+        return TBOARD_OK;
+    }
+    if (HEADER_SIZE + (self->len + 1ul) * ENTRY_SIZE > self->map_len &&
+        !grow_(self)
+    ) {
+        int const grow_errno = errno;
+        invalidate_(self);
+        errno = grow_errno;
+        return TBOARD_ERR_MAP_FAIL;
+    }
+    size_t const len = cmd_len < TBOARD_CMD_SIZE ? cmd_len : TBOARD_CMD_SIZE;
+    BoardHeader* const header = header_(self);
+    BoardEntry* const entry = entry_(self, self->len);
+    begin_write_(header);
+    entry->task_id = task_id;
+    entry->cmd_len = (uint32_t) len;
+    entry->state = (uint32_t) state;
+    memcpy(entry->cmd, cmd, len);
+    header->len = ++self->len;
+    end_write_(header);
+    return TBOARD_OK;
+}
+
+void tboard_set_state(
+    TaskBoard* const self,
+    size_t const index,
+    TaskBoardState const state
+) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(!self->is_valid || index < self->len);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    if (!self->is_valid) {
+        return;
+    }
+    BoardHeader* const header = header_(self);
+    begin_write_(header);
+    entry_(self, index)->state = (uint32_t) state;
+    end_write_(header);
+}
+
+bool tboard_rm(
+    TaskBoard* const restrict self,
+    size_t const index,
+    uint64_t* const restrict moved_id
+) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(moved_id != NULL);
+    assert(!self->is_valid || index < self->len);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    if (!self->is_valid) {
+        return false;
+    }
+    BoardHeader* const header = header_(self);
+    size_t const last = self->len - 1ul;
+    begin_write_(header);
+    if (index != last) {
+        BoardEntry* const entry = entry_(self, index);
+        BoardEntry const* const last_entry = entry_(self, last);
+        entry->task_id = last_entry->task_id;
+        entry->cmd_len = last_entry->cmd_len;
+        entry->state = last_entry->state;
+        memcpy(entry->cmd, last_entry->cmd, last_entry->cmd_len);
+        *moved_id = last_entry->task_id;
+    }
+    header->len = --self->len;
+    end_write_(header);
+    return index != last;
+}
+
+/**
+ * Maps the whole board, which may have grown since it was last mapped.
+ */
+static bool map_snapshot_(
+    int const fd,
+    char const** const map,
+    size_t* const map_len
+) {
+    struct stat board_stat;
+    if (fstat(fd, &board_stat) == -1) {
+        return false;
+    }
+    size_t const len = (size_t) board_stat.st_size;
+    if (*map && len == *map_len) {
+        return true;
+    }
+    if (*map) {
+        munmap((void*) *map, *map_len);
+        *map = NULL;
+        *map_len = 0ul;
+    }
+    if (len == 0ul) {
+        return true;
+    }
+    void* const new_map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    if (new_map == MAP_FAILED) {
+        return false;
+    }
+    *map = new_map;
+    *map_len = len;
+    return true;
+}
+
+/**
+ * Copies the board once, returning @p TBOARD_ERR_BUSY if it changed meanwhile.
+ */
+static TaskBoardOutcome copy_(
+    TaskBoardSnapshot* const self,
+    char const* const map,
+    size_t const map_len,
+    size_t* const cmds_cap
+) {
+    BoardHeader const* const header = (BoardHeader const*) map;
+    uint64_t const seq =
+        atomic_load_explicit(&header->seq, memory_order_acquire);
+    if (seq & 1u) {
+        return TBOARD_ERR_BUSY;
+    }
+    uint32_t const magic = header->magic;
+    int32_t const owner_pid = header->owner_pid;
+    uint64_t const len = header->len;
+    // the board grew past the mapping, which is remapped on the next attempt
+    if (len > (map_len - HEADER_SIZE) / ENTRY_SIZE) {
+        return TBOARD_ERR_BUSY;
+    }
+
+    size_t cmds_len = 0ul;
+    for (size_t i = 0ul; i < len; ++i) {
+        BoardEntry const* const entry =
+            (BoardEntry const*) (map + HEADER_SIZE + i * ENTRY_SIZE);
+        size_t const cmd_len = entry->cmd_len;
+        cmds_len += cmd_len < TBOARD_CMD_SIZE ? cmd_len : TBOARD_CMD_SIZE;
+    }
+    if (len > self->len) {
+        TaskBoardTask* const new_tasks =
+            realloc(self->tasks, len * sizeof *new_tasks);
+        if (!new_tasks) {
+            return TBOARD_ERR_ALLOC_FAIL;
+        }
+        self->tasks = new_tasks;
+    }
+    self->len = len > self->len ? len : self->len;
+    // never empty, so that commands always point into it
+    if (!self->cmds || cmds_len > *cmds_cap) {
+        char* const new_cmds = realloc(self->cmds, cmds_len + 1ul);
+        if (!new_cmds) {
+            return TBOARD_ERR_ALLOC_FAIL;
+        }
+        self->cmds = new_cmds;
+        *cmds_cap = cmds_len;
+    }
+    // commands are stored as offsets until the copy is known to be consistent
+    size_t cmds_pos = 0ul;
+    for (size_t i = 0ul; i < len; ++i) {
+        BoardEntry const* const entry =
+            (BoardEntry const*) (map + HEADER_SIZE + i * ENTRY_SIZE);
+        size_t cmd_len = entry->cmd_len;
+        cmd_len = cmd_len < TBOARD_CMD_SIZE ? cmd_len : TBOARD_CMD_SIZE;
+        if (cmd_len > cmds_len - cmds_pos) {
+            return TBOARD_ERR_BUSY;
+        }
+        self->tasks[i] = (TaskBoardTask) {
+            .task_id = entry->task_id,
+            .state = entry->state == TBOARD_PENDING ?
+                TBOARD_PENDING :
+                TBOARD_RUNNING,
+            .cmd = (char const*) (uintptr_t) cmds_pos,
+            .cmd_len = cmd_len
+        };
+        memcpy(self->cmds + cmds_pos, entry->cmd, cmd_len);
+        cmds_pos += cmd_len;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&header->seq, memory_order_relaxed) != seq) {
+        return TBOARD_ERR_BUSY;
+    }
+
+    if (magic != BOARD_MAGIC || owner_pid <= 0 ||
+        (kill((pid_t) owner_pid, 0) == -1 && errno == ESRCH)
+    ) {
+        return TBOARD_ERR_STALE;
+    }
+    self->len = len;
+    for (size_t i = 0ul; i < len; ++i) {
+        self->tasks[i].cmd =
+            self->cmds + (size_t) (uintptr_t) self->tasks[i].cmd;
+    }
+    return TBOARD_OK;
+}
+
+TaskBoardOutcome tboard_snapshot(
+    TaskBoardSnapshot* const init,
+    char const* const name
+) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(name != NULL);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    *init = (TaskBoardSnapshot) { .tasks = NULL, .len = 0ul, .cmds = NULL };
+    int const fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd == -1) {
+        return TBOARD_ERR_OPEN_FAIL;
+    }
+    char const* map = NULL;
+    size_t map_len = 0ul;
+    size_t cmds_cap = 0ul;
+    TaskBoardOutcome outcome = TBOARD_ERR_BUSY;
+    for (size_t attempt = 0ul;
+        attempt < SNAPSHOT_ATTEMPTS && outcome == TBOARD_ERR_BUSY;
+        ++attempt
+    ) {
+        if (attempt > 0ul) {
+            sched_yield();
+        }
+        if (!map_snapshot_(fd, &map, &map_len)) {
+            outcome = TBOARD_ERR_MAP_FAIL;
+        } else if (map_len < HEADER_SIZE) {
+            // still being created
+            outcome = TBOARD_ERR_BUSY;
+        } else {
+            outcome = copy_(init, map, map_len, &cmds_cap);
+        }
+    }
+    int const snapshot_errno = errno;
+    if (map) {
+        munmap((void*) map, map_len);
+    }
+    close(fd);
+    if (outcome != TBOARD_OK) {
+        tboard_snapshot_drop(init);
+    }
+    errno = snapshot_errno;
+    return outcome;
+}
+
+void tboard_snapshot_drop(TaskBoardSnapshot* const self) {
+#   if TASK_BOARD_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_BOARD_RUNTIME_ASSERTS
+
+    free(self->tasks);
+    free(self->cmds);
+    self->tasks = NULL;
+    self->cmds = NULL;
+    self->len = 0ul;
+}
+
+char const* tboard_outcome_msg(
+    TaskBoardOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        TBOARD_OK == 0 &&
+            TBOARD_ERR_OPEN_FAIL == 1 &&
+            TBOARD_ERR_MAP_FAIL == 2 &&
+            TBOARD_ERR_ALLOC_FAIL == 3 &&
+            TBOARD_ERR_STALE == 4 &&
+            TBOARD_ERR_BUSY == 5,
+        "Unexpected TaskBoardOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "failed opening the task board",
+        "failed mapping the task board",
+        "failed allocating memory",
+        "the task board isn't kept by a running server",
+        "the task board kept changing while being copied",
+        "unknown task board error"
+    };
+    switch (outcome) {
+    case TBOARD_ERR_OPEN_FAIL:
+    case TBOARD_ERR_MAP_FAIL:
+    case TBOARD_ERR_ALLOC_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case TBOARD_OK:
+    case TBOARD_ERR_STALE:
+    case TBOARD_ERR_BUSY:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
@@ -0,0 +1,440 @@
+#define _GNU_SOURCE
+
+#include "task/task_cgroup.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <mntent.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+/**
+ * The size of a buffer holding a path below the subtree, or a value written
+ * to a cgroup file.
+ */
+#define PATH_BUF_SIZE 64ul
+
+/**
+ * The size of a buffer holding the contents of a cgroup file, which are short.
+ */
+#define FILE_BUF_SIZE 4096ul
+
+/**
+ * The period of the CPU limit, in microseconds, over which a task gets its
+ * percentage of a CPU.
+ */
+#define CPU_PERIOD_USEC 100000ul
+
+static TaskCgroupOutcome write_file_(
+    int const dir_fd,
+    char const* const path,
+    char const* const buf,
+    size_t const len
+) {
+    int const fd = openat(dir_fd, path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    ssize_t written;
+    while ((written = write(fd, buf, len)) == -1l && errno == EINTR) {}
+    int const write_errno = errno;
+    close(fd);
+    if (written != (ssize_t) len) {
+        errno = written == -1l ? write_errno : EIO;
+        return TCGROUP_ERR_WRITE_FAIL;
+    }
+    return TCGROUP_OK;
+}
+
+/**
+ * Reads a small cgroup file, null terminated, into @p buf, of
+ * @p FILE_BUF_SIZE bytes.
+ */
+static TaskCgroupOutcome read_file_(
+    int const dir_fd,
+    char const* const path,
+    char* const buf
+) {
+    int const fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    size_t len = 0ul;
+    ssize_t read_bytes = 0l;
+    while (len < FILE_BUF_SIZE - 1ul) {
+        read_bytes = read(fd, buf + len, FILE_BUF_SIZE - 1ul - len);
+        if (read_bytes > 0l) {
+            len += (size_t) read_bytes;
+        } else if (read_bytes == 0l || errno != EINTR) {
+            break;
+        }
+    }
+    int const read_errno = errno;
+    close(fd);
+    if (read_bytes == -1l) {
+        errno = read_errno;
+        return TCGROUP_ERR_READ_FAIL;
+    }
+    buf[len] = '\0';
+    return TCGROUP_OK;
+}
+
+/**
+ * Finds where the cgroup v2 hierarchy is mounted.
+ */
+static bool find_mount_(char* const path, size_t const path_size) {
+    FILE* const mounts = setmntent("/proc/self/mounts", "re");
+    if (!mounts) {
+        return false;
+    }
+    bool is_found = false;
+    struct mntent* entry;
+    while (!is_found && (entry = getmntent(mounts))) {
+        if (strcmp(entry->mnt_type, "cgroup2") == 0 &&
+            strlen(entry->mnt_dir) < path_size
+        ) {
+            strcpy(path, entry->mnt_dir);
+            is_found = true;
+        }
+    }
+    endmntent(mounts);
+    return is_found;
+}
+
+/**
+ * Enables the controllers for the subtree's leaves, each on its own, as any
+ * may be missing, bound to a cgroup v1 hierarchy, or not delegated, and
+ * returns those that were.
+ */
+static unsigned enable_controllers_(int const root_fd, int const dir_fd) {
+    static char const* const names[] = { "memory", "cpu", "pids" };
+    static unsigned const controllers[] = {
+        TCGROUP_MEMORY,
+        TCGROUP_CPU,
+        TCGROUP_PIDS
+    };
+    for (size_t i = 0ul; i < sizeof names / sizeof *names; ++i) {
+        char enable[PATH_BUF_SIZE];
+        int const len = snprintf(enable, sizeof enable, "+%s", names[i]);
+        // the root's may fail if already enabled, or not delegated, in which
+        // case the subtree's tells
+        write_file_(root_fd, "cgroup.subtree_control", enable, (size_t) len);
+        write_file_(dir_fd, "cgroup.subtree_control", enable, (size_t) len);
+    }
+
+    static char enabled[FILE_BUF_SIZE];
+    if (read_file_(dir_fd, "cgroup.subtree_control", enabled) != TCGROUP_OK) {
+        return 0u;
+    }
+    unsigned enabled_controllers = 0u;
+    for (char* save = NULL, * word = strtok_r(enabled, " \n", &save);
+        word;
+        word = strtok_r(NULL, " \n", &save)
+    ) {
+        for (size_t i = 0ul; i < sizeof names / sizeof *names; ++i) {
+            if (strcmp(word, names[i]) == 0) {
+                enabled_controllers |= controllers[i];
+            }
+        }
+    }
+    return enabled_controllers;
+}
+
+/**
+ * Removes the leaf @p name, killing whatever is left in it if it's busy, in
+ * which case it may take until the next attempt for it to be removed.
+ */
+static void rm_leaf_(int const dir_fd, char const* const name) {
+    if (unlinkat(dir_fd, name, AT_REMOVEDIR) == 0 || errno != EBUSY) {
+        return;
+    }
+    char path[PATH_BUF_SIZE];
+    snprintf(path, sizeof path, "%s/cgroup.kill", name);
+    if (write_file_(dir_fd, path, "1", 1ul) == TCGROUP_OK) {
+        unlinkat(dir_fd, name, AT_REMOVEDIR);
+    }
+}
+
+TaskCgroupOutcome tcgroup_open(
+    TaskCgroups* const init,
+    char const* const name
+) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(name != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    init->dir_fd = -1;
+    init->controllers = 0u;
+    char mount_path[PATH_MAX];
+    if (!find_mount_(mount_path, sizeof mount_path)) {
+        errno = ENOENT;
+        return TCGROUP_ERR_NO_CGROUP2;
+    }
+    int const root_fd =
+        open(mount_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd == -1) {
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    if (mkdirat(root_fd, name, 0755) == -1 && errno != EEXIST) {
+        int const mkdir_errno = errno;
+        close(root_fd);
+        errno = mkdir_errno;
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    init->dir_fd = openat(root_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    // a subtree another user made may be there, but not be the server's
+    if (init->dir_fd == -1 ||
+        faccessat(init->dir_fd, ".", W_OK, AT_EACCESS) == -1
+    ) {
+        int const open_errno = errno;
+        if (init->dir_fd != -1) {
+            close(init->dir_fd);
+            init->dir_fd = -1;
+        }
+        close(root_fd);
+        errno = open_errno;
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    init->controllers = enable_controllers_(root_fd, init->dir_fd);
+    close(root_fd);
+
+    int const list_fd = dup(init->dir_fd);
+    DIR* const leaves = list_fd == -1 ? NULL : fdopendir(list_fd);
+    if (!leaves) {
+        if (list_fd != -1) {
+            close(list_fd);
+        }
+        return TCGROUP_OK;
+    }
+    for (struct dirent* i; (i = readdir(leaves));) {
+        if (i->d_type == DT_DIR && i->d_name[0] != '.') {
+            rm_leaf_(init->dir_fd, i->d_name);
+        }
+    }
+    closedir(leaves);
+    return TCGROUP_OK;
+}
+
+void tcgroup_close(TaskCgroups* const self) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    if (self->dir_fd == -1) {
+        return;
+    }
+    close(self->dir_fd);
+    self->dir_fd = -1;
+}
+
+TaskCgroupOutcome tcgroup_add(
+    TaskCgroups* const restrict self,
+    size_t const task_id,
+    int* const restrict procs_fd
+) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(procs_fd != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    char path[PATH_BUF_SIZE];
+    int const name_len = snprintf(path, sizeof path, "%zu", task_id);
+    if (mkdirat(self->dir_fd, path, 0755) == -1 && errno != EEXIST) {
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    snprintf(path + name_len, sizeof path - (size_t) name_len, "/cgroup.procs");
+    *procs_fd = openat(self->dir_fd, path, O_WRONLY | O_CLOEXEC);
+    if (*procs_fd == -1) {
+        int const open_errno = errno;
+        path[name_len] = '\0';
+        unlinkat(self->dir_fd, path, AT_REMOVEDIR);
+        errno = open_errno;
+        return TCGROUP_ERR_OPEN_FAIL;
+    }
+    return TCGROUP_OK;
+}
+
+TaskCgroupOutcome tcgroup_limit(
+    TaskCgroups* const restrict self,
+    size_t const task_id,
+    TaskLimits const* const restrict limits
+) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(limits != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    if ((limits->memory_mib > 0u && !(self->controllers & TCGROUP_MEMORY)) ||
+        (limits->cpu_percent > 0u && !(self->controllers & TCGROUP_CPU)) ||
+        (limits->pids > 0u && !(self->controllers & TCGROUP_PIDS))
+    ) {
+        errno = ENOTSUP;
+        return TCGROUP_ERR_NO_CONTROLLER;
+    }
+    char path[PATH_BUF_SIZE];
+    char value[PATH_BUF_SIZE];
+    TaskCgroupOutcome outcome = TCGROUP_OK;
+    if (limits->memory_mib > 0u) {
+        snprintf(path, sizeof path, "%zu/memory.max", task_id);
+        uint64_t const max_bytes = limits->memory_mib > UINT64_MAX >> 20u ?
+            UINT64_MAX :
+            limits->memory_mib << 20u;
+        int const len = snprintf(value, sizeof value, "%" PRIu64, max_bytes);
+        outcome = write_file_(self->dir_fd, path, value, (size_t) len);
+    }
+    if (outcome == TCGROUP_OK && limits->cpu_percent > 0u) {
+        snprintf(path, sizeof path, "%zu/cpu.max", task_id);
+        uint64_t const quota_usec =
+            limits->cpu_percent > UINT64_MAX / (CPU_PERIOD_USEC / 100ul) ?
+                UINT64_MAX :
+                limits->cpu_percent * (CPU_PERIOD_USEC / 100ul);
+        int const len = snprintf(
+            value,
+            sizeof value,
+            "%" PRIu64 " %lu",
+            quota_usec,
+            CPU_PERIOD_USEC
+        );
+        outcome = write_file_(self->dir_fd, path, value, (size_t) len);
+    }
+    if (outcome == TCGROUP_OK && limits->pids > 0u) {
+        snprintf(path, sizeof path, "%zu/pids.max", task_id);
+        int const len =
+            snprintf(value, sizeof value, "%" PRIu64, limits->pids);
+        outcome = write_file_(self->dir_fd, path, value, (size_t) len);
+    }
+    return outcome;
+}
+
+TaskCgroupOutcome tcgroup_kill(TaskCgroups* const self, size_t const task_id) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    char path[PATH_BUF_SIZE];
+    snprintf(path, sizeof path, "%zu/cgroup.kill", task_id);
+    return write_file_(self->dir_fd, path, "1", 1ul);
+}
+
+TaskCgroupOutcome tcgroup_usage(
+    TaskCgroups* const restrict self,
+    size_t const task_id,
+    TaskCgroupUsage* const restrict usage
+) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(usage != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    static char buf[FILE_BUF_SIZE];
+    char path[PATH_BUF_SIZE];
+    snprintf(path, sizeof path, "%zu/cpu.stat", task_id);
+    TaskCgroupOutcome const read_outcome =
+        read_file_(self->dir_fd, path, buf);
+    if (read_outcome != TCGROUP_OK) {
+        return read_outcome;
+    }
+    *usage = (TaskCgroupUsage) {
+        .utime_usec = 0,
+        .stime_usec = 0,
+        .mem_peak_kib = 0
+    };
+    for (char* save = NULL, * line = strtok_r(buf, "\n", &save);
+        line;
+        line = strtok_r(NULL, "\n", &save)
+    ) {
+        long long value;
+        if (sscanf(line, "user_usec %lld", &value) == 1) {
+            usage->utime_usec = value;
+        } else if (sscanf(line, "system_usec %lld", &value) == 1) {
+            usage->stime_usec = value;
+        }
+    }
+
+    if (self->controllers & TCGROUP_MEMORY) {
+        snprintf(path, sizeof path, "%zu/memory.peak", task_id);
+        // memory.peak is missing before Linux 5.19
+        if (read_file_(self->dir_fd, path, buf) == TCGROUP_OK) {
+            usage->mem_peak_kib = strtoll(buf, NULL, 10) / 1024;
+        }
+    }
+    return TCGROUP_OK;
+}
+
+void tcgroup_rm(TaskCgroups* const self, size_t const task_id) {
+#   if TASK_CGROUP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_CGROUP_RUNTIME_ASSERTS
+
+    char name[PATH_BUF_SIZE];
+    snprintf(name, sizeof name, "%zu", task_id);
+    rm_leaf_(self->dir_fd, name);
+}
+
+char const* tcgroup_outcome_msg(
+    TaskCgroupOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        TCGROUP_OK == 0 &&
+            TCGROUP_ERR_NO_CGROUP2 == 1 &&
+            TCGROUP_ERR_OPEN_FAIL == 2 &&
+            TCGROUP_ERR_READ_FAIL == 3 &&
+            TCGROUP_ERR_WRITE_FAIL == 4 &&
+            TCGROUP_ERR_NO_CONTROLLER == 5,
+        "Unexpected TaskCgroupOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "no cgroup v2 hierarchy is mounted",
+        "failed opening a cgroup",
+        "failed reading a cgroup file",
+        "failed writing a cgroup file",
+        "a limit's cgroup controller isn't enabled",
+        "unknown cgroup error"
+    };
+    switch (outcome) {
+    case TCGROUP_ERR_OPEN_FAIL:
+    case TCGROUP_ERR_READ_FAIL:
+    case TCGROUP_ERR_WRITE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case TCGROUP_OK:
+    case TCGROUP_ERR_NO_CGROUP2:
+    case TCGROUP_ERR_NO_CONTROLLER:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
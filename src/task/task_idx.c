@@ -0,0 +1,172 @@
+#include "task/task_idx.h"
+
+#if TASK_IDX_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // TASK_IDX_RUNTIME_ASSERTS
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define FIRST_ALLOC_CAP 16ul
+#define EMPTY_TID SIZE_MAX
+
+/**
+ * Fibonacci hashing: consecutive ids land far apart, and the top bits of the
+ * product are used, so any power of two capacity works.
+ */
+static size_t home_(TaskIdx const* const self, size_t const tid) {
+    uint64_t const hash = (uint64_t) tid * UINT64_C(11400714819323198485);
+    return (size_t) (hash >> (64u - (unsigned) __builtin_ctzl(self->cap)));
+}
+
+static bool find_(
+    TaskIdx const* const self,
+    size_t const tid,
+    size_t* const pos
+) {
+    // an empty table has no slot to point to, but callers grow it before
+    // using the position
+    if (self->cap == 0ul) {
+        *pos = 0ul;
+        return false;
+    }
+    size_t const mask = self->cap - 1ul;
+    for (size_t i = home_(self, tid); ; i = (i + 1ul) & mask) {
+        if (self->buf[i].task_id == tid) {
+            *pos = i;
+            return true;
+        }
+        if (self->buf[i].task_id == EMPTY_TID) {
+            *pos = i;
+            return false;
+        }
+    }
+}
+
+static bool grow_(TaskIdx* const self) {
+    size_t new_cap;
+    if (self->cap == 0ul) {
+        new_cap = FIRST_ALLOC_CAP;
+    } else if (__builtin_mul_overflow(self->cap, 2ul, &new_cap)) {
+        return false;
+    }
+    size_t new_size;
+    if (__builtin_mul_overflow(new_cap, sizeof *self->buf, &new_size)) {
+        return false;
+    }
+    TaskIdxEntry* const new_buf = malloc(new_size);
+    if (!new_buf) {
+        return false;
+    }
+    for (size_t i = 0ul; i < new_cap; ++i) {
+        new_buf[i].task_id = EMPTY_TID;
+    }
+    TaskIdx grown = { .buf = new_buf, .len = self->len, .cap = new_cap };
+    for (size_t i = 0ul; i < self->cap; ++i) {
+        if (self->buf[i].task_id != EMPTY_TID) {
+            size_t pos;
+            find_(&grown, self->buf[i].task_id, &pos);
+            grown.buf[pos] = self->buf[i];
+        }
+    }
+    free(self->buf);
+    *self = grown;
+    return true;
+}
+
+TaskIdx* tidx_new(TaskIdx* const init) {
+#   if TASK_IDX_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // TASK_IDX_RUNTIME_ASSERTS
+
+    init->buf = NULL;
+    init->len = 0ul;
+    init->cap = 0ul;
+    return init;
+}
+
+void tidx_drop(TaskIdx* const self) {
+#   if TASK_IDX_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_IDX_RUNTIME_ASSERTS
+
+    free(self->buf);
+}
+
+size_t tidx_len(TaskIdx const* const self) {
+#   if TASK_IDX_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_IDX_RUNTIME_ASSERTS
+
+    return self->len;
+}
+
+bool tidx_get(
+    TaskIdx const* const restrict self,
+    size_t const tid,
+    size_t* const restrict opt_idx
+) {
+#   if TASK_IDX_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(tid != EMPTY_TID);
+#   endif  // TASK_IDX_RUNTIME_ASSERTS
+
+    size_t pos;
+    if (!find_(self, tid, &pos)) {
+        return false;
+    }
+    if (opt_idx) {
+        *opt_idx = self->buf[pos].idx;
+    }
+    return true;
+}
+
+bool tidx_put(TaskIdx* const self, size_t const tid, size_t const idx) {
+#   if TASK_IDX_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(tid != EMPTY_TID);
+#   endif  // TASK_IDX_RUNTIME_ASSERTS
+
+    size_t pos;
+    if (find_(self, tid, &pos)) {
+        self->buf[pos].idx = idx;
+        return true;
+    }
+    if ((self->len + 1ul) * 2ul > self->cap) {
+        if (!grow_(self)) {
+            return false;
+        }
+        find_(self, tid, &pos);
+    }
+    self->buf[pos] = (TaskIdxEntry) { .task_id = tid, .idx = idx };
+    ++self->len;
+    return true;
+}
+
+bool tidx_rm(TaskIdx* const self, size_t const tid) {
+#   if TASK_IDX_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(tid != EMPTY_TID);
+#   endif  // TASK_IDX_RUNTIME_ASSERTS
+
+    size_t hole;
+    if (!find_(self, tid, &hole)) {
+        return false;
+    }
+    // shift back every following entry that may fill the hole, so that probe
+    // sequences never cross an empty slot
+    size_t const mask = self->cap - 1ul;
+    for (size_t i = (hole + 1ul) & mask;
+        self->buf[i].task_id != EMPTY_TID;
+        i = (i + 1ul) & mask
+    ) {
+        size_t const home = home_(self, self->buf[i].task_id);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            self->buf[hole] = self->buf[i];
+            hole = i;
+        }
+    }
+    self->buf[hole].task_id = EMPTY_TID;
+    --self->len;
+    return true;
+}
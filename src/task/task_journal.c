@@ -0,0 +1,871 @@
+#define _GNU_SOURCE
+
+#include "task/task_journal.h"
+#include "task/task.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+/**
+ * The length of a file's first mapping. Mappings double whenever the file
+ * outgrows them, which only reserves address space.
+ */
+#define FIRST_MAP_LEN (1ul << 20ul)
+
+#define FIRST_INTERN_CAP 256ul
+#define FIRST_PENDING_CAP 16ul
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+static_assert(
+    sizeof(TaskRecord) == TJOURNAL_RECORD_SIZE,
+    "Unexpected TaskRecord size"
+);
+
+/**
+ * The names of the class index files, within the TaskJournal's directory.
+ */
+static char const* const class_filenames[HQUERY_CLASSES] = {
+    [HCLASS_OK] = "history.ok",
+    [HCLASS_FAILED] = "history.failed",
+    [HCLASS_TERMINATED] = "history.terminated",
+    [HCLASS_EXEC_TIMEOUT] = "history.max-time",
+    [HCLASS_INACTIVE_TIMEOUT] = "history.inactivity"
+};
+
+/**
+ * A range of a query's candidates: record indexes, positions in a class
+ * index, or task ids.
+ */
+typedef struct Source {
+    TaskJournalFile const* opt_list;    //!< The class index, if any.
+    bool is_by_id;  //!< Whether the candidates are task ids.
+    size_t begin;   //!< The first candidate.
+    size_t end; //!< Past the last candidate.
+} Source;
+
+static uint32_t fnv1a_(uint32_t hash, char const* const buf, size_t const len) {
+    for (size_t i = 0ul; i < len; ++i) {
+        hash = (hash ^ (unsigned char) buf[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t checksum_(
+    TaskRecord const* const record,
+    char const* const cmd
+) {
+    char const* const rest = (char const*) record + sizeof record->checksum;
+    uint32_t const hash =
+        fnv1a_(FNV_OFFSET, rest, sizeof *record - sizeof record->checksum);
+    return fnv1a_(hash, cmd, record->cmd_len);
+}
+
+static bool pwrite_all_(
+    int const fd,
+    void const* const buf,
+    size_t const len,
+    uint64_t const offset
+) {
+    size_t pos = 0ul;
+    while (pos < len) {
+        ssize_t const written = pwrite(
+            fd,
+            (char const*) buf + pos,
+            len - pos,
+            (off_t) (offset + pos)
+        );
+        if (written == -1l && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0l) {
+            return false;
+        }
+        pos += (size_t) written;
+    }
+    return true;
+}
+
+/**
+ * Grows a file's mapping, if needed, to cover its first @p needed bytes.
+ * Bytes past the file's end are mapped too, but never accessed, so that
+ * appending to the file rarely requires remapping it.
+ */
+static bool map_(TaskJournalFile* const file, uint64_t const needed) {
+    if (file->map && needed <= file->map_len) {
+        return true;
+    }
+    size_t new_len = file->map_len > 0ul ? file->map_len : FIRST_MAP_LEN;
+    while (new_len < needed) {
+        if (__builtin_mul_overflow(new_len, 2ul, &new_len)) {
+            return false;
+        }
+    }
+    void* const new_map = file->map ?
+        mremap((void*) file->map, file->map_len, new_len, MREMAP_MAYMOVE) :
+        mmap(NULL, new_len, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (new_map == MAP_FAILED) {
+        return false;
+    }
+    file->map = new_map;
+    file->map_len = new_len;
+    return true;
+}
+
+static TaskJournalOutcome open_file_(
+    TaskJournalFile* const file,
+    int const dir_fd,
+    char const* const filename
+) {
+    file->fd = openat(dir_fd, filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat file_stat;
+    if (file->fd == -1 || fstat(file->fd, &file_stat) == -1) {
+        return TJOURNAL_ERR_OPEN_FAIL;
+    }
+    file->len = (uint64_t) file_stat.st_size;
+    return map_(file, file->len) ? TJOURNAL_OK : TJOURNAL_ERR_MAP_FAIL;
+}
+
+static bool close_file_(TaskJournalFile* const file) {
+    if (file->map) {
+        munmap((void*) file->map, file->map_len);
+    }
+    bool const is_closed = file->fd == -1 || close(file->fd) == 0;
+    *file = (TaskJournalFile) {
+        .fd = -1,
+        .map = NULL,
+        .map_len = 0ul,
+        .len = 0u
+    };
+    return is_closed;
+}
+
+/**
+ * Writes @p len bytes at @p offset of a file, growing it if they're past its
+ * end.
+ */
+static TaskJournalOutcome put_(
+    TaskJournalFile* const file,
+    void const* const buf,
+    size_t const len,
+    uint64_t const offset
+) {
+    if (!pwrite_all_(file->fd, buf, len, offset)) {
+        return TJOURNAL_ERR_WRITE_FAIL;
+    }
+    if (offset + len > file->len) {
+        file->len = offset + len;
+    }
+    return map_(file, file->len) ? TJOURNAL_OK : TJOURNAL_ERR_MAP_FAIL;
+}
+
+static TaskJournalOutcome truncate_(
+    TaskJournalFile* const file,
+    uint64_t const len
+) {
+    if (len == file->len) {
+        return TJOURNAL_OK;
+    }
+    if (ftruncate(file->fd, (off_t) len) == -1) {
+        return TJOURNAL_ERR_WRITE_FAIL;
+    }
+    file->len = len;
+    return TJOURNAL_OK;
+}
+
+/**
+ * Returns the @p index th u64 of an index file, or zero if it's past its end.
+ */
+static uint64_t u64_at_(TaskJournalFile const* const file, size_t const index) {
+    if (index >= file->len / 8u) {
+        return 0u;
+    }
+    uint64_t value;
+    memcpy(&value, file->map + index * 8ul, sizeof value);
+    return value;
+}
+
+static TaskRecord const* record_at_(
+    TaskJournal const* const self,
+    size_t const index
+) {
+    return (TaskRecord const*) (self->recs.map + index * TJOURNAL_RECORD_SIZE);
+}
+
+static bool is_valid_(
+    TaskJournal const* const self,
+    TaskRecord const* const record
+) {
+    return record->cmd_off <= self->strs.len &&
+        record->cmd_len <= self->strs.len - record->cmd_off &&
+        record->checksum == checksum_(record, self->strs.map + record->cmd_off);
+}
+
+static HistoryClass class_of_(TaskRecord const* const record) {
+    switch ((TaskEnd) record->end) {
+    case TASK_END_TERMINATED:
+        return HCLASS_TERMINATED;
+    case TASK_END_EXEC_TIMEOUT:
+        return HCLASS_EXEC_TIMEOUT;
+    case TASK_END_INACTIVE_TIMEOUT:
+        return HCLASS_INACTIVE_TIMEOUT;
+    default:
+        return WIFEXITED(record->exit_status) &&
+                WEXITSTATUS(record->exit_status) == 0 ?
+            HCLASS_OK : HCLASS_FAILED;
+    }
+}
+
+/**
+ * Indexes the record at @p index, unless it already is, in which case
+ * nothing is written. Only the last record may be unindexed, as records are
+ * indexed as soon as they're appended, or, if that fails, before the next
+ * one is.
+ */
+static TaskJournalOutcome index_(TaskJournal* const self, size_t const index) {
+    TaskRecord const* const record = record_at_(self, index);
+    uint64_t const id_entry = (uint64_t) index + 1u;
+    if (u64_at_(&self->ids, (size_t) record->task_id) != id_entry) {
+        TaskJournalOutcome const id_outcome = put_(
+            &self->ids,
+            &id_entry,
+            sizeof id_entry,
+            record->task_id * 8u
+        );
+        if (id_outcome != TJOURNAL_OK) {
+            return id_outcome;
+        }
+    }
+    TaskJournalFile* const list = self->classes + class_of_(record);
+    size_t const list_len = (size_t) (list->len / 8u);
+    uint64_t const class_entry = index;
+    if (list_len > 0ul && u64_at_(list, list_len - 1ul) == class_entry) {
+        return TJOURNAL_OK;
+    }
+    return put_(list, &class_entry, sizeof class_entry, list->len);
+}
+
+/**
+ * Looks up a command among those interned, returning the address of its
+ * entry, or of the empty entry where it belongs.
+ */
+static TaskJournalStr* find_interned_(
+    TaskJournal const* const self,
+    char const* const cmd,
+    uint32_t const len,
+    uint32_t const hash
+) {
+    size_t const mask = self->interned_cap - 1ul;
+    for (size_t i = hash & mask; ; i = (i + 1ul) & mask) {
+        TaskJournalStr* const entry = self->interned + i;
+        if (entry->hash == 0u ||
+            (entry->hash == hash && entry->len == len &&
+                memcmp(self->strs.map + entry->off, cmd, len) == 0)
+        ) {
+            return entry;
+        }
+    }
+}
+
+/**
+ * Doubles the intern table's capacity, which must be kept at most half full.
+ */
+static bool grow_interned_(TaskJournal* const self) {
+    size_t const new_cap = self->interned_cap == 0ul ?
+        FIRST_INTERN_CAP : self->interned_cap * 2ul;
+    TaskJournalStr* const new_interned = calloc(new_cap, sizeof *new_interned);
+    if (!new_interned) {
+        return false;
+    }
+    TaskJournalStr* const old_interned = self->interned;
+    size_t const old_cap = self->interned_cap;
+    self->interned = new_interned;
+    self->interned_cap = new_cap;
+    for (size_t i = 0ul; i < old_cap; ++i) {
+        TaskJournalStr const* const old = old_interned + i;
+        if (old->hash != 0u) {
+            *find_interned_(
+                self,
+                self->strs.map + old->off,
+                old->len,
+                old->hash
+            ) = *old;
+        }
+    }
+    free(old_interned);
+    return true;
+}
+
+/**
+ * Stores the offset of a command in the strings file, appending it unless
+ * it's interned. Failing to intern it isn't an error, as it's only stored
+ * twice.
+ */
+static TaskJournalOutcome put_cmd_(
+    TaskJournal* const self,
+    char const* const cmd,
+    uint32_t const len,
+    uint64_t* const off
+) {
+    // zero marks an empty entry
+    uint32_t const hash = fnv1a_(FNV_OFFSET, cmd, len) | 1u;
+    TaskJournalStr* entry = NULL;
+    if (self->interned_len * 2ul < self->interned_cap || grow_interned_(self)) {
+        entry = find_interned_(self, cmd, len, hash);
+        if (entry->hash != 0u) {
+            *off = entry->off;
+            return TJOURNAL_OK;
+        }
+    }
+
+    *off = self->strs.len;
+    TaskJournalOutcome const put_outcome =
+        put_(&self->strs, cmd, len, self->strs.len);
+    if (put_outcome != TJOURNAL_OK) {
+        return put_outcome;
+    }
+    if (entry) {
+        *entry = (TaskJournalStr) { .off = *off, .len = len, .hash = hash };
+        ++self->interned_len;
+    }
+    return TJOURNAL_OK;
+}
+
+static int64_t timeval_usecs_(struct timeval const* const time) {
+    return (int64_t) time->tv_sec * 1000000 + (int64_t) time->tv_usec;
+}
+
+/**
+ * Drops the entries of a class index that are torn, or refer to records that
+ * were dropped.
+ */
+static TaskJournalOutcome repair_list_(
+    TaskJournalFile* const list,
+    size_t const len
+) {
+    size_t list_len = (size_t) (list->len / 8u);
+    while (list_len > 0ul && u64_at_(list, list_len - 1ul) >= len) {
+        --list_len;
+    }
+    return truncate_(list, (uint64_t) list_len * 8u);
+}
+
+/**
+ * Indexes every record anew, e.g. if the indexes were lost, or predate the
+ * records.
+ */
+static TaskJournalOutcome reindex_(TaskJournal* const self) {
+    TaskJournalOutcome outcome = truncate_(&self->ids, 0u);
+    for (size_t i = 0ul; i < HQUERY_CLASSES && outcome == TJOURNAL_OK; ++i) {
+        outcome = truncate_(self->classes + i, 0u);
+    }
+    for (size_t i = 0ul; i < self->len && outcome == TJOURNAL_OK; ++i) {
+        outcome = index_(self, i);
+    }
+    return outcome;
+}
+
+TaskJournalOutcome tjournal_open(
+    TaskJournal* const init,
+    char const* const dirname
+) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(dirname != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    TaskJournalFile const closed = {
+        .fd = -1,
+        .map = NULL,
+        .map_len = 0ul,
+        .len = 0u
+    };
+    *init = (TaskJournal) {
+        .recs = closed,
+        .strs = closed,
+        .ids = closed,
+        .len = 0ul,
+        .pending = NULL,
+        .pending_len = 0ul,
+        .pending_cap = 0ul,
+        .synced_strs_len = 0u,
+        .interned = NULL,
+        .interned_len = 0ul,
+        .interned_cap = 0ul
+    };
+    for (size_t i = 0ul; i < HQUERY_CLASSES; ++i) {
+        init->classes[i] = closed;
+    }
+    int const dir_fd = open(dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return TJOURNAL_ERR_OPEN_FAIL;
+    }
+    TaskJournalOutcome outcome =
+        open_file_(&init->recs, dir_fd, TJOURNAL_FILENAME);
+    if (outcome == TJOURNAL_OK) {
+        outcome = open_file_(&init->strs, dir_fd, TJOURNAL_STR_FILENAME);
+    }
+    if (outcome == TJOURNAL_OK) {
+        outcome = open_file_(&init->ids, dir_fd, TJOURNAL_IDS_FILENAME);
+    }
+    for (size_t i = 0ul; i < HQUERY_CLASSES && outcome == TJOURNAL_OK; ++i) {
+        outcome = open_file_(init->classes + i, dir_fd, class_filenames[i]);
+    }
+    int const open_errno = errno;
+    close(dir_fd);
+    if (outcome != TJOURNAL_OK) {
+        tjournal_close(init);
+        errno = open_errno;
+        return outcome;
+    }
+
+    // only the end may be torn, as records are only ever appended
+    init->len = (size_t) (init->recs.len / TJOURNAL_RECORD_SIZE);
+    while (init->len > 0ul &&
+        !is_valid_(init, record_at_(init, init->len - 1ul))
+    ) {
+        --init->len;
+    }
+    outcome =
+        truncate_(&init->recs, (uint64_t) init->len * TJOURNAL_RECORD_SIZE);
+    for (size_t i = 0ul; i < HQUERY_CLASSES && outcome == TJOURNAL_OK; ++i) {
+        outcome = repair_list_(init->classes + i, init->len);
+    }
+    // stale ids entries are told apart by their record's task id
+    if (outcome == TJOURNAL_OK && init->len > 0ul) {
+        outcome = index_(init, init->len - 1ul);
+    }
+    // every record is in exactly one class, unless the indexes were lost
+    uint64_t indexed = 0u;
+    for (size_t i = 0ul; i < HQUERY_CLASSES; ++i) {
+        indexed += init->classes[i].len / 8u;
+    }
+    if (outcome == TJOURNAL_OK && indexed != init->len) {
+        outcome = reindex_(init);
+    }
+    if (outcome != TJOURNAL_OK) {
+        int const repair_errno = errno;
+        tjournal_close(init);
+        errno = repair_errno;
+        return outcome;
+    }
+    return TJOURNAL_OK;
+}
+
+TaskJournalOutcome tjournal_close(TaskJournal* const self) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    TaskJournalOutcome const flush_outcome =
+        self->pending_len > 0ul ? tjournal_flush(self) : TJOURNAL_OK;
+    int const flush_errno = errno;
+    bool is_closed = close_file_(&self->recs);
+    is_closed = close_file_(&self->strs) && is_closed;
+    is_closed = close_file_(&self->ids) && is_closed;
+    for (size_t i = 0ul; i < HQUERY_CLASSES; ++i) {
+        is_closed = close_file_(self->classes + i) && is_closed;
+    }
+    free(self->pending);
+    self->pending = NULL;
+    self->pending_len = 0ul;
+    self->pending_cap = 0ul;
+    free(self->interned);
+    self->interned = NULL;
+    if (flush_outcome != TJOURNAL_OK) {
+        errno = flush_errno;
+        return flush_outcome;
+    }
+    return is_closed ? TJOURNAL_OK : TJOURNAL_ERR_CLOSE_FAIL;
+}
+
+size_t tjournal_len(TaskJournal const* const self) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    return self->len;
+}
+
+TaskJournalOutcome tjournal_append(
+    TaskJournal* const restrict self,
+    Task const* const restrict task
+) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    if (self->pending_len == self->pending_cap) {
+        size_t const new_cap = self->pending_cap == 0ul ?
+            FIRST_PENDING_CAP : self->pending_cap * 2ul;
+        TaskRecord* const new_pending =
+            realloc(self->pending, new_cap * sizeof *new_pending);
+        if (!new_pending) {
+            return TJOURNAL_ERR_ALLOC_FAIL;
+        }
+        self->pending = new_pending;
+        self->pending_cap = new_cap;
+    }
+    size_t const cmd_len = strlen(task->task_name);
+    TaskRecord record = {
+        .checksum = 0u,
+        .end = (uint32_t) task->end,
+        .task_id = task->task_id,
+        .exit_status = task->exit_status,
+        .cmd_len = cmd_len < UINT32_MAX ? (uint32_t) cmd_len : UINT32_MAX,
+        .cmd_off = 0u,
+        .start_sec = task->start_time.tv_sec,
+        .start_nsec = task->start_time.tv_nsec,
+        .end_sec = task->end_time.tv_sec,
+        .end_nsec = task->end_time.tv_nsec,
+        .utime_usec = timeval_usecs_(&task->usage.ru_utime),
+        .stime_usec = timeval_usecs_(&task->usage.ru_stime),
+        .max_rss_kib = task->usage.ru_maxrss,
+        .min_flt = task->usage.ru_minflt,
+        .maj_flt = task->usage.ru_majflt,
+        .nvcsw = task->usage.ru_nvcsw,
+        .nivcsw = task->usage.ru_nivcsw,
+        .mem_peak_kib = task->mem_peak_kib
+    };
+    TaskJournalOutcome const cmd_outcome =
+        put_cmd_(self, task->task_name, record.cmd_len, &record.cmd_off);
+    if (cmd_outcome != TJOURNAL_OK) {
+        return cmd_outcome;
+    }
+    record.checksum = checksum_(&record, task->task_name);
+    self->pending[self->pending_len++] = record;
+    return TJOURNAL_OK;
+}
+
+TaskJournalOutcome tjournal_flush(TaskJournal* const self) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    if (self->len > 0ul) {
+        TaskJournalOutcome const index_outcome =
+            index_(self, self->len - 1ul);
+        if (index_outcome != TJOURNAL_OK) {
+            return index_outcome;
+        }
+    }
+    if (self->pending_len == 0ul) {
+        return TJOURNAL_OK;
+    }
+    // the commands must be on disk before any record referring to them, which
+    // writeback could otherwise write first
+    if (self->strs.len > self->synced_strs_len) {
+        if (fdatasync(self->strs.fd) == -1) {
+            return TJOURNAL_ERR_WRITE_FAIL;
+        }
+        self->synced_strs_len = self->strs.len;
+    }
+
+    TaskJournalOutcome outcome = TJOURNAL_OK;
+    size_t written = 0ul;
+    for (; written < self->pending_len; ++written) {
+        outcome = put_(
+            &self->recs,
+            self->pending + written,
+            sizeof *self->pending,
+            (uint64_t) self->len * TJOURNAL_RECORD_SIZE
+        );
+        if (outcome != TJOURNAL_OK) {
+            break;
+        }
+        ++self->len;
+        outcome = index_(self, self->len - 1ul);
+        if (outcome != TJOURNAL_OK) {
+            // the record is written, and indexed by the next flush
+            ++written;
+            break;
+        }
+    }
+    memmove(
+        self->pending,
+        self->pending + written,
+        (self->pending_len - written) * sizeof *self->pending
+    );
+    self->pending_len -= written;
+    return outcome;
+}
+
+TaskRecord const* tjournal_get(
+    TaskJournal const* const self,
+    size_t const index
+) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(index < self->len);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    TaskRecord const* const record = record_at_(self, index);
+    return is_valid_(self, record) ? record : NULL;
+}
+
+char const* tjournal_cmd(
+    TaskJournal const* const self,
+    TaskRecord const* const record
+) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(record != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    return self->strs.map + record->cmd_off;
+}
+
+/**
+ * Returns the record index of a query's candidate, or @p SIZE_MAX if the
+ * candidate has no record.
+ */
+static size_t candidate_(
+    TaskJournal const* const self,
+    Source const* const source,
+    size_t const pos
+) {
+    if (source->opt_list) {
+        return (size_t) u64_at_(source->opt_list, pos);
+    }
+    if (!source->is_by_id) {
+        return pos;
+    }
+    uint64_t const id_entry = u64_at_(&self->ids, pos);
+    if (id_entry == 0u || id_entry > self->len ||
+        record_at_(self, (size_t) id_entry - 1ul)->task_id != pos
+    ) {
+        return SIZE_MAX;
+    }
+    return (size_t) id_entry - 1ul;
+}
+
+/**
+ * Returns the first candidate, among those sorted by end time, which ended
+ * at or after @p sec.
+ */
+static size_t lower_bound_(
+    TaskJournal const* const self,
+    Source const* const source,
+    int64_t const sec
+) {
+    size_t begin = source->begin;
+    size_t end = source->end;
+    while (begin < end) {
+        size_t const mid = begin + (end - begin) / 2ul;
+        size_t const index = candidate_(self, source, mid);
+        if (index >= self->len || record_at_(self, index)->end_sec < sec) {
+            begin = mid + 1ul;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+static TaskRecord const* match_(
+    TaskJournal const* const self,
+    HistoryQuery const* const query,
+    size_t const index
+) {
+    if (index >= self->len) {
+        return NULL;
+    }
+    TaskRecord const* const record = tjournal_get(self, index);
+    uint32_t const fields = query->fields;
+    if (!record ||
+        ((fields & HQUERY_SINCE) && record->task_id < query->since_id) ||
+        ((fields & HQUERY_FROM) && record->end_sec < query->from_sec) ||
+        ((fields & HQUERY_TO) && record->end_sec >= query->to_sec) ||
+        ((fields & HQUERY_CLASS) && class_of_(record) != query->end_class)
+    ) {
+        return NULL;
+    }
+    if ((fields & HQUERY_STATUS) && (
+        record->end != TASK_END_COMPLETED ||
+            !WIFEXITED(record->exit_status) ||
+            WEXITSTATUS(record->exit_status) != query->exit_status
+    )) {
+        return NULL;
+    }
+    if ((fields & HQUERY_PREFIX) && (
+        record->cmd_len < query->prefix_len ||
+            memcmp(
+                tjournal_cmd(self, record),
+                query->prefix,
+                query->prefix_len
+            ) != 0
+    )) {
+        return NULL;
+    }
+    return record;
+}
+
+/**
+ * Returns whether a filter of the query is checked on each record in range,
+ * rather than answered by the index the records are taken from.
+ */
+static bool is_scanning_(
+    TaskJournal const* const self,
+    HistoryQuery const* const query,
+    Source const* const source
+) {
+    uint32_t const fields = query->fields;
+    return (fields & HQUERY_PREFIX) ||
+        ((fields & HQUERY_STATUS) && (
+            query->exit_status != 0 ||
+                source->opt_list != self->classes + HCLASS_OK
+        )) ||
+        ((fields & HQUERY_CLASS) && source->is_by_id);
+}
+
+TaskJournalOutcome tjournal_query(
+    TaskJournal const* const self,
+    HistoryQuery const* const query,
+    TaskRecordVisitor const visitor,
+    void* const ctx
+) {
+#   if TASK_JOURNAL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(query != NULL);
+    assert(visitor != NULL);
+#   endif  // TASK_JOURNAL_RUNTIME_ASSERTS
+
+    Source source = {
+        .opt_list = NULL,
+        .is_by_id = false,
+        .begin = 0ul,
+        .end = self->len
+    };
+    if (query->fields & HQUERY_SINCE) {
+        source.is_by_id = true;
+        source.begin = query->since_id < SIZE_MAX ?
+            (size_t) query->since_id : SIZE_MAX;
+        source.end = (size_t) (self->ids.len / 8u);
+    } else {
+        if (query->fields & HQUERY_CLASS) {
+            source.opt_list = self->classes + query->end_class;
+        } else if (query->fields & HQUERY_STATUS) {
+            source.opt_list = self->classes +
+                (query->exit_status == 0 ? HCLASS_OK : HCLASS_FAILED);
+        }
+        if (source.opt_list) {
+            source.end = (size_t) (source.opt_list->len / 8u);
+        }
+        if (query->fields & HQUERY_FROM) {
+            source.begin = lower_bound_(self, &source, query->from_sec);
+        }
+        if (query->fields & HQUERY_TO) {
+            source.end = lower_bound_(self, &source, query->to_sec);
+        }
+    }
+    if (source.begin >= source.end) {
+        return TJOURNAL_OK;
+    }
+    TaskJournalOutcome outcome = TJOURNAL_OK;
+    size_t scan_begin = source.begin;
+    if (source.end - source.begin > TJOURNAL_MAX_SCANNED &&
+        is_scanning_(self, query, &source)
+    ) {
+        if (!(query->fields & HQUERY_LAST)) {
+            return TJOURNAL_ERR_TOO_BROAD;
+        }
+        scan_begin = source.end - TJOURNAL_MAX_SCANNED;
+    }
+
+    // the last matches are found backwards, and then visited in order
+    if (query->fields & HQUERY_LAST) {
+        size_t first = source.end;
+        uint64_t matches = 0u;
+        while (matches < query->last && first > scan_begin) {
+            --first;
+            if (match_(self, query, candidate_(self, &source, first))) {
+                ++matches;
+            }
+        }
+        // older matches may be out of reach
+        if (matches < query->last && first > source.begin) {
+            outcome = TJOURNAL_ERR_TOO_BROAD;
+        }
+        source.begin = first;
+    }
+    for (size_t i = source.begin; i < source.end; ++i) {
+        TaskRecord const* const record =
+            match_(self, query, candidate_(self, &source, i));
+        if (record && !visitor(ctx, record)) {
+            break;
+        }
+    }
+    return outcome;
+}
+
+char const* tjournal_outcome_msg(
+    TaskJournalOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        TJOURNAL_OK == 0 &&
+            TJOURNAL_ERR_ALLOC_FAIL == 1 &&
+            TJOURNAL_ERR_OPEN_FAIL == 2 &&
+            TJOURNAL_ERR_MAP_FAIL == 3 &&
+            TJOURNAL_ERR_WRITE_FAIL == 4 &&
+            TJOURNAL_ERR_CLOSE_FAIL == 5 &&
+            TJOURNAL_ERR_TOO_BROAD == 6,
+        "Unexpected TaskJournalOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "failed allocating dynamic memory for the task journal",
+        "failed opening a task journal file",
+        "failed mapping a task journal file",
+        "failed writing a task journal file",
+        "failed closing a task journal file",
+        "too many finished tasks to check against a command or exit status",
+        "unknown task journal error"
+    };
+    switch (outcome) {
+    case TJOURNAL_ERR_ALLOC_FAIL:
+    case TJOURNAL_ERR_OPEN_FAIL:
+    case TJOURNAL_ERR_MAP_FAIL:
+    case TJOURNAL_ERR_WRITE_FAIL:
+    case TJOURNAL_ERR_CLOSE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case TJOURNAL_OK:
+    case TJOURNAL_ERR_TOO_BROAD:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
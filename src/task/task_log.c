@@ -0,0 +1,576 @@
+#define _GNU_SOURCE
+
+#include "task/task_log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+static void put_u32_(unsigned char* const buf, uint32_t const value) {
+    for (size_t i = 0ul; i < 4ul; ++i) {
+        buf[i] = (unsigned char) (value >> (8ul * i));
+    }
+}
+
+static uint32_t get_u32_(unsigned char const* const buf) {
+    uint32_t value = 0u;
+    for (size_t i = 0ul; i < 4ul; ++i) {
+        value |= (uint32_t) buf[i] << (8ul * i);
+    }
+    return value;
+}
+
+static void put_u64_(unsigned char* const buf, uint64_t const value) {
+    for (size_t i = 0ul; i < 8ul; ++i) {
+        buf[i] = (unsigned char) (value >> (8ul * i));
+    }
+}
+
+static uint64_t get_u64_(unsigned char const* const buf) {
+    uint64_t value = 0u;
+    for (size_t i = 0ul; i < 8ul; ++i) {
+        value |= (uint64_t) buf[i] << (8ul * i);
+    }
+    return value;
+}
+
+static bool pread_all_(
+    int const fd,
+    void* const buf,
+    size_t const len,
+    uint64_t const offset
+) {
+    size_t pos = 0ul;
+    while (pos < len) {
+        ssize_t const read_bytes = pread(
+            fd,
+            (char*) buf + pos,
+            len - pos,
+            (off_t) (offset + pos)
+        );
+        if (read_bytes == -1l && errno == EINTR) {
+            continue;
+        }
+        if (read_bytes <= 0l) {
+            return false;
+        }
+        pos += (size_t) read_bytes;
+    }
+    return true;
+}
+
+static bool pwrite_all_(
+    int const fd,
+    void const* const buf,
+    size_t const len,
+    uint64_t const offset
+) {
+    size_t pos = 0ul;
+    while (pos < len) {
+        ssize_t const written = pwrite(
+            fd,
+            (char const*) buf + pos,
+            len - pos,
+            (off_t) (offset + pos)
+        );
+        if (written == -1l && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0l) {
+            return false;
+        }
+        pos += (size_t) written;
+    }
+    return true;
+}
+
+static bool write_entry_(
+    TaskLog const* const self,
+    size_t const task_id,
+    TaskLogEntry const* const entry
+) {
+    unsigned char buf[TLOG_IDX_ENTRY_SIZE];
+    put_u64_(buf, entry->frame_off + 1u);
+    put_u64_(buf + 8, entry->skip);
+    put_u64_(buf + 16, entry->len);
+    return pwrite_all_(
+        self->idx_fd,
+        buf,
+        sizeof buf,
+        (uint64_t) task_id * TLOG_IDX_ENTRY_SIZE
+    );
+}
+
+static bool push_pending_(
+    TaskLog* const self,
+    size_t const task_id,
+    TaskLogEntry const* const entry
+) {
+    if (self->pending_len == self->pending_cap) {
+        size_t const new_cap =
+            self->pending_cap == 0ul ? 16ul : self->pending_cap * 2ul;
+        TaskLogPending* const new_pending =
+            realloc(self->pending, new_cap * sizeof *self->pending);
+        if (!new_pending) {
+            return false;
+        }
+        self->pending = new_pending;
+        self->pending_cap = new_cap;
+    }
+    self->pending[self->pending_len++] = (TaskLogPending) {
+        .task_id = task_id,
+        .entry = *entry
+    };
+    return true;
+}
+
+TaskLogOutcome tlog_open(TaskLog* const init, char const* const dirname) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(init != NULL);
+    assert(dirname != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    init->dir_fd = -1;
+    init->log_fd = -1;
+    init->idx_fd = -1;
+    init->ids_fd = -1;
+    init->next_id = 0u;
+    init->reserved_id = 0u;
+    init->log_len = 0u;
+    init->frame = malloc(TLOG_FRAME_SIZE);
+    init->frame_len = 0ul;
+    init->packed =
+        malloc(TLOG_FRAME_HEADER_SIZE + lz_bound(TLOG_FRAME_SIZE));
+    init->unpacked = malloc(TLOG_FRAME_SIZE);
+    init->unpacked_off = UINT64_MAX;
+    init->unpacked_next = 0u;
+    init->unpacked_len = 0ul;
+    init->pending = NULL;
+    init->pending_len = 0ul;
+    init->pending_cap = 0ul;
+    if (!init->frame || !init->packed || !init->unpacked) {
+        int const alloc_errno = errno;
+        tlog_close(init);
+        errno = alloc_errno;
+        return TLOG_ERR_ALLOC_FAIL;
+    }
+
+    init->dir_fd = open(dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (init->dir_fd == -1) {
+        int const open_errno = errno;
+        tlog_close(init);
+        errno = open_errno;
+        return TLOG_ERR_OPEN_FAIL;
+    }
+    init->log_fd =
+        openat(init->dir_fd, TLOG_FILENAME, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    init->idx_fd = openat(
+        init->dir_fd,
+        TLOG_IDX_FILENAME,
+        O_RDWR | O_CREAT | O_CLOEXEC,
+        0644
+    );
+    init->ids_fd = openat(
+        init->dir_fd,
+        TLOG_IDS_FILENAME,
+        O_RDWR | O_CREAT | O_CLOEXEC,
+        0644
+    );
+    struct stat log_stat;
+    if (init->log_fd == -1 || init->idx_fd == -1 || init->ids_fd == -1 ||
+        fstat(init->log_fd, &log_stat) == -1
+    ) {
+        int const open_errno = errno;
+        tlog_close(init);
+        errno = open_errno;
+        return TLOG_ERR_OPEN_FAIL;
+    }
+    init->log_len = (uint64_t) log_stat.st_size;
+
+    // a partially written entry still takes up its task id, and logs from
+    // before the ids file only have their index to go by
+    struct stat idx_stat;
+    struct stat ids_stat;
+    if (fstat(init->idx_fd, &idx_stat) == -1 ||
+        fstat(init->ids_fd, &ids_stat) == -1
+    ) {
+        int const read_errno = errno;
+        tlog_close(init);
+        errno = read_errno;
+        return TLOG_ERR_READ_FAIL;
+    }
+    uint64_t const idx_count =
+        ((uint64_t) idx_stat.st_size + TLOG_IDX_ENTRY_SIZE - 1u) /
+        TLOG_IDX_ENTRY_SIZE;
+    uint64_t reserved_id = 0u;
+    if (ids_stat.st_size >= 8) {
+        unsigned char buf[8];
+        if (!pread_all_(init->ids_fd, buf, sizeof buf, 0u)) {
+            int const read_errno = errno;
+            tlog_close(init);
+            errno = read_errno;
+            return TLOG_ERR_READ_FAIL;
+        }
+        reserved_id = get_u64_(buf);
+    }
+    init->next_id = idx_count > reserved_id ? idx_count : reserved_id;
+    init->reserved_id = init->next_id;
+    return TLOG_OK;
+}
+
+TaskLogOutcome tlog_close(TaskLog* const self) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    TaskLogOutcome const flush_outcome = self->log_fd != -1 ?
+        tlog_flush(self) : TLOG_OK;
+    int const flush_errno = errno;
+    bool is_closed = true;
+    int const fds[] = {
+        self->log_fd,
+        self->idx_fd,
+        self->ids_fd,
+        self->dir_fd
+    };
+    for (size_t i = 0ul; i < sizeof fds / sizeof *fds; ++i) {
+        if (fds[i] != -1 && close(fds[i]) == -1) {
+            is_closed = false;
+        }
+    }
+    self->log_fd = -1;
+    self->idx_fd = -1;
+    self->ids_fd = -1;
+    self->dir_fd = -1;
+    free(self->frame);
+    free(self->packed);
+    free(self->unpacked);
+    free(self->pending);
+    self->frame = NULL;
+    self->packed = NULL;
+    self->unpacked = NULL;
+    self->pending = NULL;
+    if (flush_outcome != TLOG_OK) {
+        errno = flush_errno;
+        return flush_outcome;
+    }
+    return is_closed ? TLOG_OK : TLOG_ERR_CLOSE_FAIL;
+}
+
+TaskLogOutcome tlog_next_id(
+    TaskLog* const restrict self,
+    size_t* const restrict task_id
+) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task_id != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    if (self->next_id == self->reserved_id) {
+        unsigned char buf[8];
+        put_u64_(buf, self->reserved_id + TLOG_IDS_BLOCK);
+        // the reservation must be on disk before any of its ids is given out
+        if (!pwrite_all_(self->ids_fd, buf, sizeof buf, 0u) ||
+            fdatasync(self->ids_fd) == -1
+        ) {
+            return TLOG_ERR_WRITE_FAIL;
+        }
+        self->reserved_id += TLOG_IDS_BLOCK;
+    }
+    *task_id = (size_t) self->next_id++;
+    return TLOG_OK;
+}
+
+TaskLogOutcome tlog_spool(
+    TaskLog const* const restrict self,
+    int* const restrict spool_fd
+) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(spool_fd != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    *spool_fd = openat(self->dir_fd, ".", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    return *spool_fd == -1 ? TLOG_ERR_OPEN_FAIL : TLOG_OK;
+}
+
+TaskLogOutcome tlog_append(
+    TaskLog* const self,
+    size_t const task_id,
+    int const spool_fd
+) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    struct stat spool_stat;
+    if (fstat(spool_fd, &spool_stat) == -1) {
+        return TLOG_ERR_READ_FAIL;
+    }
+    uint64_t const len = (uint64_t) spool_stat.st_size;
+    TaskLogEntry const entry = {
+        .frame_off = self->log_len,
+        .skip = self->frame_len,
+        .len = len
+    };
+    // an empty output points to no frame, so it's recorded right away
+    if (len == 0u) {
+        return write_entry_(self, task_id, &entry) ?
+            TLOG_OK : TLOG_ERR_WRITE_FAIL;
+    }
+
+    uint64_t pos = 0u;
+    while (pos < len) {
+        if (self->frame_len == TLOG_FRAME_SIZE) {
+            TaskLogOutcome const flush_outcome = tlog_flush(self);
+            if (flush_outcome != TLOG_OK) {
+                return flush_outcome;
+            }
+        }
+        size_t const room = TLOG_FRAME_SIZE - self->frame_len;
+        size_t const chunk_len = len - pos < room ? (size_t) (len - pos) : room;
+        char* const dst = self->frame + self->frame_len;
+        if (!pread_all_(spool_fd, dst, chunk_len, pos)) {
+            return TLOG_ERR_READ_FAIL;
+        }
+        self->frame_len += chunk_len;
+        pos += chunk_len;
+    }
+    return push_pending_(self, task_id, &entry) ?
+        TLOG_OK : TLOG_ERR_ALLOC_FAIL;
+}
+
+TaskLogOutcome tlog_flush(TaskLog* const self) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    if (self->frame_len > 0ul) {
+        unsigned char* const header = (unsigned char*) self->packed;
+        size_t data_len = lz_compress(
+            self->frame,
+            self->frame_len,
+            self->packed + TLOG_FRAME_HEADER_SIZE
+        );
+        if (data_len >= self->frame_len) {
+            data_len = self->frame_len;
+            memcpy(
+                self->packed + TLOG_FRAME_HEADER_SIZE,
+                self->frame,
+                data_len
+            );
+        }
+        put_u32_(header, TLOG_FRAME_MAGIC);
+        put_u32_(header + 4, (uint32_t) self->frame_len);
+        put_u32_(header + 8, (uint32_t) data_len);
+        size_t const frame_size = TLOG_FRAME_HEADER_SIZE + data_len;
+        if (
+            !pwrite_all_(self->log_fd, self->packed, frame_size, self->log_len)
+        ) {
+            return TLOG_ERR_WRITE_FAIL;
+        }
+        self->log_len += frame_size;
+        self->frame_len = 0ul;
+    }
+
+    // the entries are written after their frames, so they never point to
+    // garbage
+    for (size_t i = 0ul; i < self->pending_len; ++i) {
+        TaskLogPending const* const pending = self->pending + i;
+        if (!write_entry_(self, pending->task_id, &pending->entry)) {
+            return TLOG_ERR_WRITE_FAIL;
+        }
+    }
+    self->pending_len = 0ul;
+    return TLOG_OK;
+}
+
+TaskLogOutcome tlog_find(
+    TaskLog const* const restrict self,
+    size_t const task_id,
+    TaskLogEntry* const restrict entry
+) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(entry != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    for (size_t i = 0ul; i < self->pending_len; ++i) {
+        if (self->pending[i].task_id == task_id) {
+            *entry = self->pending[i].entry;
+            return TLOG_OK;
+        }
+    }
+
+    unsigned char buf[TLOG_IDX_ENTRY_SIZE];
+    off_t const entry_off = (off_t) (task_id * TLOG_IDX_ENTRY_SIZE);
+    ssize_t read_bytes;
+    while ((read_bytes = pread(self->idx_fd, buf, sizeof buf, entry_off)) ==
+        -1l && errno == EINTR
+    ) {}
+    if (read_bytes == -1l) {
+        return TLOG_ERR_READ_FAIL;
+    }
+    // entries past the end, or in a hole, read as no output recorded
+    if (read_bytes != (ssize_t) sizeof buf || get_u64_(buf) == 0u) {
+        return TLOG_NOT_FOUND;
+    }
+    entry->frame_off = get_u64_(buf) - 1u;
+    entry->skip = get_u64_(buf + 8);
+    entry->len = get_u64_(buf + 16);
+    return TLOG_OK;
+}
+
+TaskLogOutcome tlog_read(
+    TaskLog* const restrict self,
+    TaskLogEntry* const restrict entry,
+    TaskLogChunk* const restrict chunk
+) {
+#   if TASK_LOG_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(entry != NULL);
+    assert(entry->len > 0u);
+    assert(chunk != NULL);
+#   endif  // TASK_LOG_RUNTIME_ASSERTS
+
+    char const* data;
+    size_t raw_len;
+    uint64_t next_off;
+    if (entry->frame_off == self->log_len) {
+        // the open frame, which is never followed by another
+        data = self->frame;
+        raw_len = self->frame_len;
+        next_off = UINT64_MAX;
+    } else if (entry->frame_off == self->unpacked_off) {
+        data = self->unpacked;
+        raw_len = self->unpacked_len;
+        next_off = self->unpacked_next;
+    } else {
+        unsigned char header[TLOG_FRAME_HEADER_SIZE];
+        if (entry->frame_off > self->log_len ||
+            self->log_len - entry->frame_off < TLOG_FRAME_HEADER_SIZE
+        ) {
+            return TLOG_ERR_CORRUPT;
+        }
+        if (
+            !pread_all_(self->log_fd, header, sizeof header, entry->frame_off)
+        ) {
+            return TLOG_ERR_READ_FAIL;
+        }
+        raw_len = get_u32_(header + 4);
+        size_t const data_len = get_u32_(header + 8);
+        uint64_t const data_off = entry->frame_off + TLOG_FRAME_HEADER_SIZE;
+        if (get_u32_(header) != TLOG_FRAME_MAGIC ||
+            raw_len > TLOG_FRAME_SIZE || data_len > raw_len ||
+            self->log_len - data_off < data_len
+        ) {
+            return TLOG_ERR_CORRUPT;
+        }
+        next_off = data_off + data_len;
+        if (data_len == raw_len) {
+            data = NULL;
+        } else {
+            if (!pread_all_(self->log_fd, self->packed, data_len, data_off)) {
+                return TLOG_ERR_READ_FAIL;
+            }
+            self->unpacked_off = UINT64_MAX;
+            if (
+                !lz_decompress(self->packed, data_len, self->unpacked, raw_len)
+            ) {
+                return TLOG_ERR_CORRUPT;
+            }
+            self->unpacked_off = entry->frame_off;
+            self->unpacked_next = next_off;
+            self->unpacked_len = raw_len;
+            data = self->unpacked;
+        }
+    }
+
+    if (entry->skip >= raw_len) {
+        return TLOG_ERR_CORRUPT;
+    }
+    size_t const left = raw_len - (size_t) entry->skip;
+    chunk->len = entry->len < left ? (size_t) entry->len : left;
+    chunk->data = data ? data + entry->skip : NULL;
+    chunk->file_off = data ?
+        0u : entry->frame_off + TLOG_FRAME_HEADER_SIZE + entry->skip;
+    entry->len -= chunk->len;
+    entry->skip += chunk->len;
+    if (entry->skip == raw_len) {
+        entry->frame_off = next_off;
+        entry->skip = 0u;
+    }
+    return TLOG_OK;
+}
+
+char const* tlog_outcome_msg(
+    TaskLogOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        TLOG_OK == 0 &&
+            TLOG_NOT_FOUND == 1 &&
+            TLOG_ERR_ALLOC_FAIL == 2 &&
+            TLOG_ERR_CORRUPT == 3 &&
+            TLOG_ERR_OPEN_FAIL == 4 &&
+            TLOG_ERR_READ_FAIL == 5 &&
+            TLOG_ERR_WRITE_FAIL == 6 &&
+            TLOG_ERR_CLOSE_FAIL == 7,
+        "Unexpected TaskLogOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "the task has no output recorded",
+        "failed allocating memory for the task log",
+        "a task log frame is corrupt",
+        "failed opening a task log file",
+        "failed reading a task log file",
+        "failed writing a task log file",
+        "failed closing a task log file",
+        "unknown task log error"
+    };
+    switch (outcome) {
+    case TLOG_ERR_ALLOC_FAIL:
+    case TLOG_ERR_OPEN_FAIL:
+    case TLOG_ERR_READ_FAIL:
+    case TLOG_ERR_WRITE_FAIL:
+    case TLOG_ERR_CLOSE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case TLOG_OK:
+    case TLOG_NOT_FOUND:
+    case TLOG_ERR_CORRUPT:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
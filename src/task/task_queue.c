@@ -0,0 +1,163 @@
+#include "task/task_queue.h"
+
+#if TASK_QUEUE_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FIRST_ALLOC_CAP 16ul
+
+static size_t slot_(TaskQueue const* const self, size_t const index) {
+    return (self->begin + index) & (self->cap - 1ul);
+}
+
+/**
+ * Doubles the buffer's capacity, unwrapping the tasks to its start.
+ */
+static bool grow_(TaskQueue* const self) {
+    size_t new_cap;
+    if (self->cap == 0ul) {
+        new_cap = FIRST_ALLOC_CAP;
+    } else if (__builtin_mul_overflow(self->cap, 2ul, &new_cap)) {
+        return false;
+    }
+    size_t new_size;
+    if (__builtin_mul_overflow(new_cap, sizeof *self->buf, &new_size)) {
+        return false;
+    }
+    PendingTask* const new_buf = malloc(new_size);
+    if (!new_buf) {
+        return false;
+    }
+    for (size_t i = 0ul; i < self->len; ++i) {
+        new_buf[i] = self->buf[slot_(self, i)];
+    }
+    free(self->buf);
+    self->buf = new_buf;
+    self->begin = 0ul;
+    self->cap = new_cap;
+    return true;
+}
+
+TaskQueue* tqueue_new(TaskQueue* const init) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    init->buf = NULL;
+    init->begin = 0ul;
+    init->len = 0ul;
+    init->cap = 0ul;
+    return init;
+}
+
+void tqueue_drop(TaskQueue* const self) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    for (size_t i = 0ul; i < self->len; ++i) {
+        free(self->buf[slot_(self, i)].cmd);
+    }
+    free(self->buf);
+    tqueue_new(self);
+}
+
+size_t tqueue_len(TaskQueue const* const self) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    return self->len;
+}
+
+PendingTask const* tqueue_get(
+    TaskQueue const* const self,
+    size_t const index
+) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(index < self->len);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    return self->buf + slot_(self, index);
+}
+
+bool tqueue_push(
+    TaskQueue* const restrict self,
+    size_t const task_id,
+    char const* const restrict cmd,
+    size_t const cmd_len,
+    TaskLimits const* const restrict limits
+) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(cmd != NULL);
+    assert(limits != NULL);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    if (self->len == self->cap && !grow_(self)) {
+        return false;
+    }
+    char* const cmd_copy = malloc(cmd_len + 1ul);
+    if (!cmd_copy) {
+        return false;
+    }
+    memcpy(cmd_copy, cmd, cmd_len);
+    cmd_copy[cmd_len] = '\0';
+    self->buf[slot_(self, self->len)] = (PendingTask) {
+        .task_id = task_id,
+        .cmd = cmd_copy,
+        .cmd_len = cmd_len,
+        .limits = *limits
+    };
+    ++self->len;
+    return true;
+}
+
+bool tqueue_pop(
+    TaskQueue* const restrict self,
+    PendingTask* const restrict task
+) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task != NULL);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    if (self->len == 0ul) {
+        return false;
+    }
+    *task = self->buf[self->begin];
+    self->begin = slot_(self, 1ul);
+    --self->len;
+    return true;
+}
+
+bool tqueue_rm(
+    TaskQueue* const restrict self,
+    size_t const task_id,
+    PendingTask* const restrict task
+) {
+#   if TASK_QUEUE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task != NULL);
+#   endif  // TASK_QUEUE_RUNTIME_ASSERTS
+
+    size_t index = 0ul;
+    while (index < self->len &&
+        self->buf[slot_(self, index)].task_id != task_id
+    ) {
+        ++index;
+    }
+    if (index == self->len) {
+        return false;
+    }
+    *task = self->buf[slot_(self, index)];
+    for (size_t i = index + 1ul; i < self->len; ++i) {
+        self->buf[slot_(self, i - 1ul)] = self->buf[slot_(self, i)];
+    }
+    --self->len;
+    return true;
+}
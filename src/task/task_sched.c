@@ -0,0 +1,256 @@
+#include "task/task_sched.h"
+
+#if TASK_SCHED_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define FIRST_ALLOC_CAP 16ul
+#define NO_OWNER SIZE_MAX
+
+static void level_new_(SchedLevel* const init) {
+    init->owners = NULL;
+    init->owners_len = 0ul;
+    init->owners_cap = 0ul;
+    tidx_new(&init->owners_idx);
+    init->last_active = NO_OWNER;
+}
+
+static void level_drop_(SchedLevel* const self) {
+    for (size_t i = 0ul; i < self->owners_len; ++i) {
+        tqueue_drop(&self->owners[i].tasks);
+    }
+    free(self->owners);
+    tidx_drop(&self->owners_idx);
+}
+
+/**
+ * Forgets every owner once none has pending tasks, so that owners only take
+ * memory while they have tasks pending, or the level is busy.
+ */
+static void level_forget_owners_(SchedLevel* const self) {
+    level_drop_(self);
+    level_new_(self);
+}
+
+/**
+ * Returns the index of @p owner, which is added if it wasn't seen yet, or
+ * @p NO_OWNER if memory allocation fails.
+ */
+static size_t level_owner_(SchedLevel* const self, size_t const owner) {
+    size_t index;
+    if (tidx_get(&self->owners_idx, owner, &index)) {
+        return index;
+    }
+    if (self->owners_len == self->owners_cap) {
+        size_t const new_cap = self->owners_cap == 0ul ?
+            FIRST_ALLOC_CAP :
+            self->owners_cap * 2ul;
+        size_t new_size;
+        if (__builtin_mul_overflow(new_cap, sizeof *self->owners, &new_size)) {
+            return NO_OWNER;
+        }
+        SchedOwner* const new_owners = realloc(self->owners, new_size);
+        if (!new_owners) {
+            return NO_OWNER;
+        }
+        self->owners = new_owners;
+        self->owners_cap = new_cap;
+    }
+    index = self->owners_len;
+    if (!tidx_put(&self->owners_idx, owner, index)) {
+        return NO_OWNER;
+    }
+    self->owners[index].owner = owner;
+    tqueue_new(&self->owners[index].tasks);
+    self->owners[index].next_active = NO_OWNER;
+    ++self->owners_len;
+    return index;
+}
+
+/**
+ * Unlinks the owner at @p index, which follows the one at @p prev, from the
+ * owners with pending tasks, releasing its queue's buffer.
+ */
+static void level_deactivate_(
+    SchedLevel* const self,
+    size_t const prev,
+    size_t const index
+) {
+    SchedOwner* const owner = self->owners + index;
+    tqueue_drop(&owner->tasks);
+    if (prev == index) {
+        self->last_active = NO_OWNER;
+        level_forget_owners_(self);
+        return;
+    }
+    self->owners[prev].next_active = owner->next_active;
+    owner->next_active = NO_OWNER;
+    if (self->last_active == index) {
+        self->last_active = prev;
+    }
+}
+
+TaskSched* tsched_new(TaskSched* const init) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    for (size_t i = 0ul; i < TSCHED_LEVELS; ++i) {
+        level_new_(init->levels + i);
+    }
+    init->len = 0ul;
+    return init;
+}
+
+void tsched_drop(TaskSched* const self) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    for (size_t i = 0ul; i < TSCHED_LEVELS; ++i) {
+        level_drop_(self->levels + i);
+    }
+    tsched_new(self);
+}
+
+size_t tsched_len(TaskSched const* const self) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    return self->len;
+}
+
+bool tsched_push(
+    TaskSched* const restrict self,
+    size_t const priority,
+    size_t const owner,
+    size_t const task_id,
+    char const* const restrict cmd,
+    size_t const cmd_len,
+    TaskLimits const* const restrict limits
+) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(priority < TSCHED_LEVELS);
+    assert(owner != SIZE_MAX);
+    assert(cmd != NULL);
+    assert(limits != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    SchedLevel* const level = self->levels + priority;
+    size_t const index = level_owner_(level, owner);
+    if (index == NO_OWNER) {
+        return false;
+    }
+    SchedOwner* const sched_owner = level->owners + index;
+    bool const was_active = tqueue_len(&sched_owner->tasks) > 0ul;
+    if (!tqueue_push(&sched_owner->tasks, task_id, cmd, cmd_len, limits)) {
+        return false;
+    }
+    // a newly active owner is served after every other one
+    if (!was_active) {
+        if (level->last_active == NO_OWNER) {
+            sched_owner->next_active = index;
+        } else {
+            SchedOwner* const last = level->owners + level->last_active;
+            sched_owner->next_active = last->next_active;
+            last->next_active = index;
+        }
+        level->last_active = index;
+    }
+    ++self->len;
+    return true;
+}
+
+bool tsched_pop(
+    TaskSched* const restrict self,
+    PendingTask* const restrict task
+) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    for (size_t i = TSCHED_LEVELS; i-- > 0ul;) {
+        SchedLevel* const level = self->levels + i;
+        if (level->last_active == NO_OWNER) {
+            continue;
+        }
+        size_t const last = level->last_active;
+        size_t const next = level->owners[last].next_active;
+        TaskQueue* const tasks = &level->owners[next].tasks;
+        tqueue_pop(tasks, task);
+        if (tqueue_len(tasks) == 0ul) {
+            level_deactivate_(level, last, next);
+        } else {
+            level->last_active = next;
+        }
+        --self->len;
+        return true;
+    }
+    return false;
+}
+
+bool tsched_rm(
+    TaskSched* const restrict self,
+    size_t const task_id,
+    PendingTask* const restrict task
+) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    for (size_t i = 0ul; i < TSCHED_LEVELS; ++i) {
+        SchedLevel* const level = self->levels + i;
+        if (level->last_active == NO_OWNER) {
+            continue;
+        }
+        size_t prev = level->last_active;
+        do {
+            size_t const index = level->owners[prev].next_active;
+            TaskQueue* const tasks = &level->owners[index].tasks;
+            if (tqueue_rm(tasks, task_id, task)) {
+                if (tqueue_len(tasks) == 0ul) {
+                    level_deactivate_(level, prev, index);
+                }
+                --self->len;
+                return true;
+            }
+            prev = index;
+        } while (prev != level->last_active);
+    }
+    return false;
+}
+
+void tsched_for_each(
+    TaskSched const* const self,
+    bool (*const fn)(void* ctx, PendingTask const* task, size_t priority),
+    void* const ctx
+) {
+#   if TASK_SCHED_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(fn != NULL);
+#   endif  // TASK_SCHED_RUNTIME_ASSERTS
+
+    for (size_t i = TSCHED_LEVELS; i-- > 0ul;) {
+        SchedLevel const* const level = self->levels + i;
+        if (level->last_active == NO_OWNER) {
+            continue;
+        }
+        size_t index = level->last_active;
+        do {
+            index = level->owners[index].next_active;
+            TaskQueue const* const tasks = &level->owners[index].tasks;
+            for (size_t j = 0ul; j < tqueue_len(tasks); ++j) {
+                if (!fn(ctx, tqueue_get(tasks, j), i)) {
+                    return;
+                }
+            }
+        } while (index != level->last_active);
+    }
+}
@@ -0,0 +1,220 @@
+#include "task/task_slot_map.h"
+
+#include "task/task.h"
+
+#if TASK_SLOT_MAP_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define FIRST_ALLOC_CAP 16ul
+#define NO_FREE_SLOT SIZE_MAX
+#define SLOT_MASK ((((size_t) 1u) << TASK_HANDLE_SLOT_BITS) - 1ul)
+
+#define handle_slot_(handle) ((handle) & SLOT_MASK)
+#define handle_gen_(handle) ((handle) >> TASK_HANDLE_SLOT_BITS)
+#define make_handle_(slot, gen) \
+    ((((gen) & SLOT_MASK) << TASK_HANDLE_SLOT_BITS) | (slot))
+
+/**
+ * Doubles the capacity of a buffer of @p elem_size byte elements.
+ */
+static bool grow_(
+    void** const buf,
+    size_t* const cap,
+    size_t const elem_size
+) {
+    size_t new_cap;
+    size_t new_size;
+    if (*cap == 0ul) {
+        new_cap = FIRST_ALLOC_CAP;
+    } else if (__builtin_mul_overflow(*cap, 2ul, &new_cap)) {
+        return false;
+    }
+    if (__builtin_mul_overflow(new_cap, elem_size, &new_size)) {
+        return false;
+    }
+    void* const new_buf = realloc(*buf, new_size);
+    if (!new_buf) {
+        return false;
+    }
+    *buf = new_buf;
+    *cap = new_cap;
+    return true;
+}
+
+/**
+ * Returns the slot of a live handle, or @p SIZE_MAX if it's stale.
+ */
+static size_t live_slot_(
+    TaskSlotMap const* const self,
+    TaskHandle const handle
+) {
+    size_t const slot = handle_slot_(handle);
+    if (slot >= self->slots_len ||
+        (self->slots[slot].gen & SLOT_MASK) != handle_gen_(handle) ||
+        self->slots[slot].dense_idx >= self->len ||
+        self->dense_slots[self->slots[slot].dense_idx] != slot
+    ) {
+        return SIZE_MAX;
+    }
+    return slot;
+}
+
+TaskSlotMap* tsmap_new(TaskSlotMap* const init) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    init->dense = NULL;
+    init->dense_slots = NULL;
+    init->len = 0ul;
+    init->cap = 0ul;
+    init->slots = NULL;
+    init->slots_len = 0ul;
+    init->slots_cap = 0ul;
+    init->free_head = NO_FREE_SLOT;
+    return init;
+}
+
+void tsmap_drop(TaskSlotMap* const self) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    free(self->dense);
+    free(self->dense_slots);
+    free(self->slots);
+}
+
+size_t tsmap_len(TaskSlotMap const* const self) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    return self->len;
+}
+
+Task const* tsmap_begin(TaskSlotMap const* const self) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    return self->dense;
+}
+
+Task* tsmap_begin_mut(TaskSlotMap* const self) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    return self->dense;
+}
+
+Task const* tsmap_end(TaskSlotMap const* const self) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    return self->dense + self->len;
+}
+
+bool tsmap_insert(
+    TaskSlotMap* const restrict self,
+    Task const* const restrict task,
+    TaskHandle* const restrict handle
+) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(task != NULL);
+    assert(handle != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    if (self->len == self->cap) {
+        size_t dense_cap = self->cap;
+        size_t dense_slots_cap = self->cap;
+        if (!grow_((void**) &self->dense, &dense_cap, sizeof *self->dense)) {
+            return false;
+        }
+        if (!grow_(
+            (void**) &self->dense_slots,
+            &dense_slots_cap,
+            sizeof *self->dense_slots
+        )) {
+            return false;
+        }
+        self->cap = dense_cap;
+    }
+    size_t slot = self->free_head;
+    if (slot == NO_FREE_SLOT) {
+        if (self->slots_len == SLOT_MASK) {
+            return false;
+        }
+        if (self->slots_len == self->slots_cap && !grow_(
+            (void**) &self->slots,
+            &self->slots_cap,
+            sizeof *self->slots
+        )) {
+            return false;
+        }
+        slot = self->slots_len++;
+        self->slots[slot].gen = 0ul;
+    } else {
+        self->free_head = self->slots[slot].dense_idx;
+    }
+    self->slots[slot].dense_idx = self->len;
+    self->dense[self->len] = *task;
+    self->dense_slots[self->len] = slot;
+    ++self->len;
+    *handle = make_handle_(slot, self->slots[slot].gen);
+    return true;
+}
+
+Task const* tsmap_get(TaskSlotMap const* const self, TaskHandle const handle) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    size_t const slot = live_slot_(self, handle);
+    return slot == SIZE_MAX ? NULL : self->dense + self->slots[slot].dense_idx;
+}
+
+Task* tsmap_get_mut(TaskSlotMap* const self, TaskHandle const handle) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    size_t const slot = live_slot_(self, handle);
+    return slot == SIZE_MAX ? NULL : self->dense + self->slots[slot].dense_idx;
+}
+
+bool tsmap_rm(
+    TaskSlotMap* const restrict self,
+    TaskHandle const handle,
+    Task* const restrict opt_task
+) {
+#   if TASK_SLOT_MAP_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TASK_SLOT_MAP_RUNTIME_ASSERTS
+
+    size_t const slot = live_slot_(self, handle);
+    if (slot == SIZE_MAX) {
+        return false;
+    }
+    size_t const dense_idx = self->slots[slot].dense_idx;
+    if (opt_task) {
+        *opt_task = self->dense[dense_idx];
+    }
+    size_t const last_idx = --self->len;
+    if (dense_idx != last_idx) {
+        self->dense[dense_idx] = self->dense[last_idx];
+        self->dense_slots[dense_idx] = self->dense_slots[last_idx];
+        self->slots[self->dense_slots[dense_idx]].dense_idx = dense_idx;
+    }
+    ++self->slots[slot].gen;
+    self->slots[slot].dense_idx = self->free_head;
+    self->free_head = slot;
+    return true;
+}
@@ -0,0 +1,408 @@
+#define _GNU_SOURCE
+
+#include "task/zygote.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef static_assert
+#define static_assert _Static_assert
+#endif  // static_assert
+
+#ifndef thread_local
+#define thread_local _Thread_local
+#endif  // thread_local
+
+#define OUTCOME_MSG_SIZE 1024ul
+
+/**
+ * The flags of a request's first byte.
+ */
+typedef enum RequestFlag {
+    REQUEST_RELAYED = 1u << 0u, //!< The stages' traffic is relayed.
+    REQUEST_OUT_FD = 1u << 1u,  //!< The last stage's stdout is passed.
+    REQUEST_CGROUP_FD = 1u << 2u,   //!< A cgroup's @p cgroup.procs is passed,
+                                    //!< after the stdout, if any.
+} RequestFlag;
+
+/**
+ * Parses and launches a pipeline. The Zygote's ends of the relayed pipes are
+ * stored in the ZygoteLaunch, to be sent to the server and closed.
+ */
+static void launch_(
+    char const* const cmd,
+    size_t const len,
+    bool const is_relayed,
+    int const out_fd,
+    int const cgroup_fd,
+    ZygoteLaunch* const launch
+) {
+    launch->stage_count = 0ul;
+    launch->relay_count = 0ul;
+    launch->launch_errno = 0;
+    Pipeline pipeline;
+    if ((launch->outcome = pipeline_parse(&pipeline, cmd, len)) !=
+        LAUNCHER_OK
+    ) {
+        launch->launch_errno = errno;
+        return;
+    }
+
+    int in_fd = -1;
+    for (size_t i = 0ul; i < pipeline.stage_count; ++i) {
+        bool const is_last = i + 1ul == pipeline.stage_count;
+        int stage_out_fd = is_last ? out_fd : -1;
+        int next_in_fd = -1;
+        if (!is_last &&
+            (launch->outcome = pipeline_pipe(
+                &pipeline,
+                is_relayed,
+                &stage_out_fd,
+                &next_in_fd
+            )) != LAUNCHER_OK
+        ) {
+            launch->launch_errno = errno;
+            break;
+        }
+        // the stages are the server's children, not the Zygote's
+        int const err = pipeline_clone_stage(
+            pipeline.stages[i],
+            in_fd,
+            stage_out_fd,
+            cgroup_fd,
+            i > 0ul ? launch->pids[0] : 0,
+            true,
+            launch->pids + i
+        );
+        if (in_fd != -1) {
+            close(in_fd);
+        }
+        if (!is_last) {
+            close(stage_out_fd);
+        }
+        in_fd = next_in_fd;
+        if (err != 0) {
+            launch->outcome = LAUNCHER_ERR_SPAWN_FAIL;
+            launch->launch_errno = err;
+            break;
+        }
+        ++launch->stage_count;
+    }
+    if (launch->outcome != LAUNCHER_OK) {
+        if (in_fd != -1) {
+            close(in_fd);
+        }
+        if (launch->stage_count > 0ul) {
+            kill(-launch->pids[0], SIGKILL);
+        }
+        pipeline_close_relays(&pipeline);
+    }
+    launch->relay_count = pipeline.relay_count;
+    memcpy(
+        launch->relay_fds,
+        pipeline.relay_fds,
+        2ul * pipeline.relay_count * sizeof *pipeline.relay_fds
+    );
+    pipeline_drop(&pipeline);
+}
+
+/**
+ * Sends a launch's reply, along with the Zygote's ends of its relayed pipes,
+ * which are then closed.
+ */
+static bool send_launch_(int const sock_des, ZygoteLaunch* const launch) {
+    union {
+        char buf[CMSG_SPACE(sizeof launch->relay_fds)];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = {
+        .iov_base = launch,
+        .iov_len = offsetof(ZygoteLaunch, pids) +
+            launch->stage_count * sizeof *launch->pids
+    };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    size_t const fds_size = 2ul * launch->relay_count * sizeof(int);
+    if (fds_size > 0ul) {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(fds_size);
+        struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(fds_size);
+        memcpy(CMSG_DATA(cmsg), launch->relay_fds, fds_size);
+    }
+    bool is_sent;
+    while (!(is_sent = sendmsg(sock_des, &msg, MSG_NOSIGNAL) != -1l) &&
+        errno == EINTR
+    ) {}
+    for (size_t i = 0ul; i < 2ul * launch->relay_count; ++i) {
+        close(launch->relay_fds[i]);
+    }
+    return is_sent;
+}
+
+/**
+ * The Zygote's main loop: serves one launch request per message, until the
+ * server closes its end of the socket.
+ */
+static _Noreturn void zygote_main_(int const sock_des) {
+    // a request is a byte of RequestFlag, followed by the command line, and
+    // carries the file descriptors the flags tell of
+    static char request[1ul + ZYGOTE_MAX_CMD];
+    static ZygoteLaunch launch;
+    setsid();
+    for (;;) {
+        union {
+            char buf[CMSG_SPACE(2ul * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        struct iovec iov = { .iov_base = request, .iov_len = sizeof request };
+        struct msghdr msg = {
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control.buf,
+            .msg_controllen = sizeof control.buf
+        };
+        ssize_t const recv_bytes = recvmsg(sock_des, &msg, MSG_CMSG_CLOEXEC);
+        if (recv_bytes == -1l && errno == EINTR) {
+            continue;
+        }
+        if (recv_bytes <= 0l) {
+            _exit(EXIT_SUCCESS);
+        }
+        unsigned const flags = (unsigned char) request[0];
+        int fds[2] = { -1, -1 };
+        size_t fd_count = 0ul;
+        struct cmsghdr const* const cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SCM_RIGHTS
+        ) {
+            fd_count = (cmsg->cmsg_len - CMSG_LEN(0ul)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg), fd_count * sizeof(int));
+        }
+        size_t fd_index = 0ul;
+        int const out_fd = flags & REQUEST_OUT_FD && fd_index < fd_count ?
+            fds[fd_index++] :
+            -1;
+        int const cgroup_fd =
+            flags & REQUEST_CGROUP_FD && fd_index < fd_count ?
+                fds[fd_index++] :
+                -1;
+        launch_(
+            request + 1,
+            (size_t) recv_bytes - 1ul,
+            flags & REQUEST_RELAYED,
+            out_fd,
+            cgroup_fd,
+            &launch
+        );
+        for (size_t i = 0ul; i < fd_count; ++i) {
+            close(fds[i]);
+        }
+        if (!send_launch_(sock_des, &launch)) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+}
+
+ZygoteOutcome zygote_new(Zygote* const init) {
+#   if ZYGOTE_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // ZYGOTE_RUNTIME_ASSERTS
+
+    int sock_des[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sock_des) ==
+        -1
+    ) {
+        return ZYGOTE_ERR_SOCKET_FAIL;
+    }
+    pid_t const pid = fork();
+    switch (pid) {
+    case -1: {
+        int const fork_errno = errno;
+        close(sock_des[0]);
+        close(sock_des[1]);
+        errno = fork_errno;
+        return ZYGOTE_ERR_FORK_FAIL;
+    }
+    case 0:
+        close(sock_des[0]);
+        zygote_main_(sock_des[1]);
+    default:
+        break;
+    }
+    close(sock_des[1]);
+    init->sock_des = sock_des[0];
+    init->pid = pid;
+    return ZYGOTE_OK;
+}
+
+ZygoteOutcome zygote_drop(Zygote* const self) {
+#   if ZYGOTE_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // ZYGOTE_RUNTIME_ASSERTS
+
+    if (close(self->sock_des) == -1) {
+        return ZYGOTE_ERR_CLOSE_FAIL;
+    }
+    return ZYGOTE_OK;
+}
+
+ZygoteOutcome zygote_launch(
+    Zygote* const restrict self,
+    char const* const restrict cmd,
+    size_t const len,
+    bool const is_relayed,
+    int const out_fd,
+    int const cgroup_fd,
+    ZygoteLaunch* const restrict launch
+) {
+#   if ZYGOTE_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(cmd != NULL);
+    assert(launch != NULL);
+#   endif  // ZYGOTE_RUNTIME_ASSERTS
+
+    if (len > ZYGOTE_MAX_CMD) {
+        return ZYGOTE_ERR_TOO_LARGE;
+    }
+    unsigned char flags = is_relayed ? REQUEST_RELAYED : 0u;
+    int sent_fds[2];
+    size_t sent_fd_count = 0ul;
+    if (out_fd != -1) {
+        flags |= REQUEST_OUT_FD;
+        sent_fds[sent_fd_count++] = out_fd;
+    }
+    if (cgroup_fd != -1) {
+        flags |= REQUEST_CGROUP_FD;
+        sent_fds[sent_fd_count++] = cgroup_fd;
+    }
+    struct iovec request[] = {
+        { .iov_base = &flags, .iov_len = 1ul },
+        { .iov_base = (char*) cmd, .iov_len = len }
+    };
+    struct msghdr request_msg = { .msg_iov = request, .msg_iovlen = 2 };
+    union {
+        char buf[CMSG_SPACE(sizeof sent_fds)];
+        struct cmsghdr align;
+    } sent_fds_control;
+    if (sent_fd_count > 0ul) {
+        request_msg.msg_control = sent_fds_control.buf;
+        request_msg.msg_controllen = CMSG_SPACE(sent_fd_count * sizeof(int));
+        struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&request_msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sent_fd_count * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), sent_fds, sent_fd_count * sizeof(int));
+    }
+    while (sendmsg(self->sock_des, &request_msg, MSG_NOSIGNAL) == -1l) {
+        if (errno != EINTR) {
+            return ZYGOTE_ERR_SEND_FAIL;
+        }
+    }
+
+    union {
+        char buf[CMSG_SPACE(sizeof launch->relay_fds)];
+        struct cmsghdr align;
+    } control;
+    struct iovec reply = {
+        .iov_base = launch,
+        .iov_len = offsetof(ZygoteLaunch, relay_fds)
+    };
+    struct msghdr reply_msg;
+    ssize_t recv_bytes;
+    do {
+        reply_msg = (struct msghdr) {
+            .msg_iov = &reply,
+            .msg_iovlen = 1,
+            .msg_control = control.buf,
+            .msg_controllen = sizeof control.buf
+        };
+        recv_bytes = recvmsg(self->sock_des, &reply_msg, MSG_CMSG_CLOEXEC);
+    } while (recv_bytes == -1l && errno == EINTR);
+    if (recv_bytes == -1l) {
+        return ZYGOTE_ERR_RECV_FAIL;
+    }
+
+    size_t fd_count = 0ul;
+    for (struct cmsghdr* i = CMSG_FIRSTHDR(&reply_msg);
+        i;
+        i = CMSG_NXTHDR(&reply_msg, i)
+    ) {
+        if (i->cmsg_level == SOL_SOCKET && i->cmsg_type == SCM_RIGHTS) {
+            fd_count = (i->cmsg_len - CMSG_LEN(0ul)) / sizeof(int);
+            memcpy(launch->relay_fds, CMSG_DATA(i), fd_count * sizeof(int));
+        }
+    }
+    if (recv_bytes < (ssize_t) offsetof(ZygoteLaunch, pids) ||
+        reply_msg.msg_flags & MSG_CTRUNC ||
+        fd_count != 2ul * launch->relay_count
+    ) {
+        for (size_t i = 0ul; i < fd_count; ++i) {
+            close(launch->relay_fds[i]);
+        }
+        errno = ECONNRESET;
+        return ZYGOTE_ERR_RECV_FAIL;
+    }
+    return ZYGOTE_OK;
+}
+
+char const* zygote_outcome_msg(
+    ZygoteOutcome const outcome,
+    int const* const opt_errno
+) {
+    static_assert(
+        ZYGOTE_OK == 0 &&
+            ZYGOTE_ERR_TOO_LARGE == 1 &&
+            ZYGOTE_ERR_SOCKET_FAIL == 2 &&
+            ZYGOTE_ERR_FORK_FAIL == 3 &&
+            ZYGOTE_ERR_SEND_FAIL == 4 &&
+            ZYGOTE_ERR_RECV_FAIL == 5 &&
+            ZYGOTE_ERR_CLOSE_FAIL == 6,
+        "Unexpected ZygoteOutcome enumerate values"
+    );
+
+    static char const* const msgs[] = {
+        "success",
+        "command is too long for the zygote",
+        "failed creating the zygote's socket pair",
+        "failed forking the zygote",
+        "failed sending a request to the zygote",
+        "failed receiving a reply from the zygote",
+        "failed closing the zygote's socket",
+        "unknown zygote error"
+    };
+    switch (outcome) {
+    case ZYGOTE_ERR_SOCKET_FAIL:
+    case ZYGOTE_ERR_FORK_FAIL:
+    case ZYGOTE_ERR_SEND_FAIL:
+    case ZYGOTE_ERR_RECV_FAIL:
+    case ZYGOTE_ERR_CLOSE_FAIL:
+        if (opt_errno) {
+            static thread_local char msg_with_err[OUTCOME_MSG_SIZE];
+            snprintf(
+                msg_with_err,
+                OUTCOME_MSG_SIZE,
+                "%s: %s",
+                msgs[outcome],
+                strerror(*opt_errno)
+            );
+            return msg_with_err;
+        }
+        return msgs[outcome];
+    case ZYGOTE_OK:
+    case ZYGOTE_ERR_TOO_LARGE:
+        return msgs[outcome];
+    default:
+        return msgs[sizeof msgs / sizeof *msgs - 1];
+    }
+}
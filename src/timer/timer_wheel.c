@@ -0,0 +1,216 @@
+#include "timer/timer_wheel.h"
+
+#if TIMER_WHEEL_RUNTIME_ASSERTS
+#include <assert.h>
+#endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+#include <stdlib.h>
+
+#define FIRST_ALLOC_CAP 64ul
+#define SLOT_MASK (TWHEEL_SLOTS - 1ul)
+#define MAX_DELTA ((uint64_t) 1u << (TWHEEL_SLOT_BITS * TWHEEL_LEVELS))
+
+#define flat_slots_(self) (&(self)->slots[0][0])
+
+/**
+ * Links a timer into the slot of the lowest level whose span covers its
+ * expiry. Timers beyond the top level's span are parked in its farthest slot,
+ * and relinked from there when it cascades.
+ */
+static void link_(TimerWheel* const self, size_t const id) {
+    TimerNode* const node = self->nodes + id;
+    uint64_t const delta = node->expiry > self->now ?
+        node->expiry - self->now : 0u;
+    uint64_t const tick = delta < MAX_DELTA ?
+        node->expiry : self->now + MAX_DELTA - 1u;
+    size_t level = 0ul;
+    while (level + 1ul < TWHEEL_LEVELS &&
+        delta >= (uint64_t) 1u << (TWHEEL_SLOT_BITS * (level + 1ul))
+    ) {
+        ++level;
+    }
+    size_t const slot = level * TWHEEL_SLOTS +
+        (size_t) ((tick >> (TWHEEL_SLOT_BITS * level)) & SLOT_MASK);
+    size_t* const head = flat_slots_(self) + slot;
+    node->slot = (uint32_t) slot;
+    node->prev = TWHEEL_NO_TIMER;
+    node->next = *head;
+    if (*head != TWHEEL_NO_TIMER) {
+        self->nodes[*head].prev = id;
+    }
+    *head = id;
+}
+
+static void unlink_(TimerWheel* const self, size_t const id) {
+    TimerNode* const node = self->nodes + id;
+    if (node->prev != TWHEEL_NO_TIMER) {
+        self->nodes[node->prev].next = node->next;
+    } else {
+        flat_slots_(self)[node->slot] = node->next;
+    }
+    if (node->next != TWHEEL_NO_TIMER) {
+        self->nodes[node->next].prev = node->prev;
+    }
+}
+
+static void free_node_(TimerWheel* const self, size_t const id) {
+    self->nodes[id].next = self->free_head;
+    self->free_head = id;
+    --self->len;
+}
+
+/**
+ * Relinks every timer of a slot, which now fall into lower levels.
+ */
+static void cascade_(TimerWheel* const self, size_t const slot) {
+    size_t* const head = flat_slots_(self) + slot;
+    while (*head != TWHEEL_NO_TIMER) {
+        size_t const id = *head;
+        unlink_(self, id);
+        link_(self, id);
+    }
+}
+
+TimerWheel* twheel_new(TimerWheel* const init) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(init != NULL);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    init->nodes = NULL;
+    init->nodes_len = 0ul;
+    init->nodes_cap = 0ul;
+    init->free_head = TWHEEL_NO_TIMER;
+    init->len = 0ul;
+    init->now = 0u;
+    for (size_t i = 0ul; i < TWHEEL_LEVELS * TWHEEL_SLOTS; ++i) {
+        flat_slots_(init)[i] = TWHEEL_NO_TIMER;
+    }
+    return init;
+}
+
+void twheel_drop(TimerWheel* const self) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    free(self->nodes);
+}
+
+size_t twheel_len(TimerWheel const* const self) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    return self->len;
+}
+
+uint64_t twheel_now(TimerWheel const* const self) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(self != NULL);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    return self->now;
+}
+
+bool twheel_add(
+    TimerWheel* const restrict self,
+    uint64_t const delay,
+    uint32_t const tag,
+    size_t const data,
+    size_t* const restrict id
+) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(id != NULL);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    size_t new_id = self->free_head;
+    if (new_id != TWHEEL_NO_TIMER) {
+        self->free_head = self->nodes[new_id].next;
+    } else {
+        if (self->nodes_len == self->nodes_cap) {
+            size_t new_cap;
+            size_t new_size;
+            if (self->nodes_cap == 0ul) {
+                new_cap = FIRST_ALLOC_CAP;
+            } else if (
+                __builtin_mul_overflow(self->nodes_cap, 2ul, &new_cap)
+            ) {
+                return false;
+            }
+            if (
+                __builtin_mul_overflow(new_cap, sizeof *self->nodes, &new_size)
+            ) {
+                return false;
+            }
+            TimerNode* const new_nodes = realloc(self->nodes, new_size);
+            if (!new_nodes) {
+                return false;
+            }
+            self->nodes = new_nodes;
+            self->nodes_cap = new_cap;
+        }
+        new_id = self->nodes_len++;
+    }
+    TimerNode* const node = self->nodes + new_id;
+    node->expiry = self->now + (delay > 0u ? delay : 1u);
+    node->tag = tag;
+    node->data = data;
+    link_(self, new_id);
+    ++self->len;
+    *id = new_id;
+    return true;
+}
+
+void twheel_cancel(TimerWheel* const self, size_t const id) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(id < self->nodes_len);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    unlink_(self, id);
+    free_node_(self, id);
+}
+
+void twheel_advance(
+    TimerWheel* const self,
+    uint64_t ticks,
+    TimerCallback const callback,
+    void* const ctx
+) {
+#   if TIMER_WHEEL_RUNTIME_ASSERTS
+    assert(self != NULL);
+    assert(callback != NULL);
+#   endif  // TIMER_WHEEL_RUNTIME_ASSERTS
+
+    for ( ; ticks > 0u; --ticks) {
+        if (self->len == 0ul) {
+            self->now += ticks;
+            return;
+        }
+        ++self->now;
+        // when a level wraps around, the next slot of the level above is
+        // spread over the levels below
+        for (size_t level = 1ul; level < TWHEEL_LEVELS; ++level) {
+            if ((self->now & (((uint64_t) 1u <<
+                (TWHEEL_SLOT_BITS * level)) - 1u)) != 0u
+            ) {
+                break;
+            }
+            cascade_(
+                self,
+                level * TWHEEL_SLOTS +
+                    (size_t) ((self->now >> (TWHEEL_SLOT_BITS * level)) &
+                        SLOT_MASK)
+            );
+        }
+        size_t* const head = self->slots[0] + (self->now & SLOT_MASK);
+        while (*head != TWHEEL_NO_TIMER) {
+            size_t const id = *head;
+            TimerNode const expired = self->nodes[id];
+            unlink_(self, id);
+            free_node_(self, id);
+            callback(ctx, expired.tag, expired.data);
+        }
+    }
+}